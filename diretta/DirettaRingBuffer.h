@@ -151,6 +151,33 @@ public:
         fillWithSilence();
     }
 
+    /**
+     * @brief Return memory left over from a previous, larger resize()
+     *
+     * resize() keeps the vector's capacity, so a ring that once held a
+     * hi-res format stays at that footprint. Callers running under a
+     * memory limit call this after shrinking.
+     */
+    void releaseUnusedCapacity() {
+        if (buffer_.capacity() > size_) {
+            buffer_.shrink_to_fit();
+        }
+    }
+
+    /**
+     * @brief Largest size resize() can be asked for without exceeding limit
+     *
+     * resize() rounds up to a power of two; this rounds the limit down so
+     * the allocated ring stays within it.
+     */
+    static size_t floorPow2(size_t limit) {
+        size_t result = 2;
+        while (result <= limit / 2) {
+            result <<= 1;
+        }
+        return result;
+    }
+
     size_t size() const { return size_; }
     uint8_t silenceByte() const { return silenceByte_.load(std::memory_order_acquire); }
 
@@ -458,7 +485,6 @@ public:
      */
     size_t pushDSDPlanarOptimized(const uint8_t* data, size_t inputSize,
                                    int numChannels, DSDConversionMode mode) {
-        if (size_ == 0) return 0;
         if (numChannels == 0) return 0;
 
         // IMPORTANT: For partial pushes (when free space < inputSize), we must
@@ -468,7 +494,29 @@ public:
         // srcR would point into L data instead of the actual R section.
         size_t fullBytesPerChannel = inputSize / static_cast<size_t>(numChannels);
 
-        size_t maxBytes = inputSize;
+        return pushDSDStrided(data, fullBytesPerChannel, fullBytesPerChannel,
+                              numChannels, mode) * static_cast<size_t>(numChannels);
+    }
+
+    /**
+     * @brief DSD push from channel blocks at a fixed stride
+     *
+     * Channel c starts at data + c * channelStride. Lets a DSF block group
+     * ([L block][R block]) be pushed straight from the reader's buffer.
+     *
+     * @param data First channel's bytes
+     * @param bytesPerChannel Bytes available per channel
+     * @param channelStride Distance between channel starts
+     * @param numChannels Number of audio channels
+     * @param mode Pre-selected conversion mode
+     * @return Bytes consumed per channel (multiple of 4)
+     */
+    size_t pushDSDStrided(const uint8_t* data, size_t bytesPerChannel, size_t channelStride,
+                          int numChannels, DSDConversionMode mode) {
+        if (size_ == 0) return 0;
+        if (numChannels == 0) return 0;
+
+        size_t maxBytes = bytesPerChannel * static_cast<size_t>(numChannels);
         if (maxBytes > STAGING_SIZE) maxBytes = STAGING_SIZE;
         size_t free = getFreeSpace();
         if (maxBytes > free) maxBytes = free;
@@ -476,36 +524,37 @@ public:
         size_t processPerChannel = maxBytes / static_cast<size_t>(numChannels);
         size_t completeGroups = processPerChannel / 4;
         size_t usablePerChannel = completeGroups * 4;
-        size_t usableInput = usablePerChannel * static_cast<size_t>(numChannels);
-        if (usableInput == 0) return 0;
+        if (usablePerChannel == 0) return 0;
 
-        prefetch_audio_buffer(data, usableInput);
+        for (int c = 0; c < numChannels; c++) {
+            prefetch_audio_buffer(data + c * channelStride, usablePerChannel);
+        }
 
         size_t stagedBytes;
         switch (mode) {
             case DSDConversionMode::Passthrough:
                 stagedBytes = convertDSD_Passthrough(m_stagingDSD, data,
-                    usablePerChannel, fullBytesPerChannel, numChannels);
+                    usablePerChannel, channelStride, numChannels);
                 break;
             case DSDConversionMode::BitReverseOnly:
                 stagedBytes = convertDSD_BitReverse(m_stagingDSD, data,
-                    usablePerChannel, fullBytesPerChannel, numChannels);
+                    usablePerChannel, channelStride, numChannels);
                 break;
             case DSDConversionMode::ByteSwapOnly:
                 stagedBytes = convertDSD_ByteSwap(m_stagingDSD, data,
-                    usablePerChannel, fullBytesPerChannel, numChannels);
+                    usablePerChannel, channelStride, numChannels);
                 break;
             case DSDConversionMode::BitReverseAndSwap:
                 stagedBytes = convertDSD_BitReverseSwap(m_stagingDSD, data,
-                    usablePerChannel, fullBytesPerChannel, numChannels);
+                    usablePerChannel, channelStride, numChannels);
                 break;
             default:
                 stagedBytes = convertDSD_Passthrough(m_stagingDSD, data,
-                    usablePerChannel, fullBytesPerChannel, numChannels);
+                    usablePerChannel, channelStride, numChannels);
                 break;
         }
 
-        return writeToRing(m_stagingDSD, stagedBytes);
+        return writeToRing(m_stagingDSD, stagedBytes) / static_cast<size_t>(numChannels);
     }
 
     //=========================================================================
@@ -1249,6 +1298,17 @@ public:
         return len;
     }
 
+    /**
+     * @brief Drop data from the read side without copying it
+     */
+    size_t discard(size_t len) {
+        if (size_ == 0) return 0;
+        len = std::min(len, getAvailable());
+        size_t rp = readPos_.load(std::memory_order_acquire);
+        readPos_.store((rp + len) & mask_, std::memory_order_release);
+        return len;
+    }
+
     uint8_t* data() { return buffer_.data(); }
     const uint8_t* data() const { return buffer_.data(); }
 
@@ -7,6 +7,7 @@
  */
 
 #include "DirettaSync.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iomanip>
 #include <sstream>
@@ -220,6 +221,7 @@ bool DirettaSync::openSyncConnection() {
 
     m_sdkOpen = true;
     inquirySupportFormat(m_targetAddress);
+    probeSinkCapabilities();
 
     if (g_verbose) {
         logSinkCapabilities();
@@ -425,6 +427,57 @@ void DirettaSync::listTargets() {
     find.close();
 }
 
+bool DirettaSync::sinkSupportsDsd() {
+    if (!m_sdkOpen) return true;
+    return getSinkInfo().checkSinkSupportDSD();
+}
+
+bool DirettaSync::sinkSupportsPcm(uint32_t rate, uint32_t channels) {
+    if (!m_sdkOpen) return true;
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    return sinkAcceptsPcm(rate, channels);
+}
+
+DirettaSync::SinkCapabilities DirettaSync::getSinkCapabilities() const {
+    std::lock_guard<std::mutex> lock(m_sinkCapsMutex);
+    return m_sinkCaps;
+}
+
+void DirettaSync::probeSinkCapabilities() {
+    static constexpr uint32_t RATES[] = {1536000, 1411200, 768000, 705600, 384000, 352800,
+                                         192000, 176400, 96000, 88200, 48000, 44100};
+    SinkCapabilities caps;
+    caps.known = true;
+    caps.dsd = getSinkInfo().checkSinkSupportDSD();
+    for (uint32_t rate : RATES) {
+        if (sinkAcceptsPcm(rate, 2)) {
+            caps.maxPcmRate = rate;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_sinkCapsMutex);
+    if (m_sinkCaps.known && caps.dsd == m_sinkCaps.dsd && caps.maxPcmRate == m_sinkCaps.maxPcmRate) {
+        return;
+    }
+    m_sinkCaps = caps;
+    m_sinkCapsGen.fetch_add(1, std::memory_order_release);
+    std::cout << "[DirettaSync] Target accepts PCM up to " << caps.maxPcmRate << " Hz, DSD "
+              << (caps.dsd ? "yes" : "no") << std::endl;
+}
+
+bool DirettaSync::sinkAcceptsPcm(uint32_t rate, uint32_t channels) {
+    DIRETTA::FormatConfigure fmt;
+    fmt.setSpeed(rate);
+    fmt.setChannel(channels);
+    fmt.setFormat(DIRETTA::FormatID::FMT_PCM_SIGNED_32);
+    if (checkSinkSupport(fmt)) return true;
+    fmt.setFormat(DIRETTA::FormatID::FMT_PCM_SIGNED_24);
+    if (checkSinkSupport(fmt)) return true;
+    fmt.setFormat(DIRETTA::FormatID::FMT_PCM_SIGNED_16);
+    return checkSinkSupport(fmt);
+}
+
 void DirettaSync::logSinkCapabilities() {
     const auto& info = getSinkInfo();
     std::cout << "[DirettaSync] Sink capabilities:" << std::endl;
@@ -545,6 +598,7 @@ bool DirettaSync::open(const AudioFormat& format) {
                 bool wasPlaying = m_playing.load(std::memory_order_acquire);
                 beginReconfigure();
                 m_ringBuffer.clear();
+                notePlayedReset();
                 m_prefillComplete = false;
                 m_rebuffering.store(false, std::memory_order_relaxed);
                 // m_postOnlineDelayDone stays true - DAC already stable
@@ -585,6 +639,7 @@ bool DirettaSync::open(const AudioFormat& format) {
                 // NOTE: Do NOT reset m_postOnlineDelayDone for quick resume!
                 // The DAC is already stable from the previous track.
                 m_ringBuffer.clear();
+                notePlayedReset();
                 m_prefillComplete = false;
                 m_rebuffering.store(false, std::memory_order_relaxed);
                 // m_postOnlineDelayDone stays true - DAC already stable
@@ -871,7 +926,9 @@ bool DirettaSync::open(const AudioFormat& format) {
         effectiveSampleRate = format.sampleRate;
 
         int acceptedBits;
-        configureSinkPCM(format.sampleRate, format.channels, format.bitDepth, acceptedBits);
+        if (!configureSinkPCM(format.sampleRate, format.channels, format.bitDepth, acceptedBits)) {
+            return false;
+        }
         bitsPerSample = acceptedBits;
 
         int direttaBps = (acceptedBits == 32) ? 4 : (acceptedBits == 24) ? 3 : 2;
@@ -945,6 +1002,7 @@ bool DirettaSync::open(const AudioFormat& format) {
 
     // Clear buffer and start playback
     m_ringBuffer.clear();
+    notePlayedReset();
     m_prefillComplete = false;
     m_postOnlineDelayDone = false;
 
@@ -1126,6 +1184,7 @@ void DirettaSync::fullReset() {
         m_framesPerBufferAccumulator.store(0, std::memory_order_release);
 
         m_ringBuffer.clear();
+        notePlayedReset();
     }
 
     m_stopRequested = false;
@@ -1135,7 +1194,7 @@ void DirettaSync::fullReset() {
 // Sink Configuration
 //=============================================================================
 
-void DirettaSync::configureSinkPCM(int rate, int channels, int inputBits, int& acceptedBits) {
+bool DirettaSync::configureSinkPCM(int rate, int channels, int inputBits, int& acceptedBits) {
     std::lock_guard<std::mutex> lock(m_configMutex);
 
     DIRETTA::FormatConfigure fmt;
@@ -1151,7 +1210,7 @@ void DirettaSync::configureSinkPCM(int rate, int channels, int inputBits, int& a
             setSinkConfigure(fmt);
             acceptedBits = 32;
             DIRETTA_LOG("Sink PCM: " << rate << "Hz " << channels << "ch 32-bit");
-            return;
+            return true;
         }
     }
 
@@ -1160,7 +1219,7 @@ void DirettaSync::configureSinkPCM(int rate, int channels, int inputBits, int& a
         setSinkConfigure(fmt);
         acceptedBits = 24;
         DIRETTA_LOG("Sink PCM: " << rate << "Hz " << channels << "ch 24-bit");
-        return;
+        return true;
     }
 
     fmt.setFormat(DIRETTA::FormatID::FMT_PCM_SIGNED_16);
@@ -1168,10 +1227,12 @@ void DirettaSync::configureSinkPCM(int rate, int channels, int inputBits, int& a
         setSinkConfigure(fmt);
         acceptedBits = 16;
         DIRETTA_LOG("Sink PCM: " << rate << "Hz " << channels << "ch 16-bit");
-        return;
+        return true;
     }
 
-    throw std::runtime_error("No supported PCM format found");
+    std::cerr << "[DirettaSync] No supported PCM format for " << rate << "Hz "
+              << channels << "ch" << std::endl;
+    return false;
 }
 
 bool DirettaSync::configureSinkDSD(uint32_t dsdBitRate, int channels, const AudioFormat& format) {
@@ -1378,15 +1439,20 @@ void DirettaSync::configureRingPCM(int rate, int channels, int direttaBps, int i
     m_consumerStateGen.fetch_add(1, std::memory_order_release);
 
     size_t bytesPerSecond = static_cast<size_t>(rate) * channels * direttaBps;
+    m_ringBytesPerSecond.store(bytesPerSecond, std::memory_order_relaxed);
     float bufferSec = (m_config.pcmBufferSeconds > 0.0f)
         ? m_config.pcmBufferSeconds
         : DirettaBuffer::pcmBufferSeconds(static_cast<uint32_t>(rate));
-    size_t ringSize = DirettaBuffer::calculateBufferSize(bytesPerSecond, bufferSec);
+    size_t ringLimit = m_ringByteLimit.load(std::memory_order_acquire);
+    size_t ringSize = DirettaBuffer::applyByteLimit(
+        DirettaBuffer::calculateBufferSize(bytesPerSecond, bufferSec), ringLimit);
 
     m_ringBuffer.resize(ringSize, 0x00);
+    if (ringLimit > 0) m_ringBuffer.releaseUnusedCapacity();
     ringSize = m_ringBuffer.size();
 
     int bytesPerFrame = channels * direttaBps;
+    m_syncFrameBytes.store(static_cast<uint32_t>(bytesPerFrame), std::memory_order_relaxed);
     int framesBase = rate / 1000;
     int framesRemainder = rate % 1000;
     m_bytesPerFrame.store(bytesPerFrame, std::memory_order_release);
@@ -1445,12 +1511,16 @@ void DirettaSync::configureRingDSD(uint32_t byteRate, int channels) {
     m_consumerStateGen.fetch_add(1, std::memory_order_release);
 
     uint32_t bytesPerSecond = byteRate * channels;
+    m_ringBytesPerSecond.store(bytesPerSecond, std::memory_order_relaxed);
     float dsdBufSec = (m_config.dsdBufferSeconds > 0.0f)
         ? m_config.dsdBufferSeconds
         : DirettaBuffer::DSD_BUFFER_SECONDS;
-    size_t ringSize = DirettaBuffer::calculateBufferSize(bytesPerSecond, dsdBufSec);
+    size_t ringLimit = m_ringByteLimit.load(std::memory_order_acquire);
+    size_t ringSize = DirettaBuffer::applyByteLimit(
+        DirettaBuffer::calculateBufferSize(bytesPerSecond, dsdBufSec), ringLimit);
 
     m_ringBuffer.resize(ringSize, 0x69);  // DSD silence
+    if (ringLimit > 0) m_ringBuffer.releaseUnusedCapacity();
     ringSize = m_ringBuffer.size();
 
     uint32_t inputBytesPerMs = (byteRate / 1000) * channels;
@@ -1459,6 +1529,7 @@ void DirettaSync::configureRingDSD(uint32_t byteRate, int channels) {
     if (bytesPerBuffer < 64) bytesPerBuffer = 64;
     m_bytesPerBuffer.store(static_cast<int>(bytesPerBuffer), std::memory_order_release);
     m_bytesPerFrame.store(0, std::memory_order_release);
+    m_syncFrameBytes.store(static_cast<uint32_t>(4 * channels), std::memory_order_relaxed);
     m_framesPerBufferRemainder.store(0, std::memory_order_release);
     m_framesPerBufferAccumulator.store(0, std::memory_order_release);
 
@@ -1494,6 +1565,7 @@ bool DirettaSync::startPlayback() {
 
 void DirettaSync::stopPlayback(bool immediate) {
     std::lock_guard<std::recursive_mutex> controlLock(m_controlMutex);
+    holdStart(false);
     // Log accumulated underruns at session end
     uint32_t underruns = m_underrunCount.exchange(0, std::memory_order_relaxed);
     if (underruns > 0) {
@@ -1516,6 +1588,7 @@ void DirettaSync::stopPlayback(bool immediate) {
     if (m_dopSilence.load(std::memory_order_acquire)) {
         beginReconfigure();
         m_ringBuffer.clear();
+        notePlayedReset();
         m_prefillComplete = false;
         m_rebuffering.store(false, std::memory_order_relaxed);
         m_stopRequested = false;
@@ -1585,6 +1658,7 @@ void DirettaSync::resumePlayback() {
         m_silenceBuffersRemaining = 0;
         beginReconfigure();
         m_ringBuffer.clear();
+        notePlayedReset();
         m_prefillComplete = false;
         m_rebuffering.store(false, std::memory_order_relaxed);
         endReconfigure();
@@ -1600,6 +1674,7 @@ void DirettaSync::resumePlayback() {
 
     // Clear stale buffer data and require fresh prefill
     m_ringBuffer.clear();
+    notePlayedReset();
     m_prefillComplete = false;
 
     play();
@@ -1626,19 +1701,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
     RingAccessGuard ringGuard(m_ringUsers, m_reconfiguring);
     if (!ringGuard.active()) return 0;
 
-    // Generation counter optimization: single atomic load vs 5-6 loads
-    // Only reload format atomics when format has actually changed
-    uint32_t gen = m_formatGeneration.load(std::memory_order_acquire);
-    if (gen != m_cachedFormatGen) {
-        m_cachedDsdMode = m_isDsdMode.load(std::memory_order_acquire);
-        m_cachedPack24bit = m_need24BitPack.load(std::memory_order_acquire);
-        m_cachedUpsample16to32 = m_need16To32Upsample.load(std::memory_order_acquire);
-        m_cachedUpsample16to24 = m_need16To24Upsample.load(std::memory_order_acquire);
-        m_cachedChannels = m_channels.load(std::memory_order_acquire);
-        m_cachedBytesPerSample = m_bytesPerSample.load(std::memory_order_acquire);
-        m_cachedDsdConversionMode = m_dsdConversionMode.load(std::memory_order_acquire);
-        m_cachedFormatGen = gen;
-    }
+    refreshSendCache();
 
     // Use cached values (no atomic loads in hot path)
     bool dsdMode = m_cachedDsdMode;
@@ -1649,6 +1712,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
     int bytesPerSample = m_cachedBytesPerSample;
 
     size_t written = 0;
+    size_t ringBytes;   // written as stored in the ring
     size_t totalBytes;
     const char* formatLabel;
 
@@ -1661,6 +1725,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
         // Use optimized path with cached conversion mode (no per-iteration branching)
         written = m_ringBuffer.pushDSDPlanarOptimized(
             data, totalBytes, numChannels, m_cachedDsdConversionMode);
+        ringBytes = written;
         formatLabel = "DSD";
 
     } else if (pack24bit) {
@@ -1669,6 +1734,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
         totalBytes = numSamples * bytesPerFrame;
 
         written = m_ringBuffer.push24BitPacked(data, totalBytes);
+        ringBytes = written / 4 * 3;
         formatLabel = "PCM24";
 
     } else if (upsample16to32) {
@@ -1677,6 +1743,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
         totalBytes = numSamples * bytesPerFrame;
 
         written = m_ringBuffer.push16To32(data, totalBytes);
+        ringBytes = written * 2;
         formatLabel = "PCM16->32";
 
     } else if (upsample16to24) {
@@ -1685,6 +1752,7 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
         totalBytes = numSamples * bytesPerFrame;
 
         written = m_ringBuffer.push16To24(data, totalBytes);
+        ringBytes = written / 2 * 3;
         formatLabel = "PCM16->24";
 
     } else {
@@ -1693,9 +1761,51 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
         totalBytes = numSamples * bytesPerFrame;
 
         written = m_ringBuffer.push(data, totalBytes);
+        ringBytes = written;
         formatLabel = "PCM";
     }
 
+    m_pushedBytes.fetch_add(ringBytes, std::memory_order_relaxed);
+    notePushed(totalBytes, written, formatLabel);
+    return written;
+}
+
+size_t DirettaSync::sendDsdBlocks(const uint8_t* data, size_t channelStride,
+                                  size_t bytesPerChannel) {
+    if (m_draining.load(std::memory_order_acquire)) return 0;
+    if (m_stopRequested.load(std::memory_order_acquire)) return 0;
+    if (!is_online()) return 0;
+
+    RingAccessGuard ringGuard(m_ringUsers, m_reconfiguring);
+    if (!ringGuard.active()) return 0;
+
+    refreshSendCache();
+    if (!m_cachedDsdMode) return 0;
+
+    size_t perChannel = m_ringBuffer.pushDSDStrided(data, bytesPerChannel, channelStride,
+                                                    m_cachedChannels, m_cachedDsdConversionMode);
+    m_pushedBytes.fetch_add(perChannel * m_cachedChannels, std::memory_order_relaxed);
+    notePushed(bytesPerChannel * m_cachedChannels, perChannel * m_cachedChannels, "DSD");
+    return perChannel;
+}
+
+void DirettaSync::refreshSendCache() {
+    // Generation counter optimization: single atomic load vs 5-6 loads
+    // Only reload format atomics when format has actually changed
+    uint32_t gen = m_formatGeneration.load(std::memory_order_acquire);
+    if (gen != m_cachedFormatGen) {
+        m_cachedDsdMode = m_isDsdMode.load(std::memory_order_acquire);
+        m_cachedPack24bit = m_need24BitPack.load(std::memory_order_acquire);
+        m_cachedUpsample16to32 = m_need16To32Upsample.load(std::memory_order_acquire);
+        m_cachedUpsample16to24 = m_need16To24Upsample.load(std::memory_order_acquire);
+        m_cachedChannels = m_channels.load(std::memory_order_acquire);
+        m_cachedBytesPerSample = m_bytesPerSample.load(std::memory_order_acquire);
+        m_cachedDsdConversionMode = m_dsdConversionMode.load(std::memory_order_acquire);
+        m_cachedFormatGen = gen;
+    }
+}
+
+void DirettaSync::notePushed(size_t inBytes, size_t written, const char* formatLabel) {
     // Check prefill completion
     if (written > 0) {
         if (!m_prefillComplete.load(std::memory_order_acquire)) {
@@ -1710,13 +1820,23 @@ size_t DirettaSync::sendAudio(const uint8_t* data, size_t numSamples) {
             if (count <= 3 || count % 500 == 0) {
                 // A3: Async logging in hot path - zero heap allocation
                 DIRETTA_LOG_ASYNC_FMT("sendAudio #%d in=%zu out=%zu avail=%zu [%s]",
-                                      count, totalBytes, written,
+                                      count, inBytes, written,
                                       m_ringBuffer.getAvailable(), formatLabel);
             }
         }
     }
+}
 
-    return written;
+void DirettaSync::setInputPacked(bool packed) {
+    if (m_isDsdMode.load(std::memory_order_acquire)) return;
+    int direttaBps = m_bytesPerSample.load(std::memory_order_acquire);
+    int inputBps = packed ? direttaBps : 4;
+    m_inputBytesPerSample.store(inputBps, std::memory_order_release);
+    m_need24BitPack.store(direttaBps == 3 && inputBps == 4, std::memory_order_release);
+    m_need16To32Upsample.store(direttaBps == 4 && inputBps == 2, std::memory_order_release);
+    m_need16To24Upsample.store(direttaBps == 3 && inputBps == 2, std::memory_order_release);
+    // sendAudio reloads its cached conversion flags on the next push
+    m_formatGeneration.fetch_add(1, std::memory_order_release);
 }
 
 float DirettaSync::getBufferLevel() const {
@@ -1727,6 +1847,201 @@ float DirettaSync::getBufferLevel() const {
     return static_cast<float>(m_ringBuffer.getAvailable()) / static_cast<float>(size);
 }
 
+//=============================================================================
+// Played Position
+//=============================================================================
+
+void DirettaSync::notePlayedReset() {
+    m_clearedAt.store(m_pushedBytes.load(std::memory_order_relaxed), std::memory_order_release);
+}
+
+uint32_t DirettaSync::markTrackStart() {
+    if (m_trackMarkCount == MAX_TRACK_MARKS) {
+        // Only tracks shorter than the ring get here: drop the oldest start
+        std::copy(m_trackMarks + 1, m_trackMarks + MAX_TRACK_MARKS, m_trackMarks);
+        m_trackMarkCount--;
+    }
+    const uint32_t track = m_nextTrack++;
+    m_trackMarks[m_trackMarkCount++] = {track, m_pushedBytes.load(std::memory_order_relaxed)};
+    return track;
+}
+
+DirettaSync::PlayPosition DirettaSync::getPlayPosition() {
+    const uint64_t pushed = m_pushedBytes.load(std::memory_order_relaxed);
+    const uint64_t clearedAt = m_clearedAt.load(std::memory_order_acquire);
+    const uint64_t played = std::min(pushed, std::max(m_playedBytes.load(std::memory_order_acquire),
+                                                      clearedAt));
+    const uint64_t bytesPerSecond = m_ringBytesPerSecond.load(std::memory_order_relaxed);
+
+    // Audible: handed to the SDK more than the output latency ago
+    const uint64_t latencyBytes = static_cast<uint64_t>(
+        m_outputLatencyNs.load(std::memory_order_relaxed)) * bytesPerSecond / 1000000000;
+    const uint64_t audible = std::max(clearedAt, played > latencyBytes ? played - latencyBytes : 0);
+
+    // The last start playback has reached is the audible track; the ones
+    // before it are done with
+    size_t reached = 0;
+    while (reached < m_trackMarkCount && m_trackMarks[reached].start <= audible) reached++;
+    if (reached > 1) {
+        std::copy(m_trackMarks + reached - 1, m_trackMarks + m_trackMarkCount, m_trackMarks);
+        m_trackMarkCount -= reached - 1;
+    }
+
+    PlayPosition pos;
+    if (m_trackMarkCount > 0) {
+        pos.track = reached > 0 ? m_trackMarks[0].track : m_trackMarks[0].track - 1;
+        if (reached > 0 && bytesPerSecond > 0) {
+            pos.ms = (audible - m_trackMarks[0].start) * 1000 / bytesPerSecond;
+        }
+    }
+    if (bytesPerSecond > 0) pos.backlogMs = (pushed - played) * 1000 / bytesPerSecond;
+    return pos;
+}
+
+//=============================================================================
+// Sync (LMS sync groups)
+//=============================================================================
+
+namespace {
+
+int64_t steadyNs(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+// Take up to n from a counter the control side may add to or reset
+uint64_t takeBytes(std::atomic<uint64_t>& counter, uint64_t n) {
+    uint64_t cur = counter.load(std::memory_order_acquire);
+    uint64_t take;
+    do {
+        take = std::min(cur, n);
+    } while (!counter.compare_exchange_weak(cur, cur - take, std::memory_order_acq_rel));
+    return take;
+}
+
+} // anonymous namespace
+
+void DirettaSync::setOutputLatencyMs(unsigned int ms) {
+    m_outputLatencyNs.store(static_cast<int64_t>(ms) * 1000000, std::memory_order_relaxed);
+}
+
+void DirettaSync::holdStart(bool hold) {
+    m_syncSilenceBytes.store(0, std::memory_order_relaxed);
+    m_syncSkipBytes.store(0, std::memory_order_relaxed);
+    m_driftCorrect.store(hold, std::memory_order_relaxed);
+    m_syncStartNs.store(hold ? START_HELD : 0, std::memory_order_release);
+}
+
+void DirettaSync::startAt(std::chrono::steady_clock::time_point when) {
+    m_syncStartNs.store(std::max<int64_t>(1, steadyNs(when)), std::memory_order_release);
+}
+
+uint64_t DirettaSync::syncBytes(uint32_t ms) const {
+    const uint64_t unit = std::max<uint32_t>(1, m_syncFrameBytes.load(std::memory_order_relaxed));
+    const uint64_t bytes = m_ringBytesPerSecond.load(std::memory_order_relaxed) * ms / 1000;
+    return bytes - bytes % unit;
+}
+
+void DirettaSync::insertSilenceMs(uint32_t ms) {
+    m_syncSilenceBytes.fetch_add(syncBytes(ms), std::memory_order_release);
+}
+
+void DirettaSync::skipAheadMs(uint32_t ms) {
+    m_syncSkipBytes.fetch_add(syncBytes(ms), std::memory_order_release);
+}
+
+size_t DirettaSync::applySync(uint8_t* dest, size_t len, size_t avail, size_t& skipped) {
+    // Returns the bytes of dest filled with silence; the caller pops the rest
+    const size_t unit = std::max<uint32_t>(1, m_syncFrameBytes.load(std::memory_order_relaxed));
+    const uint64_t bytesPerSecond = m_ringBytesPerSecond.load(std::memory_order_relaxed);
+    size_t silence = 0;
+    skipped = 0;
+
+    // Timed start: silence up to the frame that reaches the DAC on time
+    int64_t startNs = m_syncStartNs.load(std::memory_order_acquire);
+    if (startNs != 0) {
+        if (startNs == START_HELD) {
+            fillSilence(dest, static_cast<int>(len));
+            return len;
+        }
+        const int64_t nowNs = steadyNs(std::chrono::steady_clock::now()) +
+                              m_outputLatencyNs.load(std::memory_order_relaxed);
+        if (startNs > nowNs) {
+            const int64_t dueNs = std::min<int64_t>(startNs - nowNs, 60000000000LL);
+            uint64_t wait = static_cast<uint64_t>(dueNs) * bytesPerSecond / 1000000000;
+            wait -= wait % unit;
+            if (wait >= len) {
+                fillSilence(dest, static_cast<int>(len));
+                return len;
+            }
+            silence = static_cast<size_t>(wait);
+        }
+        m_syncStartNs.compare_exchange_strong(startNs, 0, std::memory_order_acq_rel);
+    }
+
+    // Skip-ahead, keeping enough for this buffer
+    if (m_syncSkipBytes.load(std::memory_order_relaxed) > 0 && avail > len) {
+        size_t n = static_cast<size_t>(takeBytes(m_syncSkipBytes, (avail - len) / unit * unit));
+        skipped = m_ringBuffer.discard(n);
+        m_syncSkippedTotal.fetch_add(skipped, std::memory_order_relaxed);
+        m_drift.settle(-static_cast<double>(skipped / unit));
+    }
+
+    // Pause for an interval: silence without consuming
+    if (silence < len && m_syncSilenceBytes.load(std::memory_order_relaxed) > 0) {
+        size_t n = static_cast<size_t>(takeBytes(m_syncSilenceBytes, len - silence));
+        m_syncSilenceTotal.fetch_add(n, std::memory_order_relaxed);
+        m_drift.settle(static_cast<double>(n / unit));
+        silence += n;
+    }
+
+    if (silence > 0) fillSilence(dest, static_cast<int>(silence));
+    return silence;
+}
+
+void DirettaSync::noteConsumerClock(int bytes) {
+    // A gap means the SDK was stopped (pause, stop): start a new run. The
+    // reference moves once past SETTLE_NS, after the SDK's initial fill.
+    constexpr int64_t GAP_NS = 100000000;
+    constexpr int64_t SETTLE_NS = 2000000000;
+    const int64_t now = steadyNs(std::chrono::steady_clock::now());
+    if (m_clockRefNs == 0 || now - m_clockLastNs > GAP_NS) {
+        m_clockRefNs = now;
+        m_clockPublishNs = now;
+        m_clockBytes = 0;
+        m_clockSettled = false;
+        m_clockDriftPpm.store(std::numeric_limits<double>::quiet_NaN(), std::memory_order_relaxed);
+        m_drift.reset(static_cast<size_t>(m_cachedBytesPerFrame));
+    } else if (!m_clockSettled && now - m_clockRefNs >= SETTLE_NS) {
+        m_clockRefNs = now;
+        m_clockBytes = 0;
+        m_clockSettled = true;
+    } else {
+        m_clockBytes += static_cast<uint64_t>(bytes);
+    }
+    m_clockLastNs = now;
+
+    if (now - m_clockPublishNs < 1000000000) return;
+    m_clockPublishNs = now;
+    const int64_t windowNs = now - m_clockRefNs;
+    const uint64_t bytesPerSecond = m_ringBytesPerSecond.load(std::memory_order_relaxed);
+    if (!m_clockSettled || windowNs < CLOCK_MIN_WINDOW_MS * 1000000 || bytesPerSecond == 0) return;
+    const double consumedNs = static_cast<double>(m_clockBytes) * 1e9 / bytesPerSecond;
+    m_clockDriftPpm.store((consumedNs - windowNs) * 1e6 / windowNs, std::memory_order_relaxed);
+}
+
+bool DirettaSync::getClockDrift(double& ppm) const {
+    ppm = m_clockDriftPpm.load(std::memory_order_relaxed);
+    return !std::isnan(ppm);
+}
+
+size_t DirettaSync::getBufferBytes(size_t& capacity) const {
+    capacity = 0;
+    RingAccessGuard ringGuard(m_ringUsers, m_reconfiguring);
+    if (!ringGuard.active()) return 0;
+    capacity = m_ringBuffer.size();
+    return m_ringBuffer.getAvailable();
+}
+
 void DirettaSync::dumpStats() const {
     std::cout << "\n════════════════════════════════════════" << std::endl;
     std::cout << "[DirettaSync] Runtime Statistics" << std::endl;
@@ -1751,6 +2066,21 @@ void DirettaSync::dumpStats() const {
     std::cout << "  Streams:     " << m_streamCount.load(std::memory_order_relaxed) << std::endl;
     std::cout << "  Pushes:      " << m_pushCount.load(std::memory_order_relaxed) << std::endl;
     std::cout << "  Underruns:   " << m_underrunCount.load(std::memory_order_relaxed) << std::endl;
+    double driftPpm = 0.0;
+    if (getClockDrift(driftPpm)) {
+        std::cout << "  Clock:       " << std::showpos << std::setprecision(1) << driftPpm
+                  << std::noshowpos << " ppm vs host" << std::endl;
+    }
+    const uint64_t bytesPerSecond = m_ringBytesPerSecond.load(std::memory_order_relaxed);
+    if (bytesPerSecond > 0) {
+        std::cout << "  Sync:        "
+                  << m_syncSkippedTotal.load(std::memory_order_relaxed) * 1000 / bytesPerSecond
+                  << " ms skipped, "
+                  << m_syncSilenceTotal.load(std::memory_order_relaxed) * 1000 / bytesPerSecond
+                  << " ms silence inserted; drift: " << m_drift.inserted()
+                  << " frames inserted, " << m_drift.dropped()
+                  << " dropped in digital silence" << std::endl;
+    }
     std::cout << "════════════════════════════════════════\n" << std::endl;
 }
 
@@ -1820,6 +2150,8 @@ bool DirettaSync::getNewStream(diretta_stream& baseStream) {
         // m_cachedBytesPerFrame (= channels × 3) to walk frames.
         m_cachedDopSilence = m_dopSilence.load(std::memory_order_acquire);
 
+        m_clockRefNs = 0;   // New rate: new clock run
+
         m_cachedConsumerGen = gen;
     }
 
@@ -1839,6 +2171,8 @@ bool DirettaSync::getNewStream(diretta_stream& baseStream) {
         m_framesPerBufferAccumulator.store(acc, std::memory_order_relaxed);
     }
 
+    noteConsumerClock(currentBytesPerBuffer);
+
     // SDK 148 WORKAROUND: Use our own buffer instead of Stream::resize()
     // Resize our persistent buffer if needed
     if (m_streamData.size() != static_cast<size_t>(currentBytesPerBuffer)) {
@@ -1994,15 +2328,43 @@ bool DirettaSync::getNewStream(diretta_stream& baseStream) {
         return true;
     }
 
-    // Pop from ring buffer
-    m_ringBuffer.pop(dest, currentBytesPerBuffer);
+    // Sync adjustments (held or timed start, pause-for-interval, skip-ahead)
+    size_t silenceBytes = 0;
+    size_t skippedBytes = 0;
+    if (m_syncStartNs.load(std::memory_order_relaxed) != 0 ||
+        m_syncSilenceBytes.load(std::memory_order_relaxed) != 0 ||
+        m_syncSkipBytes.load(std::memory_order_relaxed) != 0) {
+        silenceBytes = applySync(dest, static_cast<size_t>(currentBytesPerBuffer), avail, skippedBytes);
+    }
+    const size_t popBytes = static_cast<size_t>(currentBytesPerBuffer) - silenceBytes;
+
+    // Pop from ring buffer. Sync groups (PCM): pay the measured clock drift
+    // back in whole frames, inserted into or dropped from digital silence.
+    size_t consumedBytes = popBytes;
+    const bool correctDrift = popBytes > 0 && m_driftCorrect.load(std::memory_order_relaxed) &&
+                              !currentIsDsd && !m_cachedDopSilence && m_cachedBytesPerFrame > 0;
+    const double driftPpm = m_clockDriftPpm.load(std::memory_order_relaxed);
+    if (correctDrift && !std::isnan(driftPpm)) {
+        m_drift.advance(popBytes / static_cast<size_t>(m_cachedBytesPerFrame), driftPpm);
+    }
+    if (correctDrift && silenceBytes == 0) {
+        consumedBytes = m_drift.fill(dest, popBytes, avail - skippedBytes,
+                                     [this](uint8_t* p, size_t n) { m_ringBuffer.pop(p, n); });
+    } else if (popBytes > 0) {
+        m_ringBuffer.pop(dest + silenceBytes, popBytes);
+    }
+
+    // Played position: these bytes are what the target plays next
+    const uint64_t played = std::max(m_playedBytes.load(std::memory_order_relaxed),
+                                     m_clearedAt.load(std::memory_order_acquire));
+    m_playedBytes.store(played + skippedBytes + consumedBytes, std::memory_order_release);
 
     // DoP: rewrite each frame's marker to continue the alternating 0x05/0xFA
     // sequence shared with the silence path (payload preserved). Keeps the
     // marker stream unbroken across every silence↔audio junction so the DAC
     // never re-triggers DoP detection (v1.4.4).
-    if (m_cachedDopSilence) {
-        writeDopMarkers(dest, currentBytesPerBuffer, /*fillPayload=*/false);
+    if (m_cachedDopSilence && popBytes > 0) {
+        writeDopMarkers(dest + silenceBytes, static_cast<int>(popBytes), /*fillPayload=*/false);
     }
 
     // G1: Signal producer that space is now available
@@ -10,6 +10,7 @@
 #define DIRETTA_SYNC_H
 
 #include "DirettaRingBuffer.h"
+#include "DriftCorrector.h"
 
 #include <Sync.hpp>
 #include <Find.hpp>
@@ -28,6 +29,7 @@
 #include <iostream>
 #include <cmath>
 #include <chrono>
+#include <limits>
 #include <cstring>
 #include <sstream>
 #include <condition_variable>
@@ -243,6 +245,14 @@ namespace DirettaBuffer {
         return size;
     }
 
+    // Apply a front-end byte limit on top of calculateBufferSize()
+    // (0 = no limit). The result never rounds up past the limit.
+    inline size_t applyByteLimit(size_t size, size_t limit) {
+        if (limit == 0) return size;
+        size_t cap = DirettaRingBuffer::floorPow2(std::max(limit, MIN_BUFFER_BYTES));
+        return std::min(size, cap);
+    }
+
     inline float pcmBufferSeconds(uint32_t sampleRate) {
         return (sampleRate > HIGHRATE_THRESHOLD) ? PCM_HIGHRATE_BUFFER_SECONDS : PCM_BUFFER_SECONDS;
     }
@@ -395,6 +405,29 @@ public:
     bool isOpen() const { return m_open; }
     bool isOnline() { return is_online(); }
 
+    /**
+     * @brief Whether the target accepts native DSD
+     *
+     * Reported by the target once the SDK connection is open (first
+     * open()); true before that, so the first DSD track tries native.
+     */
+    bool sinkSupportsDsd();
+
+    /// Whether the target accepts PCM at this rate in any bit depth (same rule)
+    bool sinkSupportsPcm(uint32_t rate, uint32_t channels);
+
+    /// What the target accepted at the last SDK open (kept across release())
+    struct SinkCapabilities {
+        bool known = false;         // No SDK connection made yet
+        bool dsd = false;
+        uint32_t maxPcmRate = 0;    // Highest stereo PCM rate, 0 if none
+    };
+    SinkCapabilities getSinkCapabilities() const;
+    /// Bumped whenever getSinkCapabilities() changes
+    uint32_t getSinkCapabilitiesGeneration() const {
+        return m_sinkCapsGen.load(std::memory_order_acquire);
+    }
+
     //=========================================================================
     // Playback Control
     //=========================================================================
@@ -428,10 +461,90 @@ public:
      */
     size_t sendAudio(const uint8_t* data, size_t numSamples);
 
+    /**
+     * @brief Send DSD channel blocks in place (DSF block groups)
+     * @param data First channel's bytes; channel c at data + c * channelStride
+     * @param channelStride Distance between channel starts (DSF block size)
+     * @param bytesPerChannel Bytes available per channel
+     * @return Bytes consumed per channel (the caller advances by this)
+     */
+    size_t sendDsdBlocks(const uint8_t* data, size_t channelStride, size_t bytesPerChannel);
+
     float getBufferLevel() const;
+    /// Ring fill in bytes; capacity is set to the ring size (0 while closed)
+    size_t getBufferBytes(size_t& capacity) const;
+
+    //=========================================================================
+    // Played Position
+    //=========================================================================
+    //
+    // The worker counts the ring bytes it pops for playback (generated
+    // silence does not count), so the position is what the target is
+    // playing, not what has been pushed. Track starts are marked at the push
+    // position and take effect when playback reaches them. A ring clear
+    // (open, seek, stop) counts as everything pushed so far being played.
+    // The output latency (setOutputLatencyMs) is taken off the position;
+    // backlogMs is the ring alone. Both calls belong to the thread that
+    // pushes.
+
+    struct PlayPosition {
+        uint32_t track = 0;         // markTrackStart() number of the audible track
+        uint64_t ms = 0;            // Played of that track
+        uint64_t backlogMs = 0;     // Pushed but not played yet
+    };
+
+    /// Start a new track at the next pushed byte; returns its number
+    uint32_t markTrackStart();
+
+    PlayPosition getPlayPosition();
+
+    //=========================================================================
+    // Sync (LMS sync groups)
+    //=========================================================================
+    //
+    // LMS keeps synced players together by starting them at a given jiffies
+    // and nudging each with pause-for-interval and skip-ahead, judged from
+    // the elapsed time it reports against its jiffies. The worker applies
+    // these in whole frames, within a buffer if it has to.
+
+    /// Delay from the worker to the DAC output (SDK, network, target)
+    void setOutputLatencyMs(unsigned int ms);
+
+    /// Hold the next stream after prefill until startAt(); false cancels all
+    /// sync state. A held stream also gets drift correction (DriftCorrector).
+    void holdStart(bool hold);
+    bool isStartHeld() const { return m_syncStartNs.load(std::memory_order_acquire) == START_HELD; }
+
+    /// Output the first frame at this time (silence until then)
+    void startAt(std::chrono::steady_clock::time_point when);
+
+    /// Pause for an interval: play silence now without consuming the ring
+    void insertSilenceMs(uint32_t ms);
+
+    /// Drop buffered audio (it counts as played)
+    void skipAheadMs(uint32_t ms);
+
+    /**
+     * @brief Consumer clock against the host clock
+     * @param ppm Set to the deviation (positive = the target runs fast)
+     * @return false until a run of CLOCK_MIN_WINDOW_MS has been measured
+     */
+    bool getClockDrift(double& ppm) const;
+
     const AudioFormat& getFormat() const { return m_currentFormat; }
     void dumpStats() const;
 
+    /**
+     * @brief Cap the ring buffer size for the next ring configuration
+     * @param maxBytes Upper bound in bytes (0 = built-in sizing only)
+     *
+     * Set by the front-end's memory budget before open(). The cap applies
+     * after the seconds-based sizing, never below MIN_BUFFER_BYTES.
+     */
+    void setRingByteLimit(size_t maxBytes) {
+        m_ringByteLimit.store(maxBytes, std::memory_order_release);
+    }
+
     /**
      * @brief Check if prefill is complete (ring buffer has enough data to start playback)
      * @return true if prefill threshold has been reached
@@ -460,6 +573,24 @@ public:
         m_ringBuffer.setS24PackModeHint(hint);
     }
 
+    /**
+     * @brief Bytes per sample of the PCM sink format negotiated by open()
+     * @return 2, 3 or 4 (S16 / S24_3LE / S32)
+     */
+    int getSinkBytesPerSample() const {
+        return m_bytesPerSample.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Declare sendAudio() PCM input as already in the sink layout
+     *
+     * Default after open() is S32 MSB-aligned input, converted on push.
+     * A front-end that caches samples pre-packed (S24_3LE / S16 matching
+     * getSinkBytesPerSample()) sets this so the push is a plain copy.
+     * Call from the producer thread after open(), before sendAudio().
+     */
+    void setInputPacked(bool packed);
+
     //=========================================================================
     // Flow Control (G1: DSD jitter reduction)
     //=========================================================================
@@ -525,7 +656,7 @@ private:
     void shutdownWorker();
     bool joinWorkerWithTimeout(int timeoutMs = 1000);  // Timed worker thread join
 
-    void configureSinkPCM(int rate, int channels, int inputBits, int& acceptedBits);
+    bool configureSinkPCM(int rate, int channels, int inputBits, int& acceptedBits);
     bool configureSinkDSD(uint32_t dsdBitRate, int channels, const AudioFormat& format);
     void configureRingPCM(int rate, int channels, int direttaBps, int inputBps, bool isCompressed, bool isDoP);
 
@@ -541,6 +672,8 @@ private:
     // audio — payload preserved). numBytes must be frame-aligned.
     void writeDopMarkers(uint8_t* dest, int numBytes, bool fillPayload);
     void configureRingDSD(uint32_t byteRate, int channels);
+    void refreshSendCache();
+    void notePushed(size_t inBytes, size_t written, const char* formatLabel);
     size_t calculateAlignedPrefill(size_t bytesPerSecond, size_t bytesPerBuffer,
                                    bool isDSD, bool isCompressed);
     void beginReconfigure();
@@ -551,6 +684,8 @@ private:
     void requestShutdownSilence(int buffers);
     bool waitForOnline(unsigned int timeoutMs);
     void logSinkCapabilities();
+    bool sinkAcceptsPcm(uint32_t rate, uint32_t channels);
+    void probeSinkCapabilities();
 
     class ReconfigureGuard {
     public:
@@ -702,6 +837,57 @@ private:
     std::atomic<int> m_pushCount{0};
     std::atomic<uint32_t> m_underrunCount{0};
     std::atomic<bool> m_rebuffering{false};              // Rebuffering after sustained underrun
+
+    // Memory budget (0 = no cap)
+    std::atomic<size_t> m_ringByteLimit{0};
+
+    // Played position (ring bytes since construction)
+    void notePlayedReset();
+    std::atomic<uint64_t> m_pushedBytes{0};       // Producer
+    std::atomic<uint64_t> m_playedBytes{0};       // Worker, per popped buffer
+    std::atomic<uint64_t> m_clearedAt{0};         // m_pushedBytes at the last ring clear
+    std::atomic<uint64_t> m_ringBytesPerSecond{0};
+    // Track starts not superseded yet (producer only)
+    struct TrackMark {
+        uint32_t track;
+        uint64_t start;
+    };
+    static constexpr size_t MAX_TRACK_MARKS = 8;
+    TrackMark m_trackMarks[MAX_TRACK_MARKS] = {};
+    size_t m_trackMarkCount = 0;
+    uint32_t m_nextTrack = 1;
+
+    mutable std::mutex m_sinkCapsMutex;
+    SinkCapabilities m_sinkCaps;
+    std::atomic<uint32_t> m_sinkCapsGen{0};
+
+    // Sync: set by the control side, consumed by the worker (0 = nothing
+    // pending); m_syncStartNs is a steady_clock time
+    static constexpr int64_t START_HELD = INT64_MAX;
+    size_t applySync(uint8_t* dest, size_t len, size_t avail, size_t& skipped);
+    uint64_t syncBytes(uint32_t ms) const;
+    std::atomic<int64_t> m_syncStartNs{0};
+    std::atomic<uint64_t> m_syncSilenceBytes{0};
+    std::atomic<uint64_t> m_syncSkipBytes{0};
+    std::atomic<uint64_t> m_syncSkippedTotal{0};
+    std::atomic<uint64_t> m_syncSilenceTotal{0};
+    std::atomic<int64_t> m_outputLatencyNs{0};
+    std::atomic<uint32_t> m_syncFrameBytes{0};
+
+    // Consumer clock: bytes the SDK asked for since the reference point of
+    // the current run (worker-only), published as ppm every second
+    static constexpr int64_t CLOCK_MIN_WINDOW_MS = 10000;
+    void noteConsumerClock(int bytes);
+    int64_t m_clockRefNs = 0;
+    int64_t m_clockLastNs = 0;
+    int64_t m_clockPublishNs = 0;
+    uint64_t m_clockBytes = 0;
+    bool m_clockSettled = false;
+    std::atomic<double> m_clockDriftPpm{std::numeric_limits<double>::quiet_NaN()};
+    // Drift correction in digital silence (sync groups, PCM): the debt is
+    // worker-only, the inserted/dropped counters are read by dumpStats()
+    DriftCorrector m_drift;
+    std::atomic<bool> m_driftCorrect{false};
 };
 
 #endif // DIRETTA_SYNC_H
@@ -0,0 +1,139 @@
+/**
+ * @file DriftCorrector.h
+ * @brief Bit-perfect clock drift correction for LMS sync groups
+ *
+ * A synced player has to play the stream at the host's clock, but the
+ * Diretta target consumes it at its own. DirettaSync measures the
+ * difference in ppm (noteConsumerClock()); this class turns it into whole
+ * frames owed and pays them back inside digital silence only: a run of
+ * all-zero frames is made longer (target fast) or shorter (target slow).
+ * Audio samples are never altered, so playback stays bit-perfect, and
+ * pause/skip corrections from LMS are rarely needed.
+ *
+ * PCM only: DSD and DoP silence are not zero frames. Used by the
+ * DirettaSync worker; kept free of SDK types for tools/sync-sim.
+ */
+
+#ifndef DIRETTA_DRIFT_CORRECTOR_H
+#define DIRETTA_DRIFT_CORRECTOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+class DriftCorrector {
+public:
+    /// Shortest run of zero frames treated as digital silence
+    static constexpr size_t MIN_SILENCE_FRAMES = 32;
+    /// Largest correction applied in one buffer (fraction of its frames)
+    static constexpr size_t MAX_STEP_DIVISOR = 8;
+
+    /// New run or format: forget the debt
+    void reset(size_t frameBytes) {
+        m_frameBytes = frameBytes;
+        m_debt = 0.0;
+    }
+
+    /// Account for frames the target consumed at ppm (+ = target fast)
+    void advance(size_t frames, double ppm) {
+        m_debt += static_cast<double>(frames) * ppm * 1e-6;
+    }
+
+    /// Frames corrected by other means (LMS pause-for-interval: +, skip-ahead: -)
+    void settle(double frames) { m_debt -= frames; }
+
+    /// Whole frames owed: > 0 to insert, < 0 to drop
+    long owed() const { return static_cast<long>(m_debt); }
+
+    /**
+     * @brief Fill one output buffer from the stream, correcting in silence
+     * @param dest Output buffer (len bytes)
+     * @param len Buffer size, a whole number of frames
+     * @param avail Stream bytes that can be popped
+     * @param pop Callable pop(uint8_t* dest, size_t bytes) reading the stream
+     * @return Stream bytes consumed (len, less inserted or plus dropped frames)
+     */
+    template <typename Pop>
+    size_t fill(uint8_t* dest, size_t len, size_t avail, Pop&& pop) {
+        const size_t fb = m_frameBytes;
+        const long due = owed();
+        if (due == 0 || fb == 0 || len % fb != 0) {
+            pop(dest, len);
+            return len;
+        }
+        const size_t frames = len / fb;
+        const size_t maxStep = frames / MAX_STEP_DIVISOR;
+
+        if (due > 0) {
+            // Insert: pop k frames short, then widen a silent run by k
+            const size_t k = std::min(static_cast<size_t>(due), maxStep);
+            const size_t got = frames - k;
+            pop(dest, got * fb);
+            size_t run = 0;
+            const size_t at = k > 0 ? findSilence(dest, got, run) : 0;
+            if (run == 0) {
+                pop(dest + got * fb, k * fb);
+                return len;
+            }
+            std::memmove(dest + (at + k) * fb, dest + at * fb, (got - at) * fb);
+            std::memset(dest + at * fb, 0, k * fb);
+            m_debt -= static_cast<double>(k);
+            m_inserted.fetch_add(k, std::memory_order_relaxed);
+            return got * fb;
+        }
+
+        // Drop: shorten a silent run, then top the buffer up from the stream
+        pop(dest, len);
+        size_t run = 0;
+        const size_t at = findSilence(dest, frames, run);
+        if (run == 0) return len;
+        size_t m = std::min({static_cast<size_t>(-due), run / 2, maxStep});
+        if (avail < len + m * fb) m = avail > len ? (avail - len) / fb : 0;
+        if (m == 0) return len;
+        std::memmove(dest + at * fb, dest + (at + m) * fb, (frames - at - m) * fb);
+        pop(dest + (frames - m) * fb, m * fb);
+        m_debt += static_cast<double>(m);
+        m_dropped.fetch_add(m, std::memory_order_relaxed);
+        return len + m * fb;
+    }
+
+    uint64_t inserted() const { return m_inserted.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    // First run of at least MIN_SILENCE_FRAMES zero frames: returns its first
+    // frame and sets run to its length (run = 0 when there is none)
+    size_t findSilence(const uint8_t* data, size_t frames, size_t& run) const {
+        run = 0;
+        size_t f = 0;
+        while (f < frames) {
+            if (!isZeroFrame(data + f * m_frameBytes)) {
+                f++;
+                continue;
+            }
+            const size_t start = f;
+            while (f < frames && isZeroFrame(data + f * m_frameBytes)) f++;
+            if (f - start >= MIN_SILENCE_FRAMES) {
+                run = f - start;
+                return start;
+            }
+        }
+        return 0;
+    }
+
+    bool isZeroFrame(const uint8_t* p) const {
+        for (size_t i = 0; i < m_frameBytes; i++) {
+            if (p[i] != 0) return false;
+        }
+        return true;
+    }
+
+    size_t m_frameBytes = 0;
+    double m_debt = 0.0;   // Frames owed (worker only)
+    std::atomic<uint64_t> m_inserted{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+#endif // DIRETTA_DRIFT_CORRECTOR_H
@@ -15,10 +15,22 @@
 
 #include "AacDecoder.h"
 #include "LogLevel.h"
+#include "SampleConverter.h"
 
 #include <cstring>
 #include <algorithm>
 
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+// fdk-aac is loaded by Decoder::create() (CodecLoader.h)
+#define aacDecoder_Open          CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_Open)
+#define aacDecoder_Close         CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_Close)
+#define aacDecoder_SetParam      CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_SetParam)
+#define aacDecoder_Fill          CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_Fill)
+#define aacDecoder_DecodeFrame   CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_DecodeFrame)
+#define aacDecoder_GetStreamInfo CODEC_SYMBOL(CodecLoader::FDKAAC, aacDecoder_GetStreamInfo)
+#endif
+
 AacDecoder::AacDecoder() {
     m_handle = aacDecoder_Open(TT_MP4_ADTS, 1 /* nrOfLayers */);
     if (!m_handle) {
@@ -30,8 +42,6 @@ AacDecoder::AacDecoder() {
     // Enable SBR and PS for HE-AAC streams
     aacDecoder_SetParam(m_handle, AAC_PCM_MAX_OUTPUT_CHANNELS, 2);
 
-    m_inputBuffer.reserve(65536);
-    m_outputBuffer.reserve(16384);
     m_decodeBuf.resize(2048 * 2);  // Max frame size * max channels
 }
 
@@ -42,7 +52,7 @@ AacDecoder::~AacDecoder() {
 }
 
 size_t AacDecoder::feed(const uint8_t* data, size_t len) {
-    m_inputBuffer.insert(m_inputBuffer.end(), data, data + len);
+    m_input.append(data, len);
     return len;
 }
 
@@ -54,32 +64,26 @@ size_t AacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
     if (m_error || m_finished) return 0;
 
     size_t channels = m_formatReady ? m_format.channels : 2;
-    size_t outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+    size_t outputFrames = m_output.available() / std::max(channels, size_t(1));
 
     while (outputFrames < maxFrames) {
-        size_t available = m_inputBuffer.size() - m_inputPos;
-        if (available == 0 && !m_eof) break;
-        if (available == 0 && m_eof) {
+        if (m_input.empty() && !m_eof) break;
+        if (m_input.empty() && m_eof) {
             m_finished = true;
             break;
         }
 
-        // Fill decoder with available data
-        UCHAR* inBuf = m_inputBuffer.data() + m_inputPos;
+        // Fill decoder with the contiguous run of queued data (the rest
+        // of a wrapped queue goes in on the next iteration)
+        size_t available = 0;
+        UCHAR* inBuf = const_cast<UCHAR*>(m_input.peekContiguous(available));
         UINT bytesAvail = static_cast<UINT>(available);
         UINT bytesValid = bytesAvail;
         UCHAR* bufList[1] = { inBuf };
         UINT sizeList[1] = { bytesAvail };
 
         aacDecoder_Fill(m_handle, bufList, sizeList, &bytesValid);
-        m_inputPos += (bytesAvail - bytesValid);
-
-        // Compact input buffer periodically
-        if (m_inputPos > 32768) {
-            m_inputBuffer.erase(m_inputBuffer.begin(),
-                                 m_inputBuffer.begin() + m_inputPos);
-            m_inputPos = 0;
-        }
+        m_input.consume(bytesAvail - bytesValid);
 
         // Decode one frame
         AAC_DECODER_ERROR err = aacDecoder_DecodeFrame(
@@ -120,11 +124,17 @@ size_t AacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
             }
 
             // Convert INT_PCM to S32_LE MSB-aligned
-            int numSamples = info->frameSize * info->numChannels;
-            for (int i = 0; i < numSamples; i++) {
-                m_outputBuffer.push_back(
-                    static_cast<int32_t>(m_decodeBuf[i]) << m_shift);
+            size_t numSamples = static_cast<size_t>(info->frameSize * info->numChannels);
+            int32_t* dst = m_output.prepare(numSamples);
+            if constexpr (sizeof(INT_PCM) == sizeof(int16_t)) {
+                SampleConverter::s16ToS32(
+                    reinterpret_cast<const int16_t*>(m_decodeBuf.data()), numSamples, dst);
+            } else {
+                SampleConverter::shiftS32(
+                    reinterpret_cast<const int32_t*>(m_decodeBuf.data()), numSamples,
+                    m_shift, dst);
             }
+            m_output.commit(numSamples);
 
         } else if (err == AAC_DEC_NOT_ENOUGH_BITS) {
             // Need more data
@@ -149,28 +159,18 @@ size_t AacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
             continue;
         }
 
-        outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+        outputFrames = m_output.available() / std::max(channels, size_t(1));
     }
 
     // Copy available output frames
     if (!m_formatReady || m_format.channels == 0) return 0;
 
-    size_t framesAvailable = (m_outputBuffer.size() - m_outputPos) / m_format.channels;
+    size_t framesAvailable = m_output.available() / m_format.channels;
     size_t framesToCopy = std::min(framesAvailable, maxFrames);
 
     if (framesToCopy > 0) {
-        size_t samplesToCopy = framesToCopy * m_format.channels;
-        std::memcpy(out, m_outputBuffer.data() + m_outputPos,
-                    samplesToCopy * sizeof(int32_t));
-        m_outputPos += samplesToCopy;
+        m_output.read(out, framesToCopy * m_format.channels);
         m_decodedSamples += framesToCopy;
-
-        // Compact output buffer
-        if (m_outputPos > 0) {
-            m_outputBuffer.erase(m_outputBuffer.begin(),
-                                 m_outputBuffer.begin() + m_outputPos);
-            m_outputPos = 0;
-        }
     }
 
     return framesToCopy;
@@ -185,10 +185,8 @@ void AacDecoder::flush() {
         aacDecoder_SetParam(m_handle, AAC_PCM_MAX_OUTPUT_CHANNELS, 2);
     }
 
-    m_inputBuffer.clear();
-    m_inputPos = 0;
-    m_outputBuffer.clear();
-    m_outputPos = 0;
+    m_input.clear();
+    m_output.clear();
     m_decodeBuf.assign(m_decodeBuf.size(), 0);
     m_format = {};
     m_formatReady = false;
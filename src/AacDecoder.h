@@ -14,6 +14,8 @@
 #define SLIM2DIRETTA_AAC_DECODER_H
 
 #include "Decoder.h"
+#include "SampleQueue.h"
+#include "InputQueue.h"
 #include <fdk-aac/aacdecoder_lib.h>
 #include <vector>
 
@@ -30,18 +32,17 @@ public:
     bool isFinished() const override { return m_finished; }
     bool hasError() const override { return m_error; }
     uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
     void flush() override;
 
 private:
     HANDLE_AACDECODER m_handle = nullptr;
 
-    // Input buffer (fed by caller)
-    std::vector<uint8_t> m_inputBuffer;
-    size_t m_inputPos = 0;
+    // Input queue (fed by caller)
+    InputQueue m_input;
 
-    // Output buffer (S32_LE interleaved, MSB-aligned)
-    std::vector<int32_t> m_outputBuffer;
-    size_t m_outputPos = 0;
+    // Output queue (S32_LE interleaved, MSB-aligned)
+    SampleQueue m_output;
 
     // Temp buffer for fdk-aac output
     std::vector<INT_PCM> m_decodeBuf;
@@ -0,0 +1,831 @@
+/**
+ * @file AlacDecoder.cpp
+ * @brief Native ALAC decoder implementation
+ *
+ * Container: top-level boxes are walked as they arrive. moov is buffered
+ * whole and parsed for the 'alac' sample entry (magic cookie) and the
+ * stsz/stsc/stco tables; unknown boxes are skipped without buffering.
+ * Inside mdat, packets are located through the chunk offsets so that
+ * interleaved non-audio data (cover art, chapters) is stepped over.
+ *
+ * Bitstream: follows Apple's open-source ALAC reference decoder
+ * (ALACDecoder.cpp, ag_dec.c, dp_dec.c, matrix_dec.c). Each channel
+ * element is decoded into per-channel planes at the source bit depth;
+ * SampleConverter then interleaves and MSB-aligns them.
+ */
+
+#include "AlacDecoder.h"
+#include "LogLevel.h"
+#include "SampleConverter.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Element tags (3 bits)
+constexpr uint32_t ID_SCE = 0;  // single channel element
+constexpr uint32_t ID_CPE = 1;  // channel pair element
+constexpr uint32_t ID_CCE = 2;  // coupling channel element (unused)
+constexpr uint32_t ID_LFE = 3;
+constexpr uint32_t ID_DSE = 4;  // data stream element
+constexpr uint32_t ID_PCE = 5;  // program config element (unused)
+constexpr uint32_t ID_FIL = 6;  // fill element
+constexpr uint32_t ID_END = 7;
+
+constexpr uint32_t MAX_CHANNELS = 8;
+constexpr uint32_t MAX_FRAME_LENGTH = 65536;
+constexpr size_t MAX_MOOV_BYTES = 64 * 1024 * 1024;
+constexpr size_t PACKET_PADDING = 8;  // BitReader loads 8 bytes at a time
+
+// Element order → output channel position (ALAC layouts to WAV order)
+constexpr uint8_t CHANNEL_OFFSETS[MAX_CHANNELS][MAX_CHANNELS] = {
+    { 0 },
+    { 0, 1 },
+    { 2, 0, 1 },
+    { 2, 0, 1, 3 },
+    { 2, 0, 1, 3, 4 },
+    { 2, 0, 1, 4, 5, 3 },
+    { 2, 0, 1, 4, 5, 6, 3 },
+    { 2, 6, 7, 0, 1, 4, 5, 3 },
+};
+
+// Adaptive Golomb parameters (ag_dec.c)
+constexpr uint32_t QBSHIFT = 9;
+constexpr uint32_t QB = 1u << QBSHIFT;
+constexpr uint32_t MMULSHIFT = 2;
+constexpr uint32_t MDENSHIFT = QBSHIFT - MMULSHIFT - 1;
+constexpr uint32_t MOFF = 1u << (MDENSHIFT - 2);
+constexpr uint32_t BITOFF = 24;
+constexpr uint32_t MAX_PREFIX = 9;
+constexpr uint32_t MAX_RUN_BITS = 16;
+constexpr uint32_t N_MAX_MEAN_CLAMP = 0xffff;
+constexpr uint32_t N_MEAN_CLAMP_VAL = 0xffff;
+
+constexpr uint32_t fourcc(const char (&s)[5]) {
+    return (uint32_t(uint8_t(s[0])) << 24) | (uint32_t(uint8_t(s[1])) << 16) |
+           (uint32_t(uint8_t(s[2])) << 8) | uint32_t(uint8_t(s[3]));
+}
+
+uint16_t readBE16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+uint32_t readBE32(const uint8_t* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+}
+
+uint64_t readBE64(const uint8_t* p) {
+    return (uint64_t(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+uint32_t countLeadingZeros(uint32_t v) {
+    return v ? static_cast<uint32_t>(__builtin_clz(v)) : 32;
+}
+
+inline int32_t signOf(int32_t v) {
+    return (v > 0) - (v < 0);
+}
+
+// Sign-extend the low bits of v (1..32)
+inline int32_t signExtend(uint32_t v, uint32_t bits) {
+    const uint32_t shift = 32 - bits;
+    return static_cast<int32_t>(v << shift) >> shift;
+}
+
+// ============================================
+// MP4 boxes
+// ============================================
+
+// Call fn(type, body, bodyLen) for each box in [p, p + len)
+template <typename Fn>
+void walkBoxes(const uint8_t* p, size_t len, Fn&& fn) {
+    size_t off = 0;
+    while (len - off >= 8) {
+        uint64_t size = readBE32(p + off);
+        uint32_t type = readBE32(p + off + 4);
+        size_t headerLen = 8;
+        if (size == 1) {
+            if (len - off < 16) return;
+            size = readBE64(p + off + 8);
+            headerLen = 16;
+        } else if (size == 0) {
+            size = len - off;
+        }
+        if (size < headerLen || size > len - off) return;
+        fn(type, p + off + headerLen, static_cast<size_t>(size - headerLen));
+        off += static_cast<size_t>(size);
+    }
+}
+
+void parseCookie(const uint8_t* p, AlacDecoder::Track& t) {
+    AlacDecoder::Config& c = t.config;
+    c.frameLength = readBE32(p);
+    c.bitDepth = p[5];
+    c.pb = p[6];
+    c.mb = p[7];
+    c.kb = p[8];
+    c.numChannels = p[9];
+    c.maxFrameBytes = readBE32(p + 12);
+    c.sampleRate = readBE32(p + 20);
+    t.isAlac = true;
+}
+
+void parseStsd(const uint8_t* p, size_t len, AlacDecoder::Track& t) {
+    if (len < 16 || readBE32(p + 4) == 0) return;
+    size_t entrySize = readBE32(p + 8);
+    if (readBE32(p + 12) != fourcc("alac") || entrySize < 8 || entrySize > len - 8) return;
+
+    // Audio sample entry: 8 bytes of SampleEntry, then 20 bytes of
+    // AudioSampleEntry (QuickTime v1/v2 descriptions are longer)
+    const uint8_t* entry = p + 16;
+    size_t entryLen = entrySize - 8;
+    if (entryLen < 28) return;
+    size_t fixed = 28;
+    uint16_t version = readBE16(entry + 8);
+    if (version == 1) fixed += 16;
+    else if (version == 2) fixed += 36;
+    if (entryLen < fixed) return;
+
+    walkBoxes(entry + fixed, entryLen - fixed, [&](uint32_t type, const uint8_t* b, size_t n) {
+        if (type != fourcc("alac") || t.isAlac) return;
+        if (n >= 28) parseCookie(b + 4, t);  // full box: version/flags first
+        else if (n >= 24) parseCookie(b, t);
+    });
+}
+
+void parseTrackBox(const uint8_t* p, size_t len, AlacDecoder::Track& t) {
+    walkBoxes(p, len, [&](uint32_t type, const uint8_t* b, size_t n) {
+        switch (type) {
+            case fourcc("mdia"):
+            case fourcc("minf"):
+            case fourcc("stbl"):
+                parseTrackBox(b, n, t);
+                break;
+            case fourcc("mdhd"):
+                if (n >= 32 && b[0] == 1) {
+                    t.timescale = readBE32(b + 20);
+                    t.duration = readBE64(b + 24);
+                } else if (n >= 20) {
+                    t.timescale = readBE32(b + 12);
+                    t.duration = readBE32(b + 16);
+                }
+                break;
+            case fourcc("stsd"):
+                parseStsd(b, n, t);
+                break;
+            case fourcc("stsz"): {
+                if (n < 12) break;
+                t.uniformSize = readBE32(b + 4);
+                t.sampleCount = readBE32(b + 8);
+                if (t.uniformSize != 0 || n - 12 < size_t(t.sampleCount) * 4) break;
+                t.sizes.resize(t.sampleCount);
+                for (uint32_t i = 0; i < t.sampleCount; i++) t.sizes[i] = readBE32(b + 12 + i * 4);
+                break;
+            }
+            case fourcc("stco"):
+            case fourcc("co64"): {
+                if (n < 8) break;
+                uint32_t count = readBE32(b + 4);
+                size_t width = (type == fourcc("co64")) ? 8 : 4;
+                if (n - 8 < size_t(count) * width) break;
+                t.chunkOffsets.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    const uint8_t* e = b + 8 + i * width;
+                    t.chunkOffsets[i] = (width == 8) ? readBE64(e) : readBE32(e);
+                }
+                break;
+            }
+            case fourcc("stsc"): {
+                if (n < 8) break;
+                uint32_t count = readBE32(b + 4);
+                if (n - 8 < size_t(count) * 12) break;
+                t.chunkRuns.resize(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    t.chunkRuns[i] = { readBE32(b + 8 + i * 12), readBE32(b + 12 + i * 12) };
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    });
+}
+
+// First ALAC track of a moov box
+AlacDecoder::Track parseMoov(const uint8_t* p, size_t len) {
+    AlacDecoder::Track result;
+    walkBoxes(p, len, [&](uint32_t type, const uint8_t* b, size_t n) {
+        if (type != fourcc("trak") || result.isAlac) return;
+        AlacDecoder::Track t;
+        parseTrackBox(b, n, t);
+        if (t.isAlac) result = std::move(t);
+    });
+    return result;
+}
+
+// ============================================
+// Prediction (dp_dec.c)
+// ============================================
+
+// Adaptive FIR over samples j >= taps + 1. TAPS > 0 fixes the order at
+// compile time for the common 4- and 8-tap predictors.
+template <uint32_t TAPS>
+void predictTail(const int32_t* pc, int32_t* out, uint32_t num, int16_t* coefs,
+                 uint32_t numActive, uint32_t chanBits, uint32_t denShift) {
+    const int32_t taps = static_cast<int32_t>(TAPS ? TAPS : numActive);
+    const uint32_t denHalf = denShift ? 1u << (denShift - 1) : 0;
+
+    for (uint32_t j = static_cast<uint32_t>(taps) + 1; j < num; j++) {
+        const int32_t* pout = out + j - 1;
+        const int32_t top = out[j - taps - 1];
+
+        uint32_t sum = 0;
+        for (int32_t k = 0; k < taps; k++) {
+            sum += static_cast<uint32_t>(coefs[k]) *
+                   (static_cast<uint32_t>(pout[-k]) - static_cast<uint32_t>(top));
+        }
+
+        int32_t del = pc[j];
+        int32_t del0 = del;
+        int32_t sg = signOf(del);
+        int32_t pred = static_cast<int32_t>(sum + denHalf) >> denShift;
+        out[j] = signExtend(static_cast<uint32_t>(del) + static_cast<uint32_t>(top) +
+                            static_cast<uint32_t>(pred), chanBits);
+
+        // Nudge the coefficients towards the residual's sign, oldest tap
+        // first, until the residual is accounted for
+        if (sg > 0) {
+            for (int32_t k = taps - 1; k >= 0; k--) {
+                int32_t dd = static_cast<int32_t>(static_cast<uint32_t>(top) -
+                                                  static_cast<uint32_t>(pout[-k]));
+                int32_t sgn = signOf(dd);
+                coefs[k] -= sgn;
+                del0 -= (taps - k) * ((sgn * dd) >> denShift);
+                if (del0 <= 0) break;
+            }
+        } else if (sg < 0) {
+            for (int32_t k = taps - 1; k >= 0; k--) {
+                int32_t dd = static_cast<int32_t>(static_cast<uint32_t>(top) -
+                                                  static_cast<uint32_t>(pout[-k]));
+                int32_t sgn = signOf(dd);
+                coefs[k] += sgn;
+                del0 -= (taps - k) * ((-sgn * dd) >> denShift);
+                if (del0 >= 0) break;
+            }
+        }
+    }
+}
+
+// Undo the adaptive FIR predictor: residuals pc → samples out (may alias
+// for numActive 0 / 31). coefs are adapted in place.
+void unpredict(const int32_t* pc, int32_t* out, uint32_t num, int16_t* coefs,
+               uint32_t numActive, uint32_t chanBits, uint32_t denShift) {
+    if (num == 0) return;
+    out[0] = pc[0];
+
+    if (numActive == 0) {
+        if (num > 1 && out != pc) std::memcpy(out + 1, pc + 1, (num - 1) * sizeof(int32_t));
+        return;
+    }
+
+    // Warm-up (all of the frame for the numActive 31 first-order mode)
+    uint32_t warmUp = (numActive == 31) ? num : std::min(numActive + 1, num);
+    for (uint32_t j = 1; j < warmUp; j++) {
+        out[j] = signExtend(static_cast<uint32_t>(pc[j]) + static_cast<uint32_t>(out[j - 1]),
+                            chanBits);
+    }
+    if (warmUp == num) return;
+
+    switch (numActive) {
+        case 4: predictTail<4>(pc, out, num, coefs, numActive, chanBits, denShift); break;
+        case 8: predictTail<8>(pc, out, num, coefs, numActive, chanBits, denShift); break;
+        default: predictTail<0>(pc, out, num, coefs, numActive, chanBits, denShift); break;
+    }
+}
+
+} // namespace
+
+// ============================================
+// Bit reader
+// ============================================
+
+// MSB-first reader over a packet followed by PACKET_PADDING readable bytes
+class AlacDecoder::BitReader {
+public:
+    BitReader(const uint8_t* data, size_t bytes) : m_data(data), m_bytes(bytes) {}
+
+    /// Next 32 bits, MSB-aligned (zeros past the end)
+    uint32_t peek32() const {
+        size_t byte = m_pos >> 3;
+        if (byte >= m_bytes) return 0;
+        uint64_t w;
+        std::memcpy(&w, m_data + byte, sizeof(w));
+        w = __builtin_bswap64(w) << (m_pos & 7);
+        return static_cast<uint32_t>(w >> 32);
+    }
+
+    uint32_t read(uint32_t bits) {
+        if (bits == 0) return 0;
+        uint32_t v = peek32() >> (32 - bits);
+        m_pos += bits;
+        return v;
+    }
+
+    void skip(size_t bits) { m_pos += bits; }
+    void byteAlign() { m_pos = (m_pos + 7) & ~size_t(7); }
+    bool overrun() const { return m_pos > m_bytes * 8; }
+
+    /**
+     * Adaptive Golomb code: a unary prefix, then k bits, or escapeBits raw
+     * bits after MAX_PREFIX ones (dyn_get / dyn_get_32bit)
+     */
+    uint32_t readGolomb(uint32_t m, uint32_t k, uint32_t escapeBits) {
+        uint32_t prefix = countLeadingZeros(~peek32());
+        if (prefix >= MAX_PREFIX) {
+            skip(MAX_PREFIX);
+            return read(escapeBits);
+        }
+        skip(prefix + 1);
+        uint32_t result = prefix * m;
+        if (k > 1) {
+            uint32_t v = peek32() >> (32 - k);
+            if (v >= 2) {
+                result += v - 1;
+                skip(k);
+            } else {
+                skip(k - 1);
+            }
+        }
+        return result;
+    }
+
+    /// Residuals of one channel (dyn_decomp): adaptive Golomb with zero runs
+    bool readResiduals(int32_t* out, uint32_t num, uint32_t chanBits,
+                       uint32_t pb, uint32_t mb, uint32_t kb) {
+        const uint32_t wb = (1u << kb) - 1;
+        uint32_t zmode = 0;
+        uint32_t c = 0;
+        while (c < num) {
+            if (overrun()) return false;
+
+            uint32_t k = std::min(31 - countLeadingZeros((mb >> QBSHIFT) + 3), kb);
+            uint32_t n = readGolomb((1u << k) - 1, k, chanBits);
+
+            // Zig-zag: even → positive, odd → negative
+            uint32_t v = n + zmode;
+            out[c++] = (v & 1) ? -static_cast<int32_t>((v + 1) >> 1) : static_cast<int32_t>(v >> 1);
+
+            mb = pb * (n + zmode) + mb - ((pb * mb) >> QBSHIFT);
+            if (n > N_MAX_MEAN_CLAMP) mb = N_MEAN_CLAMP_VAL;
+            zmode = 0;
+
+            // Low history: a run of zeros follows
+            if ((mb << MMULSHIFT) < QB && c < num) {
+                zmode = 1;
+                k = countLeadingZeros(mb) - BITOFF + ((mb + MOFF) >> MDENSHIFT);
+                n = readGolomb(((1u << k) - 1) & wb, k, MAX_RUN_BITS);
+                if (n > num - c) return false;
+                std::fill_n(out + c, n, 0);
+                c += n;
+                if (n >= 65535) zmode = 0;
+                mb = 0;
+            }
+        }
+        return !overrun();
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_bytes;
+    size_t m_pos = 0;
+};
+
+// ============================================
+// Decoder
+// ============================================
+
+AlacDecoder::AlacDecoder() = default;
+
+size_t AlacDecoder::feed(const uint8_t* data, size_t len) {
+    m_input.append(data, len);
+    return len;
+}
+
+void AlacDecoder::setEof() {
+    m_eof = true;
+}
+
+bool AlacDecoder::parseBoxes() {
+    while (!m_error) {
+        if (m_state == State::SKIP) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(m_skip, m_input.available()));
+            m_input.consume(n);
+            m_skip -= n;
+            if (m_skip > 0) break;
+            m_state = State::BOXES;
+        }
+
+        size_t avail = m_input.available();
+        if (avail < 8) break;
+        const uint8_t* h = m_input.peek(std::min<size_t>(avail, 16));
+        uint64_t size = readBE32(h);
+        uint32_t type = readBE32(h + 4);
+        size_t headerLen = 8;
+        if (size == 1) {
+            if (avail < 16) break;
+            size = readBE64(h + 8);
+            headerLen = 16;
+        }
+        if (size != 0 && size < headerLen) {
+            LOG_ERROR("[ALAC] Invalid MP4 box size " << size);
+            m_error = true;
+            return false;
+        }
+
+        if (type == fourcc("mdat")) {
+            if (!m_haveTrack) {
+                // moov at the end of the file: needs a seek we cannot do
+                LOG_ERROR("[ALAC] mdat before moov — file is not streamable");
+                m_error = true;
+                return false;
+            }
+            m_input.consume(headerLen);
+            if (!m_useOffsets) m_nextPos = m_input.readPosition();
+            m_state = State::MDAT;
+            return true;
+        }
+
+        if (type == fourcc("moov")) {
+            if (size == 0 || size > MAX_MOOV_BYTES) {
+                LOG_ERROR("[ALAC] Unsupported moov size " << size);
+                m_error = true;
+                return false;
+            }
+            if (avail < size) break;
+            const uint8_t* moov = m_input.peek(static_cast<size_t>(size));
+            m_track = parseMoov(moov + headerLen, static_cast<size_t>(size) - headerLen);
+            m_input.consume(static_cast<size_t>(size));
+            if (!startTrack()) {
+                m_error = true;
+                return false;
+            }
+            m_haveTrack = true;
+            continue;
+        }
+
+        // ftyp, free, udta, ... (size 0 runs to the end of the file)
+        m_input.consume(headerLen);
+        m_skip = (size == 0) ? UINT64_MAX : size - headerLen;
+        m_state = State::SKIP;
+    }
+
+    if (m_eof && !m_error) {
+        if (m_haveTrack) {
+            m_state = State::DONE;
+        } else {
+            LOG_ERROR("[ALAC] No ALAC track found");
+            m_error = true;
+        }
+    }
+    return false;
+}
+
+bool AlacDecoder::startTrack() {
+    const Config& cfg = m_track.config;
+    if (!m_track.isAlac) {
+        LOG_ERROR("[ALAC] No ALAC track in moov");
+        return false;
+    }
+    if (cfg.frameLength == 0 || cfg.frameLength > MAX_FRAME_LENGTH ||
+        cfg.numChannels == 0 || cfg.numChannels > MAX_CHANNELS ||
+        cfg.sampleRate == 0 || cfg.kb == 0 || cfg.kb > 23 ||
+        (cfg.bitDepth != 16 && cfg.bitDepth != 20 && cfg.bitDepth != 24 && cfg.bitDepth != 32)) {
+        LOG_ERROR("[ALAC] Unsupported config: " << cfg.sampleRate << " Hz, "
+                  << int(cfg.bitDepth) << "-bit, " << int(cfg.numChannels)
+                  << " ch, frame length " << cfg.frameLength);
+        return false;
+    }
+    if (m_track.sampleCount == 0 ||
+        (m_track.uniformSize == 0 && m_track.sizes.size() != m_track.sampleCount)) {
+        LOG_ERROR("[ALAC] Missing or truncated sample size table");
+        return false;
+    }
+
+    // Chunk tables are optional for sequential mdat layouts
+    m_useOffsets = !m_track.chunkOffsets.empty() && !m_track.chunkRuns.empty() &&
+        std::none_of(m_track.chunkRuns.begin(), m_track.chunkRuns.end(),
+                     [](const Track::ChunkRun& r) { return r.samplesPerChunk == 0; });
+    m_packet = 0;
+    m_chunk = 0;
+    m_inChunk = 0;
+    m_runIndex = 0;
+    m_nextPos = m_useOffsets ? m_track.chunkOffsets[0] : 0;
+
+    m_predictor.resize(cfg.frameLength);
+    m_mixU.resize(cfg.frameLength);
+    m_mixV.resize(cfg.frameLength);
+    m_shiftBuf.resize(size_t(cfg.frameLength) * 2);
+    m_planes.resize(size_t(cfg.frameLength) * cfg.numChannels);
+
+    m_format.sampleRate = cfg.sampleRate;
+    m_format.bitDepth = cfg.bitDepth;
+    m_format.channels = cfg.numChannels;
+    m_format.totalSamples = (m_track.timescale == cfg.sampleRate) ? m_track.duration : 0;
+    m_formatReady = true;
+
+    LOG_INFO("[ALAC] Format: " << cfg.sampleRate << " Hz, " << int(cfg.bitDepth)
+             << "-bit, " << int(cfg.numChannels) << " ch, "
+             << m_track.sampleCount << " packets of " << cfg.frameLength << " frames");
+    return true;
+}
+
+uint32_t AlacDecoder::packetSize() const {
+    return m_track.uniformSize ? m_track.uniformSize : m_track.sizes[m_packet];
+}
+
+void AlacDecoder::advancePacket(uint32_t size) {
+    m_packet++;
+    m_nextPos += size;
+    if (!m_useOffsets) return;
+
+    const auto& runs = m_track.chunkRuns;
+    if (++m_inChunk < runs[m_runIndex].samplesPerChunk) return;
+
+    // Next chunk (stsc first_chunk is 1-based)
+    m_inChunk = 0;
+    m_chunk++;
+    while (m_runIndex + 1 < runs.size() && runs[m_runIndex + 1].firstChunk <= m_chunk + 1) {
+        m_runIndex++;
+    }
+    if (m_chunk < m_track.chunkOffsets.size()) {
+        m_nextPos = m_track.chunkOffsets[m_chunk];
+    }
+}
+
+size_t AlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
+    if (m_error || m_finished) return 0;
+
+    while (m_state != State::DONE &&
+           (!m_formatReady || m_output.available() / m_format.channels < maxFrames)) {
+        if (m_state != State::MDAT && !parseBoxes()) break;
+
+        if (m_packet >= m_track.sampleCount) {
+            m_state = State::DONE;  // trailing boxes are of no interest
+            break;
+        }
+
+        // Step over anything between packets (other tracks, padding)
+        uint64_t pos = m_input.readPosition();
+        if (pos < m_nextPos) {
+            m_input.consume(static_cast<size_t>(
+                std::min<uint64_t>(m_nextPos - pos, m_input.available())));
+            if (m_input.readPosition() < m_nextPos) {
+                if (m_eof) m_state = State::DONE;
+                break;
+            }
+        } else if (pos > m_nextPos) {
+            LOG_WARN("[ALAC] Chunk offset " << m_nextPos << " behind stream position "
+                     << pos << ", reading packets sequentially");
+            m_useOffsets = false;
+            m_nextPos = pos;
+        }
+
+        // Escape-coded samples are at most 41 bits each, plus headers
+        uint32_t size = packetSize();
+        if (size > m_track.config.frameLength * m_track.config.numChannels * 6u + 1024) {
+            LOG_ERROR("[ALAC] Packet " << m_packet << " too large (" << size << " bytes)");
+            m_error = true;
+            break;
+        }
+        if (m_input.available() < size) {
+            if (m_eof) {
+                LOG_WARN("[ALAC] Stream truncated at packet " << m_packet);
+                m_state = State::DONE;
+            }
+            break;
+        }
+
+        if (m_packetBuf.size() < size + PACKET_PADDING) {
+            m_packetBuf.resize(size + PACKET_PADDING);
+        }
+        std::memcpy(m_packetBuf.data(), m_input.peek(size), size);
+        std::memset(m_packetBuf.data() + size, 0, PACKET_PADDING);
+        m_input.consume(size);
+
+        uint32_t frames = 0;
+        if (decodePacket(m_packetBuf.data(), size, frames)) {
+            const size_t channels = m_format.channels;
+            const int32_t* planes[MAX_CHANNELS];
+            for (size_t ch = 0; ch < channels; ch++) {
+                planes[ch] = m_planes.data() + ch * m_track.config.frameLength;
+            }
+            int32_t* dst = m_output.prepare(frames * channels);
+            SampleConverter::interleaveS32(planes, channels, frames,
+                                           32 - m_format.bitDepth, dst);
+            m_output.commit(frames * channels);
+        } else {
+            LOG_WARN("[ALAC] Corrupt packet " << m_packet << " skipped");
+        }
+        advancePacket(size);
+    }
+
+    if (!m_formatReady) return 0;
+
+    size_t framesToCopy = std::min(m_output.available() / m_format.channels, maxFrames);
+    if (framesToCopy > 0) {
+        m_output.read(out, framesToCopy * m_format.channels);
+        m_decodedSamples += framesToCopy;
+    }
+    if (m_state == State::DONE && m_output.empty()) {
+        m_finished = true;
+    }
+    return framesToCopy;
+}
+
+bool AlacDecoder::decodePacket(const uint8_t* data, size_t len, uint32_t& frames) {
+    BitReader br(data, len);
+    const uint32_t channels = m_track.config.numChannels;
+    uint32_t channel = 0;
+    frames = 0;
+
+    while (!br.overrun()) {
+        uint32_t tag = br.read(3);
+        switch (tag) {
+            case ID_SCE:
+            case ID_LFE:
+            case ID_CPE: {
+                uint32_t n = (tag == ID_CPE) ? 2 : 1;
+                if (channel + n > channels) return false;
+                if (!decodeElement(br, n, channel, frames)) return false;
+                channel += n;
+                if (channel == channels) return true;
+                break;
+            }
+            case ID_DSE: {
+                br.skip(4);  // element instance tag
+                bool align = br.read(1);
+                uint32_t count = br.read(8);
+                if (count == 255) count += br.read(8);
+                if (align) br.byteAlign();
+                br.skip(size_t(count) * 8);
+                break;
+            }
+            case ID_FIL: {
+                uint32_t count = br.read(4);
+                if (count == 15) count += br.read(8) - 1;
+                br.skip(size_t(count) * 8);
+                break;
+            }
+            case ID_END:
+                return false;  // before all channels were seen
+            default:
+                return false;  // CCE / PCE: never produced by encoders
+        }
+    }
+    return false;
+}
+
+bool AlacDecoder::decodeElement(BitReader& br, uint32_t channels, uint32_t firstChannel,
+                                uint32_t& frames) {
+    const Config& cfg = m_track.config;
+
+    br.skip(4);  // element instance tag
+    if (br.read(12) != 0) return false;
+    uint32_t header = br.read(4);
+    bool partialFrame = header & 8;
+    uint32_t bytesShifted = (header >> 1) & 3;
+    bool escape = header & 1;
+    if (bytesShifted == 3 || bytesShifted * 8 >= cfg.bitDepth) return false;
+
+    uint32_t shift = bytesShifted * 8;
+    uint32_t chanBits = cfg.bitDepth - shift + (channels - 1);
+
+    // Every element of a packet carries the same frame count
+    uint32_t numSamples = partialFrame ? br.read(32) : cfg.frameLength;
+    if (numSamples > cfg.frameLength || (firstChannel > 0 && numSamples != frames)) {
+        return false;
+    }
+    frames = numSamples;
+
+    int32_t* mix[2] = { m_mixU.data(), m_mixV.data() };
+    uint32_t mixBits = 0;
+    int32_t mixRes = 0;
+
+    if (!escape) {
+        mixBits = br.read(8);
+        mixRes = static_cast<int8_t>(br.read(8));
+        if (mixBits > 31 || chanBits > 32) return false;
+
+        struct {
+            uint32_t mode;
+            uint32_t denShift;
+            uint32_t pbFactor;
+            uint32_t numCoefs;
+            int16_t coefs[32];
+        } params[2];
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            uint32_t b = br.read(8);
+            params[ch].mode = b >> 4;
+            params[ch].denShift = b & 15;
+            b = br.read(8);
+            params[ch].pbFactor = b >> 5;
+            params[ch].numCoefs = b & 31;
+            for (uint32_t k = 0; k < params[ch].numCoefs; k++) {
+                params[ch].coefs[k] = static_cast<int16_t>(br.read(16));
+            }
+        }
+
+        // Shifted-off low bytes sit between the header and the residuals
+        BitReader shiftBits = br;
+        if (bytesShifted) br.skip(size_t(shift) * channels * numSamples);
+
+        for (uint32_t ch = 0; ch < channels; ch++) {
+            const auto& p = params[ch];
+            if (!br.readResiduals(m_predictor.data(), numSamples, chanBits,
+                                  (cfg.pb * p.pbFactor) / 4, cfg.mb, cfg.kb)) {
+                return false;
+            }
+            int16_t coefs[32];
+            std::copy_n(p.coefs, p.numCoefs, coefs);
+            if (p.mode != 0) {
+                // Mode 15: first-order pass before the coded predictor
+                unpredict(m_predictor.data(), m_predictor.data(), numSamples, nullptr, 31,
+                          chanBits, 0);
+            }
+            unpredict(m_predictor.data(), mix[ch], numSamples, coefs, p.numCoefs,
+                      chanBits, p.denShift);
+        }
+
+        if (bytesShifted) {
+            uint32_t* sb = m_shiftBuf.data();
+            for (size_t i = 0; i < size_t(numSamples) * channels; i++) {
+                sb[i] = shiftBits.read(shift);
+            }
+        }
+    } else {
+        // Verbatim samples, interleaved within the element
+        chanBits = cfg.bitDepth;
+        for (uint32_t i = 0; i < numSamples; i++) {
+            for (uint32_t ch = 0; ch < channels; ch++) {
+                mix[ch][i] = signExtend(br.read(chanBits), chanBits);
+            }
+        }
+        shift = 0;
+    }
+    if (br.overrun()) return false;
+
+    // Unmix the pair and restore the low bytes into the output planes
+    const uint8_t* offsets = CHANNEL_OFFSETS[cfg.numChannels - 1];
+    int32_t* out0 = m_planes.data() + size_t(offsets[firstChannel]) * cfg.frameLength;
+    const uint32_t* sb = m_shiftBuf.data();
+
+    if (channels == 1) {
+        for (uint32_t i = 0; i < numSamples; i++) {
+            uint32_t v = static_cast<uint32_t>(mix[0][i]);
+            out0[i] = static_cast<int32_t>(shift ? (v << shift) | sb[i] : v);
+        }
+        return true;
+    }
+
+    int32_t* out1 = m_planes.data() + size_t(offsets[firstChannel + 1]) * cfg.frameLength;
+    for (uint32_t i = 0; i < numSamples; i++) {
+        int32_t u = mix[0][i];
+        int32_t v = mix[1][i];
+        uint32_t l = static_cast<uint32_t>(u);
+        uint32_t r = static_cast<uint32_t>(v);
+        if (mixRes != 0) {
+            l = static_cast<uint32_t>(u) + static_cast<uint32_t>(v) -
+                static_cast<uint32_t>((int64_t(mixRes) * v) >> mixBits);
+            r = l - static_cast<uint32_t>(v);
+        }
+        if (shift) {
+            l = (l << shift) | sb[2 * i];
+            r = (r << shift) | sb[2 * i + 1];
+        }
+        out0[i] = static_cast<int32_t>(l);
+        out1[i] = static_cast<int32_t>(r);
+    }
+    return true;
+}
+
+void AlacDecoder::flush() {
+    m_input.clear();
+    m_output.clear();
+    m_eof = false;
+    m_state = State::BOXES;
+    m_skip = 0;
+    m_track = Track{};
+    m_haveTrack = false;
+    m_packet = 0;
+    m_chunk = 0;
+    m_inChunk = 0;
+    m_runIndex = 0;
+    m_nextPos = 0;
+    m_useOffsets = true;
+    m_format = {};
+    m_formatReady = false;
+    m_error = false;
+    m_finished = false;
+    m_decodedSamples = 0;
+}
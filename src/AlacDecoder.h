@@ -0,0 +1,119 @@
+/**
+ * @file AlacDecoder.h
+ * @brief Native Apple Lossless (ALAC) decoder for MP4/M4A streams
+ *
+ * No external dependency: a small streaming MP4 demuxer plus a port of
+ * Apple's reference ALAC bitstream decoder (adaptive Golomb residuals,
+ * adaptive FIR predictor, stereo unmixing).
+ *
+ * - feed() queues the file as LMS sends it
+ * - readDecoded() walks the top-level boxes, takes the 'alac' magic cookie
+ *   and sample tables from moov, then decodes mdat packet by packet
+ *
+ * The moov box must precede mdat (iTunes and LMS-served files do); a
+ * trailing moov cannot be reached without seeking and is reported as an
+ * error. Output is S32_LE interleaved, MSB-aligned.
+ */
+
+#ifndef SLIM2DIRETTA_ALAC_DECODER_H
+#define SLIM2DIRETTA_ALAC_DECODER_H
+
+#include "Decoder.h"
+#include "SampleQueue.h"
+#include "InputQueue.h"
+
+#include <cstdint>
+#include <vector>
+
+class AlacDecoder : public Decoder {
+public:
+    AlacDecoder();
+    ~AlacDecoder() override = default;
+
+    size_t feed(const uint8_t* data, size_t len) override;
+    void setEof() override;
+    size_t readDecoded(int32_t* out, size_t maxFrames) override;
+    bool isFormatReady() const override { return m_formatReady; }
+    DecodedFormat getFormat() const override { return m_format; }
+    bool isFinished() const override { return m_finished; }
+    bool hasError() const override { return m_error; }
+    uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
+    void flush() override;
+
+    /// ALACSpecificConfig ('alac' magic cookie)
+    struct Config {
+        uint32_t frameLength = 0;
+        uint8_t bitDepth = 0;
+        uint8_t pb = 0;          // Rice history multiplier
+        uint8_t mb = 0;          // Rice initial history
+        uint8_t kb = 0;          // Rice parameter limit
+        uint8_t numChannels = 0;
+        uint32_t maxFrameBytes = 0;
+        uint32_t sampleRate = 0;
+    };
+
+    /// Sample tables of the ALAC track (moov/trak/mdia/minf/stbl)
+    struct Track {
+        bool isAlac = false;
+        Config config;
+        uint32_t uniformSize = 0;             // stsz sample_size (0: use sizes)
+        uint32_t sampleCount = 0;
+        std::vector<uint32_t> sizes;
+        std::vector<uint64_t> chunkOffsets;   // stco / co64
+        struct ChunkRun { uint32_t firstChunk; uint32_t samplesPerChunk; };
+        std::vector<ChunkRun> chunkRuns;      // stsc
+        uint32_t timescale = 0;
+        uint64_t duration = 0;
+    };
+
+private:
+    enum class State { BOXES, SKIP, MDAT, DONE };
+
+    class BitReader;
+
+    // MP4 container
+    bool parseBoxes();
+    bool startTrack();
+    void advancePacket(uint32_t size);
+    uint32_t packetSize() const;
+
+    // ALAC bitstream
+    bool decodePacket(const uint8_t* data, size_t len, uint32_t& frames);
+    bool decodeElement(BitReader& br, uint32_t channels, uint32_t firstChannel,
+                       uint32_t& frames);
+
+    InputQueue m_input;
+    bool m_eof = false;
+
+    SampleQueue m_output;
+
+    State m_state = State::BOXES;
+    uint64_t m_skip = 0;        // bytes left of a skipped box
+    Track m_track;
+    bool m_haveTrack = false;
+
+    // Packet iteration over the sample tables
+    uint32_t m_packet = 0;      // next packet index
+    uint32_t m_chunk = 0;       // chunk of the next packet
+    uint32_t m_inChunk = 0;     // packets already read from that chunk
+    uint32_t m_runIndex = 0;    // stsc entry covering m_chunk
+    uint64_t m_nextPos = 0;     // absolute offset of the next packet
+    bool m_useOffsets = true;
+
+    // Decode scratch (sized from the cookie)
+    std::vector<uint8_t> m_packetBuf;
+    std::vector<int32_t> m_predictor;
+    std::vector<int32_t> m_mixU;
+    std::vector<int32_t> m_mixV;
+    std::vector<uint32_t> m_shiftBuf;
+    std::vector<int32_t> m_planes;       // one frameLength plane per output channel
+
+    DecodedFormat m_format;
+    bool m_formatReady = false;
+    bool m_error = false;
+    bool m_finished = false;
+    uint64_t m_decodedSamples = 0;
+};
+
+#endif // SLIM2DIRETTA_ALAC_DECODER_H
@@ -0,0 +1,103 @@
+/**
+ * @file AllocCounter.cpp
+ * @brief Counting replacement of the global operator new/delete
+ */
+
+#include "AllocCounter.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Constant-initialised: safe to touch from operator new at any point,
+// including static initialisation and thread teardown
+thread_local bool t_counting = false;
+thread_local uint64_t t_allocations = 0;
+
+void* allocate(std::size_t size) {
+    if (t_counting) t_allocations++;
+    if (size == 0) size = 1;
+    while (true) {
+        if (void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t align) {
+    if (t_counting) t_allocations++;
+    std::size_t alignment = static_cast<std::size_t>(align);
+    if (alignment < sizeof(void*)) alignment = sizeof(void*);
+    if (size == 0) size = 1;
+    while (true) {
+        void* p = nullptr;
+        if (posix_memalign(&p, alignment, size) == 0) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+void* allocateOrThrow(std::size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* allocateAlignedOrThrow(std::size_t size, std::align_val_t align) {
+    if (void* p = allocateAligned(size, align)) return p;
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void AllocCounter::begin() {
+    t_allocations = 0;
+    t_counting = true;
+}
+
+uint64_t AllocCounter::end() {
+    t_counting = false;
+    return t_allocations;
+}
+
+bool AllocCounter::active() {
+    return t_counting;
+}
+
+// ============================================
+// Global operator new/delete (all forms: the defaults would mix allocators)
+// ============================================
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return allocateAlignedOrThrow(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return allocateAlignedOrThrow(size, align);
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, align);
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocateAligned(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
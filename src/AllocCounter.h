@@ -0,0 +1,32 @@
+/**
+ * @file AllocCounter.h
+ * @brief Per-thread count of C++ heap allocations
+ *
+ * Replaces the global operator new/delete with malloc/free wrappers that
+ * count allocations made by the calling thread between begin() and end().
+ * The audio thread opens a window at each gapless chain point and closes
+ * it at the next track's first push, so the track-boundary statistic sees
+ * every new/make_shared/vector growth in between — including ones inside
+ * decoder backends — not just the ones main.cpp knows about.
+ *
+ * C allocations (malloc from libFLAC, mpg123, FFmpeg...) are not seen.
+ */
+
+#ifndef SLIM2DIRETTA_ALLOC_COUNTER_H
+#define SLIM2DIRETTA_ALLOC_COUNTER_H
+
+#include <cstdint>
+
+class AllocCounter {
+public:
+    /** @brief Start counting this thread's allocations (resets the count) */
+    static void begin();
+
+    /** @brief Stop counting; returns the allocations since begin() */
+    static uint64_t end();
+
+    /** @brief True between begin() and end() on this thread */
+    static bool active();
+};
+
+#endif // SLIM2DIRETTA_ALLOC_COUNTER_H
@@ -0,0 +1,152 @@
+/**
+ * @file CodecLoader.cpp
+ * @brief On-demand codec library loading implementation
+ */
+
+#include "CodecLoader.h"
+#include "LogLevel.h"
+
+#ifdef ENABLE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+#endif
+
+#include <dlfcn.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct LibraryFile {
+    std::vector<std::string> sonames;   // tried in order
+};
+
+struct LibraryInfo {
+    const char* name;
+    std::vector<LibraryFile> files;     // all must load
+    std::vector<const char*> symbols;   // everything the decoders call
+};
+
+// Sonames of the ABI the headers describe. FFmpeg's major versions come
+// from the headers we built against; a mismatched libavcodec would not be
+// ABI-compatible anyway.
+const LibraryInfo& info(CodecLoader::Library lib) {
+    static const LibraryInfo table[CodecLoader::LIBRARY_COUNT] = {
+        { "libmpg123",
+          { { { "libmpg123.so.0" } } },
+          { "mpg123_init", "mpg123_new", "mpg123_delete", "mpg123_open_feed",
+            "mpg123_close", "mpg123_feed", "mpg123_read", "mpg123_getformat",
+            "mpg123_format_none", "mpg123_format", "mpg123_strerror",
+            "mpg123_plain_strerror" } },
+        { "libvorbisfile",
+          { { { "libvorbisfile.so.3" } } },
+          { "ov_open_callbacks", "ov_clear", "ov_info", "ov_read", "ov_read_float" } },
+        { "fdk-aac",
+          { { { "libfdk-aac.so.2", "libfdk-aac.so.1" } } },
+          { "aacDecoder_Open", "aacDecoder_Close", "aacDecoder_SetParam",
+            "aacDecoder_Fill", "aacDecoder_DecodeFrame", "aacDecoder_GetStreamInfo" } },
+        { "libavcodec",
+#ifdef ENABLE_FFMPEG
+          { { { "libavutil.so." + std::to_string(LIBAVUTIL_VERSION_MAJOR) } },
+            { { "libavcodec.so." + std::to_string(LIBAVCODEC_VERSION_MAJOR) } } },
+#else
+          {},
+#endif
+          { "avcodec_version", "avcodec_find_decoder", "avcodec_get_name",
+            "avcodec_alloc_context3", "avcodec_free_context", "avcodec_open2",
+            "avcodec_send_packet", "avcodec_receive_frame", "av_parser_init",
+            "av_parser_parse2", "av_parser_close", "av_packet_alloc",
+            "av_packet_free", "av_frame_alloc", "av_frame_free", "av_frame_unref",
+            "av_channel_layout_default", "av_channel_layout_copy",
+            "av_channel_layout_uninit", "av_get_sample_fmt_name", "av_strerror" } },
+    };
+    return table[lib];
+}
+
+enum class LoadState { NOT_TRIED, LOADED, FAILED };
+
+std::mutex s_mutex;
+LoadState s_state[CodecLoader::LIBRARY_COUNT] = {};
+std::vector<void*> s_handles[CodecLoader::LIBRARY_COUNT];
+
+// Open one file of a library; empty error on success
+void* openFile(const LibraryFile& file, std::string& error) {
+    for (const auto& soname : file.sonames) {
+        if (void* handle = dlopen(soname.c_str(), RTLD_NOW | RTLD_LOCAL)) {
+            return handle;
+        }
+        const char* err = dlerror();
+        if (error.empty() && err) error = err;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+bool CodecLoader::load(Library lib) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_state[lib] != LoadState::NOT_TRIED) {
+        return s_state[lib] == LoadState::LOADED;
+    }
+
+    const LibraryInfo& li = info(lib);
+    std::vector<void*> handles;
+    std::string error;
+
+    if (li.files.empty()) {
+        error = "not available in this build";
+    }
+    for (const auto& file : li.files) {
+        void* handle = openFile(file, error);
+        if (!handle) break;
+        handles.push_back(handle);
+        error.clear();
+    }
+    if (error.empty()) {
+        for (const char* sym : li.symbols) {
+            bool found = false;
+            for (void* handle : handles) {
+                if (dlsym(handle, sym)) {
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                error = std::string("symbol ") + sym + " not found";
+                break;
+            }
+        }
+    }
+
+    if (!error.empty()) {
+        for (void* handle : handles) dlclose(handle);
+        s_state[lib] = LoadState::FAILED;
+        LOG_ERROR("[Codec] Cannot load " << li.name << ": " << error
+                  << " — install the library or rebuild with it linked");
+        return false;
+    }
+
+    s_handles[lib] = std::move(handles);
+    s_state[lib] = LoadState::LOADED;
+    LOG_INFO("[Codec] Loaded " << li.name);
+    return true;
+}
+
+bool CodecLoader::failed(Library lib) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    return s_state[lib] == LoadState::FAILED;
+}
+
+const char* CodecLoader::name(Library lib) {
+    return info(lib).name;
+}
+
+void* CodecLoader::symbol(Library lib, const char* sym) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (void* handle : s_handles[lib]) {
+        if (void* p = dlsym(handle, sym)) return p;
+    }
+    return nullptr;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file CodecLoader.h
+ * @brief On-demand loading of the optional codec libraries (dlopen)
+ *
+ * Built with -DENABLE_DLOPEN_CODECS=ON, the binary does not link libmpg123,
+ * libvorbisfile, fdk-aac or libavcodec/libavutil. Decoder::create() calls
+ * load() the first time a format needs one; an instance that only plays
+ * FLAC never maps them, and the dynamic linker has nothing to resolve for
+ * them before main().
+ *
+ * The decoder sources keep calling the library API by name: each one maps
+ * the functions it uses through CODEC_SYMBOL, which resolves the symbol on
+ * the first call at that site and caches the pointer. The type comes from
+ * the library header, so a prototype mismatch is a compile error.
+ */
+
+#ifndef SLIM2DIRETTA_CODEC_LOADER_H
+#define SLIM2DIRETTA_CODEC_LOADER_H
+
+class CodecLoader {
+public:
+    enum Library {
+        MPG123,         // MP3
+        VORBISFILE,     // Ogg Vorbis
+        FDKAAC,         // AAC
+        FFMPEG,         // --decoder ffmpeg (libavutil + libavcodec)
+        LIBRARY_COUNT
+    };
+
+    /**
+     * @brief Load a codec library and check every symbol the decoders use
+     * @return false if it is missing or incomplete (logged once, not retried)
+     *
+     * Thread-safe; cheap once the library is loaded.
+     */
+    static bool load(Library lib);
+
+    /// load() has been tried for lib and failed (never loads anything itself)
+    static bool failed(Library lib);
+
+    /// Library name for messages ("libmpg123")
+    static const char* name(Library lib);
+
+    /// Symbol address in a loaded library (nullptr if absent)
+    static void* symbol(Library lib, const char* sym);
+};
+
+/// Call-site replacement for a library function (library must be loaded)
+#define CODEC_SYMBOL(lib, fn) \
+    ([] { \
+        static const auto ptr = reinterpret_cast<decltype(&fn)>(CodecLoader::symbol(lib, #fn)); \
+        return ptr; \
+    }())
+
+#endif // SLIM2DIRETTA_CODEC_LOADER_H
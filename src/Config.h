@@ -31,6 +31,7 @@ struct Config {
     std::string cpuAudio;               // Core(s) for SDK worker + Diretta hot path
     std::string cpuDecode;              // Core(s) for the audio/decode thread (HTTP→decode→push)
     std::string cpuOther;               // Core(s) for main + slimproto threads
+    std::string cpuFlac;                // Core(s) for parallel FLAC decode workers
 
     // Buffer configuration (0 = use built-in defaults from DirettaSync)
     // Note: slim2Diretta receives audio from LMS locally, no remote-specific variant.
@@ -38,11 +39,28 @@ struct Config {
     float dsdBufferSeconds = 0.0f;         // DSD buffer size in seconds
     unsigned int pcmPrefillMs = 0;         // PCM prefill duration in ms
     unsigned int dsdPrefillMs = 0;         // DSD prefill duration in ms
+    unsigned int memoryBudgetMB = 0;       // Ring + decode cache + DSD buffer cap (0 = unlimited)
 
     // Audio
     int maxSampleRate = 1536000;
-    bool dsdEnabled = true;
-    std::string decoderBackend = "native";  // "native" or "ffmpeg"
+    bool dsdEnabled = true;                 // false: convert DSD to PCM (--no-dsd)
+    std::string decoderBackend = "native";  // "native", "ffmpeg" or "auto"
+    std::string decoderCacheFile;           // --decoder auto results (empty = default path)
+    unsigned int flacThreads = 0;           // Parallel FLAC workers at high rates (0/1 = serial)
+    bool resample = false;                  // Resample PCM rates the target rejects
+    unsigned int resampleTaps = 0;          // Resampler filter length per phase (0 = default)
+    unsigned int outputLatencyMs = 0;       // Diretta output delay after the ring (sync groups)
+
+    // Network
+    std::string ioEngine = "auto";          // Socket receive: "auto", "uring" or "socket"
+    int stallTimeoutMs = 3000;              // Range-resume a stream starved this long (0 = off)
+    unsigned int stallMinRateKB = 16;       // ... or receiving below this many KB/s (0 = off)
+    int stallRetries = 3;                   // Reconnects per stall before giving up
+    unsigned int spoolMB = 0;               // Read-ahead spool file per stream (0 = off)
+    std::string spoolDir = "/var/tmp";      // Where spool files go (tmpfs or disk)
+    unsigned int paceMargin = 0;            // Pace HTTP reads at consumption + this % (0 = off)
+    std::string streamBind;                 // HTTP socket interface or source IP ("" = any)
+    std::string controlBind;                // Slimproto socket interface or source IP ("" = any)
 
     // Logging
     bool verbose = false;
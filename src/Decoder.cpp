@@ -5,6 +5,7 @@
 
 #include "Decoder.h"
 #include "FlacDecoder.h"
+#include "AlacDecoder.h"
 #include "PcmDecoder.h"
 #include "SlimprotoMessages.h"
 #include "LogLevel.h"
@@ -21,16 +22,85 @@
 #ifdef ENABLE_FFMPEG
 #include "FfmpegDecoder.h"
 #endif
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+#endif
+
+#include <map>
+
+namespace {
+// Per-format choice for "auto" (written once at startup, read-only after)
+std::map<char, std::string> s_autoBackends;
+
+#ifdef ENABLE_DLOPEN_CODECS
+// Library a decoder needs before it can be constructed; false if none
+bool codecLibrary(char formatCode, bool ffmpeg, CodecLoader::Library& lib) {
+    if (ffmpeg) {
+        lib = CodecLoader::FFMPEG;
+        return true;
+    }
+    switch (formatCode) {
+#ifdef ENABLE_MP3
+        case FORMAT_MP3: lib = CodecLoader::MPG123;     return true;
+#endif
+#ifdef ENABLE_OGG
+        case FORMAT_OGG: lib = CodecLoader::VORBISFILE; return true;
+#endif
+#ifdef ENABLE_AAC
+        case FORMAT_AAC: lib = CodecLoader::FDKAAC;     return true;
+#endif
+        default:         return false;
+    }
+}
+#endif
+
+// Library a decoder needs is loaded (always true when the codec libraries
+// are linked). probe: only report a failed earlier load, load nothing
+bool codecAvailable(char formatCode, bool ffmpeg, bool probe = false) {
+#ifdef ENABLE_DLOPEN_CODECS
+    CodecLoader::Library lib;
+    if (!codecLibrary(formatCode, ffmpeg, lib)) return true;
+    return probe ? !CodecLoader::failed(lib) : CodecLoader::load(lib);
+#else
+    (void)formatCode;
+    (void)ffmpeg;
+    (void)probe;
+    return true;
+#endif
+}
+
+// Compressed formats the FFmpeg backend takes (see create())
+bool ffmpegFormat(char formatCode) {
+    return formatCode != FORMAT_DSD && formatCode != FORMAT_PCM && formatCode != FORMAT_ALAC;
+}
+} // namespace
+
+void Decoder::setAutoBackend(char formatCode, const std::string& backend) {
+    s_autoBackends[formatCode] = backend;
+}
+
+std::string Decoder::autoBackend(char formatCode) {
+    auto it = s_autoBackends.find(formatCode);
+    return it != s_autoBackends.end() ? it->second : "native";
+}
 
 std::unique_ptr<Decoder> Decoder::create(char formatCode,
                                           const std::string& backend) {
+    if (backend == "auto") {
+        return create(formatCode, autoBackend(formatCode));
+    }
+
 #ifdef ENABLE_FFMPEG
     // FFmpeg backend handles compressed formats (FLAC, MP3, AAC, OGG).
     // PCM uses native decoder (parses WAV/AIFF headers for true sample rate).
-    // DSD is raw bitstream — not decoded.
-    if (backend == "ffmpeg" && formatCode != FORMAT_DSD && formatCode != FORMAT_PCM) {
-        LOG_DEBUG("[Decoder] Using FFmpeg backend for format '" << formatCode << "'");
-        return std::make_unique<FfmpegDecoder>(formatCode);
+    // ALAC stays native: it needs the MP4 demuxer, which the parser-only
+    // FFmpeg path does not have. DSD is raw bitstream — not decoded.
+    if (backend == "ffmpeg" && ffmpegFormat(formatCode)) {
+        if (codecAvailable(formatCode, true)) {
+            LOG_DEBUG("[Decoder] Using FFmpeg backend for format '" << formatCode << "'");
+            return std::make_unique<FfmpegDecoder>(formatCode);
+        }
+        LOG_WARN("[Decoder] FFmpeg backend unavailable — using native");
     }
 #else
     if (backend == "ffmpeg") {
@@ -38,11 +108,17 @@ std::unique_ptr<Decoder> Decoder::create(char formatCode,
     }
 #endif
 
+    if (!codecAvailable(formatCode, false)) {
+        return nullptr;
+    }
+
     switch (formatCode) {
         case FORMAT_FLAC:
             return std::make_unique<FlacDecoder>();
         case FORMAT_PCM:
             return std::make_unique<PcmDecoder>();
+        case FORMAT_ALAC:
+            return std::make_unique<AlacDecoder>();
 #ifdef ENABLE_MP3
         case FORMAT_MP3:
             return std::make_unique<Mp3Decoder>();
@@ -60,3 +136,37 @@ std::unique_ptr<Decoder> Decoder::create(char formatCode,
             return nullptr;
     }
 }
+
+bool Decoder::available(char formatCode, const std::string& backend) {
+    if (backend == "auto") {
+        return available(formatCode, autoBackend(formatCode));
+    }
+
+#ifdef ENABLE_FFMPEG
+    // Codecs FfmpegDecoder maps (create() would also hand it others)
+    const bool ffmpegCodec = formatCode == FORMAT_FLAC || formatCode == FORMAT_MP3 ||
+                             formatCode == FORMAT_OGG || formatCode == FORMAT_AAC;
+    if (backend == "ffmpeg" && ffmpegCodec && codecAvailable(formatCode, true, true)) {
+        return true;
+    }
+#endif
+
+    switch (formatCode) {
+        case FORMAT_FLAC:
+        case FORMAT_PCM:
+        case FORMAT_ALAC:
+            return true;
+#ifdef ENABLE_MP3
+        case FORMAT_MP3:
+#endif
+#ifdef ENABLE_OGG
+        case FORMAT_OGG:
+#endif
+#ifdef ENABLE_AAC
+        case FORMAT_AAC:
+#endif
+            return codecAvailable(formatCode, false, true);
+        default:
+            return false;
+    }
+}
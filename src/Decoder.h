@@ -74,6 +74,14 @@ public:
      */
     virtual uint64_t getDecodedSamples() const = 0;
 
+    /**
+     * @brief Bytes moved inside the decoder's output buffer since flush()
+     *
+     * Reported with the stream stats. Decoders that write straight into
+     * the caller's buffer have nothing to move.
+     */
+    virtual uint64_t getOutputBytesMoved() const { return 0; }
+
     /**
      * @brief Reset decoder state for new stream
      */
@@ -91,14 +99,54 @@ public:
         (void)sampleRate; (void)bitDepth; (void)channels; (void)bigEndian;
     }
 
+    /**
+     * @brief Bytes per sample readPassthrough() delivers (0 = not supported)
+     *
+     * Uncompressed sources can hand out their samples without the S32
+     * round trip. Only PcmDecoder implements this; valid once the format
+     * is ready.
+     */
+    virtual int getPassthroughBytesPerSample() const { return 0; }
+
+    /**
+     * @brief Read frames in the source's own packed little-endian layout
+     *
+     * Same stream position as readDecoded() — a caller may alternate
+     * between the two. Big-endian sources are byte-swapped only.
+     * @param out Output buffer (maxFrames * channels * bytes per sample)
+     * @return Number of frames written (0 = need more input)
+     */
+    virtual size_t readPassthrough(uint8_t* out, size_t maxFrames) {
+        (void)out; (void)maxFrames;
+        return 0;
+    }
+
     /**
      * @brief Create decoder for the given Slimproto format code
      * @param formatCode 'f' = FLAC, 'p' = PCM (WAV/AIFF), 'a' = AAC, etc.
-     * @param backend "native" (default) or "ffmpeg" for FFmpeg-based decoding
+     * @param backend "native" (default), "ffmpeg" for FFmpeg-based decoding,
+     *        or "auto" for the backend chosen by setAutoBackend()
      * @return Decoder instance, or nullptr for unsupported formats
      */
     static std::unique_ptr<Decoder> create(char formatCode,
                                             const std::string& backend = "native");
+
+    /**
+     * @brief Whether create() can make a decoder for formatCode
+     *
+     * Codec libraries loaded on demand count as available until a load has
+     * failed; nothing is loaded here.
+     */
+    static bool available(char formatCode, const std::string& backend = "native");
+
+    /**
+     * @brief Backend that "auto" resolves to for formatCode
+     *
+     * Set at startup (DecoderBenchmark), before any decoder is created.
+     * Formats without an entry use "native".
+     */
+    static void setAutoBackend(char formatCode, const std::string& backend);
+    static std::string autoBackend(char formatCode);
 };
 
 #endif // SLIM2DIRETTA_DECODER_H
@@ -0,0 +1,259 @@
+/**
+ * @file DecoderBenchmark.cpp
+ * @brief Backend microbenchmark and cache implementation
+ */
+
+#include "DecoderBenchmark.h"
+#include "Decoder.h"
+#include "SlimprotoMessages.h"
+#include "LogLevel.h"
+
+#include <FLAC/format.h>
+#include <FLAC/stream_encoder.h>
+
+#ifdef ENABLE_FFMPEG
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+#endif
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace {
+
+// Test stream: 4 s of 96 kHz / 24-bit stereo, the typical hi-res case
+constexpr uint32_t BENCH_RATE = 96000;
+constexpr uint32_t BENCH_BITS = 24;
+constexpr uint32_t BENCH_CHANNELS = 2;
+constexpr uint32_t BENCH_SECONDS = 4;
+constexpr int BENCH_RUNS = 3;           // best of, against scheduling noise
+constexpr size_t FEED_CHUNK = 65536;    // like HttpStreamClient reads
+constexpr size_t READ_FRAMES = 4096;
+
+struct Format {
+    char code;
+    const char* name;
+};
+
+// Formats with more than one backend and a test stream we can build
+constexpr Format BENCH_FORMATS[] = {
+    { FORMAT_FLAC, "FLAC" },
+};
+
+const char* const BACKENDS[] = {
+    "native",
+#ifdef ENABLE_FFMPEG
+    "ffmpeg",
+#endif
+};
+
+FLAC__StreamEncoderWriteStatus collectBytes(const FLAC__StreamEncoder*, const FLAC__byte buffer[],
+                                            size_t bytes, uint32_t, uint32_t, void* clientData) {
+    auto* out = static_cast<std::vector<uint8_t>*>(clientData);
+    out->insert(out->end(), buffer, buffer + bytes);
+    return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+}
+
+// Two tones plus low-level noise: compresses like music rather than
+// like silence or white noise
+std::vector<uint8_t> makeFlacStream() {
+    std::vector<uint8_t> out;
+    FLAC__StreamEncoder* enc = FLAC__stream_encoder_new();
+    if (!enc) return out;
+
+    const uint64_t totalFrames = uint64_t(BENCH_RATE) * BENCH_SECONDS;
+    FLAC__stream_encoder_set_channels(enc, BENCH_CHANNELS);
+    FLAC__stream_encoder_set_bits_per_sample(enc, BENCH_BITS);
+    FLAC__stream_encoder_set_sample_rate(enc, BENCH_RATE);
+    FLAC__stream_encoder_set_compression_level(enc, 5);
+    FLAC__stream_encoder_set_total_samples_estimate(enc, totalFrames);
+
+    if (FLAC__stream_encoder_init_stream(enc, collectBytes, nullptr, nullptr, nullptr, &out)
+            != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
+        FLAC__stream_encoder_delete(enc);
+        return out;
+    }
+
+    const double fullScale = double(1 << (BENCH_BITS - 1)) - 1;
+    const double twoPi = 6.283185307179586;
+    uint32_t noise = 1;
+    std::vector<FLAC__int32> block(READ_FRAMES * BENCH_CHANNELS);
+    bool ok = true;
+    for (uint64_t frame = 0; ok && frame < totalFrames; frame += READ_FRAMES) {
+        size_t n = static_cast<size_t>(std::min<uint64_t>(READ_FRAMES, totalFrames - frame));
+        for (size_t i = 0; i < n; i++) {
+            double t = double(frame + i) / BENCH_RATE;
+            for (uint32_t ch = 0; ch < BENCH_CHANNELS; ch++) {
+                noise = noise * 1664525u + 1013904223u;
+                double v = 0.4 * std::sin(twoPi * (440.0 + 110.0 * ch) * t) +
+                           0.2 * std::sin(twoPi * 1870.0 * t) +
+                           0.002 * (double(noise >> 8) / double(1 << 24) - 0.5);
+                block[i * BENCH_CHANNELS + ch] = static_cast<FLAC__int32>(v * fullScale);
+            }
+        }
+        ok = FLAC__stream_encoder_process_interleaved(enc, block.data(), static_cast<uint32_t>(n));
+    }
+    ok = FLAC__stream_encoder_finish(enc) && ok;
+    FLAC__stream_encoder_delete(enc);
+    if (!ok) out.clear();
+    return out;
+}
+
+std::vector<uint8_t> makeStream(char code) {
+    switch (code) {
+        case FORMAT_FLAC: return makeFlacStream();
+        default:          return {};
+    }
+}
+
+// Seconds to decode stream once, the way the audio thread does (chunked
+// feed, drained as it goes); < 0 if the backend failed
+double timeDecode(char code, const std::string& backend, const std::vector<uint8_t>& stream,
+                  uint64_t& frames) {
+    auto decoder = Decoder::create(code, backend);
+    if (!decoder) return -1.0;
+
+    std::vector<int32_t> out(READ_FRAMES * BENCH_CHANNELS);
+    frames = 0;
+    size_t fed = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (!decoder->isFinished() && !decoder->hasError()) {
+        if (fed < stream.size()) {
+            size_t n = std::min(FEED_CHUNK, stream.size() - fed);
+            fed += decoder->feed(stream.data() + fed, n);
+            if (fed == stream.size()) decoder->setEof();
+        }
+        size_t got;
+        bool progress = false;
+        while ((got = decoder->readDecoded(out.data(), READ_FRAMES)) > 0) {
+            frames += got;
+            progress = true;
+        }
+        if (!progress && fed == stream.size() && !decoder->isFinished()) break;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (decoder->hasError() || frames == 0) return -1.0;
+    return seconds;
+}
+
+// Cache key: the binary plus the codec libraries it loaded
+std::string cacheKey(const std::string& buildId) {
+    std::ostringstream key;
+    key << buildId << " libFLAC " << FLAC__VERSION_STRING;
+#if defined(ENABLE_FFMPEG) && defined(ENABLE_DLOPEN_CODECS)
+    if (CodecLoader::load(CodecLoader::FFMPEG)) {
+        key << " libavcodec " << CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_version)();
+    }
+#elif defined(ENABLE_FFMPEG)
+    key << " libavcodec " << avcodec_version();
+#endif
+    return key.str();
+}
+
+} // namespace
+
+std::vector<DecoderBenchmark::Result> DecoderBenchmark::measure() {
+    std::vector<Result> results;
+
+    for (const auto& fmt : BENCH_FORMATS) {
+        std::vector<uint8_t> stream = makeStream(fmt.code);
+        if (stream.empty()) {
+            LOG_WARN("[Decoder] No " << fmt.name << " test stream — auto uses native");
+            continue;
+        }
+        for (const char* backend : BACKENDS) {
+            double best = -1.0;
+            uint64_t frames = 0;
+            for (int run = 0; run < BENCH_RUNS; run++) {
+                double s = timeDecode(fmt.code, backend, stream, frames);
+                if (s < 0) {
+                    best = -1.0;
+                    break;
+                }
+                if (best < 0 || s < best) best = s;
+            }
+            if (best <= 0) {
+                LOG_WARN("[Decoder] " << fmt.name << " benchmark failed with " << backend);
+                continue;
+            }
+            results.push_back({ fmt.code, backend, double(frames) / BENCH_RATE / best });
+        }
+    }
+    return results;
+}
+
+bool DecoderBenchmark::loadCache(const std::string& path, const std::string& key,
+                                 std::vector<Result>& results) {
+    std::ifstream in(path);
+    if (!in) return false;
+
+    std::string line;
+    if (!std::getline(in, line) || line != "key " + key) return false;
+
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Result r{};
+        if (fields >> r.formatCode >> r.backend >> r.realtimeFactor) {
+            results.push_back(r);
+        }
+    }
+    return !results.empty();
+}
+
+void DecoderBenchmark::saveCache(const std::string& path, const std::string& key,
+                                 const std::vector<Result>& results) {
+    // Create the directory if needed (one level — /var/cache exists)
+    size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    out << "key " << key << "\n";
+    for (const auto& r : results) {
+        out << r.formatCode << " " << r.backend << " " << r.realtimeFactor << "\n";
+    }
+    if (!out) {
+        LOG_WARN("[Decoder] Cannot write benchmark cache " << path << " — will re-measure next start");
+    }
+}
+
+void DecoderBenchmark::selectBackends(const std::string& cacheFile, const std::string& buildId) {
+    const bool useCache = !cacheFile.empty() && cacheFile != "none";
+    const std::string key = cacheKey(buildId);
+
+    std::vector<Result> results;
+    bool cached = useCache && loadCache(cacheFile, key, results);
+    if (!cached) {
+        LOG_INFO("[Decoder] Measuring decoder backends for --decoder auto...");
+        results = measure();
+        if (useCache && !results.empty()) saveCache(cacheFile, key, results);
+    }
+
+    for (const auto& fmt : BENCH_FORMATS) {
+        const Result* best = nullptr;
+        std::ostringstream line;
+        line << std::fixed << std::setprecision(0);
+        for (const auto& r : results) {
+            if (r.formatCode != fmt.code) continue;
+            line << (best ? ", " : "") << r.backend << " " << r.realtimeFactor << "x";
+            if (!best || r.realtimeFactor > best->realtimeFactor) best = &r;
+        }
+        if (!best) continue;
+        Decoder::setAutoBackend(fmt.code, best->backend);
+        LOG_INFO("[Decoder] " << fmt.name << " realtime factor: " << line.str()
+                 << " → " << best->backend << (cached ? " (cached)" : ""));
+    }
+}
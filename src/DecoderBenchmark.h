@@ -0,0 +1,47 @@
+/**
+ * @file DecoderBenchmark.h
+ * @brief Per-format backend selection for --decoder auto
+ *
+ * Decodes a built-in test bitstream with every compiled-in backend and
+ * picks the fastest per Slimproto format code (Decoder::setAutoBackend).
+ * Results are cached in a small text file keyed by build and library
+ * versions, so a host measures once and later starts just read it.
+ *
+ * Test streams are generated at startup: FLAC with libFLAC's encoder
+ * (linked anyway). The lossy radio codecs and ALAC have no encoder in
+ * the build (and ALAC no FFmpeg path), so they stay on native.
+ */
+
+#ifndef SLIM2DIRETTA_DECODER_BENCHMARK_H
+#define SLIM2DIRETTA_DECODER_BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+class DecoderBenchmark {
+public:
+    struct Result {
+        char formatCode;
+        std::string backend;
+        double realtimeFactor;  // seconds of audio decoded per second
+    };
+
+    /// Default cache location ("none" disables the cache)
+    static constexpr const char* DEFAULT_CACHE_FILE = "/var/cache/slim2diretta/decoder-bench";
+
+    /**
+     * @brief Measure (or load) and install the per-format auto backends
+     * @param cacheFile Cache path, or "none" to always measure
+     * @param buildId Identifies this binary; a different id re-measures
+     */
+    static void selectBackends(const std::string& cacheFile, const std::string& buildId);
+
+private:
+    static std::vector<Result> measure();
+    static bool loadCache(const std::string& path, const std::string& key,
+                          std::vector<Result>& results);
+    static void saveCache(const std::string& path, const std::string& key,
+                          const std::vector<Result>& results);
+};
+
+#endif // SLIM2DIRETTA_DECODER_BENCHMARK_H
@@ -0,0 +1,49 @@
+/**
+ * @file DecoderPool.cpp
+ * @brief Decoder pool implementation
+ */
+
+#include "DecoderPool.h"
+#include "LogLevel.h"
+
+std::unique_ptr<Decoder> DecoderPool::acquire(char formatCode,
+                                              const std::string& backend) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& e : m_entries) {
+            if (e.decoder && e.formatCode == formatCode && e.backend == backend) {
+                m_reuses.fetch_add(1, std::memory_order_relaxed);
+                LOG_DEBUG("[DecoderPool] Reusing '" << formatCode << "' decoder ("
+                          << backend << ")");
+                // Slot stays in m_entries (empty) so release() never reallocates
+                return std::move(e.decoder);
+            }
+        }
+    }
+
+    auto decoder = Decoder::create(formatCode, backend);
+    if (decoder) {
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return decoder;
+}
+
+void DecoderPool::release(char formatCode, const std::string& backend,
+                          std::unique_ptr<Decoder> decoder) {
+    if (!decoder) return;
+    decoder->flush();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& e : m_entries) {
+        if (e.formatCode == formatCode && e.backend == backend) {
+            e.decoder = std::move(decoder);
+            return;
+        }
+    }
+    m_entries.push_back(Entry{formatCode, backend, std::move(decoder)});
+}
+
+void DecoderPool::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+}
@@ -0,0 +1,65 @@
+/**
+ * @file DecoderPool.h
+ * @brief Reuse of decoder instances across gapless track boundaries
+ *
+ * Album playback chains many tracks of the same codec. Instead of building
+ * a fresh decoder (libFLAC/mpg123 handle, input/output vectors) per track,
+ * finished decoders are flush()ed and parked here, keyed by Slimproto format
+ * code and decoder backend. flush() keeps vector capacity, so a reused
+ * decoder decodes the next track without touching the heap.
+ */
+
+#ifndef SLIM2DIRETTA_DECODER_POOL_H
+#define SLIM2DIRETTA_DECODER_POOL_H
+
+#include "Decoder.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class DecoderPool {
+public:
+    /**
+     * @brief Get a ready-to-use decoder for formatCode/backend
+     *
+     * Returns a parked decoder when one matches, otherwise falls back to
+     * Decoder::create() (counted as a track-boundary allocation).
+     * @return Decoder instance, or nullptr for unsupported formats
+     */
+    std::unique_ptr<Decoder> acquire(char formatCode, const std::string& backend);
+
+    /**
+     * @brief Return a decoder to the pool once its track is finished
+     *
+     * The decoder is flush()ed here. At most one idle decoder is kept per
+     * key — the chaining loop never holds more than one at a time.
+     */
+    void release(char formatCode, const std::string& backend,
+                 std::unique_ptr<Decoder> decoder);
+
+    /// Drop all parked decoders (frees their buffers)
+    void clear();
+
+    /// Decoders built by Decoder::create() (pool misses)
+    uint64_t getAllocations() const { return m_allocations.load(std::memory_order_relaxed); }
+    /// Decoders handed out from the pool (no allocation)
+    uint64_t getReuses() const { return m_reuses.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        char formatCode;
+        std::string backend;
+        std::unique_ptr<Decoder> decoder;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    std::atomic<uint64_t> m_allocations{0};
+    std::atomic<uint64_t> m_reuses{0};
+};
+
+#endif // SLIM2DIRETTA_DECODER_POOL_H
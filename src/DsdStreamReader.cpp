@@ -7,6 +7,8 @@
  *
  * DSF: block-interleaved (already planar per block pair), LSB-first
  * DFF: byte-interleaved (needs de-interleaving), MSB-first
+ *
+ * Data bytes go into a fixed ring; nothing is erased or compacted.
  */
 
 #include "DsdStreamReader.h"
@@ -48,19 +50,31 @@ uint64_t DsdStreamReader::readBE64(const uint8_t* p) {
 // Constructor / flush
 // ============================================================
 
+namespace {
+
+// Smallest ring: room for a couple of HTTP reads plus the header excess
+constexpr size_t MIN_BUFFER_BYTES = 262144;
+
+// DSF block padding is replaced by the DSD idle pattern
+constexpr uint8_t DSD_SILENCE = 0x69;
+
+} // namespace
+
 DsdStreamReader::DsdStreamReader() {
     m_headerBuf.reserve(256);
-    m_dataBuf.reserve(65536);
 }
 
 void DsdStreamReader::flush() {
     m_state = State::DETECT;
     m_headerBuf.clear();
-    m_dataBuf.clear();
-    m_dataBufPos = 0;
+    // Ring storage is kept: the next track usually has the same rate
+    m_readPos = 0;
+    m_writePos = 0;
+    m_blockOffset = 0;
     m_format = DsdFormat{};
     m_formatReady = false;
     m_rawDsdConfigured = false;
+    m_dataBounded = false;
     m_dataRemaining = 0;
     m_totalBytesOutput = 0;
     m_audioBytesPerChannel = 0;
@@ -100,21 +114,44 @@ size_t DsdStreamReader::feed(const uint8_t* data, size_t len) {
         } else if (m_state == State::PARSE_DFF) {
             parseDffHeader();
         }
-    } else if (m_state == State::DATA) {
-        // Append to data buffer, respecting dataRemaining
-        size_t toAdd = len;
-        if (m_dataRemaining > 0 && toAdd > m_dataRemaining) {
-            toAdd = static_cast<size_t>(m_dataRemaining);
-        }
-        m_dataBuf.insert(m_dataBuf.end(), data, data + toAdd);
-        if (m_dataRemaining > 0) {
-            m_dataRemaining -= toAdd;
-        }
+        return len;
     }
 
+    if (m_state == State::DATA) {
+        return appendData(data, len);
+    }
     return len;
 }
 
+size_t DsdStreamReader::appendData(const uint8_t* data, size_t len) {
+    // Bytes past the data chunk (DSF ID3 tag, DFF trailing chunks) are
+    // not audio: accept and drop them
+    size_t audio = len;
+    if (m_dataBounded && audio > m_dataRemaining) {
+        audio = static_cast<size_t>(m_dataRemaining);
+    }
+    size_t n = std::min(audio, freeBytes());
+
+    const size_t cap = m_ring.size();
+    size_t pos = static_cast<size_t>(m_writePos % cap);
+    size_t first = std::min(n, cap - pos);
+    std::memcpy(m_ring.data() + pos, data, first);
+    std::memcpy(m_ring.data(), data + first, n - first);
+    m_writePos += n;
+    if (m_dataBounded) {
+        m_dataRemaining -= n;
+    }
+
+    return (n == audio) ? len : n;
+}
+
+size_t DsdStreamReader::freeBytes() const {
+    if (m_state != State::DATA) {
+        return (m_state == State::DONE || m_state == State::ERROR) ? 0 : SIZE_MAX;
+    }
+    return m_ring.size() - static_cast<size_t>(m_writePos - m_readPos);
+}
+
 void DsdStreamReader::setEof() {
     m_eof = true;
 }
@@ -143,13 +180,11 @@ bool DsdStreamReader::detectContainer() {
     // No known container — check for raw DSD mode
     if (m_rawDsdConfigured) {
         m_formatReady = true;
-        m_dataRemaining = 0;  // Unlimited
-        // Move header bytes to data buffer (they're DSD data)
-        m_dataBuf.insert(m_dataBuf.end(), m_headerBuf.begin(), m_headerBuf.end());
-        m_headerBuf.clear();
-        m_state = State::DATA;
+        m_dataBounded = false;  // Unlimited
         LOG_INFO("[DSD] Raw DSD: " << m_format.sampleRate << " Hz, "
                  << m_format.channels << " ch");
+        // Header bytes are DSD data
+        startData(0);
         return true;
     }
 
@@ -254,6 +289,7 @@ bool DsdStreamReader::parseDsfHeader() {
     m_format.container = DsdFormat::Container::DSF;
     m_format.isLSBFirst = true;
 
+    m_dataBounded = true;
     m_dataRemaining = dataBytes;
     m_audioBytesPerChannel = sampleCount / 8;  // Actual audio (no block padding)
     m_outputBytesPerChannel = 0;
@@ -264,23 +300,7 @@ bool DsdStreamReader::parseDsfHeader() {
              << "block=" << blockSize << ", data=" << dataBytes << " bytes"
              << ", samples/ch=" << sampleCount);
 
-    // Move remaining header bytes to data buffer
-    size_t dataStart = dataChunkOffset + 12;
-    if (m_headerBuf.size() > dataStart) {
-        size_t excess = m_headerBuf.size() - dataStart;
-        size_t toMove = excess;
-        if (m_dataRemaining > 0 && toMove > m_dataRemaining) {
-            toMove = static_cast<size_t>(m_dataRemaining);
-        }
-        m_dataBuf.insert(m_dataBuf.end(),
-                         m_headerBuf.begin() + dataStart,
-                         m_headerBuf.begin() + dataStart + toMove);
-        if (m_dataRemaining > 0) {
-            m_dataRemaining -= toMove;
-        }
-    }
-    m_headerBuf.clear();
-    m_state = State::DATA;
+    startData(dataChunkOffset + 12);
     return true;
 }
 
@@ -415,6 +435,7 @@ bool DsdStreamReader::parseDffHeader() {
     m_format.container = DsdFormat::Container::DFF;
     m_format.isLSBFirst = false;  // DFF is MSB-first
 
+    m_dataBounded = true;
     m_dataRemaining = dataSize;
     m_formatReady = true;
 
@@ -422,122 +443,184 @@ bool DsdStreamReader::parseDffHeader() {
              << sampleRate << " Hz), " << channels << " ch, "
              << "data=" << dataSize << " bytes");
 
-    // Move excess bytes to data buffer
-    if (m_headerBuf.size() > dataStart) {
-        size_t excess = m_headerBuf.size() - dataStart;
-        size_t toMove = excess;
-        if (m_dataRemaining > 0 && toMove > m_dataRemaining) {
-            toMove = static_cast<size_t>(m_dataRemaining);
-        }
-        m_dataBuf.insert(m_dataBuf.end(),
-                         m_headerBuf.begin() + dataStart,
-                         m_headerBuf.begin() + dataStart + toMove);
-        if (m_dataRemaining > 0) {
-            m_dataRemaining -= toMove;
-        }
+    startData(dataStart);
+    return true;
+}
+
+// ============================================================
+// Data ring
+// ============================================================
+
+void DsdStreamReader::startData(size_t dataStart) {
+    m_state = State::DATA;
+    m_readPos = 0;
+    m_writePos = 0;
+    m_blockOffset = 0;
+
+    size_t excess = m_headerBuf.size() > dataStart ? m_headerBuf.size() - dataStart : 0;
+    setBufferCapacity(0);
+    if (excess > m_ring.size()) {
+        setBufferCapacity(excess);
+    }
+    if (excess > 0) {
+        appendData(m_headerBuf.data() + dataStart, excess);
     }
     m_headerBuf.clear();
-    m_state = State::DATA;
-    return true;
+}
+
+void DsdStreamReader::setBufferCapacity(size_t bytes) {
+    const uint64_t byteRate = static_cast<uint64_t>(m_format.sampleRate / 8) * m_format.channels;
+    if (bytes == 0) {
+        bytes = static_cast<size_t>(byteRate * DEFAULT_BUFFER_SECONDS);
+    }
+    bytes = std::max(bytes, MIN_BUFFER_BYTES);
+
+    // Whole DSF block groups (never split across the wrap), or whole
+    // frames for byte-interleaved data
+    size_t unit = m_format.channels > 0 ? m_format.channels : 1;
+    if (m_format.container == DsdFormat::Container::DSF && m_format.blockSizePerChannel > 0) {
+        unit = static_cast<size_t>(m_format.blockSizePerChannel) * unit;
+    }
+    bytes = (bytes + unit - 1) / unit * unit;
+
+    const size_t used = static_cast<size_t>(m_writePos - m_readPos);
+    if (bytes < used) {
+        bytes = (used + unit - 1) / unit * unit;
+    }
+    if (bytes == m_ring.size()) return;
+
+    // Rare: first format, a different rate, or a budget share. Buffered
+    // bytes move to the start; m_readPos is group-aligned, so the groups
+    // stay aligned.
+    std::vector<uint8_t> ring(bytes);
+    if (used > 0) {
+        const size_t cap = m_ring.size();
+        size_t pos = static_cast<size_t>(m_readPos % cap);
+        size_t first = std::min(used, cap - pos);
+        std::memcpy(ring.data(), m_ring.data() + pos, first);
+        std::memcpy(ring.data() + first, m_ring.data(), used - first);
+    }
+    m_ring.swap(ring);
+    m_readPos = 0;
+    m_writePos = used;
 }
 
 // ============================================================
 // Data processing
 // ============================================================
 
-size_t DsdStreamReader::processDsfBlocks(uint8_t* out, size_t maxBytes) {
-    // DSF block structure: [blockSize L][blockSize R][blockSize L][blockSize R]...
-    // One block group = blockSizePerChannel * channels bytes
-    //
-    // DirettaSync expects FULLY planar: [all L bytes][all R bytes]
-    // So we must rearrange: collect all L blocks first, then all R blocks.
+bool DsdStreamReader::hasBlockLayout() const {
+    // sendDsdBlocks() moves 4-byte groups per channel; DSF blocks are
+    // 4096 bytes in practice
+    return m_formatReady && m_format.container == DsdFormat::Container::DSF &&
+           m_format.blockSizePerChannel > 0 && m_format.blockSizePerChannel % 4 == 0;
+}
 
-    uint32_t bs = m_format.blockSizePerChannel;
-    uint32_t ch = m_format.channels;
-    uint32_t blockGroup = bs * ch;
-    if (blockGroup == 0) return 0;
-
-    size_t avail = m_dataBuf.size() - m_dataBufPos;
-    size_t maxGroups = maxBytes / blockGroup;
-    size_t availGroups = avail / blockGroup;
-    size_t groups = std::min(maxGroups, availGroups);
-
-    if (groups == 0) {
-        // At EOF, handle partial last block group
-        if (m_eof && avail > 0 && m_dataRemaining == 0) {
-            size_t bytesPerCh = avail / ch;
-            if (bytesPerCh == 0) return 0;
-            size_t usable = bytesPerCh * ch;
-            if (usable > maxBytes) {
-                bytesPerCh = (maxBytes / ch);
-                usable = bytesPerCh * ch;
-            }
-            if (usable == 0) return 0;
-            std::memcpy(out, m_dataBuf.data() + m_dataBufPos, usable);
-            m_dataBufPos += usable;
-            m_totalBytesOutput += usable;
-            return usable;
+size_t DsdStreamReader::peekBlocks(BlockView& view) {
+    // DSF block structure: [blockSize L][blockSize R][blockSize L][blockSize R]...
+    // One block group = blockSizePerChannel * channels bytes. Within a group
+    // each channel's block is contiguous, so the group is planar as it sits
+    // in the ring (channel stride = block size).
+    view = BlockView{};
+    if (m_state != State::DATA || m_format.container != DsdFormat::Container::DSF) return 0;
+
+    const size_t bs = m_format.blockSizePerChannel;
+    const size_t ch = m_format.channels;
+    const size_t group = bs * ch;
+    if (group == 0) return 0;
+
+    const size_t used = static_cast<size_t>(m_writePos - m_readPos);
+    if (used < group) {
+        // DSF pads the last block, so a partial group means a truncated
+        // stream; its channel layout is unknown and it is dropped
+        bool complete = m_eof || (m_dataBounded && m_dataRemaining == 0);
+        if (complete && used > 0) {
+            LOG_WARN("[DSD] DSF: dropping " << used << " bytes of incomplete block group");
+            m_readPos = m_writePos;
+            m_blockOffset = 0;
         }
+        checkFinished();
         return 0;
     }
 
-    size_t totalBytes = groups * blockGroup;
-    size_t bytesPerCh = groups * bs;
-    const uint8_t* src = m_dataBuf.data() + m_dataBufPos;
-
-    // Rearrange block-interleaved to fully planar:
-    // Input:  [L_blk0][R_blk0][L_blk1][R_blk1]...
-    // Output: [L_blk0][L_blk1]...[R_blk0][R_blk1]...
-    for (size_t g = 0; g < groups; g++) {
-        for (uint32_t c = 0; c < ch; c++) {
-            std::memcpy(out + c * bytesPerCh + g * bs,
-                        src + g * blockGroup + c * bs,
-                        bs);
-        }
-    }
+    uint8_t* base = m_ring.data() + static_cast<size_t>(m_readPos % m_ring.size());
 
     // Replace DSF block padding with DSD silence (0x69).
     // DSF pads the last block of each channel with zeros, but in DSD
     // zeros are NOT silence — they produce an audible click.
     // The idle DSD pattern 0x69 (01101001, LSB-first) is near-silent.
-    if (m_audioBytesPerChannel > 0) {
-        uint64_t prevOutput = m_outputBytesPerChannel;
-        m_outputBytesPerChannel += bytesPerCh;
-        if (m_outputBytesPerChannel > m_audioBytesPerChannel) {
-            // Calculate where real audio ends within this output
-            size_t audioInThis = (m_audioBytesPerChannel > prevOutput)
-                ? static_cast<size_t>(m_audioBytesPerChannel - prevOutput) : 0;
-            // For each channel section, fill padding with DSD silence
-            for (uint32_t c = 0; c < ch; c++) {
-                size_t padOffset = c * bytesPerCh + audioInThis;
-                size_t padLen = bytesPerCh - audioInThis;
-                std::memset(out + padOffset, 0x69, padLen);
-            }
+    if (m_audioBytesPerChannel > 0 && m_outputBytesPerChannel + bs > m_audioBytesPerChannel) {
+        size_t audioInThis = (m_audioBytesPerChannel > m_outputBytesPerChannel)
+            ? static_cast<size_t>(m_audioBytesPerChannel - m_outputBytesPerChannel) : 0;
+        for (size_t c = 0; c < ch; c++) {
+            std::memset(base + c * bs + audioInThis, DSD_SILENCE, bs - audioInThis);
         }
     }
 
-    m_dataBufPos += totalBytes;
-    m_totalBytesOutput += totalBytes;
-    return totalBytes;
+    view.data = base + m_blockOffset;
+    view.channelStride = bs;
+    view.bytesPerChannel = bs - m_blockOffset;
+    return view.bytesPerChannel;
+}
+
+void DsdStreamReader::consumeBlocks(size_t bytesPerChannel) {
+    const size_t bs = m_format.blockSizePerChannel;
+    if (bytesPerChannel == 0 || bs == 0) return;
+
+    bytesPerChannel = std::min(bytesPerChannel, bs - m_blockOffset);
+    m_blockOffset += bytesPerChannel;
+    m_totalBytesOutput += bytesPerChannel * m_format.channels;
+
+    if (m_blockOffset == bs) {
+        m_readPos += bs * m_format.channels;
+        m_outputBytesPerChannel += bs;
+        m_blockOffset = 0;
+    }
+    checkFinished();
+}
+
+size_t DsdStreamReader::processDsfBlocks(uint8_t* out, size_t maxBytes) {
+    // DirettaSync::sendAudio expects planar [all L bytes][all R bytes]:
+    // copy the channel blocks of one group out of the ring
+    BlockView view;
+    size_t n = peekBlocks(view);
+    const uint32_t ch = m_format.channels;
+    n = std::min(n, maxBytes / ch);
+    if (n == 0) return 0;
+
+    for (uint32_t c = 0; c < ch; c++) {
+        std::memcpy(out + c * n, view.channel(c), n);
+    }
+    consumeBlocks(n);
+    return n * ch;
 }
 
 size_t DsdStreamReader::processDffData(uint8_t* out, size_t maxBytes) {
     // DFF data is byte-interleaved: [L0][R0][L1][R1]...
     // Need to de-interleave to planar: [L0L1...][R0R1...]
 
-    size_t avail = m_dataBuf.size() - m_dataBufPos;
+    size_t avail = static_cast<size_t>(m_writePos - m_readPos);
     if (avail == 0) return 0;
 
     uint32_t ch = m_format.channels;
     if (ch == 0) return 0;
 
-    // Ensure byte count is a multiple of channels
-    size_t usable = std::min(avail, maxBytes);
+    // Contiguous span up to the ring end; the ring size is a multiple of
+    // channels, so frames never wrap
+    const size_t cap = m_ring.size();
+    size_t pos = static_cast<size_t>(m_readPos % cap);
+    size_t usable = std::min({avail, maxBytes, cap - pos});
     usable = (usable / ch) * ch;
-    if (usable == 0) return 0;
+    if (usable == 0) {
+        // Trailing partial frame of a finished stream
+        if (m_eof && avail < ch) {
+            m_readPos = m_writePos;
+        }
+        return 0;
+    }
 
-    DsdProcessor::deinterleaveToPlaynar(m_dataBuf.data() + m_dataBufPos, out, usable, ch);
-    m_dataBufPos += usable;
+    DsdProcessor::deinterleaveToPlaynar(m_ring.data() + pos, out, usable, ch);
+    m_readPos += usable;
     m_totalBytesOutput += usable;
     return usable;
 }
@@ -547,6 +630,13 @@ size_t DsdStreamReader::processRawData(uint8_t* out, size_t maxBytes) {
     return processDffData(out, maxBytes);
 }
 
+void DsdStreamReader::checkFinished() {
+    if (m_state == State::DATA && m_eof && availableBytes() == 0) {
+        m_finished = true;
+        m_state = State::DONE;
+    }
+}
+
 // ============================================================
 // readPlanar — main output method
 // ============================================================
@@ -570,18 +660,9 @@ size_t DsdStreamReader::readPlanar(uint8_t* out, size_t maxBytes) {
             break;
     }
 
-    // Compact buffer periodically to prevent unbounded growth
-    if (m_dataBufPos > 131072) {
-        m_dataBuf.erase(m_dataBuf.begin(), m_dataBuf.begin() + m_dataBufPos);
-        m_dataBufPos = 0;
-    }
-
     // Check if we're done
-    if (result == 0 && availableBytes() == 0) {
-        if (m_eof) {
-            m_finished = true;
-            m_state = State::DONE;
-        }
+    if (result == 0) {
+        checkFinished();
     }
 
     return result;
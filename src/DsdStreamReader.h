@@ -10,6 +10,13 @@
  * - DSF: block-interleaved, LSB-first
  * - DFF (DSDIFF): byte-interleaved, MSB-first
  * - Raw DSD: no container, format from strm parameters
+ *
+ * Container data is held in a ring allocated once the format is known,
+ * sized in seconds of audio (DEFAULT_BUFFER_SECONDS, or the memory
+ * budget's share via setBufferCapacity()), and kept across flush() so a
+ * chained track of the same rate reuses it. For DSF the ring holds whole
+ * block groups, and peekBlocks() hands out the channel blocks in place for
+ * DirettaSync::sendDsdBlocks() — no planar copy.
  */
 
 #ifndef SLIM2DIRETTA_DSD_STREAM_READER_H
@@ -33,12 +40,29 @@ struct DsdFormat {
 
 class DsdStreamReader {
 public:
+    /// Built-in buffer size in seconds of audio (2x the DSD prebuffer)
+    static constexpr float DEFAULT_BUFFER_SECONDS = 1.0f;
+
+    /**
+     * @brief DSF channel blocks in the ring: channel c starts at
+     * data + c * channelStride, bytesPerChannel bytes each
+     */
+    struct BlockView {
+        const uint8_t* data = nullptr;
+        size_t channelStride = 0;
+        size_t bytesPerChannel = 0;
+
+        const uint8_t* channel(uint32_t c) const { return data + c * channelStride; }
+    };
+
     DsdStreamReader();
     ~DsdStreamReader() = default;
 
     /**
      * @brief Feed raw container data from HTTP stream
-     * @return Number of bytes consumed (always len — buffered internally)
+     * @return Number of bytes consumed: all of len while parsing headers
+     *         (and for trailing non-audio chunks), at most freeBytes() of
+     *         audio data
      */
     size_t feed(const uint8_t* data, size_t len);
 
@@ -55,6 +79,24 @@ public:
      */
     size_t readPlanar(uint8_t* out, size_t maxBytes);
 
+    /**
+     * @brief True when peekBlocks() can be used (DSF with 4-byte aligned blocks)
+     */
+    bool hasBlockLayout() const;
+
+    /**
+     * @brief Next channel blocks in place (DSF only)
+     * @return bytesPerChannel of the view, 0 if no whole block group is buffered
+     *
+     * Pointers stay valid until the next feed(), consumeBlocks() or flush().
+     */
+    size_t peekBlocks(BlockView& view);
+
+    /**
+     * @brief Mark bytes of each channel's current block as sent
+     */
+    void consumeBlocks(size_t bytesPerChannel);
+
     bool isFormatReady() const { return m_formatReady; }
     const DsdFormat& getFormat() const { return m_format; }
     bool isFinished() const { return m_finished; }
@@ -62,9 +104,27 @@ public:
     uint64_t getTotalBytesOutput() const { return m_totalBytesOutput; }
 
     /**
-     * @brief Get bytes of raw DSD data available for readPlanar
+     * @brief Get bytes of raw DSD data available for readPlanar / peekBlocks
      */
-    size_t availableBytes() const { return m_dataBuf.size() - m_dataBufPos; }
+    size_t availableBytes() const {
+        return static_cast<size_t>(m_writePos - m_readPos) - m_blockOffset * m_format.channels;
+    }
+
+    /**
+     * @brief Bytes feed() accepts as audio data right now (unbounded while
+     *        the container header is parsed)
+     */
+    size_t freeBytes() const;
+
+    /// Ring size in bytes (0 until the format is known)
+    size_t capacity() const { return m_ring.size(); }
+
+    /**
+     * @brief Resize the ring, keeping buffered data (call once the format is ready)
+     * @param bytes New size (0 = DEFAULT_BUFFER_SECONDS at the stream's rate);
+     *              rounded up to whole DSF block groups
+     */
+    void setBufferCapacity(size_t bytes);
 
     /**
      * @brief Set raw DSD format hint from strm parameters (no container)
@@ -72,7 +132,7 @@ public:
     void setRawDsdFormat(uint32_t dsdRate, uint32_t channels);
 
     /**
-     * @brief Reset for new stream
+     * @brief Reset for new stream (keeps the ring allocation)
      */
     void flush();
 
@@ -83,7 +143,12 @@ private:
     bool parseDsfHeader();
     bool parseDffHeader();
 
-    // DSF: block-interleaved → planar (already planar per block pair)
+    // Header → data transition: size the ring, move the bytes after the header
+    void startData(size_t dataStart);
+    size_t appendData(const uint8_t* data, size_t len);
+    void checkFinished();
+
+    // DSF: block-interleaved → planar (one block group at a time)
     size_t processDsfBlocks(uint8_t* out, size_t maxBytes);
     // DFF: byte-interleaved → planar via DsdProcessor
     size_t processDffData(uint8_t* out, size_t maxBytes);
@@ -101,14 +166,19 @@ private:
     // Header accumulation buffer
     std::vector<uint8_t> m_headerBuf;
 
-    // DSD data buffer (raw bytes from container)
-    std::vector<uint8_t> m_dataBuf;
-    size_t m_dataBufPos = 0;  // Read position (avoids costly erase)
+    // DSD data ring (raw bytes from container). Positions are running byte
+    // counts; the ring size is a multiple of the DSF block group, so a
+    // group never wraps.
+    std::vector<uint8_t> m_ring;
+    uint64_t m_readPos = 0;
+    uint64_t m_writePos = 0;
+    size_t m_blockOffset = 0;   // bytes per channel already sent from the current DSF group
 
     DsdFormat m_format;
     bool m_formatReady = false;
     bool m_rawDsdConfigured = false;
 
+    bool m_dataBounded = false;       // container gave a data size (not raw)
     uint64_t m_dataRemaining = 0;     // DSD data bytes remaining in container
     uint64_t m_totalBytesOutput = 0;
     uint64_t m_audioBytesPerChannel = 0;  // Actual audio bytes per channel (no DSF padding)
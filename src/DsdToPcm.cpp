@@ -0,0 +1,391 @@
+/**
+ * @file DsdToPcm.cpp
+ * @brief Table-driven DSD decimation (AVX2 / NEON / scalar)
+ */
+
+#include "DsdToPcm.h"
+#include "SampleConverter.h"
+#include "LogLevel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sched.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define DP_HAS_AVX2 1
+    #define DP_HAS_NEON 0
+    #include <immintrin.h>
+    #define DP_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define DP_HAS_AVX2 0
+    #define DP_HAS_NEON 1
+    #include <arm_neon.h>
+#else
+    #define DP_HAS_AVX2 0
+    #define DP_HAS_NEON 0
+#endif
+
+namespace {
+
+constexpr uint32_t DSD64_RATE = 2822400;
+constexpr uint32_t DSD256_RATE = 4 * DSD64_RATE;
+constexpr uint32_t MAX_PCM_RATE = 352800;
+constexpr uint32_t MIN_PCM_RATE = 44100;
+
+// Filter: passband to a quarter of the output rate, stopband from Nyquist.
+// 120 dB keeps the DSD noise shaper's ultrasonic energy from folding back
+// above the 24-bit floor.
+constexpr double STOPBAND_DB = 120.0;
+constexpr double PASSBAND_FRACTION = 0.25;
+
+// DSD silence pattern (balanced, no DC) to prime the history
+constexpr uint8_t DSD_SILENCE = 0x69;
+
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+// Kaiser-windowed sinc low-pass, DC gain 1. Frequencies relative to fs.
+std::vector<double> designLowpass(double cutoff, double transition) {
+    const double pi = 3.141592653589793;
+    const double beta = 0.1102 * (STOPBAND_DB - 8.7);
+    size_t taps = static_cast<size_t>(
+        std::ceil((STOPBAND_DB - 7.95) / (2.285 * 2.0 * pi * transition))) + 1;
+    taps |= 1;  // odd: integer group delay
+
+    std::vector<double> h(taps);
+    const double mid = 0.5 * static_cast<double>(taps - 1);
+    const double i0beta = besselI0(beta);
+    double sum = 0.0;
+    for (size_t i = 0; i < taps; i++) {
+        double t = static_cast<double>(i) - mid;
+        double x = 2.0 * pi * cutoff * t;
+        double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(x) / (pi * t);
+        double r = t / mid;
+        double w = besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0beta;
+        h[i] = sinc * w;
+        sum += h[i];
+    }
+    for (double& v : h) v /= sum;
+    return h;
+}
+
+// One output sample: sum of one table entry per history byte
+using FirKernel = float (*)(const float* table, const uint8_t* bytes, size_t groups);
+
+float firScalar(const float* table, const uint8_t* bytes, size_t groups) {
+    float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+    for (size_t g = 0; g < groups; g += 4, table += 4 * 256) {
+        a0 += table[bytes[g]];
+        a1 += table[256 + bytes[g + 1]];
+        a2 += table[512 + bytes[g + 2]];
+        a3 += table[768 + bytes[g + 3]];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+#if DP_HAS_AVX2
+// ============================================
+// AVX2
+// ============================================
+
+bool useAvx2() {
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool s_avx2 = __builtin_cpu_supports("avx2");
+    return s_avx2;
+#endif
+}
+
+// 8 groups per gather: lane i reads table[(g + i) * 256 + byte]
+DP_AVX2 float firAvx2(const float* table, const uint8_t* bytes, size_t groups) {
+    const __m256i lane = _mm256_setr_epi32(0, 256, 512, 768, 1024, 1280, 1536, 1792);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t g = 0;
+    for (; g + 16 <= groups; g += 16, table += 16 * 256) {
+        __m256i i0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + g)));
+        __m256i i1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + g + 8)));
+        acc0 = _mm256_add_ps(acc0, _mm256_i32gather_ps(table, _mm256_add_epi32(i0, lane), 4));
+        acc1 = _mm256_add_ps(acc1, _mm256_i32gather_ps(table + 8 * 256, _mm256_add_epi32(i1, lane), 4));
+    }
+    if (g < groups) {
+        __m256i i0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + g)));
+        acc0 = _mm256_add_ps(acc0, _mm256_i32gather_ps(table, _mm256_add_epi32(i0, lane), 4));
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+#if DP_HAS_NEON
+// ============================================
+// NEON
+// ============================================
+
+// No gather: lanes are filled from scalar loads, the adds run 8 wide
+float firNeon(const float* table, const uint8_t* bytes, size_t groups) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t g = 0; g < groups; g += 8, table += 8 * 256) {
+        const uint8_t* b = bytes + g;
+        float lo[4] = { table[b[0]], table[256 + b[1]], table[512 + b[2]], table[768 + b[3]] };
+        float hi[4] = { table[1024 + b[4]], table[1280 + b[5]], table[1536 + b[6]], table[1792 + b[7]] };
+        acc0 = vaddq_f32(acc0, vld1q_f32(lo));
+        acc1 = vaddq_f32(acc1, vld1q_f32(hi));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    return vaddvq_f32(acc);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+#endif
+
+FirKernel firKernel() {
+#if DP_HAS_AVX2
+    if (useAvx2()) return firAvx2;
+#elif DP_HAS_NEON
+    return firNeon;
+#endif
+    return firScalar;
+}
+
+// CPUs the calling thread may run on (workers inherit its affinity)
+int usableCpus() {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 1;
+    return CPU_COUNT(&set);
+}
+
+} // namespace
+
+DsdToPcm::DsdToPcm() = default;
+
+DsdToPcm::~DsdToPcm() {
+    stopWorkers();
+}
+
+uint32_t DsdToPcm::outputRate(uint32_t dsdRate, uint32_t maxRate) {
+    if (dsdRate == 0 || dsdRate % DSD64_RATE != 0) return 0;
+    uint32_t rate = std::min(dsdRate / 32, MAX_PCM_RATE);
+    const uint32_t floor = std::max(dsdRate / 512, MIN_PCM_RATE);
+    while (rate > maxRate && rate / 2 >= floor) {
+        rate /= 2;
+    }
+    return rate;
+}
+
+bool DsdToPcm::matches(uint32_t dsdRate, uint32_t channels, bool lsbFirst, uint32_t pcmRate) const {
+    return dsdRate == m_dsdRate && channels == m_channels &&
+           lsbFirst == m_lsbFirst && pcmRate == m_pcmRate;
+}
+
+bool DsdToPcm::configure(uint32_t dsdRate, uint32_t channels, bool lsbFirst, uint32_t pcmRate) {
+    stopWorkers();
+    m_dsdRate = m_pcmRate = m_channels = 0;
+
+    if (channels == 0 || pcmRate == 0 || dsdRate % pcmRate != 0 ||
+        (dsdRate / pcmRate) % 8 != 0) {
+        LOG_ERROR("[DSD→PCM] Unsupported conversion: " << dsdRate << " Hz DSD to "
+                  << pcmRate << " Hz");
+        return false;
+    }
+
+    const size_t ratio = dsdRate / pcmRate;
+    m_step = ratio / 8;
+
+    // The tables depend only on the ratio and bit order: a new track at
+    // the same rates keeps them
+    if (m_table.empty() || ratio != m_tableRatio || lsbFirst != m_tableLsbFirst) {
+        const double outNyquist = 0.5 / static_cast<double>(ratio);
+        const double passband = PASSBAND_FRACTION / static_cast<double>(ratio);
+        buildTables(designLowpass(0.5 * (passband + outNyquist), outNyquist - passband),
+                    lsbFirst);
+        m_tableRatio = ratio;
+        m_tableLsbFirst = lsbFirst;
+    }
+
+    m_dsdRate = dsdRate;
+    m_channels = channels;
+    m_pcmRate = pcmRate;
+    m_lsbFirst = lsbFirst;
+    m_state.assign(channels, Channel{});
+    m_planes.assign(channels, nullptr);
+    reset();
+
+    if (dsdRate >= DSD256_RATE && channels > 1 && usableCpus() > 1) {
+        startWorkers();
+    }
+
+    LOG_INFO("[DSD→PCM] DSD" << (dsdRate / 44100) << " → " << pcmRate << " Hz / "
+             << OUTPUT_BIT_DEPTH << "-bit, " << filterTaps() << " taps ("
+             << kernelName() << ")"
+             << (m_workers.empty() ? "" : ", one thread per channel"));
+    return true;
+}
+
+void DsdToPcm::buildTables(const std::vector<double>& coeffs, bool lsbFirst) {
+    // Groups of 8 taps, padded with zero taps to a multiple of 8 groups
+    // (one AVX2 gather / two NEON vectors)
+    m_groups = ((coeffs.size() + 7) / 8 + 7) / 8 * 8;
+    m_table.assign(m_groups * 256, 0.0f);
+
+    for (size_t g = 0; g < m_groups; g++) {
+        float* t = &m_table[g * 256];
+        for (int v = 0; v < 256; v++) {
+            double sum = 0.0;
+            for (int k = 0; k < 8; k++) {
+                size_t tap = g * 8 + k;
+                if (tap >= coeffs.size()) break;
+                // Bit k in time order: first bit is the LSB for DSF, the MSB for DFF
+                int bit = lsbFirst ? (v >> k) & 1 : (v >> (7 - k)) & 1;
+                sum += bit ? coeffs[tap] : -coeffs[tap];
+            }
+            t[v] = static_cast<float>(sum);
+        }
+    }
+    m_fir = firKernel();
+}
+
+void DsdToPcm::reset() {
+    if (m_groups == 0) return;
+    // Prime with silence so the first sample is due after one step of input
+    const size_t prime = m_groups - std::min(m_step, m_groups);
+    for (auto& st : m_state) {
+        if (st.history.size() < m_groups * 2) st.history.resize(m_groups * 2);
+        std::memset(st.history.data(), DSD_SILENCE, prime);
+        st.length = prime;
+    }
+}
+
+size_t DsdToPcm::maxFrames(size_t bytesPerChannel) const {
+    return m_step ? bytesPerChannel / m_step + 1 : 0;
+}
+
+size_t DsdToPcm::runChannel(size_t ch, const uint8_t* src, size_t bytes) {
+    Channel& st = m_state[ch];
+    if (st.history.size() < st.length + bytes) st.history.resize(st.length + bytes);
+    std::memcpy(st.history.data() + st.length, src, bytes);
+    st.length += bytes;
+
+    size_t frames = 0;
+    if (st.length >= m_groups) frames = (st.length - m_groups) / m_step + 1;
+    if (st.output.size() < frames) st.output.resize(frames);
+
+    const uint8_t* h = st.history.data();
+    const float* table = m_table.data();
+    float* out = st.output.data();
+    for (size_t i = 0; i < frames; i++, h += m_step) {
+        out[i] = m_fir(table, h, m_groups);
+    }
+
+    // Keep the unconsumed tail (< filter span + step) for the next call
+    size_t used = frames * m_step;
+    std::memmove(st.history.data(), st.history.data() + used, st.length - used);
+    st.length -= used;
+    return frames;
+}
+
+size_t DsdToPcm::process(const uint8_t* data, size_t channelStride, size_t bytesPerChannel,
+                         int32_t* out) {
+    if (m_channels == 0 || bytesPerChannel == 0) return 0;
+
+    size_t frames;
+    if (m_workers.empty()) {
+        frames = runChannel(0, data, bytesPerChannel);
+        for (size_t ch = 1; ch < m_channels; ch++) {
+            runChannel(ch, data + ch * channelStride, bytesPerChannel);
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobData = data;
+            m_jobStride = channelStride;
+            m_jobBytes = bytesPerChannel;
+            m_pending = m_workers.size();
+            m_generation++;
+        }
+        m_workCv.notify_all();
+        frames = runChannel(0, data, bytesPerChannel);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this]() { return m_pending == 0; });
+    }
+
+    // Every channel got the same input, so the same frame count
+    for (size_t ch = 0; ch < m_channels; ch++) {
+        m_planes[ch] = m_state[ch].output.data();
+    }
+    SampleConverter::interleaveFloat(m_planes.data(), m_channels, frames, out);
+    return frames;
+}
+
+// ============================================
+// Channel threads
+// ============================================
+
+void DsdToPcm::startWorkers() {
+    m_stop = false;
+    m_pending = 0;
+    const uint64_t generation = m_generation;
+    for (size_t ch = 1; ch < m_channels; ch++) {
+        m_workers.emplace_back([this, ch, generation]() { workerLoop(ch, generation); });
+    }
+}
+
+void DsdToPcm::stopWorkers() {
+    if (m_workers.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+    for (auto& t : m_workers) {
+        if (t.joinable()) t.join();
+    }
+    m_workers.clear();
+}
+
+void DsdToPcm::workerLoop(size_t ch, uint64_t seen) {
+    while (true) {
+        const uint8_t* src;
+        size_t bytes;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCv.wait(lock, [&]() { return m_stop || m_generation != seen; });
+            if (m_stop) return;
+            seen = m_generation;
+            src = m_jobData + ch * m_jobStride;
+            bytes = m_jobBytes;
+        }
+        runChannel(ch, src, bytes);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_pending == 0) m_doneCv.notify_one();
+        }
+    }
+}
+
+const char* DsdToPcm::kernelName() {
+#if DP_HAS_AVX2
+    return useAvx2() ? "AVX2" : "scalar";
+#elif DP_HAS_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
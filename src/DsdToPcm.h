@@ -0,0 +1,128 @@
+/**
+ * @file DsdToPcm.h
+ * @brief DSD to PCM conversion for targets that cannot play DSD natively
+ *
+ * Used when --no-dsd is set or the Diretta target reports no DSD support:
+ * the DSD path keeps DsdStreamReader and converts its output to 24-bit
+ * PCM for the normal sendAudio() path instead of opening the sink in DSD.
+ *
+ * Decimation is a single linear-phase FIR straight from the 1-bit stream
+ * (DSD64/128/256 → 88.2/176.4/352.8 kHz, DSD512 → 352.8 kHz; lower if
+ * --max-rate asks for it). Each group of 8 taps sees one DSD byte, so the
+ * filter is precomputed into one 256-entry table per group and an output
+ * sample is one table lookup per input byte of the filter span, summed —
+ * no per-bit work. Accumulation uses AVX2 gathers on x86-64 (chosen at
+ * runtime) and NEON on ARM.
+ *
+ * At DSD256 and above, stereo/multichannel streams are converted one
+ * channel per thread when the audio thread may use more than one core.
+ */
+
+#ifndef SLIM2DIRETTA_DSD_TO_PCM_H
+#define SLIM2DIRETTA_DSD_TO_PCM_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class DsdToPcm {
+public:
+    /// PCM output bit depth (samples are S32 MSB-aligned with 24 significant bits)
+    static constexpr uint32_t OUTPUT_BIT_DEPTH = 24;
+
+    DsdToPcm();
+    ~DsdToPcm();
+
+    DsdToPcm(const DsdToPcm&) = delete;
+    DsdToPcm& operator=(const DsdToPcm&) = delete;
+
+    /**
+     * @brief PCM rate for a DSD rate: DSD rate / 32, at most 352.8 kHz
+     * and halved until it fits maxRate (not below DSD rate / 512)
+     * @return 0 if the DSD rate is not a multiple of 44.1 kHz × 64
+     */
+    static uint32_t outputRate(uint32_t dsdRate, uint32_t maxRate);
+
+    /**
+     * @brief Set up for a stream (builds the filter tables, resets history)
+     * @param dsdRate DSD bit rate per channel (2822400 for DSD64)
+     * @param lsbFirst Bit order of the DSD bytes (DSF = LSB first)
+     * @param pcmRate Output rate from outputRate()
+     * @return false if the combination is not supported
+     */
+    bool configure(uint32_t dsdRate, uint32_t channels, bool lsbFirst, uint32_t pcmRate);
+
+    /// True if configure() was last called with these parameters
+    bool matches(uint32_t dsdRate, uint32_t channels, bool lsbFirst, uint32_t pcmRate) const;
+
+    /// Clear the filter history (seek / new stream at the same format)
+    void reset();
+
+    /**
+     * @brief Convert planar DSD to interleaved S32
+     * @param data First channel's bytes; channel c at data + c * channelStride
+     *             (DsdStreamReader block layout, or readPlanar() output)
+     * @param bytesPerChannel Bytes per channel, any amount (remainders are
+     *             kept for the next call)
+     * @param out At least maxFrames(bytesPerChannel) * channels samples
+     * @return Frames written
+     */
+    size_t process(const uint8_t* data, size_t channelStride, size_t bytesPerChannel,
+                   int32_t* out);
+
+    /// Upper bound of frames process() returns for this input
+    size_t maxFrames(size_t bytesPerChannel) const;
+
+    uint32_t pcmRate() const { return m_pcmRate; }
+    uint32_t channels() const { return m_channels; }
+    /// FIR length in DSD bits
+    size_t filterTaps() const { return m_groups * 8; }
+    /// Channel threads in use (0 = all channels on the calling thread)
+    size_t threads() const { return m_workers.size(); }
+
+    /// Accumulation kernel in use ("AVX2", "NEON" or "scalar")
+    static const char* kernelName();
+
+private:
+    struct Channel {
+        std::vector<uint8_t> history;   // filter span + pending input
+        size_t length = 0;              // valid bytes in history
+        std::vector<float> output;
+    };
+
+    void buildTables(const std::vector<double>& coeffs, bool lsbFirst);
+    size_t runChannel(size_t ch, const uint8_t* src, size_t bytes);
+    void startWorkers();
+    void stopWorkers();
+    void workerLoop(size_t ch, uint64_t seen);
+
+    uint32_t m_dsdRate = 0;
+    uint32_t m_channels = 0;
+    uint32_t m_pcmRate = 0;
+    bool m_lsbFirst = false;
+    size_t m_step = 0;                  // input bytes per output sample
+    size_t m_groups = 0;                // filter span in bytes (multiple of 8)
+    std::vector<float> m_table;         // m_groups × 256
+    size_t m_tableRatio = 0;
+    bool m_tableLsbFirst = false;
+    float (*m_fir)(const float*, const uint8_t*, size_t) = nullptr;
+    std::vector<Channel> m_state;
+    std::vector<const float*> m_planes;
+
+    // Channel threads: the caller does channel 0, worker i channel i + 1
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+    uint64_t m_generation = 0;          // bumped per process() call
+    size_t m_pending = 0;               // workers still busy this round
+    bool m_stop = false;
+    const uint8_t* m_jobData = nullptr;
+    size_t m_jobStride = 0;
+    size_t m_jobBytes = 0;
+};
+
+#endif // SLIM2DIRETTA_DSD_TO_PCM_H
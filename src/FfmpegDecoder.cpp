@@ -14,10 +14,36 @@
 
 #include "FfmpegDecoder.h"
 #include "LogLevel.h"
+#include "SampleConverter.h"
 
 #include <cstring>
 #include <algorithm>
 
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+// libavcodec/libavutil are loaded by Decoder::create() (CodecLoader.h)
+#define avcodec_find_decoder      CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_find_decoder)
+#define avcodec_get_name          CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_get_name)
+#define avcodec_alloc_context3    CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_alloc_context3)
+#define avcodec_free_context      CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_free_context)
+#define avcodec_open2             CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_open2)
+#define avcodec_send_packet       CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_send_packet)
+#define avcodec_receive_frame     CODEC_SYMBOL(CodecLoader::FFMPEG, avcodec_receive_frame)
+#define av_parser_init            CODEC_SYMBOL(CodecLoader::FFMPEG, av_parser_init)
+#define av_parser_parse2          CODEC_SYMBOL(CodecLoader::FFMPEG, av_parser_parse2)
+#define av_parser_close           CODEC_SYMBOL(CodecLoader::FFMPEG, av_parser_close)
+#define av_packet_alloc           CODEC_SYMBOL(CodecLoader::FFMPEG, av_packet_alloc)
+#define av_packet_free            CODEC_SYMBOL(CodecLoader::FFMPEG, av_packet_free)
+#define av_frame_alloc            CODEC_SYMBOL(CodecLoader::FFMPEG, av_frame_alloc)
+#define av_frame_free             CODEC_SYMBOL(CodecLoader::FFMPEG, av_frame_free)
+#define av_frame_unref            CODEC_SYMBOL(CodecLoader::FFMPEG, av_frame_unref)
+#define av_channel_layout_default CODEC_SYMBOL(CodecLoader::FFMPEG, av_channel_layout_default)
+#define av_channel_layout_copy    CODEC_SYMBOL(CodecLoader::FFMPEG, av_channel_layout_copy)
+#define av_channel_layout_uninit  CODEC_SYMBOL(CodecLoader::FFMPEG, av_channel_layout_uninit)
+#define av_get_sample_fmt_name    CODEC_SYMBOL(CodecLoader::FFMPEG, av_get_sample_fmt_name)
+#define av_strerror               CODEC_SYMBOL(CodecLoader::FFMPEG, av_strerror)
+#endif
+
 AVCodecID FfmpegDecoder::formatCodeToCodecId(char code) {
     switch (code) {
         case 'f': return AV_CODEC_ID_FLAC;
@@ -32,7 +58,6 @@ AVCodecID FfmpegDecoder::formatCodeToCodecId(char code) {
 
 FfmpegDecoder::FfmpegDecoder(char formatCode)
     : m_formatCode(formatCode) {
-    m_outputBuffer.reserve(16384);
 }
 
 FfmpegDecoder::~FfmpegDecoder() {
@@ -158,7 +183,7 @@ bool FfmpegDecoder::initDecoder() {
 }
 
 size_t FfmpegDecoder::feed(const uint8_t* data, size_t len) {
-    m_inputBuffer.insert(m_inputBuffer.end(), data, data + len);
+    m_input.append(data, len);
     return len;
 }
 
@@ -176,64 +201,43 @@ void FfmpegDecoder::setRawPcmFormat(uint32_t sampleRate, uint32_t bitDepth,
 }
 
 void FfmpegDecoder::convertFrame() {
-    int numSamples = m_frame->nb_samples;
-    int numChannels = m_frame->ch_layout.nb_channels;
-
-    for (int s = 0; s < numSamples; s++) {
-        for (int ch = 0; ch < numChannels; ch++) {
-            int32_t sample = 0;
-
-            switch (m_codecCtx->sample_fmt) {
-                case AV_SAMPLE_FMT_S16: {
-                    const int16_t* data = reinterpret_cast<const int16_t*>(
-                        m_frame->data[0]);
-                    sample = static_cast<int32_t>(
-                        data[s * numChannels + ch]) << 16;
-                    break;
-                }
-                case AV_SAMPLE_FMT_S16P: {
-                    const int16_t* data = reinterpret_cast<const int16_t*>(
-                        m_frame->data[ch]);
-                    sample = static_cast<int32_t>(data[s]) << 16;
-                    break;
-                }
-                case AV_SAMPLE_FMT_S32: {
-                    const int32_t* data = reinterpret_cast<const int32_t*>(
-                        m_frame->data[0]);
-                    sample = data[s * numChannels + ch] << m_s32Shift;
-                    break;
-                }
-                case AV_SAMPLE_FMT_S32P: {
-                    const int32_t* data = reinterpret_cast<const int32_t*>(
-                        m_frame->data[ch]);
-                    sample = data[s] << m_s32Shift;
-                    break;
-                }
-                case AV_SAMPLE_FMT_FLT: {
-                    const float* data = reinterpret_cast<const float*>(
-                        m_frame->data[0]);
-                    float f = data[s * numChannels + ch];
-                    if (f > 1.0f) f = 1.0f;
-                    if (f < -1.0f) f = -1.0f;
-                    sample = static_cast<int32_t>(f * 2147483647.0f);
-                    break;
-                }
-                case AV_SAMPLE_FMT_FLTP: {
-                    const float* data = reinterpret_cast<const float*>(
-                        m_frame->data[ch]);
-                    float f = data[s];
-                    if (f > 1.0f) f = 1.0f;
-                    if (f < -1.0f) f = -1.0f;
-                    sample = static_cast<int32_t>(f * 2147483647.0f);
-                    break;
-                }
-                default:
-                    break;
-            }
-
-            m_outputBuffer.push_back(sample);
-        }
+    size_t frames = static_cast<size_t>(m_frame->nb_samples);
+    size_t channels = static_cast<size_t>(m_frame->ch_layout.nb_channels);
+    size_t total = frames * channels;
+    int32_t* dst = m_output.prepare(total);
+    uint8_t* const* data = m_frame->extended_data;
+
+    switch (m_codecCtx->sample_fmt) {
+        case AV_SAMPLE_FMT_S16:
+            SampleConverter::s16ToS32(
+                reinterpret_cast<const int16_t*>(data[0]), total, dst);
+            break;
+        case AV_SAMPLE_FMT_S16P:
+            SampleConverter::interleaveS16(
+                reinterpret_cast<const int16_t* const*>(data), channels, frames, dst);
+            break;
+        case AV_SAMPLE_FMT_S32:
+            SampleConverter::shiftS32(
+                reinterpret_cast<const int32_t*>(data[0]), total, m_s32Shift, dst);
+            break;
+        case AV_SAMPLE_FMT_S32P:
+            SampleConverter::interleaveS32(
+                reinterpret_cast<const int32_t* const*>(data), channels, frames,
+                m_s32Shift, dst);
+            break;
+        case AV_SAMPLE_FMT_FLT:
+            SampleConverter::floatToS32(
+                reinterpret_cast<const float*>(data[0]), total, dst);
+            break;
+        case AV_SAMPLE_FMT_FLTP:
+            SampleConverter::interleaveFloat(
+                reinterpret_cast<const float* const*>(data), channels, frames, dst);
+            break;
+        default:
+            std::memset(dst, 0, total * sizeof(int32_t));
+            break;
     }
+    m_output.commit(total);
 }
 
 size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
@@ -301,7 +305,7 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
             // Check if we have enough output
             size_t channels = m_format.channels;
             if (channels > 0) {
-                size_t framesAvail = (m_outputBuffer.size() - m_outputPos) / channels;
+                size_t framesAvail = m_output.available() / channels;
                 if (framesAvail >= maxFrames) break;
             }
             continue;
@@ -321,7 +325,7 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
         }
 
         // EAGAIN: decoder needs more packets — parse input data
-        size_t available = m_inputBuffer.size() - m_inputPos;
+        size_t available = m_input.available();
         if (available == 0) {
             if (m_eof) {
                 // Flush parser first — it may have buffered the last
@@ -351,9 +355,11 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
         }
 
         if (m_parser) {
-            // Use parser to extract codec frames
-            const uint8_t* inData = m_inputBuffer.data() + m_inputPos;
-            int inSize = static_cast<int>(std::min(available, size_t(65536)));
+            // Use parser to extract codec frames (parsers are streaming,
+            // so the contiguous run of the queue is enough)
+            size_t contiguous = 0;
+            const uint8_t* inData = m_input.peekContiguous(contiguous);
+            int inSize = static_cast<int>(std::min(contiguous, size_t(65536)));
 
             uint8_t* outData = nullptr;
             int outSize = 0;
@@ -365,14 +371,9 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
                 AV_NOPTS_VALUE, AV_NOPTS_VALUE, 0);
 
             if (consumed > 0) {
-                m_inputPos += static_cast<size_t>(consumed);
-
-                // Compact input buffer periodically
-                if (m_inputPos > 65536) {
-                    m_inputBuffer.erase(m_inputBuffer.begin(),
-                                         m_inputBuffer.begin() + m_inputPos);
-                    m_inputPos = 0;
-                }
+                // Only moves the read position — outData may point into
+                // the queue and stays valid until the next feed()
+                m_input.consume(static_cast<size_t>(consumed));
             }
 
             if (outSize > 0) {
@@ -406,10 +407,9 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
                 break;  // Not enough data for a complete frame
             }
 
-            m_packet->data = const_cast<uint8_t*>(
-                m_inputBuffer.data() + m_inputPos);
+            m_packet->data = const_cast<uint8_t*>(m_input.peek(chunkSize));
             m_packet->size = static_cast<int>(chunkSize);
-            m_inputPos += chunkSize;
+            m_input.consume(chunkSize);
 
             int sendRet = avcodec_send_packet(m_codecCtx, m_packet);
             if (sendRet < 0 && sendRet != AVERROR(EAGAIN)) {
@@ -424,22 +424,12 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
     if (!m_formatReady || m_format.channels == 0) return 0;
 
     size_t channels = m_format.channels;
-    size_t framesAvailable = (m_outputBuffer.size() - m_outputPos) / channels;
+    size_t framesAvailable = m_output.available() / channels;
     size_t framesToCopy = std::min(framesAvailable, maxFrames);
 
     if (framesToCopy > 0) {
-        size_t samplesToCopy = framesToCopy * channels;
-        std::memcpy(out, m_outputBuffer.data() + m_outputPos,
-                    samplesToCopy * sizeof(int32_t));
-        m_outputPos += samplesToCopy;
+        m_output.read(out, framesToCopy * channels);
         m_decodedSamples += framesToCopy;
-
-        // Compact output buffer
-        if (m_outputPos > 0) {
-            m_outputBuffer.erase(m_outputBuffer.begin(),
-                                  m_outputBuffer.begin() + m_outputPos);
-            m_outputPos = 0;
-        }
     }
 
     return framesToCopy;
@@ -447,10 +437,8 @@ size_t FfmpegDecoder::readDecoded(int32_t* out, size_t maxFrames) {
 
 void FfmpegDecoder::flush() {
     cleanup();
-    m_inputBuffer.clear();
-    m_inputPos = 0;
-    m_outputBuffer.clear();
-    m_outputPos = 0;
+    m_input.clear();
+    m_output.clear();
     m_format = {};
     m_formatReady = false;
     m_error = false;
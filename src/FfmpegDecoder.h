@@ -18,13 +18,14 @@
 #define SLIM2DIRETTA_FFMPEG_DECODER_H
 
 #include "Decoder.h"
+#include "SampleQueue.h"
+#include "InputQueue.h"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavutil/opt.h>
 }
 
-#include <vector>
 #include <cstdint>
 
 class FfmpegDecoder : public Decoder {
@@ -40,6 +41,7 @@ public:
     bool isFinished() const override { return m_finished; }
     bool hasError() const override { return m_error; }
     uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
     void flush() override;
     void setRawPcmFormat(uint32_t sampleRate, uint32_t bitDepth,
                           uint32_t channels, bool bigEndian) override;
@@ -54,15 +56,13 @@ private:
 
     char m_formatCode;
 
-    // Input buffer (fed by caller)
-    std::vector<uint8_t> m_inputBuffer;
-    size_t m_inputPos = 0;
+    // Input queue (fed by caller)
+    InputQueue m_input;
     bool m_eof = false;
     bool m_parserFlushed = false;
 
-    // Output buffer (decoded S32_LE interleaved)
-    std::vector<int32_t> m_outputBuffer;
-    size_t m_outputPos = 0;
+    // Output queue (decoded S32_LE interleaved)
+    SampleQueue m_output;
 
     // FFmpeg contexts (parser-based, no avformat)
     AVCodecParserContext* m_parser = nullptr;
@@ -5,25 +5,32 @@
  * Key design: two-phase decoding to handle large metadata blocks (album art).
  *
  * Phase 1 (metadata): Uses process_until_end_of_metadata(). If ABORT happens
- * (not enough data for all metadata), the decoder is deleted and recreated
- * on the next attempt with more accumulated data.
+ * (not enough data for all metadata), the decoder is reset and retried on the
+ * next attempt with more accumulated data.
  *
  * Phase 2 (audio): Uses process_single() per frame. On ABORT (incomplete frame),
  * we rollback to the last confirmed frame boundary using get_decode_position()
  * and flush(). This avoids losing the read-ahead bytes that libFLAC keeps in
- * its internal buffer — we only compact up to the confirmed position, so those
- * bytes remain in our buffer and get re-provided on the next call.
+ * its internal buffer — we only release input up to the confirmed position, so
+ * those bytes remain in the InputQueue and get re-provided on the next call.
  */
 
 #include "FlacDecoder.h"
 #include "LogLevel.h"
+#include "SampleConverter.h"
 
 #include <cstring>
 #include <algorithm>
 
+unsigned FlacDecoder::s_parallelThreads = 0;
+std::vector<int> FlacDecoder::s_parallelCores;
+
+void FlacDecoder::setParallelConfig(unsigned threads, const std::vector<int>& cores) {
+    s_parallelThreads = threads;
+    s_parallelCores = cores;
+}
+
 FlacDecoder::FlacDecoder() {
-    m_inputBuffer.reserve(131072);  // 128KB — enough for most metadata blocks
-    m_outputBuffer.reserve(16384);
 }
 
 FlacDecoder::~FlacDecoder() {
@@ -32,12 +39,27 @@ FlacDecoder::~FlacDecoder() {
     }
 }
 
+void FlacDecoder::resetDecoder() {
+    // reset() rewinds to the metadata search and keeps libFLAC's internal
+    // buffers; finish() would free them and the next init_stream() would
+    // allocate them again at every track boundary.
+    if (!m_decoder || !m_initialized) return;
+    if (!FLAC__stream_decoder_reset(m_decoder)) {
+        FLAC__stream_decoder_finish(m_decoder);
+        m_initialized = false;
+    }
+}
+
 bool FlacDecoder::initDecoder() {
-    m_decoder = FLAC__stream_decoder_new();
+    // The libFLAC instance outlives metadata retries and flush() — both
+    // reset() it (see resetDecoder()), so this normally runs once per decoder.
     if (!m_decoder) {
-        LOG_ERROR("[FLAC] Failed to create decoder");
-        m_error = true;
-        return false;
+        m_decoder = FLAC__stream_decoder_new();
+        if (!m_decoder) {
+            LOG_ERROR("[FLAC] Failed to create decoder");
+            m_error = true;
+            return false;
+        }
     }
 
     FLAC__StreamDecoderInitStatus status = FLAC__stream_decoder_init_stream(
@@ -66,17 +88,52 @@ bool FlacDecoder::initDecoder() {
 }
 
 size_t FlacDecoder::feed(const uint8_t* data, size_t len) {
-    m_inputBuffer.insert(m_inputBuffer.end(), data, data + len);
+    if (m_parallelActive) {
+        m_parallel->feed(data, len);
+        return len;
+    }
+    m_input.append(data, len);
     return len;
 }
 
 void FlacDecoder::setEof() {
     m_eof = true;
+    if (m_parallelActive) m_parallel->setEof();
+}
+
+void FlacDecoder::startParallel() {
+    if (!m_parallel) {
+        m_parallel = std::make_unique<ParallelFlacEngine>(s_parallelThreads,
+                                                          s_parallelCores);
+    }
+    m_parallel->start(m_streamInfo);
+
+    // Retained input starts exactly at the first audio frame here
+    m_input.rewind(m_input.retainPosition());
+    while (!m_input.empty()) {
+        size_t len = 0;
+        const uint8_t* p = m_input.peekContiguous(len);
+        m_parallel->feed(p, len);
+        m_input.consume(len);
+    }
+    if (m_eof) m_parallel->setEof();
+    m_parallelActive = true;
+
+    LOG_INFO("[FLAC] " << m_format.sampleRate << " Hz: decoding frames on "
+             << m_parallel->getWorkers() << " threads");
 }
 
 size_t FlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
     if (m_error || m_finished) return 0;
 
+    if (m_parallelActive) {
+        size_t frames = m_parallel->read(out, maxFrames);
+        m_decodedSamples += frames;
+        if (m_parallel->hasError()) m_error = true;
+        else if (frames == 0 && m_parallel->isFinished()) m_finished = true;
+        return frames;
+    }
+
     // Lazy init on first decode attempt
     if (!m_initialized) {
         if (!initDecoder()) return 0;
@@ -86,33 +143,31 @@ size_t FlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
     // Phase 1: Process all metadata blocks
     // ================================================================
     // FLAC files can have large metadata (album art = 100KB+).
-    // If ABORT happens during metadata (not enough data), we delete
-    // the decoder entirely and recreate it on the next call with more
-    // accumulated data. The input buffer is NOT compacted during this
-    // phase, so all previously fed data is available for the retry.
+    // If ABORT happens during metadata (not enough data), we reset()
+    // the decoder and retry it on the next call with more
+    // accumulated data. Input is NOT released during this phase, so all
+    // previously fed data is available for the retry.
 
     if (!m_metadataDone) {
-        size_t savedPos = m_inputPos;
+        uint64_t savedPos = m_input.readPosition();
 
         if (!FLAC__stream_decoder_process_until_end_of_metadata(m_decoder)) {
             FLAC__StreamDecoderState state = FLAC__stream_decoder_get_state(m_decoder);
 
             if (state == FLAC__STREAM_DECODER_ABORTED) {
                 // Not enough data for all metadata — need more input
-                m_inputPos = savedPos;  // Rollback: keep all data
-                FLAC__stream_decoder_delete(m_decoder);
-                m_decoder = nullptr;
-                m_initialized = false;
+                m_input.rewind(savedPos);  // Rollback: keep all data
+                resetDecoder();
                 m_metadataRetries++;
                 // Log first attempt and then only every 50th to avoid spam
                 // (Qobuz streams with large album art can need 100+ retries)
                 if (m_metadataRetries == 1) {
                     LOG_DEBUG("[FLAC] Metadata incomplete, need more data ("
-                              << m_inputBuffer.size() << " bytes buffered)");
+                              << m_input.retained() << " bytes buffered)");
                 } else if (m_metadataRetries % 50 == 0) {
                     LOG_DEBUG("[FLAC] Metadata still incomplete after "
                               << m_metadataRetries << " retries ("
-                              << m_inputBuffer.size() << " bytes buffered)");
+                              << m_input.retained() << " bytes buffered)");
                 }
                 return 0;
             }
@@ -131,49 +186,49 @@ size_t FlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
         m_metadataDone = true;
         if (m_metadataRetries > 0) {
             LOG_DEBUG("[FLAC] Metadata complete after " << m_metadataRetries
-                      << " retries (" << m_inputBuffer.size() << " bytes buffered)");
+                      << " retries (" << m_input.retained() << " bytes buffered)");
         } else {
             LOG_DEBUG("[FLAC] Metadata complete, starting audio decode");
         }
 
         // Use get_decode_position to find exact metadata/audio boundary.
         // This excludes read-ahead bytes in libFLAC's internal buffer,
-        // so those bytes stay in our buffer for the audio phase.
+        // so those bytes stay in our queue for the audio phase.
         FLAC__uint64 absPos;
-        if (FLAC__stream_decoder_get_decode_position(m_decoder, &absPos)) {
-            size_t audioStart = static_cast<size_t>(absPos - m_tellOffset);
-            if (audioStart > 0 && audioStart <= m_inputBuffer.size()) {
-                m_inputBuffer.erase(m_inputBuffer.begin(),
-                                    m_inputBuffer.begin() + audioStart);
-                m_inputPos -= audioStart;
-                m_tellOffset += audioStart;
-            }
+        bool exactAudioStart = false;
+        if (FLAC__stream_decoder_get_decode_position(m_decoder, &absPos) &&
+            absPos > m_input.retainPosition() && absPos <= m_input.readPosition()) {
+            m_input.release(absPos);
+            exactAudioStart = true;
         } else {
-            // Fallback: compact to m_inputPos (may lose read-ahead on first ABORT)
-            if (m_inputPos > 0) {
-                m_tellOffset += m_inputPos;
-                m_inputBuffer.erase(m_inputBuffer.begin(),
-                                    m_inputBuffer.begin() + m_inputPos);
-                m_inputPos = 0;
-            }
+            // Fallback: release up to the read position (may lose read-ahead
+            // on first ABORT)
+            m_input.release(m_input.readPosition());
+        }
+        m_confirmedAbsolutePos = m_input.retainPosition();
+
+        // Very high rates: hand the audio frames to the worker threads.
+        // Needs STREAMINFO (workers are primed with it) and the exact
+        // first-frame offset.
+        if (s_parallelThreads > 1 && m_haveStreamInfo && exactAudioStart &&
+            m_format.sampleRate >= PARALLEL_MIN_SAMPLE_RATE) {
+            startParallel();
+            return readDecoded(out, maxFrames);
         }
-        m_confirmedAbsolutePos = m_tellOffset;
     }
 
     // ================================================================
     // Phase 2: Decode audio frames
     // ================================================================
-    // On ABORT (incomplete frame), we rollback m_inputPos to the last
-    // confirmed frame boundary (from get_decode_position), not to
-    // savedInputPos. This ensures read-ahead bytes from the previous
+    // On ABORT (incomplete frame), we rewind the input queue to the last
+    // confirmed frame boundary (from get_decode_position), not to the
+    // position before this call. This ensures read-ahead bytes from the previous
     // successful frame are re-provided to libFLAC after flush().
 
-    size_t outputAvailable = (m_outputBuffer.size() - m_outputPos) /
-                              std::max(m_format.channels, 1u);
+    size_t outputAvailable = m_output.available() / std::max(m_format.channels, 1u);
 
     while (outputAvailable < maxFrames) {
-        size_t inputAvailable = m_inputBuffer.size() - m_inputPos;
-        if (inputAvailable == 0 && !m_eof) break;
+        if (m_input.empty() && !m_eof) break;
 
         if (!FLAC__stream_decoder_process_single(m_decoder)) {
             FLAC__StreamDecoderState state = FLAC__stream_decoder_get_state(m_decoder);
@@ -185,9 +240,7 @@ size_t FlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
 
             if (state == FLAC__STREAM_DECODER_ABORTED) {
                 // Rollback to last confirmed frame boundary
-                size_t confirmedBufPos = static_cast<size_t>(
-                    m_confirmedAbsolutePos - m_tellOffset);
-                m_inputPos = confirmedBufPos;
+                m_input.rewind(m_confirmedAbsolutePos);
 
                 if (!m_eof && !m_error) {
                     FLAC__stream_decoder_flush(m_decoder);
@@ -219,65 +272,48 @@ size_t FlacDecoder::readDecoded(int32_t* out, size_t maxFrames) {
             m_confirmedAbsolutePos = absPos;
         }
 
-        outputAvailable = (m_outputBuffer.size() - m_outputPos) /
-                           std::max(m_format.channels, 1u);
+        outputAvailable = m_output.available() / std::max(m_format.channels, 1u);
     }
 
-    // Compact input buffer: only remove confirmed-consumed bytes.
-    // Read-ahead bytes (between confirmed pos and m_inputPos) stay in the buffer.
-    size_t confirmedBufPos = static_cast<size_t>(m_confirmedAbsolutePos - m_tellOffset);
-    if (confirmedBufPos > 0) {
-        m_inputBuffer.erase(m_inputBuffer.begin(),
-                            m_inputBuffer.begin() + confirmedBufPos);
-        m_inputPos -= confirmedBufPos;
-        m_tellOffset += confirmedBufPos;
-    }
+    // Release only confirmed-consumed bytes. Read-ahead bytes (between the
+    // confirmed position and the read position) stay in the queue.
+    m_input.release(m_confirmedAbsolutePos);
 
     // Copy available output frames
     if (!m_formatReady || m_format.channels == 0) return 0;
 
-    size_t framesAvailable = (m_outputBuffer.size() - m_outputPos) / m_format.channels;
+    size_t framesAvailable = m_output.available() / m_format.channels;
     size_t framesToCopy = std::min(framesAvailable, maxFrames);
 
     if (framesToCopy > 0) {
-        size_t samplesToCopy = framesToCopy * m_format.channels;
-        std::memcpy(out, m_outputBuffer.data() + m_outputPos,
-                    samplesToCopy * sizeof(int32_t));
-        m_outputPos += samplesToCopy;
+        m_output.read(out, framesToCopy * m_format.channels);
         m_decodedSamples += framesToCopy;
-
-        // Compact output buffer
-        if (m_outputPos > 0) {
-            m_outputBuffer.erase(m_outputBuffer.begin(),
-                                 m_outputBuffer.begin() + m_outputPos);
-            m_outputPos = 0;
-        }
     }
 
     return framesToCopy;
 }
 
 void FlacDecoder::flush() {
-    if (m_decoder) {
-        FLAC__stream_decoder_delete(m_decoder);
-        m_decoder = nullptr;
-    }
-    m_inputBuffer.clear();
-    m_inputPos = 0;
-    m_outputBuffer.clear();
-    m_outputPos = 0;
+    // Keep the libFLAC instance (reset, not finished) and the buffers'
+    // capacity so DecoderPool can reuse this decoder.
+    resetDecoder();
+    m_input.clear();
+    m_output.clear();
     m_format = {};
     m_formatReady = false;
     m_shift = 0;
-    m_tellOffset = 0;
     m_confirmedAbsolutePos = 0;
-    m_initialized = false;
     m_metadataDone = false;
     m_error = false;
     m_finished = false;
     m_eof = false;
     m_decodedSamples = 0;
     m_metadataRetries = 0;
+    m_haveStreamInfo = false;
+    if (m_parallelActive) {
+        m_parallel->reset();
+        m_parallelActive = false;
+    }
 }
 
 // ============================================
@@ -290,9 +326,7 @@ FLAC__StreamDecoderReadStatus FlacDecoder::readCallback(
 {
     auto* self = static_cast<FlacDecoder*>(clientData);
 
-    size_t available = self->m_inputBuffer.size() - self->m_inputPos;
-
-    if (available == 0) {
+    if (self->m_input.empty()) {
         *bytes = 0;
         if (self->m_eof) {
             return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
@@ -300,10 +334,8 @@ FLAC__StreamDecoderReadStatus FlacDecoder::readCallback(
         return FLAC__STREAM_DECODER_READ_STATUS_ABORT;
     }
 
-    size_t toRead = std::min(available, *bytes);
-    std::memcpy(buffer, self->m_inputBuffer.data() + self->m_inputPos, toRead);
-    self->m_inputPos += toRead;
-    *bytes = toRead;
+    // Read-ahead: bytes stay retained until a frame boundary is confirmed
+    *bytes = self->m_input.readAhead(buffer, *bytes);
 
     return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
 }
@@ -333,17 +365,10 @@ FLAC__StreamDecoderWriteStatus FlacDecoder::writeCallback(
 
     int shift = self->m_shift;
 
-    // Reserve space for interleaved output
-    size_t prevSize = self->m_outputBuffer.size();
-    self->m_outputBuffer.resize(prevSize + blocksize * channels);
-    int32_t* dst = self->m_outputBuffer.data() + prevSize;
-
-    // Interleave and MSB-align samples
-    for (uint32_t i = 0; i < blocksize; i++) {
-        for (uint32_t ch = 0; ch < channels; ch++) {
-            *dst++ = buffer[ch][i] << shift;
-        }
-    }
+    // Interleave and MSB-align straight into the output queue
+    int32_t* dst = self->m_output.prepare(blocksize * channels);
+    SampleConverter::interleaveS32(buffer, channels, blocksize, shift, dst);
+    self->m_output.commit(blocksize * channels);
 
     return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
 }
@@ -366,6 +391,8 @@ void FlacDecoder::metadataCallback(
 
         self->m_shift = 32 - static_cast<int>(info.bits_per_sample);
         self->m_formatReady = true;
+        self->m_streamInfo = info;
+        self->m_haveStreamInfo = true;
 
         // Only log once — metadata retries re-trigger this callback
         if (firstTime) {
@@ -409,6 +436,6 @@ FLAC__StreamDecoderTellStatus FlacDecoder::tellCallback(
     void* clientData)
 {
     auto* self = static_cast<FlacDecoder*>(clientData);
-    *absolute_byte_offset = self->m_tellOffset + self->m_inputPos;
+    *absolute_byte_offset = self->m_input.readPosition();
     return FLAC__STREAM_DECODER_TELL_STATUS_OK;
 }
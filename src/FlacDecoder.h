@@ -9,13 +9,20 @@
  * Handles streaming with incomplete data:
  * - During metadata: ABORT → reset() (back to SEARCH_FOR_METADATA)
  * - During audio: ABORT → flush() (back to SEARCH_FOR_FRAME_SYNC)
+ *
+ * At high sample rates (and --flac-threads > 1) the audio phase is handed
+ * to ParallelFlacEngine after STREAMINFO, decoding frames on worker threads.
  */
 
 #ifndef SLIM2DIRETTA_FLAC_DECODER_H
 #define SLIM2DIRETTA_FLAC_DECODER_H
 
 #include "Decoder.h"
+#include "InputQueue.h"
+#include "ParallelFlacEngine.h"
+#include "SampleQueue.h"
 #include <FLAC/stream_decoder.h>
+#include <memory>
 #include <vector>
 
 class FlacDecoder : public Decoder {
@@ -31,10 +38,24 @@ public:
     bool isFinished() const override { return m_finished; }
     bool hasError() const override { return m_error; }
     uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
     void flush() override;
 
+    /**
+     * @brief Configure frame-parallel decoding (call once at startup)
+     * @param threads Worker threads (0/1 = serial libFLAC only)
+     * @param cores   CPU cores for the workers (empty = no pinning)
+     */
+    static void setParallelConfig(unsigned threads, const std::vector<int>& cores);
+
+    // Streams below this rate keep the serial decoder: one libFLAC instance
+    // is fast enough there and the hand-off would only add latency
+    static constexpr uint32_t PARALLEL_MIN_SAMPLE_RATE = 352800;
+
 private:
     bool initDecoder();
+    void resetDecoder();
+    void startParallel();
 
     // libFLAC callbacks
     static FLAC__StreamDecoderReadStatus readCallback(
@@ -59,14 +80,13 @@ private:
 
     FLAC__StreamDecoder* m_decoder = nullptr;
 
-    // Input buffer (fed by caller)
-    std::vector<uint8_t> m_inputBuffer;
-    size_t m_inputPos = 0;
+    // Input queue (fed by caller). Its read position is libFLAC's stream
+    // position; bytes stay retained until a frame boundary is confirmed.
+    InputQueue m_input{131072};  // 128KB — enough for most metadata blocks
     bool m_eof = false;
 
-    // Output buffer (filled by write callback)
-    std::vector<int32_t> m_outputBuffer;
-    size_t m_outputPos = 0;
+    // Output queue (filled by write callback)
+    SampleQueue m_output{32768};
 
     // Format from STREAMINFO metadata
     DecodedFormat m_format;
@@ -76,8 +96,8 @@ private:
     // Stream position tracking for accurate rollback on ABORT
     // libFLAC reads ahead into an internal buffer. On flush(), those bytes
     // are lost. We use get_decode_position() to find the exact frame boundary
-    // and rollback/compact to there (not to m_inputPos which includes read-ahead).
-    uint64_t m_tellOffset = 0;            // Cumulative bytes removed by compaction
+    // and rewind/release to there (not to the read position, which includes
+    // read-ahead).
     uint64_t m_confirmedAbsolutePos = 0;  // Last frame boundary (absolute stream pos)
 
     // State
@@ -87,6 +107,15 @@ private:
     bool m_finished = false;
     uint64_t m_decodedSamples = 0;
     unsigned m_metadataRetries = 0;  // Count of metadata incomplete retries
+
+    // Frame-parallel audio phase (kept across flush() for pooled reuse)
+    FLAC__StreamMetadata_StreamInfo m_streamInfo{};
+    bool m_haveStreamInfo = false;
+    std::unique_ptr<ParallelFlacEngine> m_parallel;
+    bool m_parallelActive = false;
+
+    static unsigned s_parallelThreads;
+    static std::vector<int> s_parallelCores;
 };
 
 #endif // SLIM2DIRETTA_FLAC_DECODER_H
@@ -4,97 +4,314 @@
  */
 
 #include "HttpStreamClient.h"
+#include "UringReceiver.h"
+#include "StreamSpool.h"
+#include "NetBind.h"
 #include "LogLevel.h"
 
 #include <sys/socket.h>
+#include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <poll.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 #include <cstring>
 #include <algorithm>
+#include <thread>
+
+namespace {
+
+// Receive buffer: headers, ICY metadata (<= 4 KB per block) and chunk
+// framing are parsed here; matches the callers' 64 KB read size
+constexpr size_t RECV_BUFFER_SIZE = 65536;
+constexpr size_t MAX_HEADER_BYTES = 16384;
+constexpr size_t MAX_CHUNK_LINE = 256;
+constexpr uint64_t UNKNOWN_LENGTH = UINT64_MAX;
+
+// Connect + response headers of a Range reconnect, each
+constexpr int RESUME_TIMEOUT_MS = 3000;
+
+// Stall recovery policy (setStallRecovery)
+int s_stallIdleMs = 3000;
+uint32_t s_stallMinRate = 16 * 1024;
+int s_stallRetries = 3;
+
+// Spool (setSpool); the fetch thread receives up to this much per read
+std::string s_spoolDir;
+size_t s_spoolBytes = 0;
+constexpr size_t SPOOL_READ_BYTES = 262144;
+
+// Pacing (setPacing): consumption is measured over the whole stream from
+// the first read, and only trusted after the prefill burst has averaged out
+unsigned s_paceMargin = 0;
+constexpr int64_t PACE_WARMUP_MS = 3000;
+constexpr size_t PACE_QUANTUM = 16384;        // Smallest paced read
+constexpr size_t DEFAULT_RCVBUF = 256 * 1024;
+std::string s_bindSpec;
+
+// Burstiness slot length
+constexpr int64_t SLOT_MS = 10;
+
+// Closed streams, for dumpStats()
+std::atomic<uint64_t> s_streams{0};
+std::atomic<uint64_t> s_bytes{0};
+std::atomic<uint64_t> s_syscalls{0};
+std::atomic<uint64_t> s_streamMs{0};
+std::atomic<uint64_t> s_ingestNs{0};
+std::atomic<bool> s_uringUsed{false};
+std::atomic<uint64_t> s_stallsRecovered{0};
+std::atomic<uint64_t> s_stallsLost{0};
+
+// Spool of the stream being played, for dumpStats()
+std::atomic<uint64_t> s_spoolLead{0};
+std::atomic<uint64_t> s_spoolLeadMs{0};
+std::atomic<bool> s_spoolActive{false};
+
+// Ingest of the stream being received, for dumpStats()
+std::atomic<uint64_t> s_liveRate{0};
+std::atomic<uint64_t> s_liveConsume{0};
+std::atomic<uint64_t> s_livePeakSlot{0};
+std::atomic<uint64_t> s_liveMeanSlot{0};
+std::atomic<bool> s_liveActive{false};
+
+// Trimmed value of header `name` (lowercase) in lowercased headers, "" if absent
+std::string headerValue(const std::string& lowerHeaders, const std::string& name) {
+    size_t pos = lowerHeaders.find("\n" + name + ":");
+    if (pos == std::string::npos) return {};
+    pos += name.size() + 2;
+    size_t end = lowerHeaders.find_first_of("\r\n", pos);
+    if (end == std::string::npos) end = lowerHeaders.size();
+    while (pos < end && (lowerHeaders[pos] == ' ' || lowerHeaders[pos] == '\t')) pos++;
+    while (end > pos && (lowerHeaders[end - 1] == ' ' || lowerHeaders[end - 1] == '\t')) end--;
+    return lowerHeaders.substr(pos, end - pos);
+}
+
+// LMS request with any Range header replaced by "Range: bytes=<offset>-"
+std::string withRange(const std::string& request, uint64_t offset) {
+    std::string out;
+    size_t pos = 0;
+    while (pos < request.size()) {
+        size_t end = request.find("\r\n", pos);
+        if (end == std::string::npos) end = request.size();
+        if (end == pos) break;  // blank line: end of the headers
+        std::string line = request.substr(pos, end - pos);
+        std::string lower = line;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return std::tolower(c); });
+        if (lower.compare(0, 6, "range:") != 0) out += line + "\r\n";
+        pos = end + 2;
+    }
+    return out + "Range: bytes=" + std::to_string(offset) + "-\r\n\r\n";
+}
+
+} // namespace
 
 HttpStreamClient::HttpStreamClient() = default;
 
 HttpStreamClient::~HttpStreamClient() {
     disconnect();
+    closeConnection();
 }
 
 bool HttpStreamClient::connect(const std::string& serverIp, uint16_t serverPort,
                                 const std::string& httpRequest) {
     disconnect();
+    closeConnection();
+    {
+        std::lock_guard<std::mutex> lock(m_socketMutex);
+        m_stopped = false;
+    }
+
+    m_serverIp = serverIp;
+    m_serverPort = serverPort;
+    m_httpRequest = httpRequest;
+    m_bytesReceived = 0;
+    m_syscalls = 0;
+    m_uring.reset();
+    m_ingestNs = 0;
+    m_waitNs = 0;
+    m_starved = false;
+    m_windowBytes = 0;
+    m_windowWaitNs = 0;
+    m_resumeAttempts = 0;
+    m_resumePending = false;
+    m_stallsRecovered = 0;
+    m_stallsLost = 0;
+    m_spool.reset();
+    m_spoolReading = false;
+    m_consumeRate.store(0, std::memory_order_relaxed);
+    m_consumeBytes = 0;
+    m_paceTokens = 0.0;
+    m_paceRefill = {};
+    m_paceTuned = 0;
+    m_slot = 0;
+    m_slotBytes = 0;
+    m_peakSlotBytes = 0;
+    const auto connectStart = std::chrono::steady_clock::now();
+    m_connectTime = connectStart;
+    m_windowStart = connectStart;
+
+    if (!openConnection(httpRequest, -1)) return false;
+
+    // What a Range reconnect needs: the full length to tell an early close
+    // from the end, or at least the server's word that it takes ranges
+    const std::string length = responseHeader("content-length");
+    m_totalLength = (m_httpStatus == 200 && !length.empty())
+        ? std::strtoull(length.c_str(), nullptr, 10) : 0;
+    m_acceptRanges = responseHeader("accept-ranges").find("bytes") != std::string::npos;
+
+    m_statsPending = true;
+    m_connected.store(true, std::memory_order_release);
+    const auto headerUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - connectStart).count();
+
+    LOG_INFO("[HTTP] Stream connected (status " << m_httpStatus << ", headers in "
+             << headerUs / 1000 << "." << headerUs / 100 % 10 << " ms)");
+    LOG_DEBUG("[HTTP] Response headers:\n" << m_responseHeaders);
+
+    if (s_spoolBytes > 0) {
+        auto spool = std::make_unique<StreamSpool>();
+        if (spool->open(s_spoolDir, s_spoolBytes)) {
+            // The fetch thread inherits this (control) thread's CPU placement,
+            // keeping socket work off the audio core
+            m_spool = std::move(spool);
+            m_spoolOpen.store(true, std::memory_order_release);
+            m_spoolThread = std::thread(&HttpStreamClient::spoolLoop, this);
+        } else {
+            LOG_WARN("[Spool] Reading this stream without the spool");
+        }
+    }
 
+    return true;
+}
+
+bool HttpStreamClient::openConnection(const std::string& request, int connectTimeoutMs) {
     m_responseHeaders.clear();
     m_httpStatus = 0;
-    m_bytesReceived = 0;
     m_icyMetaInt = 0;
     m_icyBytesUntilMeta = 0;
+    m_icySkip = 0;
+    m_rxBuf.resize(RECV_BUFFER_SIZE);
+    m_rxPos = m_rxLen = 0;
+    m_peerClosed = false;
+    m_bodyLeft = UNKNOWN_LENGTH;
+    m_chunked = false;
+    m_chunkState = Chunk::Size;
+    m_chunkLeft = 0;
+    m_chunkLine.clear();
+    m_useUring = UringReceiver::enabled();
 
-    // Create TCP socket
-    m_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (m_socket < 0) {
+    // Create TCP socket; published under the lock so that disconnect()
+    // can shut it down from another thread while it connects
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
         LOG_ERROR("[HTTP] Failed to create socket: " << strerror(errno));
         return false;
     }
+    {
+        std::lock_guard<std::mutex> lock(m_socketMutex);
+        if (m_stopped) {
+            close(fd);
+            return false;
+        }
+        m_socket = fd;
+    }
 
     // TCP_NODELAY for responsiveness
     int flag = 1;
     setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
 
-    // Larger receive buffer for streaming
-    int rcvBuf = 256 * 1024;
+    // Larger receive buffer for streaming (the pacer sizes it to the
+    // stream once the rate is known)
+    int rcvBuf = static_cast<int>(DEFAULT_RCVBUF);
     setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    m_paceTuned = 0;
+
+    if (!bindSocket(m_socket, s_bindSpec, "[HTTP]")) {
+        closeConnection();
+        return false;
+    }
 
     // Connect
     struct sockaddr_in addr{};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(serverPort);
-    if (inet_pton(AF_INET, serverIp.c_str(), &addr.sin_addr) != 1) {
-        LOG_ERROR("[HTTP] Invalid server address: " << serverIp);
-        close(m_socket);
-        m_socket = -1;
+    addr.sin_port = htons(m_serverPort);
+    if (inet_pton(AF_INET, m_serverIp.c_str(), &addr.sin_addr) != 1) {
+        LOG_ERROR("[HTTP] Invalid server address: " << m_serverIp);
+        closeConnection();
         return false;
     }
 
-    LOG_DEBUG("[HTTP] Connecting to " << serverIp << ":" << serverPort);
+    LOG_DEBUG("[HTTP] Connecting to " << m_serverIp << ":" << m_serverPort);
 
-    if (::connect(m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+    // A reconnect runs on the audio thread: bound the connect and the
+    // header read so a dead server cannot block it for the TCP timeout
+    const int flags = fcntl(m_socket, F_GETFL, 0);
+    if (connectTimeoutMs >= 0) {
+        fcntl(m_socket, F_SETFL, flags | O_NONBLOCK);
+        struct timeval tv{};
+        tv.tv_sec = connectTimeoutMs / 1000;
+        tv.tv_usec = (connectTimeoutMs % 1000) * 1000;
+        setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    int rc = ::connect(m_socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    if (rc < 0 && errno == EINPROGRESS) {
+        struct pollfd pfd{};
+        pfd.fd = m_socket;
+        pfd.events = POLLOUT;
+        int err = ETIMEDOUT;
+        socklen_t errLen = sizeof(err);
+        if (poll(&pfd, 1, connectTimeoutMs) > 0) {
+            getsockopt(m_socket, SOL_SOCKET, SO_ERROR, &err, &errLen);
+        }
+        errno = err;
+        rc = err == 0 ? 0 : -1;
+    }
+    if (rc < 0) {
         LOG_ERROR("[HTTP] Connection failed: " << strerror(errno));
-        close(m_socket);
-        m_socket = -1;
+        closeConnection();
         return false;
     }
+    if (connectTimeoutMs >= 0) fcntl(m_socket, F_SETFL, flags);
 
     LOG_DEBUG("[HTTP] Connected, sending request");
 
     // Send the HTTP request provided by LMS
-    if (!sendAll(httpRequest.c_str(), httpRequest.size())) {
+    if (!sendAll(request.c_str(), request.size())) {
         LOG_ERROR("[HTTP] Failed to send request");
-        close(m_socket);
-        m_socket = -1;
+        closeConnection();
         return false;
     }
 
     // Parse response headers
     if (!parseResponseHeaders()) {
         LOG_ERROR("[HTTP] Failed to parse response headers");
-        close(m_socket);
-        m_socket = -1;
+        closeConnection();
         return false;
     }
 
-    m_connected.store(true, std::memory_order_release);
-
-    LOG_INFO("[HTTP] Stream connected (status " << m_httpStatus << ")");
-    LOG_DEBUG("[HTTP] Response headers:\n" << m_responseHeaders);
-
+    if (connectTimeoutMs >= 0) {
+        struct timeval tv{};
+        setsockopt(m_socket, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
     return true;
 }
 
-void HttpStreamClient::disconnect() {
-    m_connected.store(false, std::memory_order_release);
+void HttpStreamClient::closeConnection() {
+    // The io_uring receive is cancelled before its socket goes away
+    if (m_uring) {
+        m_syscalls += m_uring->syscalls();
+        m_uring.reset();
+    }
+    std::lock_guard<std::mutex> lock(m_socketMutex);
     if (m_socket >= 0) {
         shutdown(m_socket, SHUT_RDWR);
         close(m_socket);
@@ -102,114 +319,708 @@ void HttpStreamClient::disconnect() {
     }
 }
 
+void HttpStreamClient::disconnect() {
+    m_connected.store(false, std::memory_order_release);
+    if (m_spool) {
+        // The mapping stays until connect() or the destructor: the reader
+        // may still hold a view into it
+        m_spoolOpen.store(false, std::memory_order_release);
+        m_spool->cancel();
+    }
+    if (m_spoolThread.joinable() && m_spoolThread.get_id() != std::this_thread::get_id()) {
+        m_spoolThread.join();
+    }
+    if (m_statsPending && m_bytesReceived > 0) {
+        // Ingest cost of the stream: kernel entries per MB and per second,
+        // and the time the reading thread spent outside of waits
+        const uint64_t syscalls = getSyscalls();
+        const uint64_t mb10 = m_bytesReceived * 10 >> 20;
+        const uint64_t ms = std::max<uint64_t>(1, static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - m_connectTime).count()));
+        LOG_INFO("[HTTP] Stream closed (" << (m_uring ? "io_uring" : "socket") << "): "
+                 << mb10 / 10 << "." << mb10 % 10 << " MB in " << ms / 1000 << "s, "
+                 << syscalls << " syscalls (" << syscalls * 1000 / ms << "/s, "
+                 << syscalls * (1 << 20) / m_bytesReceived << " per MB), ingest "
+                 << m_ingestNs / 1000000 << "." << m_ingestNs / 100000 % 10 << " ms CPU, peak "
+                 << SLOT_MS << " ms burst " << m_peakSlotBytes / 1024
+                 << " KB"
+                 << (m_stallsRecovered ? ", " + std::to_string(m_stallsRecovered)
+                                         + " stalls recovered" : std::string()));
+
+        s_streams.fetch_add(1, std::memory_order_relaxed);
+        s_bytes.fetch_add(m_bytesReceived, std::memory_order_relaxed);
+        s_syscalls.fetch_add(syscalls, std::memory_order_relaxed);
+        s_streamMs.fetch_add(ms, std::memory_order_relaxed);
+        s_ingestNs.fetch_add(m_ingestNs, std::memory_order_relaxed);
+        if (m_uring) s_uringUsed.store(true, std::memory_order_relaxed);
+        s_stallsRecovered.fetch_add(m_stallsRecovered, std::memory_order_relaxed);
+        s_stallsLost.fetch_add(m_stallsLost, std::memory_order_relaxed);
+    }
+    m_statsPending = false;
+
+    // Only shut down: the reading thread may be inside a read or a
+    // reconnect on this socket, and closes it itself (closeConnection())
+    std::lock_guard<std::mutex> lock(m_socketMutex);
+    m_stopped = true;
+    if (m_socket >= 0) shutdown(m_socket, SHUT_RDWR);
+}
+
+void HttpStreamClient::release() {
+    disconnect();
+    closeConnection();
+    // disconnect() joined the fetch thread: nothing writes the spool now
+    m_spool.reset();
+    m_spoolReading = false;
+}
+
+void HttpStreamClient::dumpStats() {
+    if (s_liveActive.load(std::memory_order_relaxed)) {
+        const uint64_t consume = s_liveConsume.load(std::memory_order_relaxed);
+        const uint64_t peak = s_livePeakSlot.load(std::memory_order_relaxed);
+        const uint64_t mean = std::max<uint64_t>(1, s_liveMeanSlot.load(std::memory_order_relaxed));
+        std::cout << "[HTTP] Current stream: " << s_liveRate.load(std::memory_order_relaxed) / 1024
+                  << " KB/s in, decoder " << consume / 1024 << " KB/s, ";
+        if (s_paceMargin > 0 && consume > 0) {
+            std::cout << "paced at " << consume * (100 + s_paceMargin) / 100 / 1024 << " KB/s";
+        } else {
+            std::cout << "unpaced";
+        }
+        std::cout << ", peak " << SLOT_MS << " ms burst " << peak / 1024 << " KB ("
+                  << peak / mean << "x mean)" << std::endl;
+    }
+
+    if (s_spoolActive.load(std::memory_order_relaxed)) {
+        const uint64_t lead = s_spoolLead.load(std::memory_order_relaxed);
+        const uint64_t leadMs = s_spoolLeadMs.load(std::memory_order_relaxed);
+        std::cout << "[Spool] " << (lead >> 10) << " KB of " << (s_spoolBytes >> 20)
+                  << " MB ahead of the decoder (~" << leadMs / 1000 << "." << leadMs / 100 % 10
+                  << " s at its read rate)" << std::endl;
+    }
+
+    const uint64_t streams = s_streams.load(std::memory_order_relaxed);
+    if (streams == 0) return;
+    const uint64_t bytes = s_bytes.load(std::memory_order_relaxed);
+    const uint64_t syscalls = s_syscalls.load(std::memory_order_relaxed);
+    const uint64_t ms = std::max<uint64_t>(1, s_streamMs.load(std::memory_order_relaxed));
+    const uint64_t ingestUs = s_ingestNs.load(std::memory_order_relaxed) / 1000;
+    const uint64_t permille = ingestUs / ms;
+    std::cout << "[HTTP] Ingest ("
+              << (s_uringUsed.load(std::memory_order_relaxed) ? "io_uring" : "socket") << "): "
+              << streams << " streams, " << (bytes >> 20) << " MB, " << syscalls
+              << " syscalls (" << syscalls * 1000 / ms << "/s, "
+              << (bytes > 0 ? syscalls * (1 << 20) / bytes : 0) << " per MB), CPU "
+              << ingestUs / 1000 << " ms (" << permille / 10 << "." << permille % 10
+              << "% of one core)" << std::endl;
+
+    const uint64_t recovered = s_stallsRecovered.load(std::memory_order_relaxed);
+    const uint64_t lost = s_stallsLost.load(std::memory_order_relaxed);
+    if (recovered + lost > 0) {
+        std::cout << "[HTTP] Stalls/drops: " << recovered << " recovered with Range, "
+                  << lost << " gave up" << std::endl;
+    }
+}
+
+void HttpStreamClient::setPacing(unsigned marginPercent) {
+    s_paceMargin = marginPercent;
+}
+
+void HttpStreamClient::setBind(const std::string& spec) {
+    s_bindSpec = spec;
+}
+
+void HttpStreamClient::setSpool(const std::string& dir, size_t bytes) {
+    s_spoolDir = dir;
+    s_spoolBytes = bytes;
+}
+
+void HttpStreamClient::setStallRecovery(int idleMs, uint32_t minBytesPerSec, int retries) {
+    s_stallIdleMs = std::max(0, idleMs);
+    s_stallMinRate = minBytesPerSec;
+    s_stallRetries = std::max(0, retries);
+}
+
+uint64_t HttpStreamClient::getInputBacklog(size_t& capacity) const {
+    if (m_spool) {
+        capacity = m_spool->capacity();
+        return m_spool->written() - m_spool->consumed();
+    }
+    capacity = m_rxBuf.size();
+    uint64_t backlog = m_rxLen - m_rxPos;
+    if (m_socket >= 0) {
+        // The reading thread owns the descriptor: it is never closed under us
+        int queued = 0;
+        if (ioctl(m_socket, FIONREAD, &queued) == 0 && queued > 0) {
+            backlog += static_cast<uint64_t>(queued);
+        }
+        int rcvBuf = 0;
+        socklen_t len = sizeof(rcvBuf);
+        if (getsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &rcvBuf, &len) == 0 && rcvBuf > 0) {
+            capacity += static_cast<size_t>(rcvBuf);
+        }
+    }
+    return backlog;
+}
+
 bool HttpStreamClient::isConnected() const {
+    if (m_spool) return m_spoolOpen.load(std::memory_order_acquire);
     return m_connected.load(std::memory_order_acquire);
 }
 
-ssize_t HttpStreamClient::readRaw(uint8_t* buf, size_t maxLen) {
-    if (m_socket < 0) return -1;
+uint64_t HttpStreamClient::getSyscalls() const {
+    return m_syscalls + (m_uring ? m_uring->syscalls() : 0);
+}
 
-    ssize_t n = recv(m_socket, buf, maxLen, 0);
-    if (n > 0) {
+ssize_t HttpStreamClient::recvSome(uint8_t* buf, const uint8_t** view, size_t len) {
+    // A complete Content-Length body reads as a close
+    if (m_bodyLeft == 0) return 0;
+    len = static_cast<size_t>(std::min<uint64_t>(len, m_bodyLeft));
+
+    if (m_uring) {
+        ssize_t n = view ? m_uring->next(*view, len) : m_uring->read(buf, len);
+        if (n > 0) {
+            if (m_bodyLeft != UNKNOWN_LENGTH) m_bodyLeft -= static_cast<uint64_t>(n);
+            return n;
+        }
+        if (n == UringReceiver::EMPTY) return -2;
+        if (n == UringReceiver::FAILED) LOG_ERROR("[HTTP] Read error: " << strerror(errno));
         return n;
-    } else if (n == 0) {
-        m_connected.store(false, std::memory_order_release);
-        return 0;
-    } else {
-        if (errno == EINTR) return 0;
+    }
+
+    while (true) {
+        ssize_t n = recv(m_socket, buf, len, MSG_DONTWAIT);
+        m_syscalls++;
+        if (n > 0) {
+            if (m_bodyLeft != UNKNOWN_LENGTH) m_bodyLeft -= static_cast<uint64_t>(n);
+            return n;
+        }
+        if (n == 0) return 0;
+        if (errno == EINTR) continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return -2;
         LOG_ERROR("[HTTP] Read error: " << strerror(errno));
-        m_connected.store(false, std::memory_order_release);
         return -1;
     }
 }
 
-bool HttpStreamClient::skipIcyMetadata() {
-    // Read 1 byte: metadata length * 16
-    uint8_t lenByte = 0;
+ssize_t HttpStreamClient::fillBuffer() {
+    if (m_rxPos > 0) {
+        std::memmove(m_rxBuf.data(), m_rxBuf.data() + m_rxPos, m_rxLen - m_rxPos);
+        m_rxLen -= m_rxPos;
+        m_rxPos = 0;
+    }
+    ssize_t n = recvSome(m_rxBuf.data() + m_rxLen, nullptr, m_rxBuf.size() - m_rxLen);
+    if (n > 0) m_rxLen += static_cast<size_t>(n);
+    return n;
+}
+
+bool HttpStreamClient::parseChunkFraming() {
+    while (m_rxPos < m_rxLen) {
+        const char* start = reinterpret_cast<const char*>(m_rxBuf.data()) + m_rxPos;
+        const size_t avail = m_rxLen - m_rxPos;
+        const char* nl = static_cast<const char*>(std::memchr(start, '\n', avail));
+        const size_t take = nl ? static_cast<size_t>(nl - start) : avail;
+        // Chunk extensions and trailers are ignored; keep enough for the size
+        m_chunkLine.append(start, std::min(take, MAX_CHUNK_LINE - m_chunkLine.size()));
+        m_rxPos += nl ? take + 1 : take;
+        if (!nl) return false;
+
+        if (!m_chunkLine.empty() && m_chunkLine.back() == '\r') m_chunkLine.pop_back();
+        switch (m_chunkState) {
+            case Chunk::Size: {
+                char* end = nullptr;
+                unsigned long long size = std::strtoull(m_chunkLine.c_str(), &end, 16);
+                if (end == m_chunkLine.c_str()) {
+                    LOG_ERROR("[HTTP] Bad chunk size line: \"" << m_chunkLine << "\"");
+                    m_chunkState = Chunk::Done;
+                } else if (size == 0) {
+                    m_chunkState = Chunk::Trailer;
+                } else {
+                    m_chunkLeft = size;
+                    m_chunkState = Chunk::Data;
+                }
+                break;
+            }
+            case Chunk::DataEnd:
+                m_chunkState = Chunk::Size;
+                break;
+            case Chunk::Trailer:
+                if (m_chunkLine.empty()) m_chunkState = Chunk::Done;
+                break;
+            default:
+                break;
+        }
+        m_chunkLine.clear();
+        return true;
+    }
+    return false;
+}
+
+size_t HttpStreamClient::decodeBuffered(uint8_t* buf, size_t maxLen) {
+    size_t out = 0;
+    while (out < maxLen && m_rxPos < m_rxLen) {
+        if (m_chunked && m_chunkState != Chunk::Data) {
+            if (m_chunkState == Chunk::Done) {
+                m_rxPos = m_rxLen;
+                break;
+            }
+            if (!parseChunkFraming()) break;
+            continue;
+        }
+
+        size_t avail = m_rxLen - m_rxPos;
+        if (m_chunked) avail = static_cast<size_t>(std::min<uint64_t>(avail, m_chunkLeft));
+        const uint8_t* src = m_rxBuf.data() + m_rxPos;
+
+        size_t used;
+        if (m_icyMetaInt == 0) {
+            used = std::min(avail, maxLen - out);
+            std::memcpy(buf + out, src, used);
+            out += used;
+        } else if (m_icySkip > 0) {
+            used = std::min(avail, m_icySkip);
+            m_icySkip -= used;
+        } else if (m_icyBytesUntilMeta == 0) {
+            // Length byte: metadata size / 16, then the block itself
+            used = 1;
+            m_icySkip = static_cast<size_t>(*src) * 16;
+            m_icyBytesUntilMeta = m_icyMetaInt;
+        } else {
+            used = std::min({ avail, maxLen - out, static_cast<size_t>(m_icyBytesUntilMeta) });
+            std::memcpy(buf + out, src, used);
+            out += used;
+            m_icyBytesUntilMeta -= static_cast<uint32_t>(used);
+        }
+
+        m_rxPos += used;
+        if (m_chunked) {
+            m_chunkLeft -= used;
+            if (m_chunkLeft == 0) m_chunkState = Chunk::DataEnd;
+        }
+    }
+    return out;
+}
+
+bool HttpStreamClient::bodyComplete() const {
+    if (m_chunked) return m_chunkState == Chunk::Done;
+    return m_bodyLeft == 0 && m_rxPos == m_rxLen;
+}
+
+ssize_t HttpStreamClient::receive(uint8_t* buf, const uint8_t** view, size_t maxLen,
+                                  int timeoutMs) {
+    if (m_socket < 0) return -1;
+    if (maxLen == 0) return 0;
+
+    if (m_useUring && !m_uring) {
+        m_uring = std::make_unique<UringReceiver>();
+        if (m_uring->start(m_socket)) {
+            LOG_DEBUG("[HTTP] Receiving through io_uring");
+        } else {
+            LOG_WARN("[HTTP] io_uring receive unavailable for this stream — using recv()");
+            m_uring.reset();
+            m_useUring = false;
+        }
+    }
+
+    maxLen = paceAllowance(maxLen, timeoutMs);
+    if (maxLen == 0) return 0;
+
+    const auto entered = std::chrono::steady_clock::now();
+    const uint64_t waitedBefore = m_waitNs;
+    ssize_t n = receiveData(buf, view, maxLen, timeoutMs);
+    const uint64_t spent = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - entered).count());
+    m_ingestNs += spent - std::min(spent, m_waitNs - waitedBefore);
+
+    if (n > 0) {
+        // Spend the tokens: the bucket only refills at the paced rate
+        if (s_paceMargin > 0) {
+            m_paceTokens = std::max(0.0, m_paceTokens - static_cast<double>(n));
+        }
+        noteArrival(static_cast<size_t>(n));
+        if (!m_spool) noteConsumed(static_cast<size_t>(n));
+        m_starved = false;
+        m_windowBytes += static_cast<uint64_t>(n);
+        m_resumeAttempts = 0;
+        if (m_resumePending) {
+            m_resumePending = false;
+            m_stallsRecovered++;
+        }
+    }
+    return n;
+}
+
+ssize_t HttpStreamClient::receiveData(uint8_t* buf, const uint8_t** view, size_t maxLen,
+                                      int timeoutMs) {
+    bool waited = false;
     while (true) {
-        ssize_t n = recv(m_socket, &lenByte, 1, 0);
-        if (n == 1) break;
-        if (n == 0) {
+        if (view) {
+            // Plain body: buffered bytes are handed out where they are
+            if (m_rxPos < m_rxLen) {
+                size_t n = std::min(maxLen, m_rxLen - m_rxPos);
+                *view = m_rxBuf.data() + m_rxPos;
+                m_rxPos += n;
+                m_bytesReceived += n;
+                return static_cast<ssize_t>(n);
+            }
+        } else {
+            size_t n = decodeBuffered(buf, maxLen);
+            if (n > 0) {
+                m_bytesReceived += n;
+                return static_cast<ssize_t>(n);
+            }
+        }
+
+        // Buffer drained: only now does a close from the server end the stream
+        if (m_peerClosed || bodyComplete()) {
+            const bool early = m_chunked ? m_chunkState != Chunk::Done
+                                         : m_totalLength > 0 && m_bytesReceived < m_totalLength;
+            if (early && resumable()) {
+                if (resume("closed early")) continue;
+                m_connected.store(false, std::memory_order_release);
+                return -1;
+            }
+            if (m_chunked && m_chunkState != Chunk::Done) {
+                LOG_WARN("[HTTP] Connection closed inside a chunked body");
+            }
             m_connected.store(false, std::memory_order_release);
-            return false;
+            return 0;
+        }
+
+        // Plain body with nothing buffered: receive straight into buf, or
+        // for a view straight from the io_uring buffers. Everything else
+        // goes through the receive buffer.
+        const bool plain = !m_chunked && m_icyMetaInt == 0;
+        const bool direct = plain && (!view || m_uring);
+        ssize_t r = direct ? recvSome(buf, view, maxLen) : fillBuffer();
+        if (r > 0) {
+            if (!direct) continue;
+            m_bytesReceived += static_cast<uint64_t>(r);
+            return r;
         }
-        if (errno != EINTR) {
+        if (r == 0) {
+            m_peerClosed = true;
+            continue;
+        }
+        if (r == -1) {
+            if (resumable() && !bodyComplete() && resume("failed")) continue;
             m_connected.store(false, std::memory_order_release);
-            return false;
+            return -1;
+        }
+
+        // Socket empty: wait once (a blocking read() waits as long as needed)
+        if (!m_starved) {
+            m_starved = true;
+            m_starvedSince = std::chrono::steady_clock::now();
+        }
+        if (waited && timeoutMs >= 0) return 0;
+        int ready = waitReadable(timeoutMs);
+        if (ready == 0) {
+            const char* stall = stallReason();
+            if (!stall) return 0;
+            if (resume(stall)) continue;
+            m_connected.store(false, std::memory_order_release);
+            return -1;
         }
+        if (ready < 0) return ready;
+        waited = true;
     }
+}
 
-    size_t metaLen = static_cast<size_t>(lenByte) * 16;
-    if (metaLen == 0) return true;  // No metadata this time
+size_t HttpStreamClient::paceAllowance(size_t maxLen, int timeoutMs) {
+    const uint64_t consume = m_consumeRate.load(std::memory_order_relaxed);
+    if (s_paceMargin == 0 || consume == 0) return maxLen;
 
-    // Read and discard metadata bytes
-    uint8_t discardBuf[256];
-    size_t remaining = metaLen;
-    while (remaining > 0) {
-        size_t toRead = std::min(remaining, sizeof(discardBuf));
-        ssize_t n = recv(m_socket, discardBuf, toRead, 0);
-        if (n <= 0) {
-            if (n < 0 && errno == EINTR) continue;
-            m_connected.store(false, std::memory_order_release);
-            return false;
+    const uint64_t rate = consume * (100 + s_paceMargin) / 100;
+    if (rate * 4 > m_paceTuned * 5 || rate * 5 < m_paceTuned * 4) tuneSocketBuffers(rate);
+
+    // Bucket of 20 ms at the paced rate: reads stay small and regular
+    const double depth = std::max(static_cast<double>(rate) / 50.0,
+                                  static_cast<double>(PACE_QUANTUM));
+    const size_t want = std::min(maxLen, PACE_QUANTUM);
+    auto refill = [&] {
+        const auto now = std::chrono::steady_clock::now();
+        const double dt = std::chrono::duration<double>(now - m_paceRefill).count();
+        m_paceTokens = std::min(depth, m_paceTokens + static_cast<double>(rate) * dt);
+        m_paceRefill = now;
+    };
+    refill();
+    if (m_paceTokens < static_cast<double>(want)) {
+        int sleepMs = static_cast<int>(
+            (static_cast<double>(want) - m_paceTokens) * 1000.0 / static_cast<double>(rate)) + 1;
+        if (timeoutMs >= 0) sleepMs = std::min(sleepMs, timeoutMs);
+        if (sleepMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+        refill();
+        if (m_paceTokens < static_cast<double>(want)) return 0;
+    }
+    return std::min(maxLen, static_cast<size_t>(m_paceTokens));
+}
+
+void HttpStreamClient::tuneSocketBuffers(uint64_t rate) {
+    // Window of ~200 ms at the paced rate; wake-ups for >= 10 ms of it
+    const int rcvBuf = static_cast<int>(std::min<uint64_t>(
+        std::max<uint64_t>(rate / 5, 32768), DEFAULT_RCVBUF));
+    const int lowat = static_cast<int>(std::min<uint64_t>(
+        std::max<uint64_t>(rate / 100, 2048), static_cast<uint64_t>(rcvBuf) / 4));
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, &rcvBuf, sizeof(rcvBuf));
+    setsockopt(m_socket, SOL_SOCKET, SO_RCVLOWAT, &lowat, sizeof(lowat));
+    m_paceTuned = rate;
+    LOG_DEBUG("[HTTP] Pacing at " << rate / 1024 << " KB/s: SO_RCVBUF " << rcvBuf / 1024
+              << " KB, SO_RCVLOWAT " << lowat / 1024 << " KB");
+}
+
+void HttpStreamClient::noteConsumed(size_t n) {
+    const auto now = std::chrono::steady_clock::now();
+    if (m_consumeBytes == 0) m_consumeStart = now;
+    m_consumeBytes += n;
+    const int64_t ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        now - m_consumeStart).count();
+    if (ms >= PACE_WARMUP_MS) {
+        m_consumeRate.store(m_consumeBytes * 1000 / static_cast<uint64_t>(ms),
+                            std::memory_order_relaxed);
+    }
+}
+
+void HttpStreamClient::noteArrival(size_t n) {
+    const auto now = std::chrono::steady_clock::now();
+    if (m_bytesReceived == n) {
+        m_firstByte = now;
+        m_slot = 0;
+        m_slotBytes = 0;
+    }
+    const uint64_t slot = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_firstByte).count() / SLOT_MS);
+    if (slot != m_slot) {
+        // The prefill is a burst by design: peaks count from a second after
+        // the warm-up (pacing, if on, has started by then)
+        if (static_cast<int64_t>(m_slot) * SLOT_MS >= PACE_WARMUP_MS + 1000) {
+            m_peakSlotBytes = std::max(m_peakSlotBytes, m_slotBytes);
         }
-        remaining -= static_cast<size_t>(n);
+        m_slot = slot;
+        m_slotBytes = 0;
+
+        const uint64_t elapsedMs = std::max<uint64_t>(1, slot * SLOT_MS);
+        s_liveRate.store(m_bytesReceived * 1000 / elapsedMs, std::memory_order_relaxed);
+        s_liveConsume.store(m_consumeRate.load(std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+        s_livePeakSlot.store(m_peakSlotBytes, std::memory_order_relaxed);
+        s_liveMeanSlot.store(m_bytesReceived / (slot + 1), std::memory_order_relaxed);
+        s_liveActive.store(true, std::memory_order_relaxed);
     }
+    m_slotBytes += n;
+}
 
-    return true;
+bool HttpStreamClient::resumable() const {
+    // Live streams (ICY, or no length and no ranges) cannot be resumed
+    return s_stallIdleMs > 0 && m_icyMetaInt == 0 && (m_totalLength > 0 || m_acceptRanges);
 }
 
-ssize_t HttpStreamClient::read(uint8_t* buf, size_t maxLen) {
-    if (m_socket < 0) return -1;
+const char* HttpStreamClient::stallReason() {
+    if (!m_starved || !resumable()) return nullptr;
+    const auto now = std::chrono::steady_clock::now();
+    const auto idle = std::chrono::milliseconds(s_stallIdleMs);
+    if (now - m_starvedSince >= idle) return "stalled (no data)";
 
-    // No ICY metadata — simple passthrough
-    if (m_icyMetaInt == 0) {
-        ssize_t n = readRaw(buf, maxLen);
-        if (n > 0) m_bytesReceived += static_cast<uint64_t>(n);
-        return n;
+    // Rate window: only counts when the reader spent most of it waiting, so
+    // a reader throttled by a full decode cache is not taken for a stall
+    const auto windowNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_windowStart).count());
+    if (now - m_windowStart < idle) return nullptr;
+    const bool slow = s_stallMinRate > 0 && (m_waitNs - m_windowWaitNs) * 2 >= windowNs &&
+                      m_windowBytes * 1000000000 < static_cast<uint64_t>(s_stallMinRate) * windowNs;
+    m_windowStart = now;
+    m_windowBytes = 0;
+    m_windowWaitNs = m_waitNs;
+    return slow ? "stalled (below minimum rate)" : nullptr;
+}
+
+bool HttpStreamClient::resume(const char* reason) {
+    // Reconnecting is waiting for the server, not ingest work
+    const auto start = std::chrono::steady_clock::now();
+    const bool resumed = reconnect(reason);
+    const auto now = std::chrono::steady_clock::now();
+    m_waitNs += static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+    if (resumed) {
+        m_starved = false;
+        m_resumePending = true;
+        m_windowStart = now;
+        m_windowBytes = 0;
+        m_windowWaitNs = m_waitNs;
     }
+    return resumed;
+}
 
-    // ICY metadata active — limit read to bytes before next metadata block
-    size_t canRead = std::min(maxLen, static_cast<size_t>(m_icyBytesUntilMeta));
-    if (canRead == 0) {
-        // At metadata boundary — skip metadata block
-        if (!skipIcyMetadata()) return -1;
-        m_icyBytesUntilMeta = m_icyMetaInt;
-        canRead = std::min(maxLen, static_cast<size_t>(m_icyBytesUntilMeta));
+bool HttpStreamClient::reconnect(const char* reason) {
+    const uint64_t offset = m_bytesReceived;
+    while (m_connected.load(std::memory_order_acquire)) {
+        if (m_resumeAttempts >= s_stallRetries) {
+            LOG_WARN("[HTTP] Stream " << reason << " at byte " << offset << " — giving up after "
+                     << m_resumeAttempts << " reconnects");
+            m_stallsLost++;
+            return false;
+        }
+        // Back off a little more on each failed attempt (the reader of a
+        // stopped stream is released at once by disconnect())
+        const auto backoff = std::chrono::steady_clock::now() +
+                             std::chrono::milliseconds(500 * m_resumeAttempts);
+        while (m_connected.load(std::memory_order_acquire) &&
+               std::chrono::steady_clock::now() < backoff) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        if (!m_connected.load(std::memory_order_acquire)) break;
+
+        m_resumeAttempts++;
+        LOG_WARN("[HTTP] Stream " << reason << " at byte " << offset
+                 << " — reconnecting with Range (attempt " << m_resumeAttempts << "/"
+                 << s_stallRetries << ")");
+
+        const auto start = std::chrono::steady_clock::now();
+        closeConnection();
+        if (!openConnection(withRange(m_httpRequest, offset), RESUME_TIMEOUT_MS)) continue;
+
+        // Only a 206 from the requested byte continues the same body
+        const std::string range = responseHeader("content-range");
+        const size_t digits = range.find_first_of("0123456789");
+        const bool continues = m_httpStatus == 206 && digits != std::string::npos &&
+            std::strtoull(range.c_str() + digits, nullptr, 10) == offset;
+        if (!continues) {
+            LOG_WARN("[HTTP] Server did not resume at byte " << offset << " (status "
+                     << m_httpStatus << ", Content-Range \"" << range << "\")");
+            m_stallsLost++;
+            return false;
+        }
+        if (m_icyMetaInt != 0) {
+            LOG_WARN("[HTTP] Resumed stream carries ICY metadata — not spliced");
+            m_stallsLost++;
+            return false;
+        }
+
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("[HTTP] Stream resumed at byte " << offset << " (206 in " << ms << " ms)");
+        return true;
     }
+    return false;
+}
 
-    ssize_t n = readRaw(buf, canRead);
-    if (n > 0) {
-        m_bytesReceived += static_cast<uint64_t>(n);
-        m_icyBytesUntilMeta -= static_cast<uint32_t>(n);
+int HttpStreamClient::waitReadable(int timeoutMs) {
+    const auto start = std::chrono::steady_clock::now();
+    int ready;
+    if (m_uring) {
+        ready = m_uring->wait(timeoutMs);
+        if (ready < 0) {
+            LOG_ERROR("[HTTP] io_uring wait error: " << strerror(errno));
+            m_connected.store(false, std::memory_order_release);
+        }
+    } else {
+        struct pollfd pfd;
+        pfd.fd = m_socket;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        ready = poll(&pfd, 1, timeoutMs);
+        m_syscalls++;
+        if (ready < 0) {
+            if (errno == EINTR) {
+                ready = 0;
+            } else {
+                LOG_ERROR("[HTTP] Poll error: " << strerror(errno));
+                m_connected.store(false, std::memory_order_release);
+            }
+        } else if (ready > 0 && (pfd.revents & POLLNVAL)) {
+            // POLLHUP and POLLERR are left to recv(): data the server sent
+            // before closing is still read out first, and a reset reaches
+            // the reconnect path as a read error
+            m_connected.store(false, std::memory_order_release);
+            ready = -1;
+        }
     }
-    return n;
+    m_waitNs += static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    return ready;
+}
+
+ssize_t HttpStreamClient::read(uint8_t* buf, size_t maxLen) {
+    if (m_spool) return readSpool(buf, nullptr, maxLen, -1);
+    return receive(buf, nullptr, maxLen, -1);
 }
 
 ssize_t HttpStreamClient::readWithTimeout(uint8_t* buf, size_t maxLen, int timeoutMs) {
-    if (m_socket < 0) return -1;
+    if (m_spool) return readSpool(buf, nullptr, maxLen, timeoutMs);
+    return receive(buf, nullptr, maxLen, timeoutMs);
+}
 
-    struct pollfd pfd;
-    pfd.fd = m_socket;
-    pfd.events = POLLIN;
-    pfd.revents = 0;
+ssize_t HttpStreamClient::readView(const uint8_t*& data, size_t maxLen, int timeoutMs) {
+    if (m_spool) return readSpool(nullptr, &data, maxLen, timeoutMs);
+    if (m_chunked || m_icyMetaInt != 0) {
+        // Framing and metadata are stripped into a buffer of our own
+        if (m_viewBuf.size() < maxLen) m_viewBuf.resize(maxLen);
+        data = m_viewBuf.data();
+        return receive(m_viewBuf.data(), nullptr, maxLen, timeoutMs);
+    }
+    return receive(nullptr, &data, maxLen, timeoutMs);
+}
 
-    int ready = poll(&pfd, 1, timeoutMs);
-    if (ready < 0) {
-        if (errno == EINTR) return 0;
-        LOG_ERROR("[HTTP] Poll error: " << strerror(errno));
-        m_connected.store(false, std::memory_order_release);
-        return -1;
+void HttpStreamClient::spoolLoop() {
+    const auto start = std::chrono::steady_clock::now();
+    while (true) {
+        size_t len = 0;
+        uint8_t* dst = m_spool->reserve(len, 100);
+        if (!dst) {
+            // Ring full (the reader is SPOOL size behind), or cancelled
+            if (!m_spoolOpen.load(std::memory_order_acquire) || m_spool->cancelled()) break;
+            continue;
+        }
+        ssize_t n = receive(dst, nullptr, std::min(len, SPOOL_READ_BYTES), 100);
+        if (n > 0) {
+            m_spool->commit(static_cast<size_t>(n));
+        } else if (n < 0 || !m_connected.load(std::memory_order_acquire)) {
+            break;
+        }
     }
-    if (ready == 0) return 0;  // Timeout - no data available
+    m_spool->finish();
 
-    // Check for errors/hangup on the socket
-    if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
-        m_connected.store(false, std::memory_order_release);
+    if (m_spoolOpen.load(std::memory_order_acquire)) {
+        const uint64_t written = m_spool->written();
+        const uint64_t lead = written - m_spool->consumed();
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("[Spool] Stream fetched: " << (written >> 10) << " KB in " << ms << " ms, "
+                 << (lead >> 10) << " KB ahead of the decoder");
+    }
+}
+
+ssize_t HttpStreamClient::readSpool(uint8_t* buf, const uint8_t** view, size_t maxLen,
+                                    int timeoutMs) {
+    const uint8_t* data = nullptr;
+    ssize_t n = m_spool->read(data, maxLen, timeoutMs);
+    if (n < 0) {
+        m_spoolOpen.store(false, std::memory_order_release);
+        s_spoolActive.store(false, std::memory_order_relaxed);
         return -1;
     }
+    if (n == 0) return 0;
+
+    if (view) {
+        *view = data;
+    } else {
+        std::memcpy(buf, data, static_cast<size_t>(n));
+    }
+    noteConsumed(static_cast<size_t>(n));
 
-    return read(buf, maxLen);
+    // Lead over the decoder, in bytes and in time at the rate it reads
+    const auto now = std::chrono::steady_clock::now();
+    if (!m_spoolReading) {
+        m_spoolReading = true;
+        m_spoolFirstRead = now;
+    }
+    const uint64_t consumed = m_spool->consumed() + static_cast<uint64_t>(n);
+    const uint64_t lead = m_spool->written() - consumed;
+    const uint64_t readMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_spoolFirstRead).count());
+    s_spoolLead.store(lead, std::memory_order_relaxed);
+    s_spoolLeadMs.store(consumed > 0 ? lead * readMs / consumed : 0, std::memory_order_relaxed);
+    s_spoolActive.store(true, std::memory_order_relaxed);
+    return n;
 }
 
 bool HttpStreamClient::sendAll(const void* buf, size_t len) {
@@ -228,74 +1039,88 @@ bool HttpStreamClient::sendAll(const void* buf, size_t len) {
     return true;
 }
 
-bool HttpStreamClient::parseResponseHeaders() {
-    // Read until we find \r\n\r\n (end of HTTP headers)
-    // LMS uses HTTP/1.0 so headers are simple
-    std::string headerBuf;
-    headerBuf.reserve(4096);
+std::string HttpStreamClient::responseHeader(const std::string& name) const {
+    std::string lower = m_responseHeaders;
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return headerValue(lower, name);
+}
 
-    char c;
-    int endSeq = 0;  // Track \r\n\r\n sequence
+bool HttpStreamClient::parseResponseHeaders() {
+    // Receive until \r\n\r\n (end of HTTP headers) is in the buffer; the
+    // bytes after it are the start of the body and stay there
+    static const char END[] = "\r\n\r\n";
+    size_t searchFrom = 0;
+    size_t headerLen = 0;
 
-    while (true) {
-        ssize_t n = recv(m_socket, &c, 1, 0);
+    while (headerLen == 0) {
+        ssize_t n = recv(m_socket, m_rxBuf.data() + m_rxLen, m_rxBuf.size() - m_rxLen, 0);
+        m_syscalls++;
         if (n <= 0) {
             if (n < 0 && errno == EINTR) continue;
             LOG_ERROR("[HTTP] Connection closed while reading headers");
             return false;
         }
+        m_rxLen += static_cast<size_t>(n);
 
-        headerBuf += c;
-
-        // Detect \r\n\r\n
-        if (c == '\r' && (endSeq == 0 || endSeq == 2)) {
-            endSeq++;
-        } else if (c == '\n' && (endSeq == 1 || endSeq == 3)) {
-            endSeq++;
-            if (endSeq == 4) break;  // Found end of headers
+        const char* data = reinterpret_cast<const char*>(m_rxBuf.data());
+        const char* found = std::search(data + searchFrom, data + m_rxLen, END, END + 4);
+        if (found != data + m_rxLen) {
+            headerLen = static_cast<size_t>(found - data) + 4;
         } else {
-            endSeq = 0;
+            searchFrom = m_rxLen >= 3 ? m_rxLen - 3 : 0;
         }
 
         // Safety: headers shouldn't be larger than 16KB
-        if (headerBuf.size() > 16384) {
+        if ((headerLen ? headerLen : m_rxLen) > MAX_HEADER_BYTES) {
             LOG_ERROR("[HTTP] Headers too large (>16KB)");
             return false;
         }
     }
 
+    const std::string headerBuf(reinterpret_cast<const char*>(m_rxBuf.data()), headerLen);
     m_responseHeaders = headerBuf;
+    m_rxPos = headerLen;
 
     // Parse HTTP status code from first line
-    // Expected: "HTTP/1.0 200 OK\r\n" or "ICY 200 OK\r\n"
+    // Expected: "HTTP/1.0 200 OK\r\n", "HTTP/1.1 200 OK\r\n" or "ICY 200 OK\r\n"
     size_t spacePos = headerBuf.find(' ');
     if (spacePos != std::string::npos && spacePos + 3 < headerBuf.size()) {
         m_httpStatus = std::atoi(headerBuf.c_str() + spacePos + 1);
     }
 
-    if (m_httpStatus != 200) {
+    if (m_httpStatus != 200 && m_httpStatus != 206) {
         LOG_WARN("[HTTP] Unexpected status: " << m_httpStatus);
     }
 
-    // Parse icy-metaint header (case-insensitive)
-    // Format: "icy-metaint:16000\r\n" or "icy-metaint: 16000\r\n"
     std::string lowerHeaders = headerBuf;
     std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(),
                    [](unsigned char c) { return std::tolower(c); });
 
-    size_t icyPos = lowerHeaders.find("icy-metaint:");
-    if (icyPos != std::string::npos) {
-        size_t valStart = icyPos + 12;  // strlen("icy-metaint:")
-        // Skip optional whitespace
-        while (valStart < lowerHeaders.size() && lowerHeaders[valStart] == ' ') {
-            valStart++;
-        }
-        uint32_t metaInt = static_cast<uint32_t>(std::atoi(headerBuf.c_str() + valStart));
-        if (metaInt > 0) {
-            m_icyMetaInt = metaInt;
-            m_icyBytesUntilMeta = metaInt;
-            LOG_INFO("[HTTP] ICY metadata interval: " << metaInt << " bytes");
+    // Parse icy-metaint header
+    // Format: "icy-metaint:16000\r\n" or "icy-metaint: 16000\r\n"
+    uint32_t metaInt = static_cast<uint32_t>(
+        std::strtoul(headerValue(lowerHeaders, "icy-metaint").c_str(), nullptr, 10));
+    if (metaInt > 0) {
+        m_icyMetaInt = metaInt;
+        m_icyBytesUntilMeta = metaInt;
+        LOG_INFO("[HTTP] ICY metadata interval: " << metaInt << " bytes");
+    }
+
+    // Body framing: chunked, else Content-Length on HTTP/1.1 (the connection
+    // may stay open after it), else until the server closes
+    m_chunked = headerValue(lowerHeaders, "transfer-encoding").find("chunked") != std::string::npos;
+    const std::string contentLength = headerValue(lowerHeaders, "content-length");
+    if (m_chunked) {
+        LOG_DEBUG("[HTTP] Chunked transfer encoding");
+    } else if (lowerHeaders.compare(0, 9, "http/1.1 ") == 0 && !contentLength.empty()) {
+        uint64_t length = std::strtoull(contentLength.c_str(), nullptr, 10);
+        uint64_t buffered = m_rxLen - m_rxPos;
+        if (buffered > length) {
+            m_rxLen = m_rxPos + static_cast<size_t>(length);
+            buffered = length;
         }
+        m_bodyLeft = length - buffered;
     }
 
     return true;
@@ -4,6 +4,34 @@
  *
  * Connects to LMS HTTP port and streams encoded audio data.
  * The HTTP request is provided by LMS in the strm-s command.
+ *
+ * Socket data goes through one receive buffer: response headers, ICY
+ * metadata and Transfer-Encoding: chunked framing are parsed there, in
+ * large reads, instead of with one recv() per byte. Reads try
+ * recv(MSG_DONTWAIT) first and only poll() when the socket is empty. A
+ * plain body (no ICY, not chunked) is received straight into the
+ * caller's buffer once the header leftovers are consumed.
+ *
+ * With the io_uring engine (UringReceiver::enable()), the kernel receives
+ * into registered buffers ahead of the reads, and readView() hands those
+ * buffers to the decoder without a copy.
+ *
+ * Stall recovery: a stream that can be resumed (known length or
+ * Accept-Ranges, no ICY) and drops before its end, or leaves the reader
+ * waiting without data, is reconnected with the original request plus a
+ * Range header from the first byte not yet received. The continuation is
+ * returned by the same reads, so the decoder never sees the gap.
+ *
+ * With a spool (setSpool()), connect() starts a fetch thread that receives
+ * the body into a StreamSpool as fast as the server sends, and the read
+ * calls return the spooled bytes; isConnected() then stays true until the
+ * reader has drained the spool.
+ *
+ * Pacing (setPacing()): once the reader's consumption rate is known, socket
+ * reads are limited by a token bucket at that rate plus a margin, and the
+ * socket buffer and low-water mark are sized to it. The TCP window then
+ * closes between reads and the server sends in small steady steps, instead
+ * of 256 KB bursts whenever the decoder refills.
  */
 
 #ifndef SLIM2DIRETTA_HTTP_STREAM_CLIENT_H
@@ -11,7 +39,16 @@
 
 #include <string>
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+
+class UringReceiver;
+class StreamSpool;
 
 class HttpStreamClient {
 public:
@@ -29,9 +66,16 @@ public:
     bool connect(const std::string& serverIp, uint16_t serverPort,
                  const std::string& httpRequest);
 
+    // Stop the stream: any thread; a blocked read or reconnect returns at
+    // once. The socket is closed by the next connect() or the destructor.
     void disconnect();
     bool isConnected() const;
 
+    // disconnect(), then close the socket and free the spool: only the
+    // receive buffers stay, for a client kept around for the next
+    // connect(). Reading thread only, with no view from readView() held.
+    void release();
+
     // Read audio data (blocking). Returns bytes read, 0 = EOF, -1 = error
     ssize_t read(uint8_t* buf, size_t maxLen);
 
@@ -39,6 +83,11 @@ public:
     // Negative bytesRead with isConnected()=false means real error/EOF.
     ssize_t readWithTimeout(uint8_t* buf, size_t maxLen, int timeoutMs);
 
+    // readWithTimeout() without the copy: data points at the received bytes
+    // (valid until the next read) — straight into the io_uring buffers when
+    // that engine is active and the body is plain
+    ssize_t readView(const uint8_t*& data, size_t maxLen, int timeoutMs);
+
     // HTTP response headers (available after connect)
     const std::string& getResponseHeaders() const { return m_responseHeaders; }
     int getHttpStatus() const { return m_httpStatus; }
@@ -49,25 +98,170 @@ public:
     // ICY metadata interval (0 = no ICY metadata in stream)
     uint32_t getIcyMetaInt() const { return m_icyMetaInt; }
 
+    // Body uses Transfer-Encoding: chunked
+    bool isChunked() const { return m_chunked; }
+
+    // Kernel entries since connect, headers included (recv() + poll(), or
+    // io_uring submits + waits)
+    uint64_t getSyscalls() const;
+
+    // Ingest totals of all closed streams (syscalls/s, CPU) to stdout
+    static void dumpStats();
+
+    // Stall recovery for all streams (set before the first connect).
+    // A stall is idleMs of reads without data, or a window of idleMs in
+    // which the reader mostly waited and got less than minBytesPerSec.
+    // Up to `retries` reconnects without data in between; idleMs 0 = off.
+    static void setStallRecovery(int idleMs, uint32_t minBytesPerSec, int retries);
+
+    // Stalls/drops resumed with a Range request (data flowed again)
+    uint32_t getStallsRecovered() const { return m_stallsRecovered; }
+
+    // Spool every stream into a ring file of `bytes` in dir (0 = off; set
+    // before the first connect)
+    static void setSpool(const std::string& dir, size_t bytes);
+
+    // Undecoded input held on the host, for LMS's stream buffer fields: the
+    // spool's unread bytes (capacity = spool size), or without a spool the
+    // unparsed receive buffer plus the socket's receive queue (capacity =
+    // receive buffer + SO_RCVBUF). Call from the reading thread.
+    uint64_t getInputBacklog(size_t& capacity) const;
+
+    // Pace socket reads at the consumption rate + marginPercent (0 = off)
+    static void setPacing(unsigned marginPercent);
+
+    // Bind stream sockets to an interface or source address (NetBind.h)
+    static void setBind(const std::string& spec);
+
 private:
+    enum class Chunk { Size, Data, DataEnd, Trailer, Done };
+
+    // m_socket is opened and closed by the reading thread only; both, and
+    // disconnect()'s shutdown from other threads, hold m_socketMutex
     int m_socket = -1;
+    std::mutex m_socketMutex;
+    bool m_stopped = false;           // disconnect() since connect()
     std::atomic<bool> m_connected{false};
 
+    // Original request, for Range reconnects
+    std::string m_serverIp;
+    uint16_t m_serverPort = 0;
+    std::string m_httpRequest;
+
     std::string m_responseHeaders;
     int m_httpStatus = 0;
     uint64_t m_bytesReceived = 0;
 
+    // Receive buffer: unparsed socket bytes are m_rxBuf[m_rxPos, m_rxLen)
+    std::vector<uint8_t> m_rxBuf;
+    size_t m_rxPos = 0;
+    size_t m_rxLen = 0;
+    bool m_peerClosed = false;
+    uint64_t m_bodyLeft = 0;          // Content-Length bytes not yet received
+    uint64_t m_syscalls = 0;
+    std::vector<uint8_t> m_viewBuf;   // readView() output for ICY / chunked
+
+    // io_uring engine, set up by the first read (on the reading thread)
+    std::unique_ptr<UringReceiver> m_uring;
+    bool m_useUring = false;
+
+    // Ingest cost: time in read calls minus time waiting for the socket
+    std::chrono::steady_clock::time_point m_connectTime;
+    uint64_t m_ingestNs = 0;
+    uint64_t m_waitNs = 0;
+
+    // Spool: fetch thread fills m_spool, the read calls drain it
+    std::unique_ptr<StreamSpool> m_spool;
+    std::thread m_spoolThread;
+    std::atomic<bool> m_spoolOpen{false};     // Reader has not drained it yet
+    std::chrono::steady_clock::time_point m_spoolFirstRead;
+    bool m_spoolReading = false;
+
+    // Pacing: consumption measured where the reader takes the bytes (the
+    // spool's reader may be another thread than the socket's)
+    std::atomic<uint64_t> m_consumeRate{0};   // Bytes/s, 0 = not measured yet
+    std::chrono::steady_clock::time_point m_consumeStart;
+    uint64_t m_consumeBytes = 0;
+    double m_paceTokens = 0.0;
+    std::chrono::steady_clock::time_point m_paceRefill;
+    uint64_t m_paceTuned = 0;                 // Rate the socket buffers are sized for
+
+    // Burstiness: bytes received per 10 ms slot since the first byte
+    std::chrono::steady_clock::time_point m_firstByte;
+    uint64_t m_slot = 0;
+    uint64_t m_slotBytes = 0;
+    uint64_t m_peakSlotBytes = 0;
+
+    // Stall recovery
+    bool m_statsPending = false;      // Stream connected, totals not yet logged
+    uint64_t m_totalLength = 0;       // Body length of the 200 response (0 = unknown)
+    bool m_acceptRanges = false;
+    bool m_starved = false;           // Reads found no data since m_starvedSince
+    std::chrono::steady_clock::time_point m_starvedSince;
+    std::chrono::steady_clock::time_point m_windowStart;
+    uint64_t m_windowBytes = 0;       // Received since m_windowStart
+    uint64_t m_windowWaitNs = 0;      // m_waitNs at m_windowStart
+    int m_resumeAttempts = 0;         // Reconnects since data last flowed
+    bool m_resumePending = false;     // Reconnected, no data yet
+    uint32_t m_stallsRecovered = 0;
+    uint32_t m_stallsLost = 0;
+
+    // Chunked transfer decoding
+    bool m_chunked = false;
+    Chunk m_chunkState = Chunk::Size;
+    uint64_t m_chunkLeft = 0;
+    std::string m_chunkLine;          // Size / trailer line being assembled
+
     // ICY metadata handling
     uint32_t m_icyMetaInt = 0;        // Metadata interval (bytes), 0 = disabled
     uint32_t m_icyBytesUntilMeta = 0; // Countdown to next metadata block
+    size_t m_icySkip = 0;             // Metadata bytes still to discard
+
+    // Shared by the read calls: copies into buf, or with view set (plain
+    // body only) points *view at the data instead
+    ssize_t receive(uint8_t* buf, const uint8_t** view, size_t maxLen, int timeoutMs);
+    ssize_t receiveData(uint8_t* buf, const uint8_t** view, size_t maxLen, int timeoutMs);
+    // Wait for the socket: 1 ready, 0 timeout, -1 error
+    int waitReadable(int timeoutMs);
+    // Decode buffered bytes (chunk framing, ICY) into buf; returns audio bytes
+    size_t decodeBuffered(uint8_t* buf, size_t maxLen);
+    // Consume chunk framing at m_rxPos; false if the buffer ran out first
+    bool parseChunkFraming();
+    // recv(MSG_DONTWAIT) or io_uring, into buf or (io_uring) as *view:
+    // > 0 bytes, 0 = peer closed, -1 = error, -2 = would block
+    ssize_t recvSome(uint8_t* buf, const uint8_t** view, size_t len);
+    // Top up the receive buffer (same returns as recvSome)
+    ssize_t fillBuffer();
+    bool bodyComplete() const;
+
+    // Socket, request and response headers for one connection of the
+    // stream (connectTimeoutMs -1 = block)
+    bool openConnection(const std::string& request, int connectTimeoutMs);
+    void closeConnection();
+    bool resumable() const;
+    // Stall description if the reader has been starved too long, else nullptr
+    const char* stallReason();
+    // Reconnect from m_bytesReceived with a Range request (retries,
+    // backoff); resume() books the time as waiting and restarts the window
+    bool resume(const char* reason);
+    bool reconnect(const char* reason);
+
+    // Bytes the next socket read may take under the pacer (0 = not yet;
+    // sleeps up to timeoutMs for tokens)
+    size_t paceAllowance(size_t maxLen, int timeoutMs);
+    void tuneSocketBuffers(uint64_t rate);
+    void noteConsumed(size_t n);
+    void noteArrival(size_t n);
 
-    // Low-level recv (no ICY handling)
-    ssize_t readRaw(uint8_t* buf, size_t maxLen);
-    // Read and discard ICY metadata block at current position
-    bool skipIcyMetadata();
+    // Fetch thread: body into the spool until EOF or disconnect()
+    void spoolLoop();
+    // read calls with a spool: same returns as receive()
+    ssize_t readSpool(uint8_t* buf, const uint8_t** view, size_t maxLen, int timeoutMs);
 
     bool sendAll(const void* buf, size_t len);
     bool parseResponseHeaders();
+    // Trimmed value of a response header (name lowercase), "" if absent
+    std::string responseHeader(const std::string& name) const;
 };
 
 #endif // SLIM2DIRETTA_HTTP_STREAM_CLIENT_H
@@ -0,0 +1,106 @@
+/**
+ * @file InputQueue.cpp
+ * @brief Encoded-input byte queue implementation
+ */
+
+#include "InputQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+InputQueue::InputQueue(size_t initialCapacity)
+    : m_buf(roundUpPow2(std::max<size_t>(initialCapacity, 4096)))
+    , m_mask(m_buf.size() - 1)
+{
+}
+
+void InputQueue::append(const uint8_t* data, size_t len) {
+    if (len == 0) return;
+    if (retained() + len > m_buf.size()) grow(retained() + len);
+
+    size_t idx = static_cast<size_t>(m_writePos) & m_mask;
+    size_t first = std::min(len, m_buf.size() - idx);
+    std::memcpy(m_buf.data() + idx, data, first);
+    std::memcpy(m_buf.data(), data + first, len - first);
+    m_writePos += len;
+}
+
+const uint8_t* InputQueue::peekContiguous(size_t& len) const {
+    size_t idx = static_cast<size_t>(m_readPos) & m_mask;
+    len = std::min(available(), m_buf.size() - idx);
+    return m_buf.data() + idx;
+}
+
+const uint8_t* InputQueue::peek(size_t len) {
+    size_t contiguous = 0;
+    const uint8_t* p = peekContiguous(contiguous);
+    if (len <= contiguous) return p;
+
+    len = std::min(len, available());
+    if (m_scratch.size() < len) m_scratch.resize(len);
+    copyOut(m_readPos, m_scratch.data(), len);
+    return m_scratch.data();
+}
+
+size_t InputQueue::read(uint8_t* dst, size_t len) {
+    size_t n = readAhead(dst, len);
+    m_retainPos = m_readPos;
+    return n;
+}
+
+size_t InputQueue::readAhead(uint8_t* dst, size_t len) {
+    size_t n = std::min(len, available());
+    copyOut(m_readPos, dst, n);
+    m_readPos += n;
+    return n;
+}
+
+void InputQueue::consume(size_t len) {
+    m_readPos += std::min(len, available());
+    m_retainPos = m_readPos;
+}
+
+void InputQueue::rewind(uint64_t pos) {
+    m_readPos = std::max(m_retainPos, std::min(pos, m_readPos));
+}
+
+void InputQueue::release(uint64_t pos) {
+    m_retainPos = std::max(m_retainPos, std::min(pos, m_readPos));
+}
+
+void InputQueue::clear() {
+    m_retainPos = m_readPos = m_writePos = 0;
+}
+
+void InputQueue::grow(size_t needed) {
+    std::vector<uint8_t> bigger(roundUpPow2(needed));
+    size_t newMask = bigger.size() - 1;
+
+    // Re-place the retained bytes at their indices under the new mask
+    size_t len = retained();
+    size_t idx = static_cast<size_t>(m_retainPos) & newMask;
+    size_t first = std::min(len, bigger.size() - idx);
+    copyOut(m_retainPos, bigger.data() + idx, first);
+    copyOut(m_retainPos + first, bigger.data(), len - first);
+
+    m_buf.swap(bigger);
+    m_mask = newMask;
+}
+
+void InputQueue::copyOut(uint64_t pos, uint8_t* dst, size_t len) const {
+    if (len == 0) return;
+    size_t idx = static_cast<size_t>(pos) & m_mask;
+    size_t first = std::min(len, m_buf.size() - idx);
+    std::memcpy(dst, m_buf.data() + idx, first);
+    std::memcpy(dst + first, m_buf.data(), len - first);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file InputQueue.h
+ * @brief Encoded-input byte queue shared by the decoders
+ *
+ * Growable power-of-two ring addressed by absolute stream positions.
+ * feed() appends at the write position, decoders read from the read
+ * position, and bytes are only dropped once released — consuming from
+ * the front never moves the backlog, however far ahead the network is.
+ *
+ * Read-ahead with rollback (FlacDecoder): readAhead() advances the read
+ * position but keeps the bytes, rewind() goes back to any retained
+ * position, release() drops everything before a confirmed position.
+ * Simple consumers use read()/consume(), which release as they go.
+ */
+
+#ifndef SLIM2DIRETTA_INPUT_QUEUE_H
+#define SLIM2DIRETTA_INPUT_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class InputQueue {
+public:
+    explicit InputQueue(size_t initialCapacity = 65536);
+
+    /// Append bytes at the write position (grows the ring when full)
+    void append(const uint8_t* data, size_t len);
+
+    /// Bytes between the read and write positions
+    size_t available() const { return static_cast<size_t>(m_writePos - m_readPos); }
+    /// Bytes still stored (from the oldest retained position)
+    size_t retained() const { return static_cast<size_t>(m_writePos - m_retainPos); }
+    bool empty() const { return m_writePos == m_readPos; }
+
+    /// Absolute stream positions (bytes appended since clear())
+    uint64_t readPosition() const { return m_readPos; }
+    uint64_t retainPosition() const { return m_retainPos; }
+
+    /**
+     * @brief Longest run of readable bytes that is contiguous in memory
+     * @param len Set to the run length (< available() only at the ring wrap)
+     */
+    const uint8_t* peekContiguous(size_t& len) const;
+
+    /**
+     * @brief Pointer to len contiguous readable bytes (len <= available())
+     *
+     * Zero-copy except when the range wraps, where it is copied into a
+     * scratch buffer. Valid until the next non-const call.
+     */
+    const uint8_t* peek(size_t len);
+
+    /// Copy out and release up to len bytes
+    size_t read(uint8_t* dst, size_t len);
+    /// Copy out up to len bytes, keeping them for rewind()
+    size_t readAhead(uint8_t* dst, size_t len);
+
+    /// Advance the read position and release the bytes
+    void consume(size_t len);
+
+    /// Move the read position back to a retained position
+    void rewind(uint64_t pos);
+    /// Drop retained bytes before pos (clamped to the read position)
+    void release(uint64_t pos);
+
+    /// Empty the queue and restart positions at 0 (capacity is kept)
+    void clear();
+
+private:
+    void grow(size_t needed);
+    void copyOut(uint64_t pos, uint8_t* dst, size_t len) const;
+
+    std::vector<uint8_t> m_buf;
+    size_t m_mask;
+    uint64_t m_retainPos = 0;
+    uint64_t m_readPos = 0;
+    uint64_t m_writePos = 0;
+    std::vector<uint8_t> m_scratch;  // peek() across the wrap
+};
+
+#endif // SLIM2DIRETTA_INPUT_QUEUE_H
@@ -0,0 +1,146 @@
+/**
+ * @file MemoryBudget.cpp
+ * @brief Memory budget split implementation
+ */
+
+#include "MemoryBudget.h"
+#include "LogLevel.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+// Floors — below these the pipeline stops being robust, budget or not
+constexpr size_t MIN_RING_BYTES = 65536;         // == DirettaBuffer::MIN_BUFFER_BYTES
+constexpr float MIN_CACHE_SECONDS = 0.5f;        // one decode burst + HTTP jitter
+constexpr float MIN_DSD_BUFFER_SECONDS = 0.25f;  // half the DSD prebuffer
+
+// Decode cache / DSD buffer wanted when the budget is large enough
+constexpr float WANTED_CACHE_SECONDS = 3.0f;
+constexpr float WANTED_DSD_BUFFER_SECONDS = 1.0f;
+
+// Ring share of the budget per codec class. Compressed streams decode in
+// bursts, so the cache earns a larger share; uncompressed PCM and DSD are
+// copied straight through and the ring is what rides out network stalls.
+float ringWeight(CodecClass c) {
+    switch (c) {
+        case CodecClass::Compressed:   return 0.60f;
+        case CodecClass::Uncompressed: return 0.75f;
+        case CodecClass::Dsd:          return 0.50f;
+    }
+    return 0.60f;
+}
+
+size_t secondsToBytes(float seconds, uint64_t bytesPerSecond) {
+    return static_cast<size_t>(seconds * static_cast<double>(bytesPerSecond));
+}
+
+float bytesToSeconds(size_t bytes, uint64_t bytesPerSecond) {
+    return bytesPerSecond > 0
+        ? static_cast<float>(static_cast<double>(bytes) / bytesPerSecond) : 0.0f;
+}
+
+// Divide budget between ring and input buffer: weighted shares first, then
+// any share one side doesn't need goes to the other. Floors always apply.
+void divide(size_t budget, float weight, size_t wantRing, size_t wantInput,
+            size_t minRing, size_t minInput, size_t& ring, size_t& input) {
+    ring = std::min(wantRing, static_cast<size_t>(budget * weight));
+    input = std::min(wantInput, budget - ring);
+    ring = std::min(wantRing, budget - input);
+    ring = std::max(ring, minRing);
+    input = std::max(input, minInput);
+}
+
+} // namespace
+
+BudgetSplit MemoryBudget::plan(const BudgetRequest& req) {
+    BudgetSplit split;
+    const bool dsd = (req.codecClass == CodecClass::Dsd);
+
+    if (!isEnabled()) {
+        // Built-in sizing: DirettaSync picks the ring and DsdStreamReader
+        // its buffer (both in seconds); fixed decode cache cap
+        split.ringBytes = 0;
+        split.decodeCacheBytes = DEFAULT_DECODE_CACHE_BYTES;
+        split.dsdBufferBytes = 0;
+        split.ringSeconds = req.ringSeconds;
+    } else {
+        size_t wantRing = std::max(secondsToBytes(req.ringSeconds, req.ringBytesPerSecond),
+                                   MIN_RING_BYTES);
+        size_t wantInput = secondsToBytes(dsd ? WANTED_DSD_BUFFER_SECONDS
+                                              : WANTED_CACHE_SECONDS,
+                                          req.inputBytesPerSecond);
+        size_t minInput = secondsToBytes(dsd ? MIN_DSD_BUFFER_SECONDS
+                                             : MIN_CACHE_SECONDS,
+                                         req.inputBytesPerSecond);
+        size_t ring = 0, input = 0;
+        divide(m_budgetBytes, ringWeight(req.codecClass), wantRing, wantInput,
+               MIN_RING_BYTES, minInput, ring, input);
+
+        if (ring + input > m_budgetBytes) {
+            LOG_WARN("[Memory] Budget " << (m_budgetBytes >> 20) << " MB below the minimum for this format ("
+                     << ((ring + input) >> 20) << " MB) — using the minimum");
+        }
+
+        split.ringBytes = ring;
+        split.ringSeconds = bytesToSeconds(ring, req.ringBytesPerSecond);
+        if (dsd) {
+            split.dsdBufferBytes = input;
+        } else {
+            split.decodeCacheBytes = input;
+        }
+    }
+
+    split.decodeCacheSeconds = dsd ? 0.0f
+        : bytesToSeconds(split.decodeCacheBytes, req.inputBytesPerSecond);
+    split.dsdBufferSeconds = dsd
+        ? bytesToSeconds(split.dsdBufferBytes, req.inputBytesPerSecond) : 0.0f;
+    if (dsd) split.decodeCacheBytes = 0;
+    else split.dsdBufferBytes = 0;
+
+    m_ringBytes.store(split.ringBytes, std::memory_order_relaxed);
+    m_decodeCacheBytes.store(split.decodeCacheBytes, std::memory_order_relaxed);
+    m_dsdBufferBytes.store(split.dsdBufferBytes, std::memory_order_relaxed);
+    m_ringMs.store(static_cast<uint32_t>(split.ringSeconds * 1000.0f), std::memory_order_relaxed);
+    m_decodeCacheMs.store(static_cast<uint32_t>(split.decodeCacheSeconds * 1000.0f), std::memory_order_relaxed);
+    m_dsdBufferMs.store(static_cast<uint32_t>(split.dsdBufferSeconds * 1000.0f), std::memory_order_relaxed);
+    m_planned.store(true, std::memory_order_release);
+
+    if (isEnabled()) {
+        LOG_INFO("[Memory] Budget split: ring " << (split.ringBytes >> 10) << " KB ("
+                 << std::fixed << std::setprecision(2) << split.ringSeconds << "s), "
+                 << (dsd ? "DSD buffer " : "decode cache ")
+                 << ((dsd ? split.dsdBufferBytes : split.decodeCacheBytes) >> 10) << " KB ("
+                 << (dsd ? split.dsdBufferSeconds : split.decodeCacheSeconds) << "s)"
+                 << std::defaultfloat);
+    }
+    return split;
+}
+
+void MemoryBudget::dumpStats() const {
+    std::cout << "[Memory] Budget: ";
+    if (isEnabled()) {
+        std::cout << (m_budgetBytes >> 20) << " MB";
+    } else {
+        std::cout << "unlimited (built-in sizing)";
+    }
+    std::cout << std::endl;
+    if (!m_planned.load(std::memory_order_acquire)) return;
+
+    auto line = [](const char* name, size_t bytes, uint32_t ms) {
+        std::cout << "  " << name << (bytes > 0 ? std::to_string(bytes >> 10) + " KB"
+                                                : std::string("built-in"))
+                  << " (" << ms << " ms)" << std::endl;
+    };
+    line("Ring:        ", m_ringBytes.load(std::memory_order_relaxed),
+         m_ringMs.load(std::memory_order_relaxed));
+    size_t cache = m_decodeCacheBytes.load(std::memory_order_relaxed);
+    if (cache > 0) {
+        line("DecodeCache: ", cache, m_decodeCacheMs.load(std::memory_order_relaxed));
+    }
+    size_t dsdBuf = m_dsdBufferBytes.load(std::memory_order_relaxed);
+    if (dsdBuf > 0) {
+        line("DsdBuffer:   ", dsdBuf, m_dsdBufferMs.load(std::memory_order_relaxed));
+    }
+}
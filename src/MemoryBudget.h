@@ -0,0 +1,82 @@
+/**
+ * @file MemoryBudget.h
+ * @brief Single memory budget shared by the audio buffers
+ *
+ * Three buffers hold audio between LMS and the Diretta target:
+ * - the DirettaSync ring buffer (sink format, consumed by the SDK worker)
+ * - the PCM decode cache (S32 samples, filled while the ring is full)
+ * - the DsdStreamReader input buffer (raw DSD container bytes)
+ *
+ * Without a budget each keeps its built-in sizing. With --memory-budget the
+ * byte budget is divided between the buffers active for the current format,
+ * in seconds of audio at that format's byte rate, weighted by codec class.
+ * Small boards running several instances can then bound each one's RSS.
+ */
+
+#ifndef SLIM2DIRETTA_MEMORY_BUDGET_H
+#define SLIM2DIRETTA_MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class CodecClass {
+    Compressed,     // FLAC, MP3, Ogg, AAC, ALAC — bursty decode, cache matters
+    Uncompressed,   // WAV, AIFF, raw PCM — cache is a plain copy
+    Dsd             // native DSD — ring + DsdStreamReader buffer
+};
+
+/// Format description the split is computed from
+struct BudgetRequest {
+    CodecClass codecClass = CodecClass::Compressed;
+    uint64_t ringBytesPerSecond = 0;    // ring (sink format) byte rate
+    uint64_t inputBytesPerSecond = 0;   // decode cache (S32) or DSD reader byte rate
+    float ringSeconds = 0.0f;           // ring size wanted without a budget
+};
+
+/// Resulting per-buffer limits (bytes and seconds of audio)
+struct BudgetSplit {
+    size_t ringBytes = 0;               // 0 = DirettaSync built-in sizing
+    size_t decodeCacheBytes = 0;
+    size_t dsdBufferBytes = 0;          // 0 = DsdStreamReader built-in sizing
+    float ringSeconds = 0.0f;
+    float decodeCacheSeconds = 0.0f;
+    float dsdBufferSeconds = 0.0f;
+};
+
+class MemoryBudget {
+public:
+    // Built-in limits used when no budget is configured
+    static constexpr size_t DEFAULT_DECODE_CACHE_BYTES = 9216000 * sizeof(int32_t);
+
+    /// @param budgetBytes Total bytes for all buffers (0 = unlimited)
+    explicit MemoryBudget(size_t budgetBytes = 0) : m_budgetBytes(budgetBytes) {}
+
+    bool isEnabled() const { return m_budgetBytes > 0; }
+    size_t getBudgetBytes() const { return m_budgetBytes; }
+
+    /**
+     * @brief Divide the budget for a new format and remember the result
+     *
+     * Called by the audio thread once the format is known, before the
+     * ring is (re)configured.
+     */
+    BudgetSplit plan(const BudgetRequest& req);
+
+    /// Print the last split (SIGUSR1 stats)
+    void dumpStats() const;
+
+private:
+    size_t m_budgetBytes;
+
+    // Last split, read by the stats handler from another thread
+    std::atomic<size_t> m_ringBytes{0};
+    std::atomic<size_t> m_decodeCacheBytes{0};
+    std::atomic<size_t> m_dsdBufferBytes{0};
+    std::atomic<uint32_t> m_ringMs{0};
+    std::atomic<uint32_t> m_decodeCacheMs{0};
+    std::atomic<uint32_t> m_dsdBufferMs{0};
+    std::atomic<bool> m_planned{false};
+};
+
+#endif // SLIM2DIRETTA_MEMORY_BUDGET_H
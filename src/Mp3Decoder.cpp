@@ -18,6 +18,23 @@
 #include <cstring>
 #include <algorithm>
 
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+// libmpg123 is loaded by Decoder::create() (CodecLoader.h)
+#define mpg123_init           CODEC_SYMBOL(CodecLoader::MPG123, mpg123_init)
+#define mpg123_new            CODEC_SYMBOL(CodecLoader::MPG123, mpg123_new)
+#define mpg123_delete         CODEC_SYMBOL(CodecLoader::MPG123, mpg123_delete)
+#define mpg123_open_feed      CODEC_SYMBOL(CodecLoader::MPG123, mpg123_open_feed)
+#define mpg123_close          CODEC_SYMBOL(CodecLoader::MPG123, mpg123_close)
+#define mpg123_feed           CODEC_SYMBOL(CodecLoader::MPG123, mpg123_feed)
+#define mpg123_read           CODEC_SYMBOL(CodecLoader::MPG123, mpg123_read)
+#define mpg123_getformat      CODEC_SYMBOL(CodecLoader::MPG123, mpg123_getformat)
+#define mpg123_format_none    CODEC_SYMBOL(CodecLoader::MPG123, mpg123_format_none)
+#define mpg123_format         CODEC_SYMBOL(CodecLoader::MPG123, mpg123_format)
+#define mpg123_strerror       CODEC_SYMBOL(CodecLoader::MPG123, mpg123_strerror)
+#define mpg123_plain_strerror CODEC_SYMBOL(CodecLoader::MPG123, mpg123_plain_strerror)
+#endif
+
 std::once_flag Mp3Decoder::s_initFlag;
 
 Mp3Decoder::Mp3Decoder() {
@@ -26,7 +43,6 @@ Mp3Decoder::Mp3Decoder() {
         mpg123_init();
     });
 
-    m_outputBuffer.reserve(16384);
 }
 
 Mp3Decoder::~Mp3Decoder() {
@@ -37,12 +53,30 @@ Mp3Decoder::~Mp3Decoder() {
 }
 
 bool Mp3Decoder::initHandle() {
-    int err;
-    m_handle = mpg123_new(nullptr, &err);
+    // The mpg123 handle survives flush() (only the feed is closed), so a
+    // pooled decoder just reopens the feed on the next track.
     if (!m_handle) {
-        LOG_ERROR("[MP3] Failed to create decoder: " << mpg123_plain_strerror(err));
-        m_error = true;
-        return false;
+        int err;
+        m_handle = mpg123_new(nullptr, &err);
+        if (!m_handle) {
+            LOG_ERROR("[MP3] Failed to create decoder: " << mpg123_plain_strerror(err));
+            m_error = true;
+            return false;
+        }
+
+        // Clear all format constraints, then set our desired output
+        mpg123_format_none(m_handle);
+
+        // Accept any sample rate, mono or stereo, 32-bit signed output
+        // mpg123 will scale to full 32-bit range (MSB-aligned)
+        const long rates[] = {
+            8000, 11025, 12000, 16000, 22050, 24000,
+            32000, 44100, 48000
+        };
+        for (long rate : rates) {
+            mpg123_format(m_handle, rate, MPG123_MONO | MPG123_STEREO,
+                          MPG123_ENC_SIGNED_32);
+        }
     }
 
     // Open in feed mode (streaming, no file)
@@ -54,20 +88,6 @@ bool Mp3Decoder::initHandle() {
         return false;
     }
 
-    // Clear all format constraints, then set our desired output
-    mpg123_format_none(m_handle);
-
-    // Accept any sample rate, mono or stereo, 32-bit signed output
-    // mpg123 will scale to full 32-bit range (MSB-aligned)
-    const long rates[] = {
-        8000, 11025, 12000, 16000, 22050, 24000,
-        32000, 44100, 48000
-    };
-    for (long rate : rates) {
-        mpg123_format(m_handle, rate, MPG123_MONO | MPG123_STEREO,
-                      MPG123_ENC_SIGNED_32);
-    }
-
     m_initialized = true;
     return true;
 }
@@ -98,14 +118,16 @@ size_t Mp3Decoder::readDecoded(int32_t* out, size_t maxFrames) {
 
     // Decode into output buffer
     size_t channels = m_formatReady ? m_format.channels : 2;
-    size_t outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+    size_t outputFrames = m_output.available() / std::max(channels, size_t(1));
 
     while (outputFrames < maxFrames) {
-        // Temp buffer for mpg123 output (max ~1152 frames * 2 ch * 4 bytes)
-        unsigned char tmpBuf[1152 * 2 * sizeof(int32_t)];
+        // mpg123 writes straight into the output queue (max 1152 frames * 2 ch)
+        constexpr size_t MAX_CHUNK = 1152 * 2;
+        int32_t* dst = m_output.prepare(MAX_CHUNK);
         size_t done = 0;
 
-        int ret = mpg123_read(m_handle, tmpBuf, sizeof(tmpBuf), &done);
+        int ret = mpg123_read(m_handle, reinterpret_cast<unsigned char*>(dst),
+                              MAX_CHUNK * sizeof(int32_t), &done);
 
         if (ret == MPG123_NEW_FORMAT) {
             long rate;
@@ -125,9 +147,7 @@ size_t Mp3Decoder::readDecoded(int32_t* out, size_t maxFrames) {
         if (done > 0) {
             // mpg123 outputs int32_t in native byte order when using MPG123_ENC_SIGNED_32
             // Already full-scale 32-bit, no shift needed
-            size_t samples = done / sizeof(int32_t);
-            const int32_t* src = reinterpret_cast<const int32_t*>(tmpBuf);
-            m_outputBuffer.insert(m_outputBuffer.end(), src, src + samples);
+            m_output.commit(done / sizeof(int32_t));
         }
 
         if (ret == MPG123_NEED_MORE) {
@@ -148,41 +168,28 @@ size_t Mp3Decoder::readDecoded(int32_t* out, size_t maxFrames) {
             break;
         }
 
-        outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+        outputFrames = m_output.available() / std::max(channels, size_t(1));
     }
 
     // Copy available output frames
     if (!m_formatReady || m_format.channels == 0) return 0;
 
-    size_t framesAvailable = (m_outputBuffer.size() - m_outputPos) / m_format.channels;
+    size_t framesAvailable = m_output.available() / m_format.channels;
     size_t framesToCopy = std::min(framesAvailable, maxFrames);
 
     if (framesToCopy > 0) {
-        size_t samplesToCopy = framesToCopy * m_format.channels;
-        std::memcpy(out, m_outputBuffer.data() + m_outputPos,
-                    samplesToCopy * sizeof(int32_t));
-        m_outputPos += samplesToCopy;
+        m_output.read(out, framesToCopy * m_format.channels);
         m_decodedSamples += framesToCopy;
-
-        // Compact output buffer
-        if (m_outputPos > 0) {
-            m_outputBuffer.erase(m_outputBuffer.begin(),
-                                 m_outputBuffer.begin() + m_outputPos);
-            m_outputPos = 0;
-        }
     }
 
     return framesToCopy;
 }
 
 void Mp3Decoder::flush() {
-    if (m_handle) {
+    if (m_handle && m_initialized) {
         mpg123_close(m_handle);
-        mpg123_delete(m_handle);
-        m_handle = nullptr;
     }
-    m_outputBuffer.clear();
-    m_outputPos = 0;
+    m_output.clear();
     m_format = {};
     m_formatReady = false;
     m_initialized = false;
@@ -14,8 +14,8 @@
 #define SLIM2DIRETTA_MP3_DECODER_H
 
 #include "Decoder.h"
+#include "SampleQueue.h"
 #include <mpg123.h>
-#include <vector>
 #include <mutex>
 
 class Mp3Decoder : public Decoder {
@@ -31,6 +31,7 @@ public:
     bool isFinished() const override { return m_finished; }
     bool hasError() const override { return m_error; }
     uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
     void flush() override;
 
 private:
@@ -38,9 +39,8 @@ private:
 
     mpg123_handle* m_handle = nullptr;
 
-    // Output buffer (S32_LE interleaved, MSB-aligned)
-    std::vector<int32_t> m_outputBuffer;
-    size_t m_outputPos = 0;
+    // Output queue (S32_LE interleaved, MSB-aligned)
+    SampleQueue m_output;
 
     DecodedFormat m_format;
     bool m_formatReady = false;
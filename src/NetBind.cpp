@@ -0,0 +1,41 @@
+/**
+ * @file NetBind.cpp
+ * @brief Interface / source address binding for outgoing TCP sockets
+ */
+
+#include "NetBind.h"
+#include "LogLevel.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+
+#include <cerrno>
+#include <cstring>
+
+bool bindSocket(int fd, const std::string& spec, const char* tag) {
+    if (spec.empty()) return true;
+
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    if (inet_pton(AF_INET, spec.c_str(), &addr.sin_addr) == 1) {
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            LOG_ERROR(tag << " Cannot bind to " << spec << ": " << strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    if (spec.size() >= IFNAMSIZ) {
+        LOG_ERROR(tag << " Invalid interface name: " << spec);
+        return false;
+    }
+    if (setsockopt(fd, SOL_SOCKET, SO_BINDTODEVICE, spec.c_str(),
+                   static_cast<socklen_t>(spec.size() + 1)) != 0) {
+        LOG_ERROR(tag << " Cannot bind to interface " << spec << ": " << strerror(errno)
+                  << (errno == EPERM ? " (needs CAP_NET_RAW)" : ""));
+        return false;
+    }
+    return true;
+}
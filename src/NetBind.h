@@ -0,0 +1,26 @@
+/**
+ * @file NetBind.h
+ * @brief Interface / source address binding for outgoing TCP sockets
+ *
+ * --stream-bind and --control-bind put the HTTP stream and the Slimproto
+ * connection on a chosen interface, e.g. to keep stream bursts off the
+ * NIC that carries Diretta traffic. A spec is either an IPv4 address
+ * (source address; the route still picks the interface unless policy
+ * routing is set up for it) or an interface name (SO_BINDTODEVICE, needs
+ * CAP_NET_RAW).
+ */
+
+#ifndef SLIM2DIRETTA_NET_BIND_H
+#define SLIM2DIRETTA_NET_BIND_H
+
+#include <string>
+
+/**
+ * @brief Bind a socket before connect()
+ * @param spec IPv4 address or interface name ("" = leave unbound)
+ * @param tag Log prefix, e.g. "[HTTP]"
+ * @return false (logged) if the binding failed
+ */
+bool bindSocket(int fd, const std::string& spec, const char* tag);
+
+#endif // SLIM2DIRETTA_NET_BIND_H
@@ -4,8 +4,9 @@
  *
  * Key design: libvorbisfile with custom non-seekable callbacks.
  * - readCallback() pulls data from the internal input buffer
- * - ov_read() decodes Vorbis audio to 16-bit PCM
- * - Output is converted to S32_LE MSB-aligned (shift left 16)
+ * - ov_read_float() hands out libvorbis' own planar float output
+ * - SampleConverter interleaves it to S32_LE with clipping (24-bit
+ *   effective resolution — a float mantissa — instead of ov_read()'s int16)
  *
  * Handles:
  * - OV_HOLE: gaps in data (normal for radio streams, logged and skipped)
@@ -15,14 +16,23 @@
 
 #include "OggDecoder.h"
 #include "LogLevel.h"
+#include "SampleConverter.h"
 
 #include <cstring>
 #include <algorithm>
 #include <cerrno>
 
+#ifdef ENABLE_DLOPEN_CODECS
+#include "CodecLoader.h"
+// libvorbisfile is loaded by Decoder::create() (CodecLoader.h)
+#define ov_open_callbacks CODEC_SYMBOL(CodecLoader::VORBISFILE, ov_open_callbacks)
+#define ov_clear          CODEC_SYMBOL(CodecLoader::VORBISFILE, ov_clear)
+#define ov_info           CODEC_SYMBOL(CodecLoader::VORBISFILE, ov_info)
+#define ov_read           CODEC_SYMBOL(CodecLoader::VORBISFILE, ov_read)
+#define ov_read_float     CODEC_SYMBOL(CodecLoader::VORBISFILE, ov_read_float)
+#endif
+
 OggDecoder::OggDecoder() {
-    m_inputBuffer.reserve(65536);
-    m_outputBuffer.reserve(16384);
     std::memset(&m_vf, 0, sizeof(m_vf));
 }
 
@@ -33,7 +43,7 @@ OggDecoder::~OggDecoder() {
 }
 
 size_t OggDecoder::feed(const uint8_t* data, size_t len) {
-    m_inputBuffer.insert(m_inputBuffer.end(), data, data + len);
+    m_input.append(data, len);
     return len;
 }
 
@@ -44,10 +54,9 @@ void OggDecoder::setEof() {
 size_t OggDecoder::readCallback(void* ptr, size_t size, size_t nmemb, void* datasource) {
     auto* self = static_cast<OggDecoder*>(datasource);
 
-    size_t available = self->m_inputBuffer.size() - self->m_inputPos;
     size_t requested = size * nmemb;
 
-    if (available == 0) {
+    if (self->m_input.empty()) {
         if (self->m_eof) {
             return 0;  // EOF
         }
@@ -56,17 +65,7 @@ size_t OggDecoder::readCallback(void* ptr, size_t size, size_t nmemb, void* data
         return 0;
     }
 
-    size_t toRead = std::min(available, requested);
-    std::memcpy(ptr, self->m_inputBuffer.data() + self->m_inputPos, toRead);
-    self->m_inputPos += toRead;
-
-    // Compact input buffer periodically
-    if (self->m_inputPos > 32768) {
-        self->m_inputBuffer.erase(self->m_inputBuffer.begin(),
-                                   self->m_inputBuffer.begin() + self->m_inputPos);
-        self->m_inputPos = 0;
-    }
-
+    size_t toRead = self->m_input.read(static_cast<uint8_t*>(ptr), requested);
     return toRead / size;
 }
 
@@ -75,8 +74,7 @@ size_t OggDecoder::readDecoded(int32_t* out, size_t maxFrames) {
 
     // Lazy init: open vorbisfile on first call with enough data
     if (!m_initialized) {
-        size_t available = m_inputBuffer.size() - m_inputPos;
-        if (available < 4096 && !m_eof) {
+        if (m_input.available() < 4096 && !m_eof) {
             return 0;  // Wait for more data before attempting init
         }
 
@@ -105,7 +103,7 @@ size_t OggDecoder::readDecoded(int32_t* out, size_t maxFrames) {
         if (vi) {
             m_format.sampleRate = static_cast<uint32_t>(vi->rate);
             m_format.channels = static_cast<uint32_t>(vi->channels);
-            m_format.bitDepth = 16;
+            m_format.bitDepth = 24;  // Float output, 24-bit mantissa
             m_format.totalSamples = 0;  // Unknown for streams
             m_formatReady = true;
             m_currentBitstream = 0;
@@ -116,20 +114,15 @@ size_t OggDecoder::readDecoded(int32_t* out, size_t maxFrames) {
 
     // Decode into output buffer
     size_t channels = m_formatReady ? m_format.channels : 2;
-    size_t outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+    size_t outputFrames = m_output.available() / std::max(channels, size_t(1));
 
     while (outputFrames < maxFrames) {
         // Check if we have data to decode
-        size_t available = m_inputBuffer.size() - m_inputPos;
-        if (available == 0 && !m_eof) break;
+        if (m_input.empty() && !m_eof) break;
 
-        char pcmBuf[4096];
+        float** pcm = nullptr;
         int bitstream = 0;
-        long ret = ov_read(&m_vf, pcmBuf, sizeof(pcmBuf),
-                           0 /* little-endian */,
-                           2 /* 16-bit */,
-                           1 /* signed */,
-                           &bitstream);
+        long ret = ov_read_float(&m_vf, &pcm, READ_FRAMES, &bitstream);
 
         if (ret > 0) {
             // Check for chained stream (format change)
@@ -145,12 +138,12 @@ size_t OggDecoder::readDecoded(int32_t* out, size_t maxFrames) {
                 }
             }
 
-            // Convert 16-bit signed to S32_LE MSB-aligned
-            size_t numSamples = static_cast<size_t>(ret) / 2;  // 2 bytes per sample
-            const int16_t* src = reinterpret_cast<const int16_t*>(pcmBuf);
-            for (size_t i = 0; i < numSamples; i++) {
-                m_outputBuffer.push_back(static_cast<int32_t>(src[i]) << 16);
-            }
+            // Planar float -> interleaved S32_LE (ret = frames)
+            size_t frames = static_cast<size_t>(ret);
+            size_t numSamples = frames * channels;
+            SampleConverter::interleaveFloat(pcm, channels, frames,
+                                             m_output.prepare(numSamples));
+            m_output.commit(numSamples);
         } else if (ret == 0) {
             // EOF or need more data
             if (m_eof) {
@@ -177,28 +170,18 @@ size_t OggDecoder::readDecoded(int32_t* out, size_t maxFrames) {
             break;
         }
 
-        outputFrames = (m_outputBuffer.size() - m_outputPos) / std::max(channels, size_t(1));
+        outputFrames = m_output.available() / std::max(channels, size_t(1));
     }
 
     // Copy available output frames
     if (!m_formatReady || m_format.channels == 0) return 0;
 
-    size_t framesAvailable = (m_outputBuffer.size() - m_outputPos) / m_format.channels;
+    size_t framesAvailable = m_output.available() / m_format.channels;
     size_t framesToCopy = std::min(framesAvailable, maxFrames);
 
     if (framesToCopy > 0) {
-        size_t samplesToCopy = framesToCopy * m_format.channels;
-        std::memcpy(out, m_outputBuffer.data() + m_outputPos,
-                    samplesToCopy * sizeof(int32_t));
-        m_outputPos += samplesToCopy;
+        m_output.read(out, framesToCopy * m_format.channels);
         m_decodedSamples += framesToCopy;
-
-        // Compact output buffer
-        if (m_outputPos > 0) {
-            m_outputBuffer.erase(m_outputBuffer.begin(),
-                                 m_outputBuffer.begin() + m_outputPos);
-            m_outputPos = 0;
-        }
     }
 
     return framesToCopy;
@@ -210,10 +193,8 @@ void OggDecoder::flush() {
         m_vfOpen = false;
     }
     std::memset(&m_vf, 0, sizeof(m_vf));
-    m_inputBuffer.clear();
-    m_inputPos = 0;
-    m_outputBuffer.clear();
-    m_outputPos = 0;
+    m_input.clear();
+    m_output.clear();
     m_format = {};
     m_formatReady = false;
     m_initialized = false;
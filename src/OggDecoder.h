@@ -4,7 +4,7 @@
  *
  * Uses libvorbisfile with custom non-seekable callbacks for streaming:
  * - feed() accumulates encoded Ogg data into an internal buffer
- * - readDecoded() pulls decoded S32_LE interleaved samples via ov_read()
+ * - readDecoded() pulls decoded S32_LE interleaved samples via ov_read_float()
  *
  * Handles chained Ogg streams (format changes) and OV_HOLE gaps
  * (normal for internet radio streams).
@@ -14,8 +14,9 @@
 #define SLIM2DIRETTA_OGG_DECODER_H
 
 #include "Decoder.h"
+#include "SampleQueue.h"
+#include "InputQueue.h"
 #include <vorbis/vorbisfile.h>
-#include <vector>
 
 class OggDecoder : public Decoder {
 public:
@@ -30,22 +31,24 @@ public:
     bool isFinished() const override { return m_finished; }
     bool hasError() const override { return m_error; }
     uint64_t getDecodedSamples() const override { return m_decodedSamples; }
+    uint64_t getOutputBytesMoved() const override { return m_output.bytesMoved(); }
     void flush() override;
 
 private:
     // Custom read callback for vorbisfile (non-seekable stream)
     static size_t readCallback(void* ptr, size_t size, size_t nmemb, void* datasource);
 
+    // Frames per ov_read_float() call
+    static constexpr int READ_FRAMES = 1024;
+
     OggVorbis_File m_vf;
     bool m_vfOpen = false;
 
-    // Input buffer (fed by caller, consumed by readCallback)
-    std::vector<uint8_t> m_inputBuffer;
-    size_t m_inputPos = 0;
+    // Input queue (fed by caller, consumed by readCallback)
+    InputQueue m_input;
 
-    // Output buffer (S32_LE interleaved, MSB-aligned)
-    std::vector<int32_t> m_outputBuffer;
-    size_t m_outputPos = 0;
+    // Output queue (S32_LE interleaved, MSB-aligned)
+    SampleQueue m_output;
 
     DecodedFormat m_format;
     bool m_formatReady = false;
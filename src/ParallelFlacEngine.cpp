@@ -0,0 +1,583 @@
+/**
+ * @file ParallelFlacEngine.cpp
+ * @brief Frame-parallel FLAC decoding implementation
+ *
+ * Frame boundaries: a candidate is a 14-bit sync code (0xFFF8/0xFFF9) whose
+ * header parses, passes its CRC-8 and matches the first frame's blocking
+ * strategy, sample rate and sample size codes. It is only accepted when the
+ * bytes since the current frame start also end in a matching CRC-16 footer,
+ * so sync-like patterns inside compressed audio never split a frame.
+ *
+ * Workers are primed with a synthetic "fLaC" + STREAMINFO header per stream,
+ * then decode batches with process_single(). Batches always end on a frame
+ * boundary, so libFLAC never holds read-ahead across batches.
+ */
+
+#include "ParallelFlacEngine.h"
+#include "LogLevel.h"
+#include "SampleConverter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+namespace {
+
+struct CrcTables {
+    uint8_t crc8[256];
+    uint16_t crc16[256];
+
+    CrcTables() {
+        for (unsigned i = 0; i < 256; i++) {
+            uint8_t c8 = static_cast<uint8_t>(i);
+            uint16_t c16 = static_cast<uint16_t>(i << 8);
+            for (int b = 0; b < 8; b++) {
+                c8 = (c8 & 0x80) ? static_cast<uint8_t>((c8 << 1) ^ 0x07)
+                                 : static_cast<uint8_t>(c8 << 1);
+                c16 = (c16 & 0x8000) ? static_cast<uint16_t>((c16 << 1) ^ 0x8005)
+                                     : static_cast<uint16_t>(c16 << 1);
+            }
+            crc8[i] = c8;
+            crc16[i] = c16;
+        }
+    }
+};
+
+const CrcTables& crcTables() {
+    static const CrcTables tables;
+    return tables;
+}
+
+uint8_t crc8(const uint8_t* p, size_t len) {
+    const auto& t = crcTables();
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) crc = t.crc8[crc ^ p[i]];
+    return crc;
+}
+
+uint16_t crc16(const uint8_t* p, size_t len) {
+    const auto& t = crcTables();
+    uint16_t crc = 0;
+    for (size_t i = 0; i < len; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ t.crc16[(crc >> 8) ^ p[i]]);
+    }
+    return crc;
+}
+
+// Big-endian bit writer for the STREAMINFO block
+void putBits(uint8_t* dst, size_t& bitPos, uint64_t value, int bits) {
+    for (int i = bits - 1; i >= 0; i--) {
+        if ((value >> i) & 1) dst[bitPos >> 3] |= static_cast<uint8_t>(0x80 >> (bitPos & 7));
+        bitPos++;
+    }
+}
+
+} // namespace
+
+ParallelFlacEngine::ParallelFlacEngine(unsigned workers, const std::vector<int>& cores)
+    : m_cores(cores)
+    , m_jobs(std::max(workers, 2u) * 2)
+{
+    workers = std::max(workers, 2u);
+    m_workers.reserve(workers);
+    for (unsigned i = 0; i < workers; i++) {
+        auto w = std::make_unique<Worker>();
+        w->engine = this;
+        Worker* raw = w.get();
+        m_workers.push_back(std::move(w));
+        raw->thread = std::thread([this, raw]() { workerLoop(*raw); });
+    }
+    LOG_INFO("[FLAC] Parallel decoder: " << workers << " worker threads");
+}
+
+ParallelFlacEngine::~ParallelFlacEngine() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_workCv.notify_all();
+    m_doneCv.notify_all();
+    for (auto& w : m_workers) {
+        if (w->thread.joinable()) w->thread.join();
+        if (w->decoder) FLAC__stream_decoder_delete(w->decoder);
+    }
+}
+
+void ParallelFlacEngine::start(const FLAC__StreamMetadata_StreamInfo& info) {
+    reset();
+
+    // "fLaC" + last-metadata-block flag | STREAMINFO (type 0), length 34
+    uint8_t body[34] = {};
+    size_t bit = 0;
+    putBits(body, bit, info.min_blocksize, 16);
+    putBits(body, bit, info.max_blocksize, 16);
+    putBits(body, bit, info.min_framesize, 24);
+    putBits(body, bit, info.max_framesize, 24);
+    putBits(body, bit, info.sample_rate, 20);
+    putBits(body, bit, info.channels - 1, 3);
+    putBits(body, bit, info.bits_per_sample - 1, 5);
+    putBits(body, bit, info.total_samples, 36);
+    std::memcpy(body + 18, info.md5sum, 16);
+
+    m_header = {'f', 'L', 'a', 'C', 0x80, 0x00, 0x00, 34};
+    m_header.insert(m_header.end(), body, body + sizeof(body));
+    m_shift = 32 - static_cast<int>(info.bits_per_sample);
+    m_channels = info.channels;
+}
+
+void ParallelFlacEngine::reset() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCv.wait(lock, [this]() {
+            return std::none_of(m_jobs.begin(), m_jobs.end(), [](const Job& j) {
+                return j.state == Job::State::Decoding;
+            });
+        });
+        for (auto& job : m_jobs) {
+            job.state = Job::State::Free;
+            job.input.clear();
+            job.frames = 0;
+            job.output.clear();
+            job.outputPos = 0;
+            job.failed = false;
+        }
+        m_head = m_fill = m_nextDecode = 0;
+        m_generation++;  // workers re-prime their decoder on the next batch
+    }
+    m_input.clear();
+    m_frameStart = 0;
+    m_searchPos = 0;
+    m_haveRefHeader = false;
+    m_eof = false;
+    m_error = false;
+}
+
+void ParallelFlacEngine::feed(const uint8_t* data, size_t len) {
+    m_input.insert(m_input.end(), data, data + len);
+}
+
+void ParallelFlacEngine::setEof() {
+    m_eof = true;
+}
+
+bool ParallelFlacEngine::isFinished() const {
+    if (!m_eof || m_frameStart < m_input.size()) return false;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::all_of(m_jobs.begin(), m_jobs.end(), [](const Job& j) {
+        return j.state == Job::State::Free;
+    });
+}
+
+size_t ParallelFlacEngine::read(int32_t* out, size_t maxFrames) {
+    if (m_error || m_channels == 0) return 0;
+
+    splitAndDispatch();
+
+    size_t written = 0;
+    bool freed = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (written < maxFrames) {
+            Job& job = m_jobs[m_head];
+            if (job.state == Job::State::Queued || job.state == Job::State::Decoding) {
+                if (written > 0) break;  // Don't block with frames in hand
+                m_doneCv.wait(lock, [this, &job]() {
+                    return job.state == Job::State::Done || m_stop;
+                });
+                if (m_stop) break;
+            }
+            if (job.state != Job::State::Done) break;  // Nothing decoded yet
+
+            if (job.failed) {
+                LOG_ERROR("[FLAC] Parallel decode failed on a " << job.frames
+                          << "-frame batch");
+                m_error = true;
+                break;
+            }
+
+            size_t avail = (job.output.size() - job.outputPos) / m_channels;
+            size_t n = std::min(avail, maxFrames - written);
+            std::memcpy(out + written * m_channels, job.output.data() + job.outputPos,
+                        n * m_channels * sizeof(int32_t));
+            job.outputPos += n * m_channels;
+            written += n;
+
+            if (job.outputPos >= job.output.size()) {
+                job.state = Job::State::Free;
+                m_head = (m_head + 1) % m_jobs.size();
+                freed = true;
+            }
+        }
+    }
+
+    // A freed slot lets input that was held back go to the workers now
+    if (freed) splitAndDispatch();
+    return written;
+}
+
+// ============================================
+// Frame Splitting
+// ============================================
+
+int ParallelFlacEngine::parseFrameHeader(const uint8_t* p, size_t avail, size_t& headerLen) {
+    if (avail < 4) return 0;
+    if (p[0] != 0xFF || (p[1] & 0xFE) != 0xF8) return -1;
+
+    uint8_t blockCode = p[2] >> 4;
+    uint8_t rateCode = p[2] & 0x0F;
+    uint8_t channelCode = p[3] >> 4;
+    uint8_t sizeCode = (p[3] >> 1) & 0x07;
+    if (blockCode == 0 || rateCode == 15 || channelCode > 10 ||
+        sizeCode == 3 || (p[3] & 0x01)) {
+        return -1;
+    }
+
+    // UTF-8 coded frame/sample number
+    size_t pos = 4;
+    if (avail < pos + 1) return 0;
+    uint8_t lead = p[pos];
+    size_t extra;
+    if (!(lead & 0x80)) extra = 0;
+    else if ((lead & 0xE0) == 0xC0) extra = 1;
+    else if ((lead & 0xF0) == 0xE0) extra = 2;
+    else if ((lead & 0xF8) == 0xF0) extra = 3;
+    else if ((lead & 0xFC) == 0xF8) extra = 4;
+    else if ((lead & 0xFE) == 0xFC) extra = 5;
+    else if (lead == 0xFE) extra = 6;
+    else return -1;
+    if (avail < pos + 1 + extra) return 0;
+    for (size_t i = 1; i <= extra; i++) {
+        if ((p[pos + i] & 0xC0) != 0x80) return -1;
+    }
+    pos += 1 + extra;
+
+    // Optional explicit block size / sample rate
+    if (blockCode == 6) pos += 1;
+    else if (blockCode == 7) pos += 2;
+    if (rateCode == 12) pos += 1;
+    else if (rateCode == 13 || rateCode == 14) pos += 2;
+
+    if (avail < pos + 1) return 0;
+    if (crc8(p, pos) != p[pos]) return -1;
+
+    headerLen = pos + 1;
+    return 1;
+}
+
+void ParallelFlacEngine::splitAndDispatch() {
+    if (m_error) return;
+
+    if (!m_haveRefHeader) {
+        size_t headerLen = 0;
+        int r = parseFrameHeader(m_input.data() + m_frameStart,
+                                 m_input.size() - m_frameStart, headerLen);
+        if (r < 0) {
+            LOG_ERROR("[FLAC] Parallel: no frame header at start of audio");
+            m_error = true;
+            return;
+        }
+        if (r == 0) {
+            if (m_eof) m_frameStart = m_input.size();  // Truncated stub — nothing to decode
+            return;
+        }
+        const uint8_t* h = m_input.data() + m_frameStart;
+        m_refBlocking = h[1] & 0x01;
+        m_refRateCode = h[2] & 0x0F;
+        m_refSizeCode = (h[3] >> 1) & 0x07;
+        m_searchPos = m_frameStart + headerLen;
+        m_haveRefHeader = true;
+    }
+
+    while (m_frameStart < m_input.size()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            Job::State s = m_jobs[m_fill].state;
+            if (s != Job::State::Free && s != Job::State::Filling) break;  // All slots busy
+        }
+
+        const uint8_t* base = m_input.data();
+        const size_t size = m_input.size();
+        size_t frameEnd = 0;
+
+        while (m_searchPos + 1 < size) {
+            const void* ff = std::memchr(base + m_searchPos, 0xFF, size - 1 - m_searchPos);
+            if (!ff) {
+                m_searchPos = size - 1;
+                break;
+            }
+            size_t c = static_cast<const uint8_t*>(ff) - base;
+            if ((base[c + 1] & 0xFE) == 0xF8 && (base[c + 1] & 0x01) == m_refBlocking) {
+                size_t headerLen = 0;
+                int r = parseFrameHeader(base + c, size - c, headerLen);
+                if (r == 0) {
+                    m_searchPos = c;  // Header incomplete — resume here
+                    break;
+                }
+                size_t frameLen = c - m_frameStart;
+                if (r > 0 && (base[c + 2] & 0x0F) == m_refRateCode &&
+                    ((base[c + 3] >> 1) & 0x07) == m_refSizeCode && frameLen > 2) {
+                    uint16_t footer = static_cast<uint16_t>((base[c - 2] << 8) | base[c - 1]);
+                    if (crc16(base + m_frameStart, frameLen - 2) == footer) {
+                        frameEnd = c;
+                        break;
+                    }
+                }
+            }
+            m_searchPos = c + 1;
+        }
+
+        if (frameEnd > 0) {
+            appendFrame(frameEnd);
+            continue;
+        }
+        // No further boundary. At EOF the rest is the last frame, or the
+        // last two when the final one has its own block size code; a tail
+        // cut off mid-frame is dropped, as the serial decoder does
+        if (m_eof) {
+            size_t end = lastFrameEnd();
+            if (end == 0) {
+                LOG_WARN("[FLAC] Parallel: dropping incomplete last frame ("
+                         << size - m_frameStart << " bytes)");
+                m_frameStart = size;
+                m_searchPos = size;
+                break;
+            }
+            appendFrame(end);
+            continue;
+        }
+        break;
+    }
+
+    // Send a partly filled batch when the workers would otherwise idle
+    // (stream start, slow network) or nothing more will arrive
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Job& job = m_jobs[m_fill];
+        bool send = job.state == Job::State::Filling && job.frames > 0 &&
+                    (m_eof || pipelineIdle());
+        lock.unlock();
+        if (send) dispatchFilling();
+    }
+
+    // Reclaim input already copied into batches
+    if (m_frameStart >= INPUT_COMPACT_THRESHOLD) {
+        m_input.erase(m_input.begin(), m_input.begin() + m_frameStart);
+        m_searchPos -= m_frameStart;
+        m_frameStart = 0;
+    }
+}
+
+size_t ParallelFlacEngine::lastFrameEnd() const {
+    const uint8_t* base = m_input.data();
+    const size_t size = m_input.size();
+    size_t headerLen = 0;
+    if (parseFrameHeader(base + m_frameStart, size - m_frameStart, headerLen) <= 0) return 0;
+
+    auto footerMatches = [&](size_t end) {
+        uint16_t footer = static_cast<uint16_t>((base[end - 2] << 8) | base[end - 1]);
+        return crc16(base + m_frameStart, end - m_frameStart - 2) == footer;
+    };
+    // Block size code not compared: the final frame is usually shorter
+    for (size_t c = m_frameStart + headerLen + 2; c + 1 < size; c++) {
+        if (base[c] != 0xFF || (base[c + 1] & 0xFE) != 0xF8) continue;
+        size_t len = 0;
+        if (parseFrameHeader(base + c, size - c, len) > 0 &&
+            (base[c + 2] & 0x0F) == m_refRateCode && footerMatches(c)) {
+            return c;
+        }
+    }
+    return size - m_frameStart > headerLen + 2 && footerMatches(size) ? size : 0;
+}
+
+void ParallelFlacEngine::appendFrame(size_t end) {
+    Job& job = m_jobs[m_fill];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (job.state == Job::State::Free) {
+            job.input.clear();
+            job.frames = 0;
+            job.failed = false;
+            job.state = Job::State::Filling;
+        }
+    }
+    job.input.insert(job.input.end(), m_input.begin() + m_frameStart,
+                     m_input.begin() + end);
+    job.frames++;
+    m_frameStart = end;
+    m_searchPos = end + 2;
+
+    if (job.frames >= JOB_FRAMES) dispatchFilling();
+}
+
+void ParallelFlacEngine::dispatchFilling() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs[m_fill].state = Job::State::Queued;
+        m_fill = (m_fill + 1) % m_jobs.size();
+    }
+    m_workCv.notify_one();
+}
+
+bool ParallelFlacEngine::pipelineIdle() const {
+    return std::none_of(m_jobs.begin(), m_jobs.end(), [](const Job& j) {
+        return j.state == Job::State::Queued || j.state == Job::State::Decoding;
+    });
+}
+
+// ============================================
+// Workers
+// ============================================
+
+void ParallelFlacEngine::workerLoop(Worker& w) {
+    if (!m_cores.empty()) {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        for (int core : m_cores) CPU_SET(core, &cpuset);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+        if (ret != 0) {
+            LOG_WARN("[FLAC] Failed to pin parallel decode worker: " << strerror(ret));
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workCv.wait(lock, [this]() {
+            return m_stop || m_jobs[m_nextDecode].state == Job::State::Queued;
+        });
+        if (m_stop) break;
+
+        Job& job = m_jobs[m_nextDecode];
+        job.state = Job::State::Decoding;
+        m_nextDecode = (m_nextDecode + 1) % m_jobs.size();
+        uint64_t generation = m_generation;
+        lock.unlock();
+
+        bool ok = decodeJob(w, job, generation);
+
+        lock.lock();
+        job.failed = !ok;
+        job.state = Job::State::Done;
+        m_doneCv.notify_all();
+    }
+}
+
+bool ParallelFlacEngine::decodeJob(Worker& w, Job& job, uint64_t generation) {
+    w.job = &job;
+    w.inputPos = 0;
+    w.framesWritten = 0;
+    w.failed = false;
+    job.output.clear();
+    job.outputPos = 0;
+
+    // New stream: re-init and feed the synthetic STREAMINFO header
+    if (!w.initialized || w.generation != generation) {
+        if (w.initialized) FLAC__stream_decoder_finish(w.decoder);
+        w.initialized = false;
+        if (!w.decoder) {
+            w.decoder = FLAC__stream_decoder_new();
+            if (!w.decoder) return false;
+        }
+        if (FLAC__stream_decoder_init_stream(w.decoder, readCallback, nullptr, nullptr,
+                                             nullptr, nullptr, writeCallback, nullptr,
+                                             errorCallback, &w)
+                != FLAC__STREAM_DECODER_INIT_STATUS_OK) {
+            return false;
+        }
+        w.initialized = true;
+        w.generation = generation;
+        w.headerPos = 0;
+        if (!FLAC__stream_decoder_process_until_end_of_metadata(w.decoder)) {
+            FLAC__stream_decoder_finish(w.decoder);
+            w.initialized = false;
+            return false;
+        }
+    }
+
+    while (w.framesWritten < job.frames && !w.failed) {
+        if (!FLAC__stream_decoder_process_single(w.decoder)) break;
+        if (FLAC__stream_decoder_get_state(w.decoder) == FLAC__STREAM_DECODER_END_OF_STREAM) break;
+    }
+
+    bool ok = !w.failed && w.framesWritten == job.frames;
+    if (!ok) {
+        // Back to frame search so the next batch starts clean
+        FLAC__stream_decoder_flush(w.decoder);
+    }
+    w.job = nullptr;
+    return ok;
+}
+
+FLAC__StreamDecoderReadStatus ParallelFlacEngine::readCallback(
+    const FLAC__StreamDecoder*, FLAC__byte buffer[],
+    size_t* bytes, void* clientData)
+{
+    auto* w = static_cast<Worker*>(clientData);
+    const auto& header = w->engine->m_header;
+    size_t n = 0;
+
+    if (w->headerPos < header.size()) {
+        n = std::min(*bytes, header.size() - w->headerPos);
+        std::memcpy(buffer, header.data() + w->headerPos, n);
+        w->headerPos += n;
+    } else if (w->job && w->inputPos < w->job->input.size()) {
+        n = std::min(*bytes, w->job->input.size() - w->inputPos);
+        std::memcpy(buffer, w->job->input.data() + w->inputPos, n);
+        w->inputPos += n;
+    }
+
+    *bytes = n;
+    // Batches end on a frame boundary: running dry mid-frame is an error
+    return n > 0 ? FLAC__STREAM_DECODER_READ_STATUS_CONTINUE
+                 : FLAC__STREAM_DECODER_READ_STATUS_ABORT;
+}
+
+FLAC__StreamDecoderWriteStatus ParallelFlacEngine::writeCallback(
+    const FLAC__StreamDecoder*, const FLAC__Frame* frame,
+    const FLAC__int32* const buffer[], void* clientData)
+{
+    auto* w = static_cast<Worker*>(clientData);
+    if (!w->job) return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;  // metadata priming
+
+    uint32_t channels = frame->header.channels;
+    uint32_t blocksize = frame->header.blocksize;
+    if (channels != w->engine->m_channels) {
+        w->failed = true;
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+
+    int shift = w->engine->m_shift;
+    auto& output = w->job->output;
+    size_t prevSize = output.size();
+    output.resize(prevSize + static_cast<size_t>(blocksize) * channels);
+    SampleConverter::interleaveS32(buffer, channels, blocksize, shift,
+                                   output.data() + prevSize);
+
+    w->framesWritten++;
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+void ParallelFlacEngine::errorCallback(
+    const FLAC__StreamDecoder*,
+    FLAC__StreamDecoderErrorStatus status, void* clientData)
+{
+    auto* w = static_cast<Worker*>(clientData);
+
+    switch (status) {
+        case FLAC__STREAM_DECODER_ERROR_STATUS_LOST_SYNC:
+            return;
+
+        case FLAC__STREAM_DECODER_ERROR_STATUS_BAD_HEADER:
+        case FLAC__STREAM_DECODER_ERROR_STATUS_FRAME_CRC_MISMATCH:
+            // Same handling as the serial decoder: libFLAC outputs the
+            // frame (silenced on CRC mismatch) and carries on
+            LOG_DEBUG("[FLAC] Worker: " << FLAC__StreamDecoderErrorStatusString[status]);
+            return;
+
+        default:
+            LOG_ERROR("[FLAC] Worker decode error: "
+                      << FLAC__StreamDecoderErrorStatusString[status]);
+            w->failed = true;
+            break;
+    }
+}
@@ -0,0 +1,152 @@
+/**
+ * @file ParallelFlacEngine.h
+ * @brief Frame-parallel FLAC decoding for very high sample rates
+ *
+ * Once STREAMINFO is known, every FLAC frame decodes on its own. The engine
+ * splits the audio part of the stream at frame boundaries (sync code, header
+ * CRC-8, and the previous frame's CRC-16 footer), hands batches of frames to
+ * N worker threads — each with its own libFLAC instance primed with the
+ * stream's STREAMINFO — and returns the decoded samples in stream order.
+ *
+ * Used by FlacDecoder when --flac-threads is set and the stream rate is at
+ * or above the parallel threshold; below it the serial path is cheaper.
+ */
+
+#ifndef SLIM2DIRETTA_PARALLEL_FLAC_ENGINE_H
+#define SLIM2DIRETTA_PARALLEL_FLAC_ENGINE_H
+
+#include <FLAC/stream_decoder.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ParallelFlacEngine {
+public:
+    /**
+     * @param workers Decoder threads to start (>= 2)
+     * @param cores   CPU cores the workers may run on (empty = no pinning)
+     */
+    ParallelFlacEngine(unsigned workers, const std::vector<int>& cores);
+    ~ParallelFlacEngine();
+
+    ParallelFlacEngine(const ParallelFlacEngine&) = delete;
+    ParallelFlacEngine& operator=(const ParallelFlacEngine&) = delete;
+
+    /**
+     * @brief Begin a new stream
+     *
+     * Input fed afterwards must start at the first audio frame (right
+     * after the metadata blocks).
+     */
+    void start(const FLAC__StreamMetadata_StreamInfo& info);
+
+    /// Drop all queued/decoded data (waits for in-flight batches); threads stay up
+    void reset();
+
+    void feed(const uint8_t* data, size_t len);
+    void setEof();
+
+    /**
+     * @brief Read decoded S32_LE interleaved MSB-aligned frames, in order
+     *
+     * Splits and dispatches pending input first, then waits for the oldest
+     * in-flight batch if nothing decoded is ready yet.
+     * @return Frames written (0 = need more input)
+     */
+    size_t read(int32_t* out, size_t maxFrames);
+
+    bool isFinished() const;
+    bool hasError() const { return m_error; }
+    unsigned getWorkers() const { return static_cast<unsigned>(m_workers.size()); }
+
+private:
+    // A batch of consecutive frames, decoded by one worker
+    struct Job {
+        enum class State { Free, Filling, Queued, Decoding, Done };
+        State state = State::Free;
+        std::vector<uint8_t> input;
+        unsigned frames = 0;
+        std::vector<int32_t> output;
+        size_t outputPos = 0;
+        bool failed = false;
+    };
+
+    struct Worker {
+        ParallelFlacEngine* engine = nullptr;
+        std::thread thread;
+        FLAC__StreamDecoder* decoder = nullptr;
+        bool initialized = false;
+        uint64_t generation = 0;     // Stream this decoder is primed for
+        Job* job = nullptr;
+        size_t headerPos = 0;        // Bytes of m_header delivered
+        size_t inputPos = 0;         // Bytes of job->input delivered
+        unsigned framesWritten = 0;
+        bool failed = false;
+    };
+
+    void workerLoop(Worker& w);
+    bool decodeJob(Worker& w, Job& job, uint64_t generation);
+
+    // Frame splitting (caller thread)
+    void splitAndDispatch();
+    // 1 = valid header, 0 = need more bytes, -1 = not a frame header
+    static int parseFrameHeader(const uint8_t* p, size_t avail, size_t& headerLen);
+    void appendFrame(size_t end);
+    // End of the frame at m_frameStart once the input is complete: a
+    // later valid header, or the input end if the CRC holds; 0 = cut off
+    size_t lastFrameEnd() const;
+    void dispatchFilling();
+    bool pipelineIdle() const;  // caller holds m_mutex
+
+    static FLAC__StreamDecoderReadStatus readCallback(
+        const FLAC__StreamDecoder* decoder, FLAC__byte buffer[],
+        size_t* bytes, void* clientData);
+    static FLAC__StreamDecoderWriteStatus writeCallback(
+        const FLAC__StreamDecoder* decoder, const FLAC__Frame* frame,
+        const FLAC__int32* const buffer[], void* clientData);
+    static void errorCallback(
+        const FLAC__StreamDecoder* decoder,
+        FLAC__StreamDecoderErrorStatus status, void* clientData);
+
+    // Frames per batch: enough to amortize the hand-off, small enough
+    // that all workers stay busy at 1x real time
+    static constexpr unsigned JOB_FRAMES = 8;
+    static constexpr size_t INPUT_COMPACT_THRESHOLD = 65536;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<int> m_cores;
+
+    // Job ring — filled/read in order by the caller, decoded by workers
+    std::vector<Job> m_jobs;
+    size_t m_head = 0;          // Oldest job (being read)
+    size_t m_fill = 0;          // Job being filled
+    size_t m_nextDecode = 0;    // Next job a worker picks up
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workCv;
+    std::condition_variable m_doneCv;
+    bool m_stop = false;
+    uint64_t m_generation = 0;
+
+    // "fLaC" + STREAMINFO, fed to each worker before its first batch
+    std::vector<uint8_t> m_header;
+    int m_shift = 0;
+    uint32_t m_channels = 0;
+
+    // Compressed input not yet handed to a job
+    std::vector<uint8_t> m_input;
+    size_t m_frameStart = 0;    // Start of the current (unsplit) frame
+    size_t m_searchPos = 0;     // Next offset to look for a sync code
+    bool m_haveRefHeader = false;
+    uint8_t m_refBlocking = 0;  // Fixed/variable blocksize bit of frame 1
+    uint8_t m_refRateCode = 0;
+    uint8_t m_refSizeCode = 0;
+    bool m_eof = false;
+    std::atomic<bool> m_error{false};
+};
+
+#endif // SLIM2DIRETTA_PARALLEL_FLAC_ENGINE_H
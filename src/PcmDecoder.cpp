@@ -5,6 +5,7 @@
 
 #include "PcmDecoder.h"
 #include "LogLevel.h"
+#include "SampleConverter.h"
 
 #include <cstring>
 #include <cmath>
@@ -28,7 +29,6 @@ static uint32_t readBE32(const uint8_t* p) {
 
 PcmDecoder::PcmDecoder() {
     m_headerBuf.reserve(256);
-    m_dataBuf.reserve(32768);
 }
 
 size_t PcmDecoder::feed(const uint8_t* data, size_t len) {
@@ -36,7 +36,7 @@ size_t PcmDecoder::feed(const uint8_t* data, size_t len) {
         m_state == State::PARSE_AIFF) {
         m_headerBuf.insert(m_headerBuf.end(), data, data + len);
     } else if (m_state == State::DATA) {
-        m_dataBuf.insert(m_dataBuf.end(), data, data + len);
+        m_data.append(data, len);
     }
     return len;
 }
@@ -46,6 +46,48 @@ void PcmDecoder::setEof() {
 }
 
 size_t PcmDecoder::readDecoded(int32_t* out, size_t maxFrames) {
+    size_t frames = prepareFrames(maxFrames);
+    if (frames == 0) return 0;
+
+    size_t bytes = frames * bytesPerFrame();
+    convertSamples(m_data.peek(bytes), out, bytes);
+    consumeFrames(frames);
+    return frames;
+}
+
+int PcmDecoder::getPassthroughBytesPerSample() const {
+    if (!m_formatReady) return 0;
+    // 8-bit WAV is unsigned — always goes through convertSamples()
+    switch (m_format.bitDepth) {
+        case 16: return 2;
+        case 24: return 3;
+        case 32: return 4;
+        default: return 0;
+    }
+}
+
+size_t PcmDecoder::readPassthrough(uint8_t* out, size_t maxFrames) {
+    size_t frames = prepareFrames(maxFrames);
+    if (frames == 0) return 0;
+
+    size_t bytes = frames * bytesPerFrame();
+    const uint8_t* src = m_data.peek(bytes);
+    if (!m_bigEndian) {
+        std::memcpy(out, src, bytes);
+    } else {
+        // AIFF: same layout, opposite byte order
+        uint32_t bytesPerSample = m_format.bitDepth / 8;
+        for (size_t i = 0; i < bytes; i += bytesPerSample) {
+            for (uint32_t b = 0; b < bytesPerSample; b++) {
+                out[i + b] = src[i + bytesPerSample - 1 - b];
+            }
+        }
+    }
+    consumeFrames(frames);
+    return frames;
+}
+
+size_t PcmDecoder::prepareFrames(size_t maxFrames) {
     if (m_error || m_finished) return 0;
 
     // Try to detect/parse container
@@ -61,20 +103,18 @@ size_t PcmDecoder::readDecoded(int32_t* out, size_t maxFrames) {
 
     if (m_state != State::DATA) return 0;
 
-    // Convert available PCM data to S32_LE
-    uint32_t bytesPerSample = m_format.bitDepth / 8;
-    uint32_t bytesPerFrame = bytesPerSample * m_format.channels;
-    if (bytesPerFrame == 0) return 0;
+    uint32_t frameBytes = bytesPerFrame();
+    if (frameBytes == 0) return 0;
 
     // Limit by available data and remaining chunk size
-    size_t availBytes = m_dataBuf.size() - m_dataPos;
+    size_t availBytes = m_data.available();
     if (m_dataRemaining > 0) {
         availBytes = std::min(availBytes, static_cast<size_t>(m_dataRemaining));
     }
 
-    size_t framesAvail = availBytes / bytesPerFrame;
-    size_t framesToConvert = std::min(framesAvail, maxFrames);
-    if (framesToConvert == 0) {
+    size_t framesAvail = availBytes / frameBytes;
+    size_t frames = std::min(framesAvail, maxFrames);
+    if (frames == 0) {
         // Only finish when we know no more data will arrive:
         // - EOF signaled by caller (HTTP stream ended)
         // - All data chunk bytes consumed (m_dataRemaining reached 0 via subtraction)
@@ -83,29 +123,22 @@ size_t PcmDecoder::readDecoded(int32_t* out, size_t maxFrames) {
         if (m_eof) {
             m_finished = true;
         }
-        return 0;
     }
+    return frames;
+}
 
-    size_t bytesToConvert = framesToConvert * bytesPerFrame;
-    convertSamples(m_dataBuf.data() + m_dataPos, out, bytesToConvert);
+void PcmDecoder::consumeFrames(size_t frames) {
+    size_t bytes = frames * bytesPerFrame();
 
-    // Advance read offset instead of O(n) erase
-    m_dataPos += bytesToConvert;
+    m_data.consume(bytes);
     if (m_dataRemaining > 0) {
-        m_dataRemaining -= bytesToConvert;
+        m_dataRemaining -= bytes;
         if (m_dataRemaining == 0) {
             m_finished = true;
         }
     }
 
-    // Compact when offset exceeds threshold to reclaim memory
-    if (m_dataPos >= DATA_COMPACT_THRESHOLD) {
-        m_dataBuf.erase(m_dataBuf.begin(), m_dataBuf.begin() + m_dataPos);
-        m_dataPos = 0;
-    }
-
-    m_decodedSamples += framesToConvert;
-    return framesToConvert;
+    m_decodedSamples += frames;
 }
 
 void PcmDecoder::setRawPcmFormat(uint32_t sampleRate, uint32_t bitDepth,
@@ -122,8 +155,7 @@ void PcmDecoder::setRawPcmFormat(uint32_t sampleRate, uint32_t bitDepth,
 void PcmDecoder::flush() {
     m_state = State::DETECT;
     m_headerBuf.clear();
-    m_dataBuf.clear();
-    m_dataPos = 0;
+    m_data.clear();
     m_format = {};
     m_formatReady = false;
     m_bigEndian = false;
@@ -155,7 +187,7 @@ bool PcmDecoder::detectContainer() {
         m_formatReady = true;
         m_dataRemaining = 0;  // Unlimited (stream until EOF)
         // Move all accumulated data to data buffer (it's audio, not a header)
-        m_dataBuf.insert(m_dataBuf.end(), m_headerBuf.begin(), m_headerBuf.end());
+        m_data.append(m_headerBuf.data(), m_headerBuf.size());
         m_headerBuf.clear();
         m_state = State::DATA;
         LOG_INFO("[PCM] Raw: " << m_format.sampleRate << " Hz, "
@@ -259,9 +291,8 @@ bool PcmDecoder::parseWavHeader() {
 
     // Move remaining header bytes (after data chunk start) to data buffer
     if (dataStart < m_headerBuf.size()) {
-        m_dataBuf.insert(m_dataBuf.end(),
-                         m_headerBuf.begin() + dataStart,
-                         m_headerBuf.end());
+        m_data.append(m_headerBuf.data() + dataStart,
+                      m_headerBuf.size() - dataStart);
     }
     m_headerBuf.clear();
     m_state = State::DATA;
@@ -328,9 +359,8 @@ bool PcmDecoder::parseAiffHeader() {
 
     // Move remaining data to data buffer
     if (dataStart < m_headerBuf.size()) {
-        m_dataBuf.insert(m_dataBuf.end(),
-                         m_headerBuf.begin() + dataStart,
-                         m_headerBuf.end());
+        m_data.append(m_headerBuf.data() + dataStart,
+                      m_headerBuf.size() - dataStart);
     }
     m_headerBuf.clear();
     m_state = State::DATA;
@@ -340,65 +370,7 @@ bool PcmDecoder::parseAiffHeader() {
 size_t PcmDecoder::convertSamples(const uint8_t* src, int32_t* dst, size_t srcBytes) {
     uint32_t bytesPerSample = m_format.bitDepth / 8;
     size_t numSamples = srcBytes / bytesPerSample;
-
-    if (m_bigEndian) {
-        // Big-endian (AIFF)
-        switch (bytesPerSample) {
-            case 1:
-                for (size_t i = 0; i < numSamples; i++) {
-                    dst[i] = static_cast<int32_t>(static_cast<int8_t>(src[i])) << 24;
-                }
-                break;
-            case 2:
-                for (size_t i = 0; i < numSamples; i++) {
-                    int16_t s = static_cast<int16_t>((src[i*2] << 8) | src[i*2+1]);
-                    dst[i] = static_cast<int32_t>(s) << 16;
-                }
-                break;
-            case 3:
-                for (size_t i = 0; i < numSamples; i++) {
-                    int32_t s = (src[i*3] << 24) | (src[i*3+1] << 16) | (src[i*3+2] << 8);
-                    dst[i] = s;  // Already MSB-aligned
-                }
-                break;
-            case 4:
-                for (size_t i = 0; i < numSamples; i++) {
-                    dst[i] = static_cast<int32_t>(
-                        (src[i*4] << 24) | (src[i*4+1] << 16) |
-                        (src[i*4+2] << 8) | src[i*4+3]);
-                }
-                break;
-        }
-    } else {
-        // Little-endian (WAV)
-        switch (bytesPerSample) {
-            case 1:
-                for (size_t i = 0; i < numSamples; i++) {
-                    dst[i] = static_cast<int32_t>(static_cast<int8_t>(src[i])) << 24;
-                }
-                break;
-            case 2:
-                for (size_t i = 0; i < numSamples; i++) {
-                    int16_t s = static_cast<int16_t>(src[i*2] | (src[i*2+1] << 8));
-                    dst[i] = static_cast<int32_t>(s) << 16;
-                }
-                break;
-            case 3:
-                for (size_t i = 0; i < numSamples; i++) {
-                    int32_t s = (src[i*3+2] << 24) | (src[i*3+1] << 16) | (src[i*3] << 8);
-                    dst[i] = s;  // MSB-aligned
-                }
-                break;
-            case 4:
-                for (size_t i = 0; i < numSamples; i++) {
-                    dst[i] = static_cast<int32_t>(
-                        src[i*4] | (src[i*4+1] << 8) |
-                        (src[i*4+2] << 16) | (src[i*4+3] << 24));
-                }
-                break;
-        }
-    }
-
+    SampleConverter::packedToS32(src, numSamples, bytesPerSample, m_bigEndian, dst);
     return numSamples;
 }
 
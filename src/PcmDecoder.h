@@ -3,13 +3,16 @@
  * @brief PCM decoder for WAV (RIFF) and AIFF container formats
  *
  * Parses container headers, then passes through raw PCM data
- * normalized to S32_LE interleaved MSB-aligned format.
+ * normalized to S32_LE interleaved MSB-aligned format — or, through
+ * readPassthrough(), as the container's own sample bytes (little-endian)
+ * when the consumer already stores that layout.
  */
 
 #ifndef SLIM2DIRETTA_PCM_DECODER_H
 #define SLIM2DIRETTA_PCM_DECODER_H
 
 #include "Decoder.h"
+#include "InputQueue.h"
 #include <vector>
 
 class PcmDecoder : public Decoder {
@@ -28,6 +31,8 @@ public:
     void flush() override;
     void setRawPcmFormat(uint32_t sampleRate, uint32_t bitDepth,
                           uint32_t channels, bool bigEndian) override;
+    int getPassthroughBytesPerSample() const override;
+    size_t readPassthrough(uint8_t* out, size_t maxFrames) override;
 
 private:
     enum class State { DETECT, PARSE_WAV, PARSE_AIFF, DATA, DONE, ERROR };
@@ -35,6 +40,9 @@ private:
     bool detectContainer();
     bool parseWavHeader();
     bool parseAiffHeader();
+    size_t prepareFrames(size_t maxFrames);
+    void consumeFrames(size_t frames);
+    uint32_t bytesPerFrame() const { return m_format.bitDepth / 8 * m_format.channels; }
     size_t convertSamples(const uint8_t* src, int32_t* dst, size_t srcBytes);
 
     // 80-bit extended float to uint32 (for AIFF sample rate)
@@ -45,10 +53,8 @@ private:
     // Header accumulation buffer
     std::vector<uint8_t> m_headerBuf;
 
-    // PCM data buffer (raw bytes before conversion)
-    std::vector<uint8_t> m_dataBuf;
-    size_t m_dataPos = 0;  // Read offset into m_dataBuf (avoids O(n) erase)
-    static constexpr size_t DATA_COMPACT_THRESHOLD = 65536;  // Compact when offset exceeds this
+    // PCM data queue (raw bytes before conversion)
+    InputQueue m_data{32768};
 
     // Format
     DecodedFormat m_format;
@@ -0,0 +1,254 @@
+/**
+ * @file Resampler.cpp
+ * @brief Polyphase FIR resampler (AVX2 / NEON / scalar)
+ */
+
+#include "Resampler.h"
+#include "SampleConverter.h"
+#include "LogLevel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define RS_HAS_AVX2 1
+    #define RS_HAS_NEON 0
+    #include <immintrin.h>
+    #define RS_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define RS_HAS_AVX2 0
+    #define RS_HAS_NEON 1
+    #include <arm_neon.h>
+#else
+    #define RS_HAS_AVX2 0
+    #define RS_HAS_NEON 0
+#endif
+
+namespace {
+
+constexpr double STOPBAND_DB = 100.0;
+
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+// Taps are multiples of 8 (one AVX2 vector / two NEON vectors)
+float dotScalar(const float* x, const float* h, size_t taps) {
+    float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f, a3 = 0.0f;
+    for (size_t i = 0; i < taps; i += 4) {
+        a0 += x[i] * h[i];
+        a1 += x[i + 1] * h[i + 1];
+        a2 += x[i + 2] * h[i + 2];
+        a3 += x[i + 3] * h[i + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+#if RS_HAS_AVX2
+// ============================================
+// AVX2
+// ============================================
+
+bool useAvx2() {
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool s_avx2 = __builtin_cpu_supports("avx2");
+    return s_avx2;
+#endif
+}
+
+RS_AVX2 float dotAvx2(const float* x, const float* h, size_t taps) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= taps; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(x + i + 8),
+                                                 _mm256_loadu_ps(h + i + 8)));
+    }
+    if (i < taps) {
+        acc0 = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i)));
+    }
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+#if RS_HAS_NEON
+// ============================================
+// NEON
+// ============================================
+
+float dotNeon(const float* x, const float* h, size_t taps) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < taps; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(x + i), vld1q_f32(h + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(x + i + 4), vld1q_f32(h + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+#if defined(__aarch64__)
+    return vaddvq_f32(acc);
+#else
+    float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#endif
+}
+#endif
+
+} // namespace
+
+bool Resampler::configure(uint32_t inRate, uint32_t outRate, uint32_t channels, unsigned taps) {
+    m_inRate = m_outRate = m_channels = 0;
+    if (inRate == 0 || outRate == 0 || channels == 0) {
+        LOG_ERROR("[Resample] Invalid conversion: " << inRate << " → " << outRate
+                  << " Hz, " << channels << " ch");
+        return false;
+    }
+
+    taps = std::min(std::max(taps, MIN_TAPS), MAX_TAPS);
+    taps = (taps + 7) / 8 * 8;
+    const uint32_t g = std::gcd(inRate, outRate);
+    const uint32_t up = outRate / g;
+    const uint32_t down = inRate / g;
+
+    // Prototype low-pass at the upsampled rate inRate * L. Its transition
+    // width follows from the length (Kaiser); the stopband starts at the
+    // lower Nyquist, the cutoff goes as close to it as the length allows.
+    const double pi = 3.141592653589793;
+    const size_t length = static_cast<size_t>(taps) * up;
+    const double upRate = static_cast<double>(inRate) * up;
+    const double stop = 0.5 * std::min(inRate, outRate) / upRate;
+    const double transition = (STOPBAND_DB - 7.95) / (2.285 * 2.0 * pi * static_cast<double>(length));
+    const double cutoff = std::max(stop - 0.5 * transition, 0.5 * stop);
+    const double beta = 0.1102 * (STOPBAND_DB - 8.7);
+
+    std::vector<double> h(length);
+    const double mid = 0.5 * static_cast<double>(length - 1);
+    const double i0beta = besselI0(beta);
+    double sum = 0.0;
+    for (size_t i = 0; i < length; i++) {
+        double t = static_cast<double>(i) - mid;
+        double sinc = (t == 0.0) ? 2.0 * cutoff : std::sin(2.0 * pi * cutoff * t) / (pi * t);
+        double r = t / mid;
+        h[i] = sinc * besselI0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0beta;
+        sum += h[i];
+    }
+
+    // Phase p, output y = sum_k h[p + kL] * x[i - k]: stored reversed so
+    // the dot product runs forward over the history window x[i-taps+1..i].
+    // Gain L makes up for the zero-stuffed upsampling.
+    m_coeffs.assign(length, 0.0f);
+    const double gain = static_cast<double>(up) / sum;
+    for (uint32_t p = 0; p < up; p++) {
+        for (unsigned j = 0; j < taps; j++) {
+            m_coeffs[p * taps + j] = static_cast<float>(h[p + (taps - 1 - j) * up] * gain);
+        }
+    }
+
+    m_dot = dotScalar;
+#if RS_HAS_AVX2
+    if (useAvx2()) m_dot = dotAvx2;
+#elif RS_HAS_NEON
+    m_dot = dotNeon;
+#endif
+
+    m_inRate = inRate;
+    m_outRate = outRate;
+    m_channels = channels;
+    m_taps = taps;
+    m_up = up;
+    m_down = down;
+    m_history.assign(channels, {});
+    m_output.assign(channels, {});
+    m_planes.assign(channels, nullptr);
+    reset();
+
+    LOG_INFO("[Resample] " << inRate << " → " << outRate << " Hz (" << up << "/" << down
+             << "), " << taps << " taps × " << up << " phases (" << kernelName() << ")");
+    return true;
+}
+
+void Resampler::reset() {
+    // Start from silence: the first output's window ends at the first input
+    for (auto& h : m_history) {
+        h.assign(m_taps - 1, 0.0f);
+    }
+    m_length = m_taps ? m_taps - 1 : 0;
+    m_next = 0;
+    m_phase = 0;
+}
+
+size_t Resampler::maxOutputFrames(size_t frames) const {
+    if (m_down == 0) return 0;
+    return frames * m_up / m_down + 2;
+}
+
+size_t Resampler::process(const int32_t* in, size_t frames, int32_t* out) {
+    if (m_channels == 0 || frames == 0) return 0;
+
+    constexpr float scale = 1.0f / 2147483648.0f;
+    for (uint32_t ch = 0; ch < m_channels; ch++) {
+        auto& h = m_history[ch];
+        if (h.size() < m_length + frames) h.resize(m_length + frames);
+        float* dst = h.data() + m_length;
+        const int32_t* src = in + ch;
+        for (size_t i = 0; i < frames; i++, src += m_channels) {
+            dst[i] = static_cast<float>(*src) * scale;
+        }
+    }
+    m_length += frames;
+
+    const size_t maxOut = maxOutputFrames(frames);
+    for (auto& o : m_output) {
+        if (o.size() < maxOut) o.resize(maxOut);
+    }
+
+    size_t n = 0;
+    while (m_next + m_taps <= m_length && n < maxOut) {
+        const float* coeffs = m_coeffs.data() + static_cast<size_t>(m_phase) * m_taps;
+        for (uint32_t ch = 0; ch < m_channels; ch++) {
+            m_output[ch][n] = m_dot(m_history[ch].data() + m_next, coeffs, m_taps);
+        }
+        n++;
+        m_phase += m_down;
+        m_next += m_phase / m_up;
+        m_phase %= m_up;
+    }
+
+    // Drop input no later window needs
+    const size_t drop = std::min(m_next, m_length);
+    for (auto& h : m_history) {
+        std::memmove(h.data(), h.data() + drop, (m_length - drop) * sizeof(float));
+    }
+    m_length -= drop;
+    m_next -= drop;
+
+    for (uint32_t ch = 0; ch < m_channels; ch++) {
+        m_planes[ch] = m_output[ch].data();
+    }
+    SampleConverter::interleaveFloat(m_planes.data(), m_channels, n, out);
+    return n;
+}
+
+const char* Resampler::kernelName() {
+#if RS_HAS_AVX2
+    return useAvx2() ? "AVX2" : "scalar";
+#elif RS_HAS_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
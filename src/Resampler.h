@@ -0,0 +1,78 @@
+/**
+ * @file Resampler.h
+ * @brief Polyphase sample-rate conversion for rates the target rejects
+ *
+ * With --resample, a PCM stream whose rate the Diretta target does not
+ * accept (or above --max-rate) is converted down to the highest rate it
+ * does, between the decoder and the decode cache: 1536 → 768 kHz is a
+ * plain 2:1 decimation, 192 → 176.4 kHz a rational 147/160.
+ *
+ * The ratio out/in is reduced to L/M and one Kaiser-windowed low-pass
+ * (~100 dB) is split into L phases of `taps` coefficients each; every
+ * output sample is one taps-long dot product over the input history.
+ * Longer filters give a narrower transition band below the new Nyquist.
+ * Dot products use AVX2 on x86-64 (chosen at runtime) and NEON on ARM.
+ */
+
+#ifndef SLIM2DIRETTA_RESAMPLER_H
+#define SLIM2DIRETTA_RESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Resampler {
+public:
+    /// Filter length per phase (--resample-taps), in input samples
+    static constexpr unsigned DEFAULT_TAPS = 64;
+    static constexpr unsigned MIN_TAPS = 16;
+    static constexpr unsigned MAX_TAPS = 1024;
+
+    /**
+     * @brief Set up a conversion (builds the filter, clears the history)
+     * @param taps Rounded up to a multiple of 8 and clamped to MIN/MAX_TAPS
+     * @return false if the rates are invalid
+     */
+    bool configure(uint32_t inRate, uint32_t outRate, uint32_t channels, unsigned taps);
+
+    /// Clear the history (the next output starts from silence)
+    void reset();
+
+    /**
+     * @brief Convert interleaved S32 frames
+     * @param out At least maxOutputFrames(frames) * channels samples
+     * @return Frames written (input is kept until the filter has seen it)
+     */
+    size_t process(const int32_t* in, size_t frames, int32_t* out);
+
+    /// Upper bound of frames process() returns for this input
+    size_t maxOutputFrames(size_t frames) const;
+
+    uint32_t inputRate() const { return m_inRate; }
+    uint32_t outputRate() const { return m_outRate; }
+    uint32_t channels() const { return m_channels; }
+    unsigned taps() const { return m_taps; }
+
+    /// Dot-product kernel in use ("AVX2", "NEON" or "scalar")
+    static const char* kernelName();
+
+private:
+    uint32_t m_inRate = 0;
+    uint32_t m_outRate = 0;
+    uint32_t m_channels = 0;
+    unsigned m_taps = 0;
+    uint32_t m_up = 1;                  // L
+    uint32_t m_down = 1;                // M
+    std::vector<float> m_coeffs;        // L phases × taps, time-reversed
+    float (*m_dot)(const float*, const float*, size_t) = nullptr;
+
+    // Planar history: window of the next output starts at m_next
+    std::vector<std::vector<float>> m_history;
+    size_t m_length = 0;
+    size_t m_next = 0;
+    uint32_t m_phase = 0;
+    std::vector<std::vector<float>> m_output;
+    std::vector<const float*> m_planes;
+};
+
+#endif // SLIM2DIRETTA_RESAMPLER_H
@@ -0,0 +1,441 @@
+/**
+ * @file SampleConverter.cpp
+ * @brief Sample-format conversion kernels (AVX2 / NEON / scalar)
+ */
+
+#include "SampleConverter.h"
+
+#include <cstring>
+#include <limits>
+
+// x86-64: AVX2 kernels are compiled with a target attribute and chosen at
+// runtime, so the x86-64-v2 build still gets them on AVX2 CPUs.
+// ARM64: NEON is always present.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #define SC_HAS_AVX2 1
+    #define SC_HAS_NEON 0
+    #include <immintrin.h>
+    #define SC_AVX2 __attribute__((target("avx2")))
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define SC_HAS_AVX2 0
+    #define SC_HAS_NEON 1
+    #include <arm_neon.h>
+#else
+    #define SC_HAS_AVX2 0
+    #define SC_HAS_NEON 0
+#endif
+
+namespace {
+
+// ============================================
+// Scalar
+// ============================================
+
+inline int32_t floatSample(float f) {
+    float x = f * 2147483648.0f;
+    if (x != x) return 0;
+    if (x >= 2147483648.0f) return std::numeric_limits<int32_t>::max();
+    if (x <= -2147483648.0f) return std::numeric_limits<int32_t>::min();
+    return static_cast<int32_t>(x);
+}
+
+void packedScalar(const uint8_t* src, size_t begin, size_t samples,
+                  uint32_t bytesPerSample, bool bigEndian, int32_t* dst) {
+    const uint8_t* p = src + begin * bytesPerSample;
+    switch (bytesPerSample) {
+        case 1:
+            for (size_t i = begin; i < samples; i++, p += 1) {
+                dst[i] = static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 24);
+            }
+            break;
+        case 2:
+            for (size_t i = begin; i < samples; i++, p += 2) {
+                uint32_t v = bigEndian ? (uint32_t(p[0]) << 24) | (p[1] << 16)
+                                       : (uint32_t(p[1]) << 24) | (p[0] << 16);
+                dst[i] = static_cast<int32_t>(v);
+            }
+            break;
+        case 3:
+            for (size_t i = begin; i < samples; i++, p += 3) {
+                uint32_t v = bigEndian ? (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8)
+                                       : (uint32_t(p[2]) << 24) | (p[1] << 16) | (p[0] << 8);
+                dst[i] = static_cast<int32_t>(v);
+            }
+            break;
+        case 4:
+            for (size_t i = begin; i < samples; i++, p += 4) {
+                uint32_t v = bigEndian
+                    ? (uint32_t(p[0]) << 24) | (p[1] << 16) | (p[2] << 8) | p[3]
+                    : (uint32_t(p[3]) << 24) | (p[2] << 16) | (p[1] << 8) | p[0];
+                dst[i] = static_cast<int32_t>(v);
+            }
+            break;
+    }
+}
+
+#if SC_HAS_AVX2
+// ============================================
+// AVX2
+// ============================================
+
+bool useAvx2() {
+#if defined(__AVX2__)
+    return true;
+#else
+    static const bool s_avx2 = __builtin_cpu_supports("avx2");
+    return s_avx2;
+#endif
+}
+
+// Store a[0..7], b[0..7] as a0 b0 a1 b1 ... a7 b7
+SC_AVX2 inline void store2(int32_t* dst, __m256i a, __m256i b) {
+    __m256i lo = _mm256_unpacklo_epi32(a, b);  // a0 b0 a1 b1 | a4 b4 a5 b5
+    __m256i hi = _mm256_unpackhi_epi32(a, b);  // a2 b2 a3 b3 | a6 b6 a7 b7
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                        _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8),
+                        _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+SC_AVX2 inline __m256i floatToS32x8(__m256 f) {
+    const __m256 fullScale = _mm256_set1_ps(2147483648.0f);
+    __m256 x = _mm256_mul_ps(f, fullScale);
+    x = _mm256_and_ps(x, _mm256_cmp_ps(x, x, _CMP_ORD_Q));  // NaN -> 0
+    // cvtt yields INT32_MIN when out of range: right for negative clips,
+    // flipped to INT32_MAX for positive ones
+    __m256i over = _mm256_castps_si256(_mm256_cmp_ps(x, fullScale, _CMP_GE_OQ));
+    return _mm256_xor_si256(_mm256_cvttps_epi32(x), over);
+}
+
+SC_AVX2 size_t interleave2S32Avx2(const int32_t* l, const int32_t* r, size_t frames,
+                                  int shift, int32_t* dst) {
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(l + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(r + i));
+        store2(dst + 2 * i, _mm256_sll_epi32(a, count), _mm256_sll_epi32(b, count));
+    }
+    return i;
+}
+
+SC_AVX2 size_t interleave2S16Avx2(const int16_t* l, const int16_t* r, size_t frames,
+                                  int32_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        __m256i a = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(l + i)));
+        __m256i b = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(r + i)));
+        store2(dst + 2 * i, _mm256_slli_epi32(a, 16), _mm256_slli_epi32(b, 16));
+    }
+    return i;
+}
+
+SC_AVX2 size_t interleave2FloatAvx2(const float* l, const float* r, size_t frames,
+                                    int32_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        store2(dst + 2 * i, floatToS32x8(_mm256_loadu_ps(l + i)),
+               floatToS32x8(_mm256_loadu_ps(r + i)));
+    }
+    return i;
+}
+
+SC_AVX2 size_t shiftS32Avx2(const int32_t* src, size_t samples, int shift, int32_t* dst) {
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_sll_epi32(v, count));
+    }
+    return i;
+}
+
+SC_AVX2 size_t floatToS32Avx2(const float* src, size_t samples, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            floatToS32x8(_mm256_loadu_ps(src + i)));
+    }
+    return i;
+}
+
+// Byte shuffles place each sample in the top bytes of its int32 lane
+SC_AVX2 size_t packed16Avx2(const uint8_t* src, size_t samples, bool bigEndian, int32_t* dst) {
+    const __m256i mask = bigEndian
+        ? _mm256_setr_epi8(-1, -1, 1, 0, -1, -1, 3, 2, -1, -1, 5, 4, -1, -1, 7, 6,
+                           -1, -1, 9, 8, -1, -1, 11, 10, -1, -1, 13, 12, -1, -1, 15, 14)
+        : _mm256_setr_epi8(-1, -1, 0, 1, -1, -1, 2, 3, -1, -1, 4, 5, -1, -1, 6, 7,
+                           -1, -1, 8, 9, -1, -1, 10, 11, -1, -1, 12, 13, -1, -1, 14, 15);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(v), mask));
+    }
+    return i;
+}
+
+SC_AVX2 size_t packed24Avx2(const uint8_t* src, size_t samples, bool bigEndian, int32_t* dst) {
+    const __m256i mask = bigEndian
+        ? _mm256_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9,
+                           -1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9)
+        : _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                           -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    size_t i = 0;
+    // 8 samples = 24 bytes, but the second 16-byte load ends 28 bytes in
+    for (; i + 10 <= samples; i += 8) {
+        const uint8_t* p = src + i * 3;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+
+SC_AVX2 size_t packed32BEAvx2(const uint8_t* src, size_t samples, int32_t* dst) {
+    const __m256i mask = _mm256_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask));
+    }
+    return i;
+}
+#endif // SC_HAS_AVX2
+
+#if SC_HAS_NEON
+// ============================================
+// NEON
+// ============================================
+
+size_t interleave2S32Neon(const int32_t* l, const int32_t* r, size_t frames,
+                          int shift, int32_t* dst) {
+    const int32x4_t count = vdupq_n_s32(shift);
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        int32x4x2_t v;
+        v.val[0] = vshlq_s32(vld1q_s32(l + i), count);
+        v.val[1] = vshlq_s32(vld1q_s32(r + i), count);
+        vst2q_s32(dst + 2 * i, v);
+    }
+    return i;
+}
+
+size_t interleave2S16Neon(const int16_t* l, const int16_t* r, size_t frames, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        int32x4x2_t v;
+        v.val[0] = vshlq_n_s32(vmovl_s16(vld1_s16(l + i)), 16);
+        v.val[1] = vshlq_n_s32(vmovl_s16(vld1_s16(r + i)), 16);
+        vst2q_s32(dst + 2 * i, v);
+    }
+    return i;
+}
+
+// vcvtq_s32_f32 saturates and maps NaN to 0 — exactly the clipping we want
+size_t interleave2FloatNeon(const float* l, const float* r, size_t frames, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 4 <= frames; i += 4) {
+        int32x4x2_t v;
+        v.val[0] = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(l + i), 2147483648.0f));
+        v.val[1] = vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(r + i), 2147483648.0f));
+        vst2q_s32(dst + 2 * i, v);
+    }
+    return i;
+}
+
+size_t shiftS32Neon(const int32_t* src, size_t samples, int shift, int32_t* dst) {
+    const int32x4_t count = vdupq_n_s32(shift);
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_s32(dst + i, vshlq_s32(vld1q_s32(src + i), count));
+    }
+    return i;
+}
+
+size_t floatToS32Neon(const float* src, size_t samples, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_s32(dst + i, vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(src + i), 2147483648.0f)));
+    }
+    return i;
+}
+
+size_t packed16Neon(const uint8_t* src, size_t samples, bool bigEndian, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        uint8x16_t v = vld1q_u8(src + i * 2);
+        if (bigEndian) v = vrev16q_u8(v);
+        int16x8_t s = vreinterpretq_s16_u8(v);
+        vst1q_s32(dst + i, vshlq_n_s32(vmovl_s16(vget_low_s16(s)), 16));
+        vst1q_s32(dst + i + 4, vshlq_n_s32(vmovl_s16(vget_high_s16(s)), 16));
+    }
+    return i;
+}
+
+size_t packed24Neon(const uint8_t* src, size_t samples, bool bigEndian, int32_t* dst) {
+    const uint8x8_t zero = vdup_n_u8(0);
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        uint8x8x3_t b = vld3_u8(src + i * 3);  // byte 0 / 1 / 2 of 8 samples
+        uint8x8_t lsb = bigEndian ? b.val[2] : b.val[0];
+        uint8x8_t msb = bigEndian ? b.val[0] : b.val[2];
+        uint8x8x2_t lo = vzip_u8(zero, lsb);    // u16: lsb << 8
+        uint8x8x2_t hi = vzip_u8(b.val[1], msb); // u16: msb << 8 | mid
+        uint16x8x2_t w = vzipq_u16(
+            vreinterpretq_u16_u8(vcombine_u8(lo.val[0], lo.val[1])),
+            vreinterpretq_u16_u8(vcombine_u8(hi.val[0], hi.val[1])));
+        vst1q_s32(dst + i, vreinterpretq_s32_u16(w.val[0]));
+        vst1q_s32(dst + i + 4, vreinterpretq_s32_u16(w.val[1]));
+    }
+    return i;
+}
+
+size_t packed32BENeon(const uint8_t* src, size_t samples, int32_t* dst) {
+    size_t i = 0;
+    for (; i + 4 <= samples; i += 4) {
+        vst1q_s32(dst + i, vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(src + i * 4))));
+    }
+    return i;
+}
+#endif // SC_HAS_NEON
+
+} // namespace
+
+// ============================================
+// Dispatch
+// ============================================
+
+void SampleConverter::interleaveS32(const int32_t* const* planes, size_t channels,
+                                    size_t frames, int shift, int32_t* dst) {
+    if (channels == 1) {
+        shiftS32(planes[0], frames, shift, dst);
+        return;
+    }
+    size_t i = 0;
+    if (channels == 2) {
+#if SC_HAS_AVX2
+        if (useAvx2()) i = interleave2S32Avx2(planes[0], planes[1], frames, shift, dst);
+#elif SC_HAS_NEON
+        i = interleave2S32Neon(planes[0], planes[1], frames, shift, dst);
+#endif
+    }
+    int32_t* out = dst + i * channels;
+    for (; i < frames; i++) {
+        for (size_t ch = 0; ch < channels; ch++) {
+            *out++ = static_cast<int32_t>(static_cast<uint32_t>(planes[ch][i]) << shift);
+        }
+    }
+}
+
+void SampleConverter::interleaveS16(const int16_t* const* planes, size_t channels,
+                                    size_t frames, int32_t* dst) {
+    if (channels == 1) {
+        s16ToS32(planes[0], frames, dst);
+        return;
+    }
+    size_t i = 0;
+    if (channels == 2) {
+#if SC_HAS_AVX2
+        if (useAvx2()) i = interleave2S16Avx2(planes[0], planes[1], frames, dst);
+#elif SC_HAS_NEON
+        i = interleave2S16Neon(planes[0], planes[1], frames, dst);
+#endif
+    }
+    int32_t* out = dst + i * channels;
+    for (; i < frames; i++) {
+        for (size_t ch = 0; ch < channels; ch++) {
+            *out++ = static_cast<int32_t>(static_cast<uint32_t>(planes[ch][i]) << 16);
+        }
+    }
+}
+
+void SampleConverter::interleaveFloat(const float* const* planes, size_t channels,
+                                      size_t frames, int32_t* dst) {
+    if (channels == 1) {
+        floatToS32(planes[0], frames, dst);
+        return;
+    }
+    size_t i = 0;
+    if (channels == 2) {
+#if SC_HAS_AVX2
+        if (useAvx2()) i = interleave2FloatAvx2(planes[0], planes[1], frames, dst);
+#elif SC_HAS_NEON
+        i = interleave2FloatNeon(planes[0], planes[1], frames, dst);
+#endif
+    }
+    int32_t* out = dst + i * channels;
+    for (; i < frames; i++) {
+        for (size_t ch = 0; ch < channels; ch++) {
+            *out++ = floatSample(planes[ch][i]);
+        }
+    }
+}
+
+void SampleConverter::shiftS32(const int32_t* src, size_t samples, int shift, int32_t* dst) {
+    size_t i = 0;
+#if SC_HAS_AVX2
+    if (useAvx2()) i = shiftS32Avx2(src, samples, shift, dst);
+#elif SC_HAS_NEON
+    i = shiftS32Neon(src, samples, shift, dst);
+#endif
+    for (; i < samples; i++) {
+        dst[i] = static_cast<int32_t>(static_cast<uint32_t>(src[i]) << shift);
+    }
+}
+
+void SampleConverter::s16ToS32(const int16_t* src, size_t samples, int32_t* dst) {
+    // Host is little-endian (S32_LE output throughout)
+    packedToS32(reinterpret_cast<const uint8_t*>(src), samples, 2, false, dst);
+}
+
+void SampleConverter::floatToS32(const float* src, size_t samples, int32_t* dst) {
+    size_t i = 0;
+#if SC_HAS_AVX2
+    if (useAvx2()) i = floatToS32Avx2(src, samples, dst);
+#elif SC_HAS_NEON
+    i = floatToS32Neon(src, samples, dst);
+#endif
+    for (; i < samples; i++) {
+        dst[i] = floatSample(src[i]);
+    }
+}
+
+void SampleConverter::packedToS32(const uint8_t* src, size_t samples,
+                                  uint32_t bytesPerSample, bool bigEndian, int32_t* dst) {
+    if (samples == 0) return;
+    if (bytesPerSample == 4 && !bigEndian) {
+        std::memcpy(dst, src, samples * sizeof(int32_t));
+        return;
+    }
+    size_t i = 0;
+#if SC_HAS_AVX2
+    if (useAvx2()) {
+        switch (bytesPerSample) {
+            case 2: i = packed16Avx2(src, samples, bigEndian, dst); break;
+            case 3: i = packed24Avx2(src, samples, bigEndian, dst); break;
+            case 4: i = packed32BEAvx2(src, samples, dst); break;
+        }
+    }
+#elif SC_HAS_NEON
+    switch (bytesPerSample) {
+        case 2: i = packed16Neon(src, samples, bigEndian, dst); break;
+        case 3: i = packed24Neon(src, samples, bigEndian, dst); break;
+        case 4: i = packed32BENeon(src, samples, dst); break;
+    }
+#endif
+    packedScalar(src, i, samples, bytesPerSample, bigEndian, dst);
+}
+
+const char* SampleConverter::kernelName() {
+#if SC_HAS_AVX2
+    return useAvx2() ? "AVX2" : "scalar";
+#elif SC_HAS_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
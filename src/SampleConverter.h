@@ -0,0 +1,63 @@
+/**
+ * @file SampleConverter.h
+ * @brief Sample-format conversion to S32_LE MSB-aligned, shared by the decoders
+ *
+ * One place for the per-sample conversions the decoders used to do inline:
+ * libFLAC's planar int32 with a left shift, WAV/AIFF packed 8/16/24/32-bit
+ * in either byte order, S16 from Vorbis/fdk-aac/FFmpeg and float from FFmpeg.
+ *
+ * Kernels: AVX2 on x86-64 (picked at runtime, so x86-64-v2 builds use it on
+ * CPUs that have it), NEON on ARM, scalar otherwise and for tails.
+ */
+
+#ifndef SLIM2DIRETTA_SAMPLE_CONVERTER_H
+#define SLIM2DIRETTA_SAMPLE_CONVERTER_H
+
+#include <cstdint>
+#include <cstddef>
+
+class SampleConverter {
+public:
+    /**
+     * @brief Planar int32 to interleaved, each sample shifted left
+     * @param planes One pointer per channel, frames samples each
+     * @param shift Left shift for MSB alignment (32 - bit depth)
+     */
+    static void interleaveS32(const int32_t* const* planes, size_t channels,
+                              size_t frames, int shift, int32_t* dst);
+
+    /// Planar S16 to interleaved S32
+    static void interleaveS16(const int16_t* const* planes, size_t channels,
+                              size_t frames, int32_t* dst);
+
+    /// Planar float to interleaved S32 (see floatToS32() for clipping)
+    static void interleaveFloat(const float* const* planes, size_t channels,
+                                size_t frames, int32_t* dst);
+
+    /// Interleaved int32 shifted left by shift
+    static void shiftS32(const int32_t* src, size_t samples, int shift, int32_t* dst);
+
+    /// Native-endian S16 to S32
+    static void s16ToS32(const int16_t* src, size_t samples, int32_t* dst);
+
+    /**
+     * @brief Float to S32
+     *
+     * Full scale is ±1.0 → ±2^31. Values at or beyond it clip to
+     * INT32_MAX / INT32_MIN, NaN becomes silence.
+     */
+    static void floatToS32(const float* src, size_t samples, int32_t* dst);
+
+    /**
+     * @brief Packed signed integer PCM to S32
+     * @param bytesPerSample 1, 2, 3 or 4
+     * @param bigEndian true for AIFF / big-endian raw PCM
+     */
+    static void packedToS32(const uint8_t* src, size_t samples,
+                            uint32_t bytesPerSample, bool bigEndian, int32_t* dst);
+
+    /// Kernel set in use ("AVX2", "NEON" or "scalar")
+    static const char* kernelName();
+};
+
+#endif // SLIM2DIRETTA_SAMPLE_CONVERTER_H
@@ -0,0 +1,103 @@
+/**
+ * @file SampleQueue.cpp
+ * @brief Decoded-sample FIFO implementation
+ */
+
+#include "SampleQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+size_t roundUpPow2(size_t v) {
+    size_t p = 1;
+    while (p < v) p <<= 1;
+    return p;
+}
+
+} // namespace
+
+SampleQueue::SampleQueue(size_t initialCapacity)
+    : m_buf(roundUpPow2(std::max<size_t>(initialCapacity, 1024)))
+    , m_mask(m_buf.size() - 1)
+{
+}
+
+int32_t* SampleQueue::prepare(size_t samples) {
+    size_t cap = m_buf.size();
+    size_t used = static_cast<size_t>(m_writePos - m_readPos);
+    size_t idx = static_cast<size_t>(m_writePos) & m_mask;
+
+    if (idx + samples <= cap) {
+        if (used + samples > cap) {
+            grow(available() + samples);
+            idx = static_cast<size_t>(m_writePos) & m_mask;
+        }
+        return m_buf.data() + idx;
+    }
+
+    // Block would straddle the end: start it at index 0 and leave the tail
+    // unused. Needs the tail plus the block free, and no older gap live.
+    size_t pad = cap - idx;
+    if (m_gapLen != 0 || used + pad + samples > cap) {
+        grow(available() + samples);
+        return m_buf.data() + (static_cast<size_t>(m_writePos) & m_mask);
+    }
+    if (used == 0) {
+        m_readPos += pad;
+    } else {
+        m_gapPos = m_writePos;
+        m_gapLen = pad;
+    }
+    m_writePos += pad;
+    return m_buf.data();
+}
+
+void SampleQueue::append(const int32_t* src, size_t samples) {
+    if (samples == 0) return;
+    std::memcpy(prepare(samples), src, samples * sizeof(int32_t));
+    commit(samples);
+}
+
+size_t SampleQueue::read(int32_t* dst, size_t samples) {
+    size_t n = std::min(samples, available());
+    size_t done = 0;
+    while (done < n) {
+        size_t idx = static_cast<size_t>(m_readPos) & m_mask;
+        size_t chunk = n - done;
+        if (m_gapLen != 0) {
+            chunk = std::min(chunk, static_cast<size_t>(m_gapPos - m_readPos));
+        }
+        chunk = std::min(chunk, m_buf.size() - idx);
+        std::memcpy(dst + done, m_buf.data() + idx, chunk * sizeof(int32_t));
+        m_readPos += chunk;
+        done += chunk;
+        if (m_gapLen != 0 && m_readPos == m_gapPos) {
+            m_readPos += m_gapLen;
+            m_gapLen = 0;
+        }
+    }
+    return n;
+}
+
+void SampleQueue::clear() {
+    m_readPos = m_writePos = 0;
+    m_gapLen = 0;
+    m_bytesMoved = 0;
+}
+
+void SampleQueue::grow(size_t needed) {
+    std::vector<int32_t> bigger(roundUpPow2(std::max(needed, m_buf.size() * 2)));
+
+    // Restart the live samples at index 0 — drops any gap
+    size_t live = available();
+    read(bigger.data(), live);
+    m_bytesMoved += live * sizeof(int32_t);
+
+    m_buf.swap(bigger);
+    m_mask = m_buf.size() - 1;
+    m_readPos = 0;
+    m_writePos = live;
+    m_gapLen = 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file SampleQueue.h
+ * @brief Decoded-sample FIFO shared by the decoders
+ *
+ * Ring of S32 samples with a read and a write cursor. Writers reserve a
+ * contiguous block with prepare(), fill it and commit(); readDecoded()
+ * copies out with read(). A block that does not fit before the end of
+ * the ring starts at index 0 instead and the skipped tail is stepped over
+ * on read (bip-buffer style), so nothing is ever moved once the ring has
+ * reached its working size. Only growth relocates samples, which
+ * bytesMoved() reports for the stats.
+ */
+
+#ifndef SLIM2DIRETTA_SAMPLE_QUEUE_H
+#define SLIM2DIRETTA_SAMPLE_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class SampleQueue {
+public:
+    explicit SampleQueue(size_t initialCapacity = 16384);
+
+    /// Samples ready to read
+    size_t available() const { return static_cast<size_t>(m_writePos - m_readPos) - m_gapLen; }
+    bool empty() const { return available() == 0; }
+
+    /**
+     * @brief Reserve room for samples contiguous samples
+     * @return Write pointer, valid until commit() or another prepare()
+     */
+    int32_t* prepare(size_t samples);
+    /// Publish samples (<= the prepared count) written at prepare()'s pointer
+    void commit(size_t samples) { m_writePos += samples; }
+
+    void append(const int32_t* src, size_t samples);
+
+    /// Copy out up to samples samples
+    size_t read(int32_t* dst, size_t samples);
+
+    /// Drop all samples (capacity is kept, bytesMoved() restarts at 0)
+    void clear();
+
+    /// Bytes relocated by growth since the last clear()
+    uint64_t bytesMoved() const { return m_bytesMoved; }
+
+private:
+    void grow(size_t needed);
+
+    std::vector<int32_t> m_buf;
+    size_t m_mask;
+    uint64_t m_readPos = 0;
+    uint64_t m_writePos = 0;
+    // Unused ring tail skipped by a wrapped prepare() (at most one live)
+    uint64_t m_gapPos = 0;
+    size_t m_gapLen = 0;
+    uint64_t m_bytesMoved = 0;
+};
+
+#endif // SLIM2DIRETTA_SAMPLE_QUEUE_H
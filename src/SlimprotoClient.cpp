@@ -7,8 +7,12 @@
  */
 
 #include "SlimprotoClient.h"
+#include "UringReceiver.h"
+#include "NetBind.h"
+#include "Decoder.h"
 #include "LogLevel.h"
 
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -18,6 +22,7 @@
 #include <poll.h>
 #include <net/if.h>
 #include <ifaddrs.h>
+#include <time.h>
 
 #include <cstring>
 #include <sstream>
@@ -26,17 +31,38 @@
 #include <algorithm>
 #include <random>
 
+namespace {
+
+// Room for the largest server frame (16-bit length + body)
+constexpr size_t RX_BUFFER_BYTES = 2 + 0xFFFF;
+// Queued frames gathered into one send()
+constexpr size_t TX_BUFFER_BYTES = 8 * SlimprotoQueue::SLOT_BYTES;
+// Overflow list: a full queue's worth of frames, or a few long RESPs
+constexpr size_t OVERFLOW_BYTES = SlimprotoQueue::SLOT_COUNT * SlimprotoQueue::SLOT_BYTES;
+
+} // namespace
+
 // ============================================
 // Constructor / Destructor
 // ============================================
 
 SlimprotoClient::SlimprotoClient()
-    : m_startTime(std::chrono::steady_clock::now())
+    : m_txBuf(TX_BUFFER_BYTES)
+    , m_rxBuf(RX_BUFFER_BYTES)
+    , m_startTime(std::chrono::steady_clock::now())
 {
+    m_overflow.reserve(OVERFLOW_BYTES);
+    m_overflowOut.reserve(OVERFLOW_BYTES);
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0) {
+        LOG_WARN("[Slimproto] eventfd failed (" << strerror(errno)
+                 << ") — status messages wait for the next server message");
+    }
 }
 
 SlimprotoClient::~SlimprotoClient() {
     disconnect();
+    if (m_wakeFd >= 0) close(m_wakeFd);
 }
 
 // ============================================
@@ -77,6 +103,12 @@ bool SlimprotoClient::connect(const std::string& server, uint16_t port, const Co
     int flag = 1;
     setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
 
+    if (!bindSocket(m_socket, config.controlBind, "[Slimproto]")) {
+        close(m_socket);
+        m_socket = -1;
+        return false;
+    }
+
     // Connect to LMS
     struct sockaddr_in addr{};
     addr.sin_family = AF_INET;
@@ -100,11 +132,37 @@ bool SlimprotoClient::connect(const std::string& server, uint16_t port, const Co
     m_connected.store(true, std::memory_order_release);
     LOG_INFO("Connected to LMS");
 
+    // The previous connection's receive thread has been joined by now
+    m_uring.reset();
+    m_uringActive.store(false, std::memory_order_relaxed);
+    m_rxSyscalls.store(0, std::memory_order_relaxed);
+    m_connectTime = std::chrono::steady_clock::now();
+    m_rxLen = 0;
+
+    // Frames still queued from the previous connection are not for this one
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        while (m_txQueue.pop(m_txBuf.data()) > 0) {}
+        m_heartbeatPending.store(false, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> overflowLock(m_overflowMutex);
+        m_overflow.clear();
+        m_overflowOut.clear();
+        m_overflowFrames = 0;
+        m_overflowOutFrames = 0;
+        m_overflowPending.store(false, std::memory_order_relaxed);
+    }
+    m_txFrames.store(0, std::memory_order_relaxed);
+    m_txWrites.store(0, std::memory_order_relaxed);
+    m_heartbeatsCoalesced.store(0, std::memory_order_relaxed);
+    m_txOverflow.store(0, std::memory_order_relaxed);
+    m_txOverflowLogged = 0;
+
     // Send HELO to register as a player
     sendHelo();
 
     // Send player name to LMS (setd id=0)
     sendSetd(0, m_config.playerName);
+    flushOutbound();
 
     return true;
 }
@@ -112,6 +170,7 @@ bool SlimprotoClient::connect(const std::string& server, uint16_t port, const Co
 void SlimprotoClient::disconnect() {
     if (m_connected.load(std::memory_order_acquire)) {
         sendBye();
+        flushOutbound();
         m_connected.store(false, std::memory_order_release);
     }
 
@@ -138,47 +197,43 @@ void SlimprotoClient::run() {
 
     LOG_DEBUG("[Slimproto] Receive loop started");
 
+    m_rxThread = pthread_self();
+    m_rxThreadRunning.store(true, std::memory_order_release);
+    if (UringReceiver::enabled()) {
+        m_uring = std::make_unique<UringReceiver>();
+        if (m_uring->start(m_socket) && (m_wakeFd < 0 || m_uring->watch(m_wakeFd))) {
+            m_uringActive.store(true, std::memory_order_relaxed);
+            LOG_DEBUG("[Slimproto] Receiving through io_uring");
+        } else {
+            LOG_WARN("[Slimproto] io_uring receive unavailable — using recv()");
+            m_uring.reset();
+        }
+    }
+
+    // Anything queued by the audio thread since connect()
+    flushOutbound();
+
+    // Each pass: wait for server bytes or a wake-up, handle every complete
+    // frame, then send what they (and the other threads) queued
     while (m_running.load(std::memory_order_acquire)) {
-        // Server -> Client frame: [2-byte length BE][4-byte opcode][payload]
-        uint16_t frameLen = 0;
-        if (!readExact(&frameLen, 2)) {
+        if (!fillBuffer()) {
             if (m_running.load(std::memory_order_acquire)) {
                 LOG_WARN("Lost connection to LMS");
             }
             break;
         }
-        frameLen = ntohs(frameLen);
-
-        if (frameLen < 4) {
-            LOG_WARN("[Slimproto] Invalid frame length: " << frameLen);
-            continue;
-        }
-
-        // Read opcode
-        char opcode[4];
-        if (!readExact(opcode, 4)) {
-            break;
-        }
-
-        // Read payload
-        size_t payloadLen = frameLen - 4;
-        std::vector<uint8_t> payload(payloadLen);
-        if (payloadLen > 0) {
-            if (!readExact(payload.data(), payloadLen)) {
-                break;
-            }
-        }
-
-        processServerMessage(opcode, payload.data(), payloadLen);
+        dispatchFrames();
+        flushOutbound();
     }
 
     LOG_DEBUG("[Slimproto] Receive loop ended");
+    m_rxThreadRunning.store(false, std::memory_order_release);
     m_connected.store(false, std::memory_order_release);
 }
 
 void SlimprotoClient::stop() {
     m_running.store(false, std::memory_order_release);
-    // Shutdown socket to unblock readExact
+    // Shutdown socket to unblock fillBuffer
     if (m_socket >= 0) {
         shutdown(m_socket, SHUT_RDWR);
     }
@@ -270,19 +325,29 @@ void SlimprotoClient::handleStrm(const uint8_t* data, size_t len) {
             break;
         }
 
-        case STRM_UNPAUSE:
-            LOG_INFO("[Slimproto] strm-u: unpause");
+        case STRM_UNPAUSE: {
+            uint32_t jiffies = cmd.getReplayGain();
+            if (jiffies > 0) {
+                LOG_INFO("[Slimproto] strm-u: unpause at jiffies " << jiffies
+                         << " (now " << getJiffies() << ")");
+            } else {
+                LOG_INFO("[Slimproto] strm-u: unpause");
+            }
             break;
+        }
 
         case STRM_FLUSH:
             LOG_INFO("[Slimproto] strm-f: flush");
             break;
 
         case STRM_STATUS: {
-            // Heartbeat - respond with STMt
+            // Heartbeat - the STMt goes out with the next flush; only the
+            // latest of several unsent heartbeats is answered
             uint32_t ts = cmd.getReplayGain();
-            m_serverTimestamp = ts;
-            sendStat(StatEvent::STMt, ts);
+            m_serverTimestamp.store(ts, std::memory_order_relaxed);
+            if (m_heartbeatPending.exchange(true, std::memory_order_acq_rel)) {
+                m_heartbeatsCoalesced.fetch_add(1, std::memory_order_relaxed);
+            }
             // Log heartbeat only once per minute to reduce noise
             {
                 static uint32_t lastLoggedTs = 0;
@@ -296,7 +361,7 @@ void SlimprotoClient::handleStrm(const uint8_t* data, size_t len) {
         }
 
         case STRM_SKIP:
-            LOG_INFO("[Slimproto] strm-a: skip");
+            LOG_INFO("[Slimproto] strm-a: skip ahead " << cmd.getReplayGain() << " ms");
             break;
 
         default:
@@ -363,8 +428,12 @@ void SlimprotoClient::handleSetd(const uint8_t* data, size_t len) {
 // Send HELO
 // ============================================
 
-void SlimprotoClient::sendHelo() {
+void SlimprotoClient::sendHelo(bool reconnect) {
     std::string caps = buildCapabilities();
+    {
+        std::lock_guard<std::mutex> lock(m_capsMutex);
+        m_sentCaps = caps;
+    }
 
     // Build payload
     std::vector<uint8_t> payload(sizeof(HeloPayload) + caps.size());
@@ -377,6 +446,13 @@ void SlimprotoClient::sendHelo() {
     helo.wlanChannels = 0;
     helo.bytesRecvHi = 0;
     helo.bytesRecvLo = 0;
+    if (reconnect) {
+        // Same connection, new capabilities: LMS keeps the player's state
+        const uint64_t received = m_bytesReceived.load(std::memory_order_relaxed);
+        helo.wlanChannels = htons(0x4000);
+        helo.bytesRecvHi = htonl(static_cast<uint32_t>(received >> 32));
+        helo.bytesRecvLo = htonl(static_cast<uint32_t>(received));
+    }
     helo.language[0] = 'e';
     helo.language[1] = 'n';
 
@@ -388,6 +464,16 @@ void SlimprotoClient::sendHelo() {
     LOG_INFO("HELO sent (capabilities: " << caps << ")");
 }
 
+void SlimprotoClient::refreshCapabilities() {
+    if (!m_connected.load(std::memory_order_acquire)) return;
+    {
+        std::lock_guard<std::mutex> lock(m_capsMutex);
+        if (buildCapabilities() == m_sentCaps) return;
+    }
+    LOG_INFO("[Slimproto] Capabilities changed, updating LMS");
+    sendHelo(true);
+}
+
 // ============================================
 // Send BYE
 // ============================================
@@ -418,8 +504,17 @@ void SlimprotoClient::sendSetd(uint8_t id, const std::string& data) {
 // ============================================
 
 void SlimprotoClient::sendStat(const char eventCode[4], uint32_t serverTimestamp) {
-    StatPayload stat{};
+    StatPayload stat;
+    buildStat(stat, eventCode, serverTimestamp);
+    if (sendMessage("STAT", &stat, sizeof(stat))) {
+        std::string evt(eventCode, 4);
+        LOG_DEBUG("[Slimproto] STAT sent: " << evt);
+    }
+}
 
+void SlimprotoClient::buildStat(StatPayload& stat, const char eventCode[4],
+                                uint32_t serverTimestamp) const {
+    stat = StatPayload{};
     std::memcpy(stat.eventCode, eventCode, 4);
     stat.crlf = 0;
     stat.masInit = 0;
@@ -440,14 +535,6 @@ void SlimprotoClient::sendStat(const char eventCode[4], uint32_t serverTimestamp
     stat.elapsedMs = htonl(m_elapsedMs.load(std::memory_order_relaxed));
     stat.serverTimestamp = htonl(serverTimestamp);
     stat.errorCode = 0;
-
-    sendMessage("STAT", &stat, sizeof(stat));
-
-    // Don't log heartbeat responses (too noisy — every 2s)
-    if (std::memcmp(eventCode, StatEvent::STMt, 4) != 0) {
-        std::string evt(eventCode, 4);
-        LOG_DEBUG("[Slimproto] STAT sent: " << evt);
-    }
 }
 
 // ============================================
@@ -484,22 +571,96 @@ void SlimprotoClient::updateBufferState(uint32_t streamBufSize, uint32_t streamB
 // Socket I/O
 // ============================================
 
-bool SlimprotoClient::readExact(void* buf, size_t len) {
-    uint8_t* ptr = static_cast<uint8_t*>(buf);
-    size_t remaining = len;
+bool SlimprotoClient::fillBuffer() {
+    uint8_t* dst = m_rxBuf.data() + m_rxLen;
+    const size_t space = m_rxBuf.size() - m_rxLen;
 
-    while (remaining > 0) {
-        ssize_t n = recv(m_socket, ptr, remaining, 0);
-        if (n <= 0) {
-            if (n < 0 && (errno == EINTR)) continue;
-            return false;
+    if (m_uring) {
+        // Completions usually hold whole frames already: no syscall
+        const uint64_t before = m_uring->syscalls();
+        ssize_t n = m_uring->read(dst, space);
+        if (n == UringReceiver::EMPTY) {
+            n = m_uring->wait(-1) < 0 ? UringReceiver::FAILED : m_uring->read(dst, space);
         }
-        ptr += n;
-        remaining -= n;
-    }
+        m_rxSyscalls.fetch_add(m_uring->syscalls() - before, std::memory_order_relaxed);
+        if (m_uring->watchFired()) drainWake();
+        if (n == UringReceiver::EMPTY) return true;  // Woken to send, or interrupted
+        if (n <= 0) return false;
+        m_rxLen += static_cast<size_t>(n);
+        return true;
+    }
+
+    // Sleep until the server sends or another thread queues a frame; then
+    // take whatever has arrived in one recv()
+    struct pollfd fds[2] = {{m_socket, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+    int r = poll(fds, 2, -1);
+    m_rxSyscalls.fetch_add(1, std::memory_order_relaxed);
+    if (r < 0) return errno == EINTR;
+    if (fds[1].revents & POLLIN) drainWake();
+    if (fds[0].revents == 0) return true;
+
+    ssize_t n = recv(m_socket, dst, space, MSG_DONTWAIT);
+    m_rxSyscalls.fetch_add(1, std::memory_order_relaxed);
+    if (n < 0 && (errno == EINTR || errno == EAGAIN)) return true;
+    if (n <= 0) return false;
+    m_rxLen += static_cast<size_t>(n);
     return true;
 }
 
+void SlimprotoClient::dispatchFrames() {
+    // Server -> Client frame: [2-byte length BE][4-byte opcode][payload]
+    size_t pos = 0;
+    while (m_rxLen - pos >= 2) {
+        const uint8_t* frame = m_rxBuf.data() + pos;
+        const size_t frameLen = (static_cast<size_t>(frame[0]) << 8) | frame[1];
+        if (m_rxLen - pos - 2 < frameLen) break;  // Rest not received yet
+
+        if (frameLen < 4) {
+            LOG_WARN("[Slimproto] Invalid frame length: " << frameLen);
+        } else {
+            processServerMessage(reinterpret_cast<const char*>(frame + 2), frame + 6,
+                                 frameLen - 4);
+        }
+        pos += 2 + frameLen;
+    }
+
+    // A partial frame moves to the front, where the largest one fits
+    if (pos > 0 && pos < m_rxLen) {
+        std::memmove(m_rxBuf.data(), m_rxBuf.data() + pos, m_rxLen - pos);
+    }
+    m_rxLen -= pos;
+}
+
+void SlimprotoClient::dumpStats() const {
+    if (!m_connected.load(std::memory_order_acquire)) return;
+
+    const uint64_t syscalls = m_rxSyscalls.load(std::memory_order_relaxed);
+    const uint64_t ms = std::max<uint64_t>(1, static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - m_connectTime).count()));
+    std::cout << "[Slimproto] Receive ("
+              << (m_uringActive.load(std::memory_order_relaxed) ? "io_uring" : "socket") << "): "
+              << syscalls << " syscalls in " << ms / 1000 << "s ("
+              << syscalls * 1000 / ms << "/s)";
+
+    // CPU of the receive thread (frame parsing and the replies it sends)
+    clockid_t clock;
+    struct timespec ts;
+    if (m_rxThreadRunning.load(std::memory_order_acquire) &&
+        pthread_getcpuclockid(m_rxThread, &clock) == 0 && clock_gettime(clock, &ts) == 0) {
+        const uint64_t us = static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+        std::cout << ", thread CPU " << us / 1000 << "." << us / 100 % 10 << " ms";
+    }
+    std::cout << std::endl;
+
+    std::cout << "[Slimproto] Send: " << m_txFrames.load(std::memory_order_relaxed)
+              << " frames in " << m_txWrites.load(std::memory_order_relaxed) << " writes, "
+              << m_heartbeatsCoalesced.load(std::memory_order_relaxed) << " heartbeats coalesced";
+    const uint64_t overflow = m_txOverflow.load(std::memory_order_relaxed);
+    if (overflow > 0) std::cout << ", " << overflow << " held in the overflow list (queue full)";
+    std::cout << std::endl;
+}
+
 bool SlimprotoClient::sendAll(const void* buf, size_t len) {
     const uint8_t* ptr = static_cast<const uint8_t*>(buf);
     size_t remaining = len;
@@ -517,20 +678,117 @@ bool SlimprotoClient::sendAll(const void* buf, size_t len) {
 }
 
 bool SlimprotoClient::sendMessage(const char opcode[4], const void* payload, size_t payloadLen) {
-    // Client -> Server: [4 opcode][4 length BE][payload]
-    std::lock_guard<std::mutex> lock(m_sendMutex);
+    // Once a frame waits in the overflow list, later ones queue behind it
+    if (!m_overflowPending.load(std::memory_order_acquire) &&
+        m_txQueue.push(opcode, payload, payloadLen)) {
+        // Frames queued by run()'s own thread go out after the current pass
+        if (!(m_rxThreadRunning.load(std::memory_order_acquire) &&
+              pthread_equal(pthread_self(), m_rxThread))) {
+            wake();
+        }
+        return true;
+    }
+
+    // Queue full, or longer than a slot (RESP with long headers): appended
+    // to the overflow list, written by the flushing thread after everything
+    // queued before it. Heartbeats never take a slot, so every queued frame
+    // is a state event LMS waits for and none may be lost; the caller still
+    // never touches the socket.
+    if (8 + payloadLen <= SlimprotoQueue::SLOT_BYTES) {
+        m_txOverflow.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        const size_t at = m_overflow.size();
+        m_overflow.resize(at + 8 + payloadLen);  // Grows only past OVERFLOW_BYTES
+        SlimprotoQueue::encode(m_overflow.data() + at, opcode, payload, payloadLen);
+        m_overflowFrames++;
+        m_overflowPending.store(true, std::memory_order_release);
+    }
+    if (!(m_rxThreadRunning.load(std::memory_order_acquire) &&
+          pthread_equal(pthread_self(), m_rxThread))) {
+        wake();
+    }
+    return true;
+}
 
-    uint32_t lenBE = htonl(static_cast<uint32_t>(payloadLen));
+void SlimprotoClient::flushOutbound() {
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    flushLocked();
+}
 
-    // Send opcode + length + payload in one go to avoid small packets
-    std::vector<uint8_t> frame(8 + payloadLen);
-    std::memcpy(frame.data(), opcode, 4);
-    std::memcpy(frame.data() + 4, &lenBE, 4);
-    if (payloadLen > 0 && payload) {
-        std::memcpy(frame.data() + 8, payload, payloadLen);
+bool SlimprotoClient::flushLocked() {
+    // Gather queued frames into as few send() calls as possible
+    bool ok = true;
+    size_t len = 0;
+    for (;;) {
+        size_t n = 0;
+        if (m_txBuf.size() - len >= SlimprotoQueue::SLOT_BYTES) {
+            n = m_txQueue.pop(m_txBuf.data() + len);
+            if (n == 0 && m_overflowPending.load(std::memory_order_acquire)) {
+                // Overflow frames follow everything queued before them: take
+                // the list only when the queue is empty under its lock
+                std::lock_guard<std::mutex> lock(m_overflowMutex);
+                n = m_txQueue.pop(m_txBuf.data() + len);
+                if (n == 0) {
+                    m_overflowOut.swap(m_overflow);
+                    m_overflowOutFrames = m_overflowFrames;
+                    m_overflowFrames = 0;
+                    m_overflowPending.store(false, std::memory_order_release);
+                }
+            }
+            if (n == 0 && !m_overflowOut.empty()) {
+                if (len > 0) {
+                    if (ok) ok = sendAll(m_txBuf.data(), len);
+                    m_txWrites.fetch_add(1, std::memory_order_relaxed);
+                    len = 0;
+                }
+                if (ok) ok = sendAll(m_overflowOut.data(), m_overflowOut.size());
+                m_txFrames.fetch_add(m_overflowOutFrames, std::memory_order_relaxed);
+                m_txWrites.fetch_add(1, std::memory_order_relaxed);
+                m_overflowOut.clear();
+                m_overflowOutFrames = 0;
+                const uint64_t overflow = m_txOverflow.load(std::memory_order_relaxed);
+                if (overflow != m_txOverflowLogged) {
+                    LOG_WARN("[Slimproto] Send queue full, " << overflow - m_txOverflowLogged
+                             << " frame(s) sent from the overflow list");
+                    m_txOverflowLogged = overflow;
+                }
+                continue;
+            }
+            if (n == 0 && m_heartbeatPending.exchange(false, std::memory_order_acq_rel)) {
+                // Heartbeat reply last, with the state as of now
+                StatPayload stat;
+                buildStat(stat, StatEvent::STMt,
+                          m_serverTimestamp.load(std::memory_order_relaxed));
+                n = SlimprotoQueue::encode(m_txBuf.data() + len, "STAT", &stat, sizeof(stat));
+            }
+        }
+        if (n > 0) {
+            len += n;
+            m_txFrames.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        if (len == 0) break;
+        if (ok) ok = sendAll(m_txBuf.data(), len);
+        m_txWrites.fetch_add(1, std::memory_order_relaxed);
+        len = 0;
     }
+    return ok;
+}
 
-    return sendAll(frame.data(), frame.size());
+void SlimprotoClient::wake() {
+    if (m_wakeFd < 0) return;
+    const uint64_t one = 1;
+    ssize_t r = write(m_wakeFd, &one, sizeof(one));
+    (void)r;  // EAGAIN only if the counter is saturated: already signalled
+}
+
+void SlimprotoClient::drainWake() {
+    uint64_t count;
+    ssize_t r = read(m_wakeFd, &count, sizeof(count));
+    (void)r;
+    m_rxSyscalls.fetch_add(1, std::memory_order_relaxed);
 }
 
 // ============================================
@@ -578,24 +836,30 @@ bool SlimprotoClient::parseMac(const std::string& str) {
 std::string SlimprotoClient::buildCapabilities() const {
     std::ostringstream caps;
 
-    // Codecs — LMS splits on commas and matches ^[a-z][a-z0-9]{1,4}$
-    caps << "flc,pcm,aif,wav";
-#ifdef ENABLE_MP3
-    caps << ",mp3";
-#endif
-#ifdef ENABLE_OGG
-    caps << ",ogg";
-#endif
-#ifdef ENABLE_AAC
-    caps << ",aac";
-#endif
-    if (m_config.dsdEnabled) {
-        caps << ",dsf,dff";  // DSD container formats recognized by LMS
+    // Codecs — LMS splits on commas and matches ^[a-z][a-z0-9]{1,4}$.
+    // Only those a decoder is available for with the configured backend:
+    // LMS transcodes the rest server-side instead of sending them
+    static constexpr struct { const char* name; char format; } CODECS[] = {
+        {"flc", FORMAT_FLAC}, {"pcm", FORMAT_PCM}, {"aif", FORMAT_PCM}, {"wav", FORMAT_PCM},
+        {"alc", FORMAT_ALAC}, {"mp3", FORMAT_MP3}, {"ogg", FORMAT_OGG}, {"aac", FORMAT_AAC},
+    };
+    for (const auto& codec : CODECS) {
+        if (Decoder::available(codec.format, m_config.decoderBackend)) {
+            caps << codec.name << ",";
+        }
     }
+    // DSD container formats recognized by LMS; with --no-dsd (or a target
+    // without DSD) they are converted to PCM here
+    caps << "dsf,dff";
 
     // Features — also comma-separated key=value pairs
-    // LMS SqueezePlay::updateCapabilities() parses these via split(',')
-    caps << ",MaxSampleRate=" << m_config.maxSampleRate;
+    // LMS SqueezePlay::updateCapabilities() parses these via split(',').
+    // Rates above the target's make LMS downsample instead of the open
+    // failing here
+    uint32_t maxRate = static_cast<uint32_t>(m_config.maxSampleRate);
+    const uint32_t targetRate = m_targetMaxRate.load(std::memory_order_relaxed);
+    if (targetRate > 0) maxRate = std::min(maxRate, targetRate);
+    caps << ",MaxSampleRate=" << maxRate;
     caps << ",Model=slim2diretta";
     caps << ",ModelName=slim2diretta";
     caps << ",AccuratePlayPoints=1";
@@ -613,3 +877,11 @@ uint32_t SlimprotoClient::getJiffies() const {
     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime);
     return static_cast<uint32_t>(elapsed.count());
 }
+
+std::chrono::steady_clock::time_point SlimprotoClient::jiffiesToTime(uint32_t jiffies) const {
+    // Relative to now: jiffies wrap after 49 days
+    auto now = std::chrono::steady_clock::now();
+    auto nowJiffies = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_startTime).count());
+    return now + std::chrono::milliseconds(static_cast<int32_t>(jiffies - nowJiffies));
+}
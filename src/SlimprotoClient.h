@@ -12,6 +12,7 @@
 #define SLIM2DIRETTA_SLIMPROTO_CLIENT_H
 
 #include "SlimprotoMessages.h"
+#include "SlimprotoQueue.h"
 #include "Config.h"
 
 #include <string>
@@ -20,6 +21,11 @@
 #include <mutex>
 #include <cstdint>
 #include <chrono>
+#include <memory>
+#include <vector>
+#include <pthread.h>
+
+class UringReceiver;
 
 class SlimprotoClient {
 public:
@@ -47,10 +53,11 @@ public:
     void onStream(StreamCallback cb) { m_streamCb = std::move(cb); }
     void onVolume(VolumeCallback cb) { m_volumeCb = std::move(cb); }
 
-    // Send status to server (thread-safe)
+    // Send status to server (thread-safe, never blocks: queued for the
+    // Slimproto thread, which writes it to the socket)
     void sendStat(const char eventCode[4], uint32_t serverTimestamp = 0);
 
-    // Send HTTP response headers back to server
+    // Send HTTP response headers back to server (queued like sendStat)
     void sendResp(const std::string& headers);
 
     // Update state for STAT messages (called from audio thread)
@@ -59,14 +66,29 @@ public:
     void updateBufferState(uint32_t streamBufSize, uint32_t streamBufFull,
                            uint32_t outputBufSize, uint32_t outputBufFull);
 
+    // Highest PCM rate the Diretta target accepts (0 = unknown or not a
+    // limit); HELO advertises it, capped by --max-rate
+    void setTargetMaxRate(uint32_t rate) { m_targetMaxRate.store(rate, std::memory_order_relaxed); }
+
+    // Send HELO again if the capabilities changed since the last one
+    // (target probed, codec library missing), flagged as a reconnect so
+    // LMS keeps the current stream
+    void refreshCapabilities();
+
+    // Local time of a jiffies value (sync starts come in our jiffies)
+    std::chrono::steady_clock::time_point jiffiesToTime(uint32_t jiffies) const;
+
     // Get the server IP used for the control connection
     const std::string& getServerIp() const { return m_serverIp; }
 
+    // Receive-side cost since connect (syscalls/s, receive thread CPU) to stdout
+    void dumpStats() const;
+
 private:
     int m_socket = -1;
     std::atomic<bool> m_running{false};
     std::atomic<bool> m_connected{false};
-    std::mutex m_sendMutex;  // Protects socket writes
+    std::mutex m_sendMutex;  // Serializes queue flushes (socket writes)
     std::string m_serverIp;
 
     Config m_config;
@@ -84,13 +106,53 @@ private:
     std::atomic<uint32_t> m_streamBufFull{0};
     std::atomic<uint32_t> m_outputBufSize{0};
     std::atomic<uint32_t> m_outputBufFull{0};
-    uint32_t m_serverTimestamp = 0;
+
+    // Outbound: frames queued by any thread, written out by run()'s thread
+    SlimprotoQueue m_txQueue;
+    std::vector<uint8_t> m_txBuf;           // Frames gathered for one send()
+    int m_wakeFd = -1;                      // eventfd: frames queued for run()
+    std::atomic<bool> m_heartbeatPending{false};
+    std::atomic<uint32_t> m_serverTimestamp{0};
+    std::atomic<uint64_t> m_txFrames{0};
+    std::atomic<uint64_t> m_txWrites{0};
+    std::atomic<uint64_t> m_heartbeatsCoalesced{0};
+    std::atomic<uint64_t> m_txOverflow{0};   // Queue full: held in the overflow list
+    uint64_t m_txOverflowLogged = 0;        // Last count warned about (flusher only)
+
+    // Frames that found the queue full or exceed a slot (RESP with long
+    // headers), encoded back to back in order. The caller only appends
+    // under the mutex; the flushing thread swaps the list out and writes it
+    // after every frame queued before it. Both preallocated.
+    std::mutex m_overflowMutex;
+    std::vector<uint8_t> m_overflow;        // Guarded by m_overflowMutex
+    std::vector<uint8_t> m_overflowOut;     // Being written (under m_sendMutex)
+    size_t m_overflowFrames = 0;            // Frames in m_overflow
+    size_t m_overflowOutFrames = 0;         // Frames in m_overflowOut
+    std::atomic<bool> m_overflowPending{false};
+
+    // Inbound: received bytes not dispatched yet (at most a partial frame
+    // between reads)
+    std::vector<uint8_t> m_rxBuf;
+    size_t m_rxLen = 0;
 
     // Startup time for jiffies calculation
     std::chrono::steady_clock::time_point m_startTime;
 
+    // Receive engine: io_uring when enabled, set up by run() on its thread
+    std::unique_ptr<UringReceiver> m_uring;
+    std::atomic<bool> m_uringActive{false};
+    std::chrono::steady_clock::time_point m_connectTime;
+    std::atomic<uint64_t> m_rxSyscalls{0};
+    pthread_t m_rxThread{};
+    std::atomic<bool> m_rxThreadRunning{false};
+
+    // Capabilities: what the last HELO advertised (guarded by m_capsMutex)
+    std::atomic<uint32_t> m_targetMaxRate{0};
+    std::mutex m_capsMutex;
+    std::string m_sentCaps;
+
     // Internal protocol methods
-    void sendHelo();
+    void sendHelo(bool reconnect = false);
     void sendBye();
     void sendSetd(uint8_t id, const std::string& data);
 
@@ -101,9 +163,15 @@ private:
     void handleSetd(const uint8_t* data, size_t len);
 
     // Socket I/O helpers
-    bool readExact(void* buf, size_t len);
+    bool fillBuffer();
+    void dispatchFrames();
     bool sendAll(const void* buf, size_t len);
     bool sendMessage(const char opcode[4], const void* payload, size_t payloadLen);
+    void flushOutbound();
+    bool flushLocked();
+    void wake();
+    void drainWake();
+    void buildStat(StatPayload& stat, const char eventCode[4], uint32_t serverTimestamp) const;
 
     // MAC address
     void generateMac();
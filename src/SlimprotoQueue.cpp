@@ -0,0 +1,68 @@
+/**
+ * @file SlimprotoQueue.cpp
+ * @brief Bounded MPMC ring of encoded Slimproto frames
+ */
+
+#include "SlimprotoQueue.h"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+
+static_assert((SlimprotoQueue::SLOT_COUNT & (SlimprotoQueue::SLOT_COUNT - 1)) == 0,
+              "SLOT_COUNT must be a power of two");
+
+SlimprotoQueue::SlimprotoQueue()
+    : m_slots(new Slot[SLOT_COUNT])
+{
+    // Slot i is free for the producer at position i
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        m_slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+size_t SlimprotoQueue::encode(uint8_t* dst, const char opcode[4], const void* payload,
+                              size_t payloadLen) {
+    uint32_t lenBE = htonl(static_cast<uint32_t>(payloadLen));
+    std::memcpy(dst, opcode, 4);
+    std::memcpy(dst + 4, &lenBE, 4);
+    if (payloadLen > 0 && payload) {
+        std::memcpy(dst + 8, payload, payloadLen);
+    }
+    return 8 + payloadLen;
+}
+
+bool SlimprotoQueue::push(const char opcode[4], const void* payload, size_t payloadLen) {
+    if (8 + payloadLen > SLOT_BYTES) return false;
+
+    uint64_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+        slot = &m_slots[pos & (SLOT_COUNT - 1)];
+        const uint64_t seq = slot->seq.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(seq - pos);
+        if (diff == 0) {
+            if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // Full: the consumer has not freed this slot yet
+        } else {
+            pos = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->len = encode(slot->frame, opcode, payload, payloadLen);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+size_t SlimprotoQueue::pop(uint8_t* dst) {
+    const uint64_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+    Slot& slot = m_slots[pos & (SLOT_COUNT - 1)];
+    if (slot.seq.load(std::memory_order_acquire) != pos + 1) return 0;
+
+    const size_t len = slot.len;
+    std::memcpy(dst, slot.frame, len);
+    slot.seq.store(pos + SLOT_COUNT, std::memory_order_release);
+    m_dequeuePos.store(pos + 1, std::memory_order_relaxed);
+    return len;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file SlimprotoQueue.h
+ * @brief Lock-free queue of outbound Slimproto frames
+ *
+ * The audio thread reports STAT events while it decodes; it must not wait
+ * for the LMS socket (a slow server or a full send buffer would stall it).
+ * Frames are encoded into preallocated fixed-size slots instead, and the
+ * Slimproto thread writes them out. Bounded MPMC ring with a sequence
+ * number per slot (Vyukov): producers never lock or allocate, a full queue
+ * fails the push.
+ *
+ * Any number of producers; pop() calls must be serialized by the caller.
+ */
+
+#ifndef SLIM2DIRETTA_SLIMPROTO_QUEUE_H
+#define SLIM2DIRETTA_SLIMPROTO_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class SlimprotoQueue {
+public:
+    static constexpr size_t SLOT_COUNT = 32;    // Power of two
+    /// Largest frame a slot holds (8-byte header included)
+    static constexpr size_t SLOT_BYTES = 2048;
+
+    SlimprotoQueue();
+
+    SlimprotoQueue(const SlimprotoQueue&) = delete;
+    SlimprotoQueue& operator=(const SlimprotoQueue&) = delete;
+
+    /**
+     * @brief Client -> server frame: [4 opcode][4 length BE][payload]
+     * @return Frame size (dst needs 8 + payloadLen bytes)
+     */
+    static size_t encode(uint8_t* dst, const char opcode[4], const void* payload,
+                         size_t payloadLen);
+
+    /// Queue one frame; false if the queue is full or the frame exceeds a slot
+    bool push(const char opcode[4], const void* payload, size_t payloadLen);
+
+    /**
+     * @brief Copy out the oldest frame
+     * @param dst At least SLOT_BYTES
+     * @return Frame size, 0 if empty
+     */
+    size_t pop(uint8_t* dst);
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> seq{0};
+        size_t len = 0;
+        uint8_t frame[SLOT_BYTES];
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    alignas(64) std::atomic<uint64_t> m_enqueuePos{0};
+    alignas(64) std::atomic<uint64_t> m_dequeuePos{0};
+};
+
+#endif // SLIM2DIRETTA_SLIMPROTO_QUEUE_H
@@ -0,0 +1,171 @@
+/**
+ * @file StreamSpool.cpp
+ * @brief Windowed mmap ring file for HTTP read-ahead
+ */
+
+#include "StreamSpool.h"
+#include "LogLevel.h"
+
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+StreamSpool::~StreamSpool() {
+    unmap(m_writeWin);
+    unmap(m_readWin);
+    if (m_fd >= 0) close(m_fd);
+}
+
+bool StreamSpool::open(const std::string& dir, size_t bytes) {
+    const size_t windows = std::max<size_t>(2, (bytes + WINDOW_BYTES - 1) / WINDOW_BYTES);
+    m_capacity = windows * WINDOW_BYTES;
+
+    // Anonymous file: nothing is left behind if the process dies
+    m_fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (m_fd < 0) {
+        std::string path = dir + "/slim2diretta-spool-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        m_fd = mkostemp(name.data(), O_CLOEXEC);
+        if (m_fd >= 0) unlink(name.data());
+    }
+    if (m_fd < 0) {
+        LOG_ERROR("[Spool] Cannot create a file in " << dir << ": " << strerror(errno));
+        return false;
+    }
+    if (ftruncate(m_fd, static_cast<off_t>(m_capacity)) != 0) {
+        LOG_ERROR("[Spool] Cannot size the spool file to " << (m_capacity >> 20) << " MB: "
+                  << strerror(errno));
+        close(m_fd);
+        m_fd = -1;
+        return false;
+    }
+    return true;
+}
+
+uint8_t* StreamSpool::map(Window& w, uint64_t offset) {
+    const uint64_t index = offset / WINDOW_BYTES;
+    if (w.index == index) return w.base;
+
+    unmap(w);
+    const off_t fileOffset = static_cast<off_t>((index * WINDOW_BYTES) % m_capacity);
+    void* p = mmap(nullptr, WINDOW_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, fileOffset);
+    if (p == MAP_FAILED) {
+        LOG_ERROR("[Spool] mmap failed: " << strerror(errno));
+        return nullptr;
+    }
+    w.base = static_cast<uint8_t*>(p);
+    w.index = index;
+    return w.base;
+}
+
+void StreamSpool::unmap(Window& w) {
+    if (w.base) munmap(w.base, WINDOW_BYTES);
+    w.base = nullptr;
+    w.index = UINT64_MAX;
+}
+
+uint8_t* StreamSpool::reserve(size_t& len, int timeoutMs) {
+    uint64_t pos;
+    size_t free;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto hasSpace = [this] { return m_cancelled || m_written - m_released < m_capacity; };
+        if (!m_spaceCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), hasSpace)) {
+            return nullptr;
+        }
+        if (m_cancelled) return nullptr;
+        pos = m_written;
+        free = static_cast<size_t>(m_capacity - (m_written - m_released));
+    }
+
+    uint8_t* base = map(m_writeWin, pos);
+    if (!base) {
+        cancel();
+        return nullptr;
+    }
+    const size_t inWindow = static_cast<size_t>(pos % WINDOW_BYTES);
+    len = std::min(free, WINDOW_BYTES - inWindow);
+    return base + inWindow;
+}
+
+void StreamSpool::commit(size_t len) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_written += len;
+    }
+    m_dataCv.notify_one();
+}
+
+void StreamSpool::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+    m_dataCv.notify_one();
+}
+
+void StreamSpool::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cancelled = true;
+    }
+    m_dataCv.notify_all();
+    m_spaceCv.notify_all();
+}
+
+ssize_t StreamSpool::read(const uint8_t*& data, size_t maxLen, int timeoutMs) {
+    uint64_t written;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        // The previous view is done with: its space goes back to the writer
+        if (m_released != m_readPos) {
+            m_released = m_readPos;
+            m_spaceCv.notify_one();
+        }
+        auto ready = [this] { return m_cancelled || m_finished || m_written > m_readPos; };
+        if (timeoutMs < 0) {
+            m_dataCv.wait(lock, ready);
+        } else if (!m_dataCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready)) {
+            return 0;
+        }
+        if (m_cancelled || m_written == m_readPos) return -1;
+        written = m_written;
+    }
+
+    uint8_t* base = map(m_readWin, m_readPos);
+    if (!base) return -1;
+    const size_t inWindow = static_cast<size_t>(m_readPos % WINDOW_BYTES);
+    const size_t n = static_cast<size_t>(std::min<uint64_t>(
+        { maxLen, written - m_readPos, WINDOW_BYTES - inWindow }));
+    data = base + inWindow;
+    m_readPos += n;
+    return static_cast<ssize_t>(n);
+}
+
+uint64_t StreamSpool::written() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_written;
+}
+
+uint64_t StreamSpool::consumed() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_released;
+}
+
+bool StreamSpool::finished() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_finished;
+}
+
+bool StreamSpool::cancelled() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cancelled;
+}
@@ -0,0 +1,106 @@
+/**
+ * @file StreamSpool.h
+ * @brief File-backed read-ahead between the HTTP stream and the decoder
+ *
+ * With --spool, each HTTP stream is fetched by its own thread into a ring
+ * file (unlinked, in --spool-dir: tmpfs or disk) as fast as the server
+ * sends, while the audio thread reads the decoder input back from it. A
+ * whole track can then be on the host long before it is played, without
+ * growing the RAM buffers.
+ *
+ * The file is never mapped as a whole: the writer and the reader each map
+ * the WINDOW_BYTES window they are in and move on window by window. With
+ * mlockall(MCL_FUTURE) every mapping is locked and populated, so only the
+ * two windows count against RAM; the rest is page cache (disk) or tmpfs.
+ *
+ * One writer thread (reserve/commit/finish) and one reader thread (read).
+ */
+
+#ifndef SLIM2DIRETTA_STREAM_SPOOL_H
+#define SLIM2DIRETTA_STREAM_SPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+
+class StreamSpool {
+public:
+    /// Mapping granularity (spool sizes are rounded up to a multiple)
+    static constexpr size_t WINDOW_BYTES = 4 << 20;
+
+    StreamSpool() = default;
+    ~StreamSpool();
+
+    StreamSpool(const StreamSpool&) = delete;
+    StreamSpool& operator=(const StreamSpool&) = delete;
+
+    /**
+     * @brief Create the ring file
+     * @param dir Directory for the (immediately unlinked) file
+     * @param bytes Ring size; at most this much is fetched ahead of the reader
+     */
+    bool open(const std::string& dir, size_t bytes);
+
+    // ---- Writer ----
+
+    /**
+     * @brief Contiguous free space at the write position
+     * @param len Set to the usable length (up to the end of the window)
+     * @return nullptr if the ring stayed full for timeoutMs, or after cancel()
+     */
+    uint8_t* reserve(size_t& len, int timeoutMs);
+
+    /// Publish len bytes written at the last reserve()
+    void commit(size_t len);
+
+    /// No more data (end of stream or error): the reader drains and ends
+    void finish();
+
+    // ---- Reader ----
+
+    /**
+     * @brief Next bytes, in place
+     * @param data Set to the bytes; valid until the next read()
+     * @return Byte count (<= maxLen, at most to the window end), 0 if none
+     *         arrived within timeoutMs, -1 once finished and drained or cancelled
+     */
+    ssize_t read(const uint8_t*& data, size_t maxLen, int timeoutMs);
+
+    /// Wake and stop both sides (reserve() and read() fail from now on)
+    void cancel();
+
+    uint64_t written() const;
+    uint64_t consumed() const;
+    size_t capacity() const { return m_capacity; }
+    bool finished() const;
+    bool cancelled() const;
+
+private:
+    struct Window {
+        uint8_t* base = nullptr;
+        uint64_t index = UINT64_MAX;    // Stream offset / WINDOW_BYTES
+    };
+
+    uint8_t* map(Window& w, uint64_t offset);
+    void unmap(Window& w);
+
+    int m_fd = -1;
+    size_t m_capacity = 0;
+    Window m_writeWin;
+    Window m_readWin;
+
+    // Stream offsets; guarded by m_mutex
+    mutable std::mutex m_mutex;
+    std::condition_variable m_dataCv;   // Reader waits for data
+    std::condition_variable m_spaceCv;  // Writer waits for space
+    uint64_t m_written = 0;
+    uint64_t m_released = 0;            // Reader is done with everything before
+    uint64_t m_readPos = 0;             // Reader-only
+    bool m_finished = false;
+    bool m_cancelled = false;
+};
+
+#endif // SLIM2DIRETTA_STREAM_SPOOL_H
@@ -0,0 +1,289 @@
+/**
+ * @file UringReceiver.cpp
+ * @brief io_uring multishot receive over a provided-buffer ring
+ */
+
+#include "UringReceiver.h"
+
+#ifdef ENABLE_IO_URING
+
+#include "LogLevel.h"
+
+#include <liburing.h>
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+constexpr unsigned RING_ENTRIES = 8;
+constexpr uint16_t BUFFER_GROUP = 1;
+constexpr uint64_t RECV_TAG = 1;
+constexpr uint64_t CANCEL_TAG = 2;
+constexpr uint64_t WATCH_TAG = 3;
+
+bool s_enabled = false;
+
+} // namespace
+
+UringReceiver::~UringReceiver() {
+    teardown();
+}
+
+bool UringReceiver::enable() {
+    // A real multishot recv on a socket pair: kernels before 6.0 accept the
+    // ring but fail the request
+    static const bool s_supported = [] {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) return false;
+        bool ok = false;
+        {
+            UringReceiver probe;
+            const uint8_t* data = nullptr;
+            ok = probe.start(sv[0]) && send(sv[1], "x", 1, MSG_NOSIGNAL) == 1 &&
+                 probe.wait(1000) == 1 && probe.next(data, 1) == 1 && probe.m_armed;
+            shutdown(sv[0], SHUT_RDWR);
+        }
+        close(sv[0]);
+        close(sv[1]);
+        return ok;
+    }();
+    s_enabled = s_supported;
+    return s_enabled;
+}
+
+bool UringReceiver::enabled() {
+    return s_enabled;
+}
+
+bool UringReceiver::start(int fd) {
+    teardown();
+
+    m_ring = new io_uring;
+    if (io_uring_queue_init(RING_ENTRIES, m_ring, 0) < 0) {
+        delete m_ring;
+        m_ring = nullptr;
+        return false;
+    }
+
+    int err = 0;
+    m_bufRing = io_uring_setup_buf_ring(m_ring, BUFFER_COUNT, BUFFER_GROUP, 0, &err);
+    if (!m_bufRing) {
+        teardown();
+        return false;
+    }
+    m_buffers.resize(BUFFER_COUNT * BUFFER_SIZE);
+    for (unsigned i = 0; i < BUFFER_COUNT; i++) {
+        io_uring_buf_ring_add(m_bufRing, m_buffers.data() + i * BUFFER_SIZE, BUFFER_SIZE,
+                              static_cast<unsigned short>(i),
+                              io_uring_buf_ring_mask(BUFFER_COUNT), static_cast<int>(i));
+    }
+    io_uring_buf_ring_advance(m_bufRing, BUFFER_COUNT);
+
+    m_fd = fd;
+    m_closed = false;
+    m_curBid = -1;
+    m_curPos = m_curLen = 0;
+    m_syscalls = 0;
+    if (!arm()) {
+        teardown();
+        return false;
+    }
+    return true;
+}
+
+bool UringReceiver::arm() {
+    io_uring_sqe* sqe = io_uring_get_sqe(m_ring);
+    if (!sqe) return false;
+    io_uring_prep_recv_multishot(sqe, m_fd, nullptr, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    io_uring_sqe_set_data64(sqe, RECV_TAG);
+
+    int r = io_uring_submit(m_ring);
+    m_syscalls++;
+    if (r < 0) {
+        errno = -r;
+        return false;
+    }
+    m_armed = true;
+    return true;
+}
+
+bool UringReceiver::watch(int fd) {
+    if (!m_ring) return false;
+    m_watchFd = fd;
+    m_watchFired = false;
+    return armWatch();
+}
+
+bool UringReceiver::armWatch() {
+    io_uring_sqe* sqe = io_uring_get_sqe(m_ring);
+    if (!sqe) return false;
+    io_uring_prep_poll_multishot(sqe, m_watchFd, POLLIN);
+    io_uring_sqe_set_data64(sqe, WATCH_TAG);
+
+    int r = io_uring_submit(m_ring);
+    m_syscalls++;
+    if (r < 0) {
+        errno = -r;
+        return false;
+    }
+    m_watchArmed = true;
+    return true;
+}
+
+bool UringReceiver::watchFired() {
+    const bool fired = m_watchFired;
+    m_watchFired = false;
+    return fired;
+}
+
+void UringReceiver::recycle(uint16_t bid) {
+    io_uring_buf_ring_add(m_bufRing, m_buffers.data() + static_cast<size_t>(bid) * BUFFER_SIZE,
+                          BUFFER_SIZE, bid, io_uring_buf_ring_mask(BUFFER_COUNT), 0);
+    io_uring_buf_ring_advance(m_bufRing, 1);
+}
+
+ssize_t UringReceiver::next(const uint8_t*& data, size_t maxLen) {
+    if (!m_ring) return FAILED;
+
+    // The last buffer goes back to the kernel once it has been handed out
+    if (m_curBid >= 0 && m_curPos == m_curLen) {
+        recycle(static_cast<uint16_t>(m_curBid));
+        m_curBid = -1;
+    }
+
+    while (m_curBid < 0) {
+        if (m_closed) return CLOSED;
+
+        io_uring_cqe* cqe = nullptr;
+        if (io_uring_peek_cqe(m_ring, &cqe) != 0) {
+            // Out of buffers earlier: the ones handed out since are back
+            if (!m_armed && !arm()) return FAILED;
+            return EMPTY;
+        }
+        const int res = cqe->res;
+        const unsigned flags = cqe->flags;
+        const uint64_t tag = io_uring_cqe_get_data64(cqe);
+        io_uring_cqe_seen(m_ring, cqe);
+        if (tag == WATCH_TAG) {
+            if (!(flags & IORING_CQE_F_MORE)) m_watchArmed = false;
+            m_watchFired = true;
+            continue;
+        }
+        if (tag != RECV_TAG) continue;
+
+        if (!(flags & IORING_CQE_F_MORE)) m_armed = false;
+        if (res > 0) {
+            m_curBid = static_cast<int>(flags >> IORING_CQE_BUFFER_SHIFT);
+            m_curPos = 0;
+            m_curLen = static_cast<size_t>(res);
+        } else if (res == 0) {
+            m_closed = true;
+        } else if (res != -ENOBUFS && res != -EINTR && res != -EAGAIN) {
+            errno = -res;
+            return FAILED;
+        }
+    }
+
+    const size_t n = std::min(maxLen, m_curLen - m_curPos);
+    data = m_buffers.data() + static_cast<size_t>(m_curBid) * BUFFER_SIZE + m_curPos;
+    m_curPos += n;
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t UringReceiver::read(uint8_t* buf, size_t maxLen) {
+    const uint8_t* data = nullptr;
+    ssize_t n = next(data, maxLen);
+    if (n > 0) std::memcpy(buf, data, static_cast<size_t>(n));
+    return n;
+}
+
+int UringReceiver::wait(int timeoutMs) {
+    if (!m_ring) return -1;
+    if ((m_curBid >= 0 && m_curPos < m_curLen) || m_closed) return 1;
+
+    io_uring_cqe* cqe = nullptr;
+    if (io_uring_peek_cqe(m_ring, &cqe) == 0) return 1;
+    if (!m_armed && !arm()) return -1;
+    if (m_watchFd >= 0 && !m_watchArmed && !armWatch()) return -1;
+
+    int r;
+    if (timeoutMs < 0) {
+        r = io_uring_wait_cqe(m_ring, &cqe);
+    } else {
+        __kernel_timespec ts{};
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        r = io_uring_wait_cqe_timeout(m_ring, &cqe, &ts);
+    }
+    m_syscalls++;
+    if (r == 0) return 1;
+    if (r == -ETIME || r == -EINTR) return 0;
+    errno = -r;
+    return -1;
+}
+
+void UringReceiver::teardown() {
+    if (!m_ring) return;
+
+    // The kernel may still fill a buffer until the receive is gone: cancel
+    // it and wait for its last completion before the buffers are freed
+    if (m_armed) {
+        if (io_uring_sqe* sqe = io_uring_get_sqe(m_ring)) {
+            io_uring_prep_cancel64(sqe, RECV_TAG, 0);
+            io_uring_sqe_set_data64(sqe, CANCEL_TAG);
+            io_uring_submit(m_ring);
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        while (m_armed && std::chrono::steady_clock::now() < deadline) {
+            io_uring_cqe* cqe = nullptr;
+            __kernel_timespec ts{};
+            ts.tv_nsec = 10000000;
+            if (io_uring_wait_cqe_timeout(m_ring, &cqe, &ts) != 0) continue;
+            if (io_uring_cqe_get_data64(cqe) == RECV_TAG && !(cqe->flags & IORING_CQE_F_MORE)) {
+                m_armed = false;
+            }
+            io_uring_cqe_seen(m_ring, cqe);
+        }
+        if (m_armed) {
+            LOG_WARN("[IO] io_uring receive did not cancel — keeping its buffers");
+            // Leak rather than free memory the kernel may still write to
+            new std::vector<uint8_t>(std::move(m_buffers));
+        }
+    }
+
+    if (m_bufRing) io_uring_free_buf_ring(m_ring, m_bufRing, BUFFER_COUNT, BUFFER_GROUP);
+    io_uring_queue_exit(m_ring);
+    delete m_ring;
+    m_ring = nullptr;
+    m_bufRing = nullptr;
+    m_buffers.clear();
+    m_armed = false;
+    m_fd = -1;
+    m_watchFd = -1;
+    m_watchArmed = false;
+}
+
+#else // !ENABLE_IO_URING
+
+// Built without liburing: the socket engine is the only one
+
+UringReceiver::~UringReceiver() = default;
+bool UringReceiver::enable() { return false; }
+bool UringReceiver::enabled() { return false; }
+bool UringReceiver::start(int) { return false; }
+bool UringReceiver::watch(int) { return false; }
+bool UringReceiver::watchFired() { return false; }
+ssize_t UringReceiver::next(const uint8_t*&, size_t) { return FAILED; }
+ssize_t UringReceiver::read(uint8_t*, size_t) { return FAILED; }
+int UringReceiver::wait(int) { return -1; }
+
+#endif // ENABLE_IO_URING
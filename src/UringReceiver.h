@@ -0,0 +1,116 @@
+/**
+ * @file UringReceiver.h
+ * @brief io_uring receive engine for the HTTP stream and Slimproto sockets
+ *
+ * Built with -DENABLE_IO_URING=ON (liburing). One multishot recv per
+ * socket draws from a ring of preallocated buffers registered with the
+ * kernel, so data lands in user memory while the thread is busy decoding.
+ * Completions are read from the shared completion queue without a
+ * syscall; the thread only enters the kernel to wait when the queue is
+ * empty, or to re-arm the receive after the buffers ran out.
+ *
+ * Without ENABLE_IO_URING the class is compiled as a stub whose enable()
+ * returns false, so callers need no #ifdefs.
+ *
+ * The ring belongs to the thread that reads: it is set up on the first
+ * read, not at connect time, because completions are delivered through
+ * the submitting thread.
+ */
+
+#ifndef SLIM2DIRETTA_URING_RECEIVER_H
+#define SLIM2DIRETTA_URING_RECEIVER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <vector>
+
+struct io_uring;
+struct io_uring_buf_ring;
+
+class UringReceiver {
+public:
+    /// Buffers per socket and their size (one completion fills at most one)
+    static constexpr unsigned BUFFER_COUNT = 4;
+    static constexpr size_t BUFFER_SIZE = 65536;
+
+    /// next() / read() results besides a byte count
+    static constexpr ssize_t CLOSED = 0;
+    static constexpr ssize_t FAILED = -1;
+    static constexpr ssize_t EMPTY = -2;
+
+    UringReceiver() = default;
+    ~UringReceiver();
+
+    UringReceiver(const UringReceiver&) = delete;
+    UringReceiver& operator=(const UringReceiver&) = delete;
+
+    /**
+     * @brief Check once that the kernel has multishot recv with provided
+     * buffer rings (Linux 6.0) and make this the engine for new sockets
+     * @return false if unsupported (the socket engine stays in use)
+     */
+    static bool enable();
+
+    /// True once enable() succeeded
+    static bool enabled();
+
+    /// Set up the ring and arm the receive (call from the reading thread)
+    bool start(int fd);
+
+    /// True after start() succeeded
+    bool started() const { return m_ring != nullptr; }
+
+    /**
+     * @brief Also end wait() when fd becomes readable (an eventfd another
+     * thread signals); next() skips these completions
+     */
+    bool watch(int fd);
+
+    /// True once per completion of the watched fd since the last call
+    bool watchFired();
+
+    /**
+     * @brief Next received bytes, in place
+     * @param data Set to the bytes; valid until the next next()/read()
+     * @return Byte count (<= maxLen), CLOSED, FAILED or EMPTY (nothing yet)
+     */
+    ssize_t next(const uint8_t*& data, size_t maxLen);
+
+    /// next() copied into buf
+    ssize_t read(uint8_t* buf, size_t maxLen);
+
+    /**
+     * @brief Wait for a completion
+     * @param timeoutMs -1 = no timeout
+     * @return 1 ready, 0 timeout/interrupted, -1 error
+     */
+    int wait(int timeoutMs);
+
+    /// Kernel entries (submit + wait) since start()
+    uint64_t syscalls() const { return m_syscalls; }
+
+private:
+    bool arm();
+    bool armWatch();
+    void recycle(uint16_t bid);
+    void teardown();
+
+    int m_fd = -1;
+    io_uring* m_ring = nullptr;
+    io_uring_buf_ring* m_bufRing = nullptr;
+    std::vector<uint8_t> m_buffers;     // BUFFER_COUNT × BUFFER_SIZE
+    bool m_armed = false;               // multishot recv still posting
+    int m_watchFd = -1;
+    bool m_watchArmed = false;          // multishot poll still posting
+    bool m_watchFired = false;
+    bool m_closed = false;
+    uint64_t m_syscalls = 0;
+
+    // Buffer being handed out: [m_curPos, m_curLen) of buffer m_curBid
+    int m_curBid = -1;
+    size_t m_curPos = 0;
+    size_t m_curLen = 0;
+};
+
+#endif // SLIM2DIRETTA_URING_RECEIVER_H
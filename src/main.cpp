@@ -9,8 +9,17 @@
 #include "Config.h"
 #include "SlimprotoClient.h"
 #include "HttpStreamClient.h"
+#include "UringReceiver.h"
 #include "Decoder.h"
+#include "DecoderPool.h"
+#include "DecoderBenchmark.h"
+#include "FlacDecoder.h"
+#include "SampleConverter.h"
+#include "MemoryBudget.h"
+#include "AllocCounter.h"
 #include "DsdStreamReader.h"
+#include "DsdToPcm.h"
+#include "Resampler.h"
 #include "DsdProcessor.h"
 #include "DirettaSync.h"
 #include "LogLevel.h"
@@ -182,6 +191,18 @@ void shutdownAsyncLogging() {
 std::atomic<bool> g_running{true};
 SlimprotoClient* g_slimproto = nullptr;  // For signal handler access
 DirettaSync* g_diretta = nullptr;        // For SIGUSR1 stats dump
+DecoderPool* g_decoderPool = nullptr;    // For SIGUSR1 stats dump
+MemoryBudget* g_memoryBudget = nullptr;  // For SIGUSR1 stats dump
+// C++ heap allocations made by the audio thread between a gapless chain
+// point and the next track's first push (AllocCounter)
+std::atomic<uint64_t> g_trackBoundaryAllocs{0};
+// Bytes relocated inside decoder output buffers, and the audio they carried
+// (finished streams). Stays at 0 once the buffers reach their working size.
+std::atomic<uint64_t> g_decoderBytesMoved{0};
+std::atomic<uint64_t> g_decodedAudioMs{0};
+// --resample: time spent in the resampler and the audio it produced
+std::atomic<uint64_t> g_resampleUs{0};
+std::atomic<uint64_t> g_resampledAudioMs{0};
 
 void signalHandler(int signal) {
     std::cout << "\nSignal " << signal << " received, shutting down..." << std::endl;
@@ -196,6 +217,31 @@ void statsSignalHandler(int /*signal*/) {
     if (g_diretta) {
         g_diretta->dumpStats();
     }
+    HttpStreamClient::dumpStats();
+    if (g_slimproto) {
+        g_slimproto->dumpStats();
+    }
+    if (g_decoderPool) {
+        std::cout << "[Decoder] Pool: " << g_decoderPool->getAllocations()
+                  << " created, " << g_decoderPool->getReuses() << " reused, "
+                  << g_trackBoundaryAllocs.load(std::memory_order_relaxed)
+                  << " track-boundary allocation(s)" << std::endl;
+        uint64_t moved = g_decoderBytesMoved.load(std::memory_order_relaxed);
+        uint64_t audioMs = g_decodedAudioMs.load(std::memory_order_relaxed);
+        std::cout << "[Decoder] Output buffer: " << moved << " bytes moved over "
+                  << audioMs / 1000 << "s of audio ("
+                  << (audioMs > 0 ? moved * 1000 / audioMs : 0) << " B/s)" << std::endl;
+    }
+    if (uint64_t resampledMs = g_resampledAudioMs.load(std::memory_order_relaxed)) {
+        uint64_t us = g_resampleUs.load(std::memory_order_relaxed);
+        uint64_t permille = us / resampledMs;
+        std::cout << "[Resample] " << resampledMs / 1000 << "s of audio in " << us / 1000
+                  << " ms (" << permille / 10 << "." << permille % 10
+                  << "% of one core)" << std::endl;
+    }
+    if (g_memoryBudget) {
+        g_memoryBudget->dumpStats();
+    }
 }
 
 // ============================================
@@ -342,10 +388,56 @@ Config parseArguments(int argc, char* argv[]) {
         }
         else if (arg == "--decoder" && i + 1 < argc) {
             config.decoderBackend = argv[++i];
-            if (config.decoderBackend != "native" && config.decoderBackend != "ffmpeg") {
-                std::cerr << "Invalid decoder backend. Use: native, ffmpeg" << std::endl;
+            if (config.decoderBackend != "native" && config.decoderBackend != "ffmpeg" &&
+                config.decoderBackend != "auto") {
+                std::cerr << "Invalid decoder backend. Use: native, ffmpeg, auto" << std::endl;
+                exit(1);
+            }
+        }
+        else if (arg == "--io-engine" && i + 1 < argc) {
+            config.ioEngine = argv[++i];
+            if (config.ioEngine != "auto" && config.ioEngine != "uring" &&
+                config.ioEngine != "socket") {
+                std::cerr << "Invalid I/O engine. Use: auto, uring, socket" << std::endl;
+                exit(1);
+            }
+        }
+        else if (arg == "--stall-timeout" && i + 1 < argc) {
+            config.stallTimeoutMs = std::atoi(argv[++i]);
+        }
+        else if (arg == "--stall-min-rate" && i + 1 < argc) {
+            config.stallMinRateKB = static_cast<unsigned int>(std::atoi(argv[++i]));
+        }
+        else if (arg == "--stall-retries" && i + 1 < argc) {
+            config.stallRetries = std::atoi(argv[++i]);
+        }
+        else if (arg == "--spool" && i + 1 < argc) {
+            int mb = std::atoi(argv[++i]);
+            if (mb < 0) {
+                std::cerr << "Invalid spool size (MB)" << std::endl;
                 exit(1);
             }
+            config.spoolMB = static_cast<unsigned int>(mb);
+        }
+        else if (arg == "--spool-dir" && i + 1 < argc) {
+            config.spoolDir = argv[++i];
+        }
+        else if (arg == "--pace" && i + 1 < argc) {
+            int margin = std::atoi(argv[++i]);
+            if (margin < 0) {
+                std::cerr << "Invalid pacing margin (%)" << std::endl;
+                exit(1);
+            }
+            config.paceMargin = static_cast<unsigned int>(margin);
+        }
+        else if (arg == "--stream-bind" && i + 1 < argc) {
+            config.streamBind = argv[++i];
+        }
+        else if (arg == "--control-bind" && i + 1 < argc) {
+            config.controlBind = argv[++i];
+        }
+        else if (arg == "--decoder-cache" && i + 1 < argc) {
+            config.decoderCacheFile = argv[++i];
         }
         else if (arg == "--cpu-audio" && i + 1 < argc) {
             config.cpuAudio = argv[++i];
@@ -419,6 +511,30 @@ Config parseArguments(int argc, char* argv[]) {
                 }
             }
         }
+        else if (arg == "--cpu-flac" && i + 1 < argc) {
+            config.cpuFlac = argv[++i];
+            std::string onlineDesc;
+            auto online = getOnlineCpus(&onlineDesc);
+            std::stringstream ss(config.cpuFlac);
+            std::string tok;
+            while (std::getline(ss, tok, ',')) {
+                try {
+                    int core = std::stoi(tok);
+                    if (core < 0 || online.find(core) == online.end()) {
+                        std::cerr << "Warning: --cpu-flac core " << core
+                                  << " not online (online CPUs: " << onlineDesc
+                                  << "), ignoring" << std::endl;
+                        config.cpuFlac.clear();
+                        break;
+                    }
+                } catch (const std::exception&) {
+                    std::cerr << "Warning: invalid --cpu-flac value '"
+                              << config.cpuFlac << "', ignoring" << std::endl;
+                    config.cpuFlac.clear();
+                    break;
+                }
+            }
+        }
         // Buffer configuration (v1.3.0)
         else if (arg == "--pcm-buffer-seconds" && i + 1 < argc) {
             config.pcmBufferSeconds = static_cast<float>(std::atof(argv[++i]));
@@ -432,6 +548,42 @@ Config parseArguments(int argc, char* argv[]) {
         else if (arg == "--dsd-prefill-ms" && i + 1 < argc) {
             config.dsdPrefillMs = std::atoi(argv[++i]);
         }
+        else if (arg == "--memory-budget" && i + 1 < argc) {
+            int mb = std::atoi(argv[++i]);
+            if (mb < 0) {
+                std::cerr << "Warning: invalid --memory-budget value, ignoring" << std::endl;
+                mb = 0;
+            }
+            config.memoryBudgetMB = static_cast<unsigned int>(mb);
+        }
+        else if (arg == "--flac-threads" && i + 1 < argc) {
+            int n = std::atoi(argv[++i]);
+            if (n < 0 || n > 16) {
+                std::cerr << "Warning: --flac-threads must be 0-16, ignoring" << std::endl;
+                n = 0;
+            }
+            config.flacThreads = static_cast<unsigned int>(n);
+        }
+        else if (arg == "--resample") {
+            config.resample = true;
+        }
+        else if (arg == "--resample-taps" && i + 1 < argc) {
+            int n = std::atoi(argv[++i]);
+            if (n < static_cast<int>(Resampler::MIN_TAPS) || n > static_cast<int>(Resampler::MAX_TAPS)) {
+                std::cerr << "Warning: --resample-taps must be " << Resampler::MIN_TAPS << "-"
+                          << Resampler::MAX_TAPS << ", using default" << std::endl;
+                n = 0;
+            }
+            config.resampleTaps = static_cast<unsigned int>(n);
+        }
+        else if (arg == "--output-latency" && i + 1 < argc) {
+            int ms = std::atoi(argv[++i]);
+            if (ms < 0) {
+                std::cerr << "Invalid output latency (ms)" << std::endl;
+                exit(1);
+            }
+            config.outputLatencyMs = static_cast<unsigned int>(ms);
+        }
         else if (arg == "--list-targets" || arg == "-l") {
             config.listTargets = true;
         }
@@ -474,17 +626,45 @@ Config parseArguments(int argc, char* argv[]) {
                       << "  --cpu-audio <core[,core...]>   Pin SDK worker + Diretta hot path to core(s)\n"
                       << "  --cpu-decode <core[,core...]>  Pin audio/decode thread (HTTP→decode→push) to core(s); also raises that thread to SCHED_FIFO\n"
                       << "  --cpu-other <core[,core...]>   Pin main + slimproto threads to core(s)\n"
+                      << "  --cpu-flac <core[,core...]>    Pin parallel FLAC decode workers to core(s) (see --flac-threads)\n"
                       << "\n"
                       << "Buffer configuration (0 = use defaults):\n"
                       << "  --pcm-buffer-seconds <s>       PCM buffer size in seconds (default 0.5)\n"
                       << "  --dsd-buffer-seconds <s>       DSD buffer size in seconds (default 0.8)\n"
                       << "  --pcm-prefill-ms <ms>          PCM prefill in ms (default 80)\n"
                       << "  --dsd-prefill-ms <ms>          DSD prefill in ms (default 200)\n"
+                      << "  --memory-budget <MB>           Cap ring + decode cache + DSD buffer, split per format (default: unlimited)\n"
                       << "\n"
                       << "Audio:\n"
                       << "  --max-rate <hz>        Max sample rate (default: 1536000)\n"
-                      << "  --no-dsd               Disable DSD support\n"
-                      << "  --decoder <backend>    Decoder backend: native (default), ffmpeg\n"
+                      << "  --no-dsd               Convert DSD to PCM instead of sending it natively\n"
+                      << "  --decoder <backend>    Decoder backend: native (default), ffmpeg, auto\n"
+                      << "                         (auto: fastest measured backend per codec)\n"
+                      << "  --decoder-cache <file> Where auto keeps its measurements (default: "
+                      << DecoderBenchmark::DEFAULT_CACHE_FILE << ", none = measure every start)\n"
+                      << "  --flac-threads <n>     Decode FLAC >= 352.8 kHz on n worker threads (default: 0 = serial)\n"
+                      << "  --resample             Resample PCM the target can't take (or above --max-rate)\n"
+                      << "                         to the highest rate it accepts\n"
+                      << "  --resample-taps <n>    Resampler filter length per phase (default: "
+                      << Resampler::DEFAULT_TAPS << ")\n"
+                      << "  --output-latency <ms>  Delay from the SDK to the DAC output, for elapsed time\n"
+                      << "                         and timed starts in LMS sync groups (default: 0)\n"
+                      << "\n"
+                      << "Network:\n"
+                      << "  --io-engine <engine>   HTTP/Slimproto receive: auto (default), uring, socket\n"
+                      << "                         (uring: io_uring multishot receive, if built with it)\n"
+                      << "  --stall-timeout <ms>   Resume a stalled/dropped stream with an HTTP Range request\n"
+                      << "                         after this long without data (default: 3000, 0 = off)\n"
+                      << "  --stall-min-rate <n>   Also resume when a starved stream stays below n KB/s\n"
+                      << "                         (default: 16, 0 = off)\n"
+                      << "  --stall-retries <n>    Reconnects per stall before the track ends (default: 3)\n"
+                      << "  --spool <MB>           Fetch each stream ahead into a spool file of this size\n"
+                      << "                         (default: 0 = off; whole tracks up to the size)\n"
+                      << "  --spool-dir <dir>      Directory for spool files, tmpfs or disk (default: /var/tmp)\n"
+                      << "  --pace <percent>       Pace stream reads at the decoder's rate + percent, with\n"
+                      << "                         socket buffers sized to it (default: 0 = read freely)\n"
+                      << "  --stream-bind <if|ip>  Interface or source address for the HTTP stream\n"
+                      << "  --control-bind <if|ip> Interface or source address for the Slimproto connection\n"
                       << "\n"
                       << "Logging:\n"
                       << "  -v, --verbose          Debug output (log level: DEBUG)\n"
@@ -547,6 +727,94 @@ static bool detectDoP(const int32_t* samples, size_t numFrames, int channels) {
     return matches >= static_cast<int>(check * 9 / 10);
 }
 
+// ============================================
+// Resampling Target
+// ============================================
+
+/**
+ * @brief Rate to send a PCM source at with --resample
+ *
+ * The source rate if the target takes it (and it is within --max-rate),
+ * else the highest lower rate of the same family (44.1/48 kHz multiples,
+ * an integer ratio), else the highest lower rate of the other family.
+ * Returns the source rate when nothing fits. Before the first open() the
+ * target's formats are unknown and only --max-rate applies.
+ */
+static uint32_t resampleTarget(DirettaSync& diretta, uint32_t rate, uint32_t channels,
+                               uint32_t maxRate) {
+    static constexpr uint32_t PCM_RATES[] = {
+        1536000, 1411200, 768000, 705600, 384000, 352800,
+        192000, 176400, 96000, 88200, 48000, 44100,
+    };
+    auto usable = [&](uint32_t r) {
+        return r <= maxRate && diretta.sinkSupportsPcm(r, channels);
+    };
+    if (usable(rate)) return rate;
+
+    const bool family44k = (rate % 11025) == 0;
+    for (bool sameFamily : { true, false }) {
+        for (uint32_t r : PCM_RATES) {
+            if (r >= rate || (((r % 11025) == 0) == family44k) != sameFamily) continue;
+            if (usable(r)) return r;
+        }
+    }
+    return rate;
+}
+
+// ============================================
+// Decode Cache Packing
+// ============================================
+
+/**
+ * @brief Bytes per sample the decode cache should hold for a sink format
+ *
+ * The cache can store samples in the sink's packed layout (S24_3LE or S16)
+ * when the decoded bit depth fits — the ring push is then a plain memcpy
+ * and the cache is 25-50% smaller. Otherwise it keeps S32 MSB-aligned.
+ */
+static int decodeCacheBytesPerSample(int sinkBytesPerSample, uint32_t sourceBits) {
+    if (sinkBytesPerSample == 3 && sourceBits <= 24) return 3;
+    if (sinkBytesPerSample == 2 && sourceBits <= 16) return 2;
+    return 4;
+}
+
+/**
+ * @brief Convert S32 MSB-aligned samples to the cache layout
+ * @param bytesPerSample 4 (copy), 3 (S24_3LE) or 2 (S16_LE)
+ */
+static void packSamples(const int32_t* src, size_t numSamples,
+                        uint8_t* dst, int bytesPerSample) {
+    if (bytesPerSample == 4) {
+        std::memcpy(dst, src, numSamples * sizeof(int32_t));
+        return;
+    }
+    const int skip = 4 - bytesPerSample;  // drop the low (padding) bytes
+    const uint8_t* in = reinterpret_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < numSamples; i++) {
+        std::memcpy(dst, in + skip, bytesPerSample);
+        dst += bytesPerSample;
+        in += 4;
+    }
+}
+
+/**
+ * @brief Re-layout cached samples between two cache formats
+ *
+ * Used when the sink (re)opens with frames already cached. Expanding to
+ * S32 puts the packed bytes back in the MSB positions. Safe in place when
+ * toBps < fromBps (each sample is read before it can be overwritten).
+ */
+static void repackSamples(const uint8_t* src, size_t numSamples, int fromBps,
+                          uint8_t* dst, int toBps) {
+    for (size_t i = 0; i < numSamples; i++) {
+        uint8_t s32[4] = {0, 0, 0, 0};
+        std::memcpy(s32 + (4 - fromBps), src, fromBps);
+        std::memcpy(dst, s32 + (4 - toBps), toBps);
+        src += fromBps;
+        dst += toBps;
+    }
+}
+
 // ============================================
 // Main
 // ============================================
@@ -591,7 +859,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Log decoder backend info
-    std::cout << "Codecs: FLAC PCM"
+    std::cout << "Codecs: FLAC PCM ALAC"
 #ifdef ENABLE_MP3
               << " MP3"
 #endif
@@ -604,12 +872,19 @@ int main(int argc, char* argv[]) {
 #ifdef ENABLE_FFMPEG
               << " [FFmpeg available]"
 #endif
-              << " DSD" << std::endl;
+              << " DSD"
+#ifdef ENABLE_DLOPEN_CODECS
+              << " (libraries loaded on first use)"
+#endif
+              << std::endl;
+    std::cout << "Sample conversion: " << SampleConverter::kernelName() << std::endl;
 
     Config config = parseArguments(argc, argv);
 
     if (config.decoderBackend == "ffmpeg") {
         std::cout << "Decoder: FFmpeg backend" << std::endl;
+    } else if (config.decoderBackend == "auto") {
+        std::cout << "Decoder: auto (fastest backend per codec)" << std::endl;
     }
 
     // Apply log level
@@ -684,7 +959,7 @@ int main(int argc, char* argv[]) {
     std::cout << "  Player:     " << config.playerName << std::endl;
     std::cout << "  Target:     #" << config.direttaTarget << std::endl;
     std::cout << "  Max Rate:   " << config.maxSampleRate << " Hz" << std::endl;
-    std::cout << "  DSD:        " << (config.dsdEnabled ? "enabled" : "disabled") << std::endl;
+    std::cout << "  DSD:        " << (config.dsdEnabled ? "native" : "converted to PCM") << std::endl;
     if (!config.macAddress.empty()) {
         std::cout << "  MAC:        " << config.macAddress << std::endl;
     }
@@ -743,6 +1018,7 @@ int main(int argc, char* argv[]) {
     }
     g_diretta = diretta.get();
     DirettaSync* direttaPtr = diretta.get();  // For lambda captures
+    direttaPtr->setOutputLatencyMs(config.outputLatencyMs);
 
     std::cout << "Diretta target #" << config.direttaTarget << " enabled" << std::endl;
 
@@ -766,6 +1042,32 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Receive engine for the HTTP stream and Slimproto sockets
+    if (config.ioEngine != "socket") {
+        if (UringReceiver::enable()) {
+            LOG_INFO("[IO] Receive engine: io_uring (multishot recv, "
+                     << UringReceiver::BUFFER_COUNT << " x "
+                     << UringReceiver::BUFFER_SIZE / 1024 << " KB buffers per socket)");
+        } else if (config.ioEngine == "uring") {
+            LOG_WARN("[IO] io_uring multishot receive not available (needs Linux 6.0 and a build"
+                     " with -DENABLE_IO_URING=ON) — using socket reads");
+        }
+    }
+
+    // Range reconnects for streams that stall or drop mid-track
+    HttpStreamClient::setStallRecovery(config.stallTimeoutMs, config.stallMinRateKB * 1024,
+                                       config.stallRetries);
+    HttpStreamClient::setBind(config.streamBind);
+    if (config.paceMargin > 0) {
+        HttpStreamClient::setPacing(config.paceMargin);
+        LOG_INFO("[HTTP] Ingest paced at the decoder's rate + " << config.paceMargin << "%");
+    }
+    if (config.spoolMB > 0) {
+        HttpStreamClient::setSpool(config.spoolDir, static_cast<size_t>(config.spoolMB) << 20);
+        LOG_INFO("[Spool] " << config.spoolMB << " MB read-ahead per stream in "
+                 << config.spoolDir);
+    }
+
     // Create Slimproto client and connect to LMS
     auto slimproto = std::make_unique<SlimprotoClient>();
     g_slimproto = slimproto.get();
@@ -776,6 +1078,39 @@ int main(int argc, char* argv[]) {
     std::atomic<bool> audioTestRunning{false};
     std::atomic<bool> audioThreadDone{true};  // true when no thread is running
 
+    // --decoder auto: pick the faster backend per codec before any decoding
+    if (config.decoderBackend == "auto") {
+        DecoderBenchmark::selectBackends(
+            config.decoderCacheFile.empty() ? DecoderBenchmark::DEFAULT_CACHE_FILE
+                                            : config.decoderCacheFile,
+            std::string(SLIM2DIRETTA_VERSION) + " " + __DATE__ + " " + __TIME__);
+    }
+
+    // Finished decoders are parked here and reused by the next track of the
+    // same codec (gapless album playback never rebuilds a decoder)
+    DecoderPool decoderPool;
+    g_decoderPool = &decoderPool;
+
+    // Frame-parallel FLAC for very high rates (native backend only)
+    if (config.flacThreads > 1) {
+        FlacDecoder::setParallelConfig(config.flacThreads, parseCoreList(config.cpuFlac));
+        LOG_INFO("[FLAC] Parallel decoding: " << config.flacThreads << " threads at >= "
+                 << FlacDecoder::PARALLEL_MIN_SAMPLE_RATE << " Hz"
+                 << (config.cpuFlac.empty() ? "" : ", cores " + config.cpuFlac));
+    }
+    if (config.resample) {
+        LOG_INFO("[Resample] Enabled for rates the target rejects: "
+                 << (config.resampleTaps ? config.resampleTaps : Resampler::DEFAULT_TAPS)
+                 << " taps per phase (" << Resampler::kernelName() << ")");
+    }
+
+    // One byte budget split across ring / decode cache / DSD buffer per format
+    MemoryBudget memoryBudget(static_cast<size_t>(config.memoryBudgetMB) << 20);
+    g_memoryBudget = &memoryBudget;
+    if (memoryBudget.isEnabled()) {
+        LOG_INFO("[Memory] Budget: " << config.memoryBudgetMB << " MB");
+    }
+
     // Idle release: release Diretta target after inactivity so other apps can use it
     constexpr int IDLE_RELEASE_TIMEOUT_S = 5;
     std::atomic<bool> direttaReleased{false};
@@ -794,6 +1129,10 @@ int main(int argc, char* argv[]) {
     };
     std::mutex pendingMutex;
     std::shared_ptr<PendingTrack> pendingNextTrack;
+    // Client of the last finished gapless track, reused for the next
+    // pre-connect. Parked after release(), so it keeps only its receive
+    // buffers: no socket, no spool file. Guarded by pendingMutex.
+    std::shared_ptr<HttpStreamClient> spareHttpClient;
     std::atomic<bool> hasPendingTrack{false};
 
     // Register stream callback
@@ -835,7 +1174,12 @@ int main(int argc, char* argv[]) {
                     LOG_INFO("[Gapless] Audio thread active, queuing next track");
 
                     // Pre-connect HTTP for the next track
-                    auto nextHttp = std::make_shared<HttpStreamClient>();
+                    std::shared_ptr<HttpStreamClient> nextHttp;
+                    {
+                        std::lock_guard<std::mutex> lock(pendingMutex);
+                        nextHttp = std::move(spareHttpClient);
+                    }
+                    if (!nextHttp) nextHttp = std::make_shared<HttpStreamClient>();
                     if (!nextHttp->connect(streamIp, streamPort, httpRequest)) {
                         LOG_ERROR("[Gapless] Failed to pre-connect next track");
                         slimproto->sendStat(StatEvent::STMn);
@@ -868,6 +1212,11 @@ int main(int argc, char* argv[]) {
                     direttaPtr->stopPlayback(true);
                 }
 
+                // No autostart (sync groups): play once buffered, at the
+                // strm-u that follows STMl
+                direttaPtr->holdStart(cmd.autostart == AUTOSTART_NONE ||
+                                      cmd.autostart == AUTOSTART_DIRECT);
+
                 // Join any previous audio thread
                 if (audioTestThread.joinable()) {
                     audioTestThread.join();
@@ -897,7 +1246,7 @@ int main(int argc, char* argv[]) {
                 char pcmEndian = cmd.pcmEndian;
                 audioTestRunning.store(true);
                 audioThreadDone.store(false, std::memory_order_release);
-                audioTestThread = std::thread([&httpStream, &slimproto, &audioTestRunning, &audioThreadDone, &hasPendingTrack, &pendingMutex, &pendingNextTrack, formatCode, pcmRate, pcmSize, pcmChannels, pcmEndian, direttaPtr, &config]() {
+                audioTestThread = std::thread([&httpStream, &slimproto, &audioTestRunning, &audioThreadDone, &hasPendingTrack, &pendingMutex, &pendingNextTrack, &spareHttpClient, &decoderPool, &memoryBudget, formatCode, pcmRate, pcmSize, pcmChannels, pcmEndian, direttaPtr, &config]() {
 
                     // Pin the audio/decode thread (HTTP→decode→push). Prefer
                     // --cpu-decode when set; otherwise fall back to --cpu-other
@@ -920,6 +1269,78 @@ int main(int argc, char* argv[]) {
 
                     bool openFailedInGapless = false;  // Track if open() failed during gapless chaining
 
+                    // HTTP data is fed to the decoder / DSD reader where it was
+                    // received (readView), up to this much per read
+                    constexpr size_t HTTP_READ_BYTES = 65536;
+
+                    // Buffer fullness for LMS's STAT messages, refreshed at
+                    // most every BUFFER_REPORT_MS: LMS times the next track's
+                    // stream and judges the player from it. As with
+                    // squeezelite, the stream buffer is undecoded input (spool
+                    // lead, or receive buffer + socket queue) and the output
+                    // buffer is decoded audio not played yet: the decoded
+                    // backlog (decode cache / DSD reader ring) plus the
+                    // DirettaSync ring, in sink-format bytes.
+                    constexpr int BUFFER_REPORT_MS = 100;
+                    auto lastBufferReport = std::chrono::steady_clock::time_point{};
+                    auto reportBuffers = [&](size_t backlogBytes, size_t backlogCapacity,
+                                             bool force = false) {
+                        auto now = std::chrono::steady_clock::now();
+                        if (!force &&
+                            now - lastBufferReport < std::chrono::milliseconds(BUFFER_REPORT_MS)) {
+                            return;
+                        }
+                        lastBufferReport = now;
+                        size_t inputSize = 0;
+                        const uint64_t input = httpStream->getInputBacklog(inputSize);
+                        size_t ringSize = 0;
+                        const size_t ringFull = direttaPtr->getBufferBytes(ringSize);
+                        auto field = [](uint64_t v) {
+                            return static_cast<uint32_t>(std::min<uint64_t>(v, UINT32_MAX));
+                        };
+                        slimproto->updateBufferState(field(inputSize), field(input),
+                                                     field(backlogCapacity + ringSize),
+                                                     field(backlogBytes + ringFull));
+                    };
+
+                    // Elapsed time and STMs follow the played position
+                    // (DirettaSync's consumer side), not what was pushed: the
+                    // ring runs seconds ahead of the DAC. A chained track's
+                    // STMs waits until its first sample is played.
+                    uint32_t stmsTrack = 0;     // Last track STMs was sent for
+                    auto reportPlayback = [&]() -> uint64_t {
+                        const auto pos = direttaPtr->getPlayPosition();
+                        if (pos.track < stmsTrack) return 0;   // Not audible yet
+                        slimproto->updateElapsed(static_cast<uint32_t>(pos.ms / 1000),
+                                                 static_cast<uint32_t>(pos.ms));
+                        for (; stmsTrack < pos.track; stmsTrack++) {
+                            slimproto->sendStat(StatEvent::STMs);
+                        }
+                        return pos.ms;
+                    };
+
+                    // End of the chain: the ring tail is still to be played.
+                    // Done once less than PLAYOUT_MARGIN_MS is left (stopping
+                    // then avoids the underrun), or once the position has not
+                    // moved for PLAYOUT_STALL_MS while not paused (the worker
+                    // holds back a last partial buffer). Reset
+                    // playoutLastBacklog before each wait.
+                    constexpr uint64_t PLAYOUT_MARGIN_MS = 50;
+                    constexpr int PLAYOUT_STALL_MS = 250;
+                    uint64_t playoutLastBacklog = UINT64_MAX;
+                    auto playoutLastMove = std::chrono::steady_clock::now();
+                    auto playedOut = [&]() {
+                        if (!direttaPtr->isPlaying()) return true;
+                        const uint64_t backlogMs = direttaPtr->getPlayPosition().backlogMs;
+                        auto now = std::chrono::steady_clock::now();
+                        if (backlogMs != playoutLastBacklog || direttaPtr->isPaused()) {
+                            playoutLastBacklog = backlogMs;
+                            playoutLastMove = now;
+                        }
+                        return backlogMs <= PLAYOUT_MARGIN_MS ||
+                               now - playoutLastMove >= std::chrono::milliseconds(PLAYOUT_STALL_MS);
+                    };
+
                     // ============================================================
                     // DSD PATH — separate from PCM/FLAC
                     // ============================================================
@@ -929,9 +1350,20 @@ int main(int argc, char* argv[]) {
                       char dsdPcmChannels = pcmChannels;
                       bool dsdFirstTrack = true;
                       AudioFormat prevDsdFmt{};
+                      // One reader for the whole chain: its ring is kept
+                      // across flush() for same-rate tracks
+                      auto dsdReader = std::make_unique<DsdStreamReader>();
+
+                      // --no-dsd, or a target without DSD: convert to 24-bit
+                      // PCM after the reader. Converted frames the ring had no
+                      // room for wait in pcmPending (interleaved S32).
+                      bool convertDsd = !config.dsdEnabled;
+                      std::unique_ptr<DsdToPcm> dsdToPcm;
+                      std::vector<int32_t> pcmPending;
+                      size_t pcmPendingPos = 0;
 
                       while (true) {  // === DSD CHAINING LOOP ===
-                        auto dsdReader = std::make_unique<DsdStreamReader>();
+                        dsdReader->flush();
 
                         // Set raw DSD format hint from strm params (fallback for raw DSD)
                         uint32_t hintRate = sampleRateFromCode(dsdPcmRate);
@@ -941,21 +1373,24 @@ int main(int argc, char* argv[]) {
                             dsdReader->setRawDsdFormat(hintRate, hintCh);
                         }
 
-                        slimproto->sendStat(StatEvent::STMs);
-
-                        if (!dsdFirstTrack) {
-                            slimproto->updateElapsed(0, 0);
+                        const uint32_t track = direttaPtr->markTrackStart();
+                        if (dsdFirstTrack) {
+                            stmsTrack = track;
+                            slimproto->sendStat(StatEvent::STMs);
+                        } else {
+                            // STMs and the elapsed reset come from reportPlayback()
                             slimproto->updateStreamBytes(0);
                         }
 
-                        uint8_t httpBuf[65536];
                         uint64_t totalBytes = 0;
                         bool formatLogged = false;
                         uint64_t lastElapsedLog = 0;
 
-                        // Planar buffer: readPlanar() fills this, sendAudio() consumes it directly.
-                        // No intermediate cache — each readPlanar output is a self-contained
-                        // planar chunk that must be sent as-is to preserve [L...][R...] structure.
+                        // DSF block groups go from the reader's ring straight to
+                        // sendDsdBlocks(). DFF/raw DSD is byte-interleaved and is
+                        // de-interleaved into this planar buffer by readPlanar();
+                        // each output is a self-contained planar chunk that must be
+                        // sent as-is to preserve [L...][R...] structure.
                         //
                         // CRITICAL: Keep this small! pushDSDPlanarOptimized computes the R channel
                         // offset from the pushed size, not the input size. If the ring buffer
@@ -973,6 +1408,67 @@ int main(int argc, char* argv[]) {
                         uint32_t dsdBitRate = 0;
                         uint64_t byteRateTotal = 0;
 
+                        // Convert the next DSD chunk and push it as PCM; DSD bytes
+                        // consumed (all channels)
+                        auto pushConverted = [&]() -> size_t {
+                            size_t consumed = 0;
+                            if (pcmPendingPos == pcmPending.size()) {
+                                const uint8_t* data = planarBuf;
+                                size_t stride = 0;
+                                size_t perChannel = 0;
+                                DsdStreamReader::BlockView view;
+                                if (dsdReader->hasBlockLayout()) {
+                                    if (dsdReader->peekBlocks(view) == 0) return 0;
+                                    data = view.data;
+                                    stride = view.channelStride;
+                                    perChannel = view.bytesPerChannel;
+                                } else {
+                                    size_t bytes = dsdReader->readPlanar(planarBuf, DSD_PLANAR_BUF);
+                                    if (bytes == 0) return 0;
+                                    perChannel = stride = bytes / detectedChannels;
+                                }
+                                pcmPending.resize(dsdToPcm->maxFrames(perChannel) * detectedChannels);
+                                size_t frames = dsdToPcm->process(data, stride, perChannel,
+                                                                  pcmPending.data());
+                                if (dsdReader->hasBlockLayout()) dsdReader->consumeBlocks(perChannel);
+                                pcmPending.resize(frames * detectedChannels);
+                                pcmPendingPos = 0;
+                                consumed = perChannel * detectedChannels;
+                            }
+                            size_t samples = pcmPending.size() - pcmPendingPos;
+                            if (samples > 0) {
+                                size_t written = direttaPtr->sendAudio(
+                                    reinterpret_cast<const uint8_t*>(pcmPending.data() + pcmPendingPos),
+                                    samples / detectedChannels);
+                                pcmPendingPos += written / sizeof(int32_t);
+                            }
+                            return consumed;
+                        };
+
+                        // Push the next DSD chunk to DirettaSync; bytes pushed (all channels)
+                        auto pushDsd = [&]() -> size_t {
+                            if (dsdToPcm) return pushConverted();
+                            if (dsdReader->hasBlockLayout()) {
+                                DsdStreamReader::BlockView view;
+                                if (dsdReader->peekBlocks(view) == 0) return 0;
+                                size_t perChannel = direttaPtr->sendDsdBlocks(
+                                    view.data, view.channelStride, view.bytesPerChannel);
+                                dsdReader->consumeBlocks(perChannel);
+                                return perChannel * detectedChannels;
+                            }
+                            size_t bytes = dsdReader->readPlanar(planarBuf, DSD_PLANAR_BUF);
+                            if (bytes > 0) {
+                                size_t numSamples = (bytes * 8) / detectedChannels;
+                                direttaPtr->sendAudio(planarBuf, numSamples);
+                            }
+                            return bytes;
+                        };
+
+                        // DSD not yet in the ring, raw or converted
+                        auto dsdBacklog = [&]() -> size_t {
+                            return dsdReader->availableBytes() +
+                                   (pcmPending.size() - pcmPendingPos) * sizeof(int32_t);
+                        };
 
                         bool httpEof = false;
                         bool stmdSent = false;  // Gapless: send STMd once on EOF
@@ -981,22 +1477,23 @@ int main(int argc, char* argv[]) {
                         constexpr int GAPLESS_WAIT_MS = 2000;
 
                         while (audioTestRunning.load(std::memory_order_acquire) &&
-                               (!httpEof || dsdReader->availableBytes() > 0 ||
+                               (!httpEof || dsdBacklog() > 0 ||
                                 !dsdReader->isFinished() ||
                                 (stmdSent && !gaplessWaitDone))) {
 
                             // === PHASE 1: HTTP read + feed ===
-                            // Flow control: don't read HTTP when internal buffer is large
-                            constexpr size_t DSD_BUF_MAX = 1048576;  // 1MB max
+                            // Flow control: read HTTP only when the reader's ring has room
+                            // for a full read (feed() then takes all of it)
                             bool gotData = false;
-                            if (!httpEof && dsdReader->availableBytes() < DSD_BUF_MAX) {
+                            if (!httpEof && dsdReader->freeBytes() >= HTTP_READ_BYTES) {
                                 if (httpStream->isConnected()) {
-                                    ssize_t n = httpStream->readWithTimeout(httpBuf, sizeof(httpBuf), 2);
+                                    const uint8_t* httpData = nullptr;
+                                    ssize_t n = httpStream->readView(httpData, HTTP_READ_BYTES, 2);
                                     if (n > 0) {
                                         gotData = true;
                                         totalBytes += n;
                                         slimproto->updateStreamBytes(totalBytes);
-                                        dsdReader->feed(httpBuf, static_cast<size_t>(n));
+                                        dsdReader->feed(httpData, static_cast<size_t>(n));
                                     } else if (n < 0 || !httpStream->isConnected()) {
                                         httpEof = true;
                                         dsdReader->setEof();
@@ -1013,26 +1510,31 @@ int main(int argc, char* argv[]) {
                             if (httpEof && direttaOpened && !stmdSent) {
                                 stmdSent = true;
                                 gaplessWaitStart = std::chrono::steady_clock::now();
+                                playoutLastBacklog = UINT64_MAX;
                                 LOG_INFO("[Audio] DSD stream complete: " << totalBytes
                                          << " bytes received, "
                                          << pushedDsdBytes << " DSD bytes pushed");
+                                // LMS reads STMd with an empty stream buffer
+                                reportBuffers(dsdReader->availableBytes(),
+                                              dsdReader->capacity(), true);
                                 slimproto->sendStat(StatEvent::STMd);
                             }
 
                             // === GAPLESS: stay in loop waiting for next track ===
                             // Keep the loop alive so ring buffer doesn't run empty.
                             // When pending arrives, we break and chain immediately.
-                            if (stmdSent && dsdReader->availableBytes() == 0) {
+                            if (stmdSent && dsdBacklog() == 0) {
                                 if (hasPendingTrack.load(std::memory_order_acquire)) {
                                     LOG_INFO("[Gapless] DSD pending detected, breaking to chain");
                                     break;  // Got pending → exit loop to chain
                                 }
+                                reportPlayback();
                                 auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                                     std::chrono::steady_clock::now() - gaplessWaitStart).count();
-                                if (elapsed >= GAPLESS_WAIT_MS) {
+                                if (elapsed >= GAPLESS_WAIT_MS && playedOut()) {
                                     gaplessWaitDone = true;
                                     LOG_INFO("[Gapless] DSD wait timeout (" << GAPLESS_WAIT_MS << "ms), no pending track");
-                                    break;  // Timeout → exit loop normally
+                                    break;  // Timeout and ring played out → exit loop normally
                                 }
                                 std::this_thread::sleep_for(std::chrono::milliseconds(5));
                                 continue;  // Stay in loop
@@ -1053,6 +1555,45 @@ int main(int argc, char* argv[]) {
                                 audioFmt.dsdFormat = (fmt.container == DsdFormat::Container::DFF)
                                     ? AudioFormat::DSDFormat::DFF
                                     : AudioFormat::DSDFormat::DSF;
+
+                                if (!convertDsd && !direttaPtr->sinkSupportsDsd()) {
+                                    LOG_WARN("[Audio] Diretta target has no DSD support, converting DSD to PCM");
+                                    convertDsd = true;
+                                }
+
+                                BudgetRequest budgetReq;
+                                budgetReq.codecClass = CodecClass::Dsd;
+                                budgetReq.ringBytesPerSecond = byteRateTotal;
+                                budgetReq.inputBytesPerSecond = byteRateTotal;
+                                budgetReq.ringSeconds = (config.dsdBufferSeconds > 0.0f)
+                                    ? config.dsdBufferSeconds
+                                    : DirettaBuffer::DSD_BUFFER_SECONDS;
+
+                                if (convertDsd) {
+                                    uint32_t outRate = DsdToPcm::outputRate(
+                                        dsdBitRate, static_cast<uint32_t>(config.maxSampleRate));
+                                    if (!dsdToPcm) dsdToPcm = std::make_unique<DsdToPcm>();
+                                    // Same format as the previous track: keep the
+                                    // filter history (gapless)
+                                    if (!dsdToPcm->matches(dsdBitRate, detectedChannels,
+                                                           fmt.isLSBFirst, outRate) &&
+                                        !dsdToPcm->configure(dsdBitRate, detectedChannels,
+                                                             fmt.isLSBFirst, outRate)) {
+                                        slimproto->sendStat(StatEvent::STMn);
+                                        audioThreadDone.store(true, std::memory_order_release);
+                                        return;
+                                    }
+                                    audioFmt = AudioFormat(outRate, DsdToPcm::OUTPUT_BIT_DEPTH,
+                                                           detectedChannels);
+                                    budgetReq.ringBytesPerSecond = static_cast<uint64_t>(outRate) *
+                                        detectedChannels * (DsdToPcm::OUTPUT_BIT_DEPTH / 8);
+                                    budgetReq.ringSeconds = (config.pcmBufferSeconds > 0.0f)
+                                        ? config.pcmBufferSeconds
+                                        : DirettaBuffer::pcmBufferSeconds(outRate);
+                                }
+                                BudgetSplit split = memoryBudget.plan(budgetReq);
+                                dsdReader->setBufferCapacity(split.dsdBufferBytes);
+                                direttaPtr->setRingByteLimit(split.ringBytes);
                             }
 
                             // === PHASE 3: Prebuffer (wait for enough raw data) ===
@@ -1067,38 +1608,51 @@ int main(int argc, char* argv[]) {
                                     continue;
                                 }
 
+                                // Time-based: the reader's ring is sized in seconds
+                                // (1 s built-in), so every DSD rate gets the full
+                                // prebuffer. Only a tight memory budget caps it.
                                 size_t targetBytes = static_cast<size_t>(byteRateTotal * PREBUFFER_MS / 1000);
-                                // Cap to achievable level: high DSD rates (DSD256/512)
-                                // need more than DSD_BUF_MAX for 500ms, but flow control
-                                // prevents the internal buffer from growing beyond DSD_BUF_MAX.
-                                if (targetBytes > DSD_BUF_MAX * 3 / 4) {
-                                    targetBytes = DSD_BUF_MAX * 3 / 4;
+                                if (targetBytes > dsdReader->capacity() * 3 / 4) {
+                                    targetBytes = dsdReader->capacity() * 3 / 4;
                                 }
 
                                 if (dsdReader->availableBytes() >= targetBytes || httpEof) {
                                     if (dsdReader->availableBytes() == 0) continue;
 
                                     if (!direttaPtr->open(audioFmt)) {
+                                        // The first open() is when the target reports
+                                        // its formats: retry as PCM if DSD is missing
+                                        if (!convertDsd && !direttaPtr->sinkSupportsDsd()) {
+                                            LOG_WARN("[Audio] Diretta target has no DSD support, converting DSD to PCM");
+                                            convertDsd = true;
+                                            formatLogged = false;  // redo PHASE 2 for PCM
+                                            continue;
+                                        }
                                         LOG_ERROR("[Audio] Failed to open Diretta for DSD");
                                         slimproto->sendStat(StatEvent::STMn);
                                         audioThreadDone.store(true, std::memory_order_release);
                                         return;
                                     }
 
+                                    if (convertDsd) {
+                                        // open() resets the hint; converted samples
+                                        // are MSB-aligned like the decoders'
+                                        direttaPtr->setS24PackModeHint(
+                                            DirettaRingBuffer::S24PackMode::MsbAligned);
+                                    }
+
                                     uint32_t prebufMs = byteRateTotal > 0
                                         ? static_cast<uint32_t>(dsdReader->availableBytes() * 1000 / byteRateTotal) : 0;
                                     LOG_INFO("[Audio] DSD pre-buffered "
                                              << dsdReader->availableBytes()
                                              << " bytes (" << prebufMs << "ms)");
 
-                                    // Flush prebuffer: readPlanar → sendAudio directly
+                                    // Flush prebuffer into the ring
                                     // Respect ring buffer capacity to avoid partial pushes
                                     while (audioTestRunning.load(std::memory_order_relaxed)) {
                                         if (direttaPtr->getBufferLevel() > 0.90f) break;
-                                        size_t bytes = dsdReader->readPlanar(planarBuf, DSD_PLANAR_BUF);
+                                        size_t bytes = pushDsd();
                                         if (bytes == 0) break;
-                                        size_t numSamples = (bytes * 8) / detectedChannels;
-                                        direttaPtr->sendAudio(planarBuf, numSamples);
                                         pushedDsdBytes += bytes;
                                     }
                                     direttaOpened = true;
@@ -1107,17 +1661,12 @@ int main(int argc, char* argv[]) {
                                 continue;
                             }
 
-                            // === PHASE 4: Push DSD — readPlanar directly to sendAudio ===
-                            if (direttaOpened && dsdReader->availableBytes() > 0) {
+                            // === PHASE 4: Push DSD — reader straight to the ring ===
+                            if (direttaOpened && dsdBacklog() > 0) {
                                 if (direttaPtr->isPaused()) {
                                     std::this_thread::sleep_for(std::chrono::milliseconds(100));
                                 } else if (direttaPtr->getBufferLevel() <= 0.95f) {
-                                    size_t bytes = dsdReader->readPlanar(planarBuf, DSD_PLANAR_BUF);
-                                    if (bytes > 0) {
-                                        size_t numSamples = (bytes * 8) / detectedChannels;
-                                        direttaPtr->sendAudio(planarBuf, numSamples);
-                                        pushedDsdBytes += bytes;
-                                    }
+                                    pushedDsdBytes += pushDsd();
                                 } else {
                                     std::this_thread::sleep_for(std::chrono::milliseconds(1));
                                 }
@@ -1125,11 +1674,10 @@ int main(int argc, char* argv[]) {
 
                             // === PHASE 5: Update elapsed time ===
                             if (direttaOpened && byteRateTotal > 0) {
-                                uint64_t totalMs = (pushedDsdBytes * 1000) / byteRateTotal;
-                                uint32_t elapsedSec = static_cast<uint32_t>(totalMs / 1000);
-                                uint32_t elapsedMs = static_cast<uint32_t>(totalMs);
-                                slimproto->updateElapsed(elapsedSec, elapsedMs);
+                                uint32_t elapsedSec = static_cast<uint32_t>(reportPlayback() / 1000);
+                                reportBuffers(dsdReader->availableBytes(), dsdReader->capacity());
 
+                                if (elapsedSec < lastElapsedLog) lastElapsedLog = 0;  // Next track audible
                                 if (elapsedSec >= lastElapsedLog + 10) {
                                     lastElapsedLog = elapsedSec;
                                     LOG_DEBUG("[Audio] DSD elapsed: " << elapsedSec << "s"
@@ -1139,7 +1687,7 @@ int main(int argc, char* argv[]) {
                             }
 
                             // === PHASE 6: Anti-busy-loop ===
-                            if (!gotData && dsdReader->availableBytes() == 0 && !httpEof) {
+                            if (!gotData && dsdBacklog() == 0 && !httpEof) {
                                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
                             }
 
@@ -1163,7 +1711,11 @@ int main(int argc, char* argv[]) {
                             }
                             if (next && next->formatCode == FORMAT_DSD) {
                                 LOG_INFO("[Gapless] Chaining to next DSD track");
-                                httpStream->disconnect();
+                                httpStream->release();
+                                {
+                                    std::lock_guard<std::mutex> lock(pendingMutex);
+                                    spareHttpClient = httpStream;
+                                }
                                 httpStream = next->httpClient;
                                 dsdPcmRate = next->pcmSampleRate;
                                 dsdPcmChannels = next->pcmChannels;
@@ -1181,6 +1733,7 @@ int main(int argc, char* argv[]) {
                       // Only send STMu (track ended) on natural end, not on forced stop
                       // Sending STMu after strm-q confuses Roon into thinking the
                       // new seek stream has ended, causing it to skip to the next track
+                      slimproto->updateBufferState(0, 0, 0, 0);
                       if (audioTestRunning.load(std::memory_order_acquire)) {
                           slimproto->sendStat(StatEvent::STMu);
                       }
@@ -1204,24 +1757,270 @@ int main(int argc, char* argv[]) {
                     // tracks so the ring buffer stays fed during transitions.
                     // When DirettaSync buffer is full (flow control), we still read
                     // HTTP and decode into this cache.
-                    // Max ~3s at 1536kHz stereo = 9216K samples
-                    constexpr size_t DECODE_CACHE_MAX_SAMPLES = 9216000;
-                    std::vector<int32_t> decodeCache;
-                    size_t decodeCachePos = 0;
+                    // Max ~3s at 1536kHz stereo S32 (~37 MB), or the
+                    // memory budget's share once the format is known
+                    size_t decodeCacheMaxBytes = MemoryBudget::DEFAULT_DECODE_CACHE_BYTES;
+                    // Byte buffer: holds S32 until the sink is open, then the
+                    // sink's packed layout when the source bit depth allows
+                    // (see decodeCacheBytesPerSample)
+                    std::vector<uint8_t> decodeCache;
+                    size_t decodeCachePos = 0;       // bytes
+                    int cacheBps = 4;                // bytes per cached sample
                     bool direttaOpened = false;
                     AudioFormat audioFmt{};
                     int detectedChannels = 2;
 
+                    // --resample: decoded frames are converted before the
+                    // cache when the target can't take the source rate. Kept
+                    // across gapless tracks of the same source format.
+                    std::unique_ptr<Resampler> resampler;
+                    std::vector<int32_t> resampleBuf;
+                    std::chrono::steady_clock::duration resampleTime{};
+                    uint64_t resampledFrames = 0;
+
+                    auto cacheFrameBytes = [&]() -> size_t {
+                        return static_cast<size_t>(cacheBps) * std::max(detectedChannels, 1);
+                    };
                     // Helper: available frames in decode cache
                     auto cacheFrames = [&]() -> size_t {
-                        return (decodeCache.size() - decodeCachePos) /
-                               std::max(detectedChannels, 1);
+                        return (decodeCache.size() - decodeCachePos) / cacheFrameBytes();
+                    };
+                    auto cacheData = [&]() -> const uint8_t* {
+                        return decodeCache.data() + decodeCachePos;
+                    };
+
+                    // Decode scratch buffers live outside the chaining loop so a
+                    // gapless track change doesn't touch them at all. Sized for
+                    // 7.1 (FLAC and ALAC go up to 8 channels); wider streams
+                    // get fewer frames per batch (see decodeIntoCache)
+                    constexpr size_t MAX_DECODE_FRAMES = 1024;
+                    constexpr size_t MAX_DECODE_CHANNELS = 8;
+                    int32_t decodeBuf[MAX_DECODE_FRAMES * MAX_DECODE_CHANNELS];
+                    uint8_t packBuf[sizeof(decodeBuf)];
+
+                    // Append decoded S32 frames to the cache in its layout
+                    auto appendToCache = [&](const int32_t* src, size_t frames) {
+                        size_t samples = frames * detectedChannels;
+                        if (cacheBps == 4) {
+                            const uint8_t* b = reinterpret_cast<const uint8_t*>(src);
+                            decodeCache.insert(decodeCache.end(), b,
+                                               b + samples * sizeof(int32_t));
+                            return;
+                        }
+                        packSamples(src, samples, packBuf, cacheBps);
+                        decodeCache.insert(decodeCache.end(), packBuf,
+                                           packBuf + samples * cacheBps);
+                    };
+
+                    // Read one batch from the decoder into the cache. When the
+                    // source's container layout is the cache layout (WAV/raw
+                    // S24_3LE into an S24 cache, S16 into S16, ...) the bytes go
+                    // straight in — no S32 widening here, no narrowing in
+                    // sendAudio(). AIFF only needs a byte swap.
+                    // Time spent inside the decoder for the current stream,
+                    // for the realtime factor in the stream stats
+                    std::chrono::steady_clock::duration decodeTime{};
+
+                    // Resample S32 frames into the cache (in pieces packBuf holds)
+                    auto appendResampled = [&](const int32_t* src, size_t frames) {
+                        const size_t ch = resampler->channels();
+                        auto start = std::chrono::steady_clock::now();
+                        resampleBuf.resize(resampler->maxOutputFrames(frames) * ch);
+                        size_t out = resampler->process(src, frames, resampleBuf.data());
+                        resampleTime += std::chrono::steady_clock::now() - start;
+                        resampledFrames += out;
+                        const size_t piece = MAX_DECODE_FRAMES * MAX_DECODE_CHANNELS / ch;
+                        for (size_t done = 0; done < out; ) {
+                            size_t n = std::min(out - done, piece);
+                            appendToCache(resampleBuf.data() + done * ch, n);
+                            done += n;
+                        }
+                    };
+
+                    auto decodeIntoCache = [&](Decoder& dec) -> size_t {
+                        // A new track in another format bypasses the previous
+                        // track's resampler until PHASE 2 drops it
+                        const bool resampling = resampler &&
+                            dec.getFormat().sampleRate == resampler->inputRate() &&
+                            dec.getFormat().channels == resampler->channels();
+                        if (!resampling && dec.getPassthroughBytesPerSample() == cacheBps) {
+                            size_t frameBytes = static_cast<size_t>(cacheBps) *
+                                                dec.getFormat().channels;
+                            size_t oldSize = decodeCache.size();
+                            decodeCache.resize(oldSize + MAX_DECODE_FRAMES * frameBytes);
+                            auto start = std::chrono::steady_clock::now();
+                            size_t frames = dec.readPassthrough(
+                                decodeCache.data() + oldSize, MAX_DECODE_FRAMES);
+                            decodeTime += std::chrono::steady_clock::now() - start;
+                            decodeCache.resize(oldSize + frames * frameBytes);
+                            return frames;
+                        }
+                        // readDecoded() writes frames x channels samples
+                        const size_t maxFrames = std::min(
+                            MAX_DECODE_FRAMES,
+                            MAX_DECODE_FRAMES * MAX_DECODE_CHANNELS /
+                                std::max<size_t>(dec.getFormat().channels, 1));
+                        auto start = std::chrono::steady_clock::now();
+                        size_t frames = dec.readDecoded(decodeBuf, maxFrames);
+                        decodeTime += std::chrono::steady_clock::now() - start;
+                        if (resampling) {
+                            appendResampled(decodeBuf, frames);
+                        } else {
+                            appendToCache(decodeBuf, frames);
+                        }
+                        return frames;
+                    };
+
+                    // Start resampling before the first open(): the frames
+                    // cached so far (S32, source rate) are converted too
+                    auto startResampler = [&](uint32_t inRate, uint32_t outRate) -> bool {
+                        if (!resampler) resampler = std::make_unique<Resampler>();
+                        unsigned taps = config.resampleTaps ? config.resampleTaps
+                                                            : Resampler::DEFAULT_TAPS;
+                        if (!resampler->configure(inRate, outRate, detectedChannels, taps)) {
+                            resampler.reset();
+                            return false;
+                        }
+                        size_t frames = cacheFrames();
+                        std::vector<uint8_t> converted(
+                            resampler->maxOutputFrames(frames) * detectedChannels * sizeof(int32_t));
+                        auto start = std::chrono::steady_clock::now();
+                        size_t out = resampler->process(
+                            reinterpret_cast<const int32_t*>(cacheData()), frames,
+                            reinterpret_cast<int32_t*>(converted.data()));
+                        resampleTime += std::chrono::steady_clock::now() - start;
+                        resampledFrames += out;
+                        converted.resize(out * detectedChannels * sizeof(int32_t));
+                        decodeCache.swap(converted);
+                        decodeCachePos = 0;
+                        audioFmt.sampleRate = outRate;
+                        return true;
+                    };
+
+                    // Add a finished stream's decoder stats (output-buffer
+                    // moves, realtime factor) to the log and SIGUSR1 totals
+                    auto recordDecoderStats = [&](const Decoder& dec) {
+                        auto decodeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                            decodeTime).count();
+                        decodeTime = {};
+
+                        // Resampler share of the decode core, in tenths of a percent
+                        if (resampler && resampledFrames > 0) {
+                            uint64_t resampleUs = static_cast<uint64_t>(
+                                std::chrono::duration_cast<std::chrono::microseconds>(
+                                    resampleTime).count());
+                            uint64_t resampledMs = resampledFrames * 1000 / resampler->outputRate();
+                            uint64_t permille = resampledMs > 0 ? resampleUs / resampledMs : 0;
+                            g_resampleUs.fetch_add(resampleUs, std::memory_order_relaxed);
+                            g_resampledAudioMs.fetch_add(resampledMs, std::memory_order_relaxed);
+                            LOG_INFO("[Resample] Stream stats: " << resampledMs / 1000 << "s at "
+                                     << resampler->outputRate() << " Hz in " << resampleUs / 1000
+                                     << " ms (" << permille / 10 << "." << permille % 10
+                                     << "% of one core)");
+                        }
+                        resampleTime = {};
+                        resampledFrames = 0;
+                        uint32_t rate = dec.getFormat().sampleRate;
+                        if (!dec.isFormatReady() || rate == 0) return;
+                        uint64_t moved = dec.getOutputBytesMoved();
+                        uint64_t audioMs = dec.getDecodedSamples() * 1000 / rate;
+                        g_decoderBytesMoved.fetch_add(moved, std::memory_order_relaxed);
+                        g_decodedAudioMs.fetch_add(audioMs, std::memory_order_relaxed);
+                        LOG_INFO("[Decoder] Stream stats: " << audioMs / 1000 << "s decoded in "
+                                 << decodeUs / 1000 << " ms (realtime factor "
+                                 << (decodeUs > 0 ? audioMs * 1000 / static_cast<uint64_t>(decodeUs) : 0)
+                                 << "x), output buffer moved " << moved << " bytes ("
+                                 << (audioMs > 0 ? moved * 1000 / audioMs : 0) << " B/s)");
+                    };
+
+                    // Switch the cache layout, converting frames already cached.
+                    // Packing runs in place (output never overtakes input);
+                    // only the rare expand back to S32 needs a second buffer.
+                    auto setCacheLayout = [&](int newBps) {
+                        if (newBps == cacheBps) return;
+                        size_t samples = (decodeCache.size() - decodeCachePos) / cacheBps;
+                        if (newBps < cacheBps) {
+                            repackSamples(cacheData(), samples, cacheBps,
+                                          decodeCache.data(), newBps);
+                            decodeCache.resize(samples * newBps);
+                        } else {
+                            std::vector<uint8_t> repacked(samples * newBps);
+                            repackSamples(cacheData(), samples, cacheBps,
+                                          repacked.data(), newBps);
+                            decodeCache.swap(repacked);
+                        }
+                        decodeCachePos = 0;
+                        cacheBps = newBps;
+                    };
+
+                    // Split the memory budget for the current format, in the
+                    // bytes the buffers actually hold: the ring stores
+                    // ringBytesPerSample (the sink format), the cache cacheBps.
+                    // The ring cap only takes effect when Phase 3 (re)opens.
+                    // Returns early when nothing changed since the last plan.
+                    // ringSized: the ring is already configured (after open),
+                    // so the cache gets at most what the ring leaves over.
+                    uint64_t plannedRingRate = 0, plannedCacheRate = 0;
+                    auto planBudget = [&](int ringBytesPerSample, bool ringSized) {
+                        const uint64_t frameRate = static_cast<uint64_t>(audioFmt.sampleRate) *
+                                                   audioFmt.channels;
+                        BudgetRequest budgetReq;
+                        budgetReq.codecClass = audioFmt.isCompressed
+                            ? CodecClass::Compressed : CodecClass::Uncompressed;
+                        budgetReq.ringBytesPerSecond = frameRate * ringBytesPerSample;
+                        budgetReq.inputBytesPerSecond = frameRate * cacheBps;
+                        if (budgetReq.ringBytesPerSecond == plannedRingRate &&
+                            budgetReq.inputBytesPerSecond == plannedCacheRate) {
+                            return;
+                        }
+                        plannedRingRate = budgetReq.ringBytesPerSecond;
+                        plannedCacheRate = budgetReq.inputBytesPerSecond;
+                        budgetReq.ringSeconds = (config.pcmBufferSeconds > 0.0f)
+                            ? config.pcmBufferSeconds
+                            : DirettaBuffer::pcmBufferSeconds(audioFmt.sampleRate);
+                        BudgetSplit split = memoryBudget.plan(budgetReq);
+                        size_t cacheBytes = split.decodeCacheBytes;
+                        if (ringSized && memoryBudget.isEnabled()) {
+                            size_t ringSize = 0;
+                            direttaPtr->getBufferBytes(ringSize);
+                            const size_t budget = memoryBudget.getBudgetBytes();
+                            cacheBytes = std::min(cacheBytes,
+                                                  budget > ringSize ? budget - ringSize : 0);
+                        }
+                        decodeCacheMaxBytes = std::max<size_t>(
+                            cacheBytes,
+                            MAX_DECODE_FRAMES * audioFmt.channels * sizeof(int32_t));
+                        direttaPtr->setRingByteLimit(split.ringBytes);
+                        if (memoryBudget.isEnabled() &&
+                            decodeCache.capacity() > 2 * decodeCacheMaxBytes) {
+                            // shrink_to_fit() keeps size(), which still spans
+                            // the consumed prefix: drop it first
+                            decodeCache.erase(decodeCache.begin(),
+                                              decodeCache.begin() + decodeCachePos);
+                            decodeCachePos = 0;
+                            decodeCache.shrink_to_fit();
+                        }
+                    };
+
+                    // Track boundary window: from the chain point until the
+                    // next track's first frames are pushed. Heap allocations
+                    // this thread makes in between are counted.
+                    bool boundaryOpen = false;
+                    size_t boundaryFrames = 0;  // Previous track's frames left at chain
+                    auto closeBoundary = [&]() {
+                        if (!boundaryOpen) return;
+                        boundaryOpen = false;
+                        g_trackBoundaryAllocs.fetch_add(AllocCounter::end(),
+                                                        std::memory_order_relaxed);
                     };
 
                     while (true) {  // === PCM/FLAC CHAINING LOOP ===
 
-                    // Create decoder for this format
-                    auto decoder = Decoder::create(curFormatCode, config.decoderBackend);
+                    // Get a decoder for this format (reused from the pool when
+                    // the previous track used the same codec)
+                    const char decoderFormatCode = curFormatCode;
+                    auto decoder = decoderPool.acquire(decoderFormatCode,
+                                                       config.decoderBackend);
                     if (!decoder) {
                         LOG_ERROR("[Audio] Unsupported format: " << curFormatCode);
                         slimproto->sendStat(StatEvent::STMn);
@@ -1244,17 +2043,15 @@ int main(int argc, char* argv[]) {
                         }
                     }
 
-                    slimproto->sendStat(StatEvent::STMs);  // Stream started
-
-                    if (!pcmFirstTrack) {
-                        slimproto->updateElapsed(0, 0);
+                    const uint32_t track = direttaPtr->markTrackStart();
+                    if (pcmFirstTrack) {
+                        stmsTrack = track;
+                        slimproto->sendStat(StatEvent::STMs);  // Stream started
+                    } else {
+                        // STMs and the elapsed reset come from reportPlayback()
                         slimproto->updateStreamBytes(0);
                     }
 
-                    uint8_t httpBuf[65536];
-                    constexpr size_t MAX_DECODE_FRAMES = 1024;
-
-                    int32_t decodeBuf[MAX_DECODE_FRAMES * 2];
                     uint64_t totalBytes = 0;
                     bool formatLogged = false;
                     uint64_t lastElapsedLog = 0;
@@ -1284,16 +2081,16 @@ int main(int argc, char* argv[]) {
                         // ========== PHASE 1a: HTTP read ==========
                         // Read HTTP data and feed to decoder when cache has space.
                         bool gotData = false;
-                        size_t cacheSamples = decodeCache.size() - decodeCachePos;
-                        if (cacheSamples < DECODE_CACHE_MAX_SAMPLES && !httpEof) {
+                        size_t cacheBytes = decodeCache.size() - decodeCachePos;
+                        if (cacheBytes < decodeCacheMaxBytes && !httpEof) {
                             if (httpStream->isConnected()) {
-                                ssize_t n = httpStream->readWithTimeout(
-                                    httpBuf, sizeof(httpBuf), 2);
+                                const uint8_t* httpData = nullptr;
+                                ssize_t n = httpStream->readView(httpData, HTTP_READ_BYTES, 2);
                                 if (n > 0) {
                                     gotData = true;
                                     totalBytes += n;
                                     slimproto->updateStreamBytes(totalBytes);
-                                    decoder->feed(httpBuf, static_cast<size_t>(n));
+                                    decoder->feed(httpData, static_cast<size_t>(n));
                                 } else if (n < 0 || !httpStream->isConnected()) {
                                     httpEof = true;
                                     decoder->setEof();
@@ -1319,6 +2116,9 @@ int main(int argc, char* argv[]) {
                                 LOG_INFO("[Audio] Stream ended (" << totalBytes
                                          << " bytes received)");
                             }
+                            // LMS reads STMd with an empty stream buffer
+                            reportBuffers(decodeCache.size() - decodeCachePos,
+                                          decodeCacheMaxBytes, true);
                             slimproto->sendStat(StatEvent::STMd);
                         }
 
@@ -1349,14 +2149,8 @@ int main(int argc, char* argv[]) {
                         // Always drain, even after httpEof — decoder may have
                         // buffered data from previous feed() calls.
                         if (decodeCache.size() - decodeCachePos <
-                            DECODE_CACHE_MAX_SAMPLES) {
-                            while (true) {
-                                size_t frames = decoder->readDecoded(
-                                    decodeBuf, MAX_DECODE_FRAMES);
-                                if (frames == 0) break;
-                                decodeCache.insert(decodeCache.end(), decodeBuf,
-                                    decodeBuf + frames * detectedChannels);
-                            }
+                            decodeCacheMaxBytes) {
+                            while (decodeIntoCache(*decoder) > 0) {}
                         }
 
                         // ========== PHASE 2: Format detection ==========
@@ -1369,8 +2163,11 @@ int main(int argc, char* argv[]) {
                             // Gapless continuation: DirettaSync already open
                             // from previous track via shared cache
                             if (direttaOpened && !pcmFirstTrack) {
+                                // Resampled: the sink runs at the output rate
+                                uint32_t prevSourceRate = resampler ? resampler->inputRate()
+                                                                    : audioFmt.sampleRate;
                                 bool sameFormat =
-                                    (fmt.sampleRate == audioFmt.sampleRate &&
+                                    (fmt.sampleRate == prevSourceRate &&
                                      fmt.channels == audioFmt.channels);
                                 if (sameFormat) {
                                     LOG_INFO("[Gapless] PCM same format, "
@@ -1399,26 +2196,32 @@ int main(int argc, char* argv[]) {
                                         size_t push = std::min(cacheFrames(),
                                                                MAX_DECODE_FRAMES);
                                         size_t written = direttaPtr->sendAudio(
-                                            reinterpret_cast<const uint8_t*>(
-                                                decodeCache.data() + decodeCachePos),
-                                            push);
-                                        size_t fw = written /
-                                            (sizeof(int32_t) * detectedChannels);
+                                            cacheData(), push);
+                                        size_t fw = written / cacheFrameBytes();
                                         if (fw == 0) continue;
-                                        decodeCachePos += fw * detectedChannels;
+                                        decodeCachePos += fw * cacheFrameBytes();
                                     }
                                     direttaOpened = false;
+                                    // Old sink layout no longer applies;
+                                    // cache S32 until Phase 3 reopens
+                                    setCacheLayout(4);
                                 }
                             }
 
                             detectedChannels = fmt.channels;
                             audioFmt.sampleRate = fmt.sampleRate;
+                            if (resampler && (resampler->inputRate() != fmt.sampleRate ||
+                                              resampler->channels() != fmt.channels)) {
+                                resampler.reset();
+                            }
+                            if (resampler) audioFmt.sampleRate = resampler->outputRate();
                             audioFmt.bitDepth = (fmt.bitDepth <= 24) ? 24 : 32;
                             audioFmt.channels = fmt.channels;
                             // Reset per track (audioFmt persists across gapless
                             // tracks); DoP detection in PHASE 3 re-sets it.
                             audioFmt.isDoP = false;
                             audioFmt.isCompressed = (curFormatCode == FORMAT_FLAC ||
+                                                     curFormatCode == FORMAT_ALAC ||
                                                      curFormatCode == FORMAT_MP3 ||
                                                      curFormatCode == FORMAT_OGG ||
                                                      curFormatCode == FORMAT_AAC);
@@ -1426,6 +2229,11 @@ int main(int argc, char* argv[]) {
                             if (fmt.sampleRate > DirettaBuffer::HIGHRATE_THRESHOLD) {
                                 prebufferMs = PREBUFFER_MS_HIGHRATE;
                             }
+
+                            // Still open: the sink layout is known. Otherwise
+                            // assume the widest (S32) until Phase 3 opens.
+                            planBudget(direttaOpened ? direttaPtr->getSinkBytesPerSample() : 4,
+                                       direttaOpened);
                         }
 
                         // ========== PHASE 3: Prebuffer phase ==========
@@ -1440,6 +2248,7 @@ int main(int argc, char* argv[]) {
                                 direttaPtr->setS24PackModeHint(
                                     DirettaRingBuffer::S24PackMode::MsbAligned);
                                 direttaOpened = true;
+                                planBudget(direttaPtr->getSinkBytesPerSample(), true);
                                 slimproto->sendStat(StatEvent::STMl);
                                 continue;
                             }
@@ -1447,15 +2256,20 @@ int main(int argc, char* argv[]) {
                             auto fmt = decoder->getFormat();
                             size_t targetFrames = static_cast<size_t>(
                                 fmt.sampleRate) * prebufferMs / 1000;
+                            // A small budgeted cache can't hold the full
+                            // prebuffer — reading stops once it's full
+                            targetFrames = std::min(targetFrames,
+                                decodeCacheMaxBytes * 3 / 4 / cacheFrameBytes());
                             if (cacheFrames() >= targetFrames || httpEof) {
                                 size_t prebufFrames = cacheFrames();
                                 if (prebufFrames == 0) continue;
 
                                 // Detect DoP (DSD over PCM) — Roon sends
                                 // DSD as DoP with format code 'p'
-                                if (!dopDetected && cacheFrames() >= 32) {
+                                if (!dopDetected && cacheBps == 4 &&
+                                    cacheFrames() >= 32) {
                                     const int32_t* samples =
-                                        decodeCache.data() + decodeCachePos;
+                                        reinterpret_cast<const int32_t*>(cacheData());
                                     // Debug: dump first 8 marker bytes
                                     {
                                         std::ostringstream oss;
@@ -1491,7 +2305,29 @@ int main(int argc, char* argv[]) {
                                     }
                                 }
 
+                                // --resample: convert when the target (or
+                                // --max-rate) can't take the source rate
+                                const uint32_t maxRate = static_cast<uint32_t>(config.maxSampleRate);
+                                if (config.resample && !audioFmt.isDoP && !resampler &&
+                                    cacheBps == 4) {
+                                    uint32_t outRate = resampleTarget(*direttaPtr, fmt.sampleRate,
+                                                                      detectedChannels, maxRate);
+                                    if (outRate != fmt.sampleRate &&
+                                        startResampler(fmt.sampleRate, outRate)) {
+                                        prebufFrames = cacheFrames();
+                                    }
+                                }
+
                                 if (!direttaPtr->open(audioFmt)) {
+                                    // The first open() is when the target reports
+                                    // its rates: retry resampled if it lacks this one
+                                    if (config.resample && !audioFmt.isDoP && !resampler &&
+                                        resampleTarget(*direttaPtr, fmt.sampleRate,
+                                                       detectedChannels, maxRate) != fmt.sampleRate) {
+                                        LOG_WARN("[Audio] Diretta target rejected " << fmt.sampleRate
+                                                 << " Hz, resampling");
+                                        continue;
+                                    }
                                     LOG_ERROR("[Audio] Failed to open Diretta output");
                                     slimproto->sendStat(StatEvent::STMn);
                                     direttaOpened = false;
@@ -1509,30 +2345,40 @@ int main(int argc, char* argv[]) {
                                 direttaPtr->setS24PackModeHint(
                                     DirettaRingBuffer::S24PackMode::MsbAligned);
 
+                                // From here on the cache holds the sink's packed
+                                // layout when the source bit depth fits, and the
+                                // ring takes it with a plain copy
+                                setCacheLayout(decodeCacheBytesPerSample(
+                                    direttaPtr->getSinkBytesPerSample(), fmt.bitDepth));
+                                direttaPtr->setInputPacked(cacheBps != 4);
+                                // Re-split now the sink and cache layouts are known
+                                planBudget(direttaPtr->getSinkBytesPerSample(), true);
+                                if (decoder->getPassthroughBytesPerSample() == cacheBps) {
+                                    LOG_INFO("[Audio] PCM passthrough: " << cacheBps * 8
+                                             << "-bit container samples copied as-is");
+                                }
+
                                 uint32_t prebufMs = static_cast<uint32_t>(
-                                    prebufFrames * 1000 / fmt.sampleRate);
+                                    prebufFrames * 1000 / audioFmt.sampleRate);
                                 LOG_INFO("[Audio] Pre-buffered " << prebufFrames
                                          << " frames (" << prebufMs << "ms)");
 
                                 // Flush prebuffer — stop when ring buffer is full
-                                const int32_t* ptr = decodeCache.data() + decodeCachePos;
+                                const uint8_t* ptr = cacheData();
                                 size_t remaining = prebufFrames;
                                 size_t actualPushed = 0;
                                 while (remaining > 0 &&
                                        audioTestRunning.load(std::memory_order_relaxed)) {
                                     if (direttaPtr->getBufferLevel() > 0.95f) break;
                                     size_t chunk = std::min(remaining, MAX_DECODE_FRAMES);
-                                    size_t written = direttaPtr->sendAudio(
-                                        reinterpret_cast<const uint8_t*>(ptr),
-                                        chunk);
-                                    size_t framesWritten = written /
-                                        (sizeof(int32_t) * detectedChannels);
+                                    size_t written = direttaPtr->sendAudio(ptr, chunk);
+                                    size_t framesWritten = written / cacheFrameBytes();
                                     if (framesWritten == 0) break;
-                                    ptr += framesWritten * detectedChannels;
+                                    ptr += framesWritten * cacheFrameBytes();
                                     remaining -= framesWritten;
                                     actualPushed += framesWritten;
                                 }
-                                decodeCachePos += actualPushed * detectedChannels;
+                                decodeCachePos += actualPushed * cacheFrameBytes();
                                 pushedFrames += actualPushed;
                                 direttaOpened = true;
                                 slimproto->sendStat(StatEvent::STMl);
@@ -1565,16 +2411,16 @@ int main(int argc, char* argv[]) {
                                     size_t push = std::min(cacheFrames(),
                                                            chunkSize);
                                     size_t written = direttaPtr->sendAudio(
-                                        reinterpret_cast<const uint8_t*>(
-                                            decodeCache.data() + decodeCachePos),
-                                        push);
-                                    size_t framesWritten = written /
-                                        (sizeof(int32_t) * detectedChannels);
+                                        cacheData(), push);
+                                    size_t framesWritten = written / cacheFrameBytes();
                                     if (framesWritten == 0) break;
-                                    decodeCachePos += framesWritten * detectedChannels;
+                                    decodeCachePos += framesWritten * cacheFrameBytes();
                                     pushedFrames += framesWritten;
                                     pushed += framesWritten;
                                 }
+                                if (boundaryOpen && pushedFrames > boundaryFrames) {
+                                    closeBoundary();
+                                }
                             } else {
                                 // Buffer full - sleep briefly, then loop back
                                 // to read more HTTP (keeps TCP pipeline flowing)
@@ -1586,13 +2432,13 @@ int main(int argc, char* argv[]) {
                         // ========== PHASE 5: Update elapsed time ==========
                         if (direttaOpened && decoder->isFormatReady()) {
                             auto fmt = decoder->getFormat();
-                            uint32_t elapsedRate = fmt.sampleRate;
+                            uint32_t elapsedRate = audioFmt.sampleRate;  // cache (sink) rate
                             if (elapsedRate > 0) {
-                                uint64_t totalMs = pushedFrames * 1000 / elapsedRate;
-                                uint32_t elapsedSec = static_cast<uint32_t>(totalMs / 1000);
-                                uint32_t elapsedMs = static_cast<uint32_t>(totalMs);
-                                slimproto->updateElapsed(elapsedSec, elapsedMs);
+                                uint32_t elapsedSec = static_cast<uint32_t>(reportPlayback() / 1000);
+                                reportBuffers(decodeCache.size() - decodeCachePos,
+                                              decodeCacheMaxBytes);
 
+                                if (elapsedSec < lastElapsedLog) lastElapsedLog = 0;  // Next track audible
                                 if (elapsedSec >= lastElapsedLog + 10) {
                                     lastElapsedLog = elapsedSec;
                                     uint32_t totalSec = fmt.totalSamples > 0
@@ -1611,7 +2457,7 @@ int main(int argc, char* argv[]) {
                         // Periodically remove consumed samples to prevent
                         // unbounded growth. Higher threshold = fewer compactions
                         // = fewer memory stalls (vector::erase is O(n))
-                        if (decodeCachePos > 500000) {
+                        if (decodeCachePos > 2000000) {
                             decodeCache.erase(decodeCache.begin(),
                                 decodeCache.begin() + decodeCachePos);
                             decodeCachePos = 0;
@@ -1634,10 +2480,7 @@ int main(int argc, char* argv[]) {
                     // Drain: decoder may have remaining frames after HTTP EOF
                     while (!decoder->isFinished() && !decoder->hasError() &&
                            audioTestRunning.load(std::memory_order_acquire)) {
-                        size_t frames = decoder->readDecoded(decodeBuf, MAX_DECODE_FRAMES);
-                        if (frames == 0) break;
-                        decodeCache.insert(decodeCache.end(), decodeBuf,
-                            decodeBuf + frames * detectedChannels);
+                        if (decodeIntoCache(*decoder) == 0) break;
                     }
 
                     // === GAPLESS: check if next track is already queued ===
@@ -1674,28 +2517,23 @@ int main(int argc, char* argv[]) {
                             }
                             size_t push = std::min(cacheFrames(), MAX_DECODE_FRAMES);
                             size_t written = direttaPtr->sendAudio(
-                                reinterpret_cast<const uint8_t*>(
-                                    decodeCache.data() + decodeCachePos),
-                                push);
-                            size_t framesWritten = written /
-                                (sizeof(int32_t) * detectedChannels);
+                                cacheData(), push);
+                            size_t framesWritten = written / cacheFrameBytes();
                             if (framesWritten == 0) {
                                 std::this_thread::sleep_for(
                                     std::chrono::milliseconds(5));
                                 continue;
                             }
-                            decodeCachePos += framesWritten * detectedChannels;
+                            decodeCachePos += framesWritten * cacheFrameBytes();
                             pushedFrames += framesWritten;
 
                             // Update elapsed during drain
                             if (decoder->isFormatReady()) {
-                                auto fmt = decoder->getFormat();
-                                uint32_t elapsedRate = fmt.sampleRate;
+                                uint32_t elapsedRate = audioFmt.sampleRate;  // cache (sink) rate
                                 if (elapsedRate > 0) {
-                                    uint64_t totalMs = pushedFrames * 1000 / elapsedRate;
-                                    uint32_t elapsedSec = static_cast<uint32_t>(totalMs / 1000);
-                                    uint32_t elapsedMs = static_cast<uint32_t>(totalMs);
-                                    slimproto->updateElapsed(elapsedSec, elapsedMs);
+                                    reportPlayback();
+                                    reportBuffers(decodeCache.size() - decodeCachePos,
+                                                  decodeCacheMaxBytes);
                                 }
                             }
                         }
@@ -1706,17 +2544,21 @@ int main(int argc, char* argv[]) {
                             LOG_DEBUG("[Gapless] PCM: waiting for next track...");
                             auto waitStart = std::chrono::steady_clock::now();
                             constexpr int GAPLESS_WAIT_MS = 2000;
+                            playoutLastBacklog = UINT64_MAX;
                             while (!hasPendingTrack.load(std::memory_order_acquire) &&
                                    audioTestRunning.load(std::memory_order_acquire) &&
-                                   std::chrono::duration_cast<std::chrono::milliseconds>(
-                                       std::chrono::steady_clock::now() - waitStart).count() < GAPLESS_WAIT_MS) {
+                                   (std::chrono::duration_cast<std::chrono::milliseconds>(
+                                        std::chrono::steady_clock::now() - waitStart).count() < GAPLESS_WAIT_MS ||
+                                    (direttaOpened && !playedOut()))) {
+                                reportPlayback();
                                 std::this_thread::sleep_for(std::chrono::milliseconds(5));
                             }
 
-                            // No next track arrived — stop playback gracefully
-                            // BEFORE the ring buffer drains and causes an underrun.
-                            // Roon interprets underruns as errors and won't start
-                            // the next track; a clean stop avoids this.
+                            // No next track arrived — the ring has played out;
+                            // stop playback gracefully BEFORE it runs dry and
+                            // causes an underrun. Roon interprets underruns as
+                            // errors and won't start the next track; a clean
+                            // stop avoids this.
                             if (!hasPendingTrack.load(std::memory_order_acquire) &&
                                 audioTestRunning.load(std::memory_order_acquire)) {
                                 LOG_INFO("[Gapless] No next track — stopping playback cleanly");
@@ -1740,8 +2582,20 @@ int main(int argc, char* argv[]) {
                             hasPendingTrack.store(false, std::memory_order_release);
                         }
                         if (next && next->formatCode != FORMAT_DSD) {
-                            LOG_INFO("[Gapless] Chaining to next PCM/FLAC track");
-                            httpStream->disconnect();
+                            LOG_INFO("[Gapless] Chaining to next PCM/FLAC track ("
+                                     << g_trackBoundaryAllocs.load(std::memory_order_relaxed)
+                                     << " track-boundary allocation(s) so far)");
+                            AllocCounter::begin();
+                            boundaryOpen = true;
+                            recordDecoderStats(*decoder);
+                            decoderPool.release(decoderFormatCode,
+                                                config.decoderBackend,
+                                                std::move(decoder));
+                            httpStream->release();
+                            {
+                                std::lock_guard<std::mutex> lock(pendingMutex);
+                                spareHttpClient = httpStream;
+                            }
                             httpStream = next->httpClient;
                             curFormatCode = next->formatCode;
                             curPcmRate = next->pcmSampleRate;
@@ -1756,14 +2610,20 @@ int main(int argc, char* argv[]) {
                                     decodeCache.begin() + decodeCachePos);
                                 decodeCachePos = 0;
                             }
+                            boundaryFrames = cacheFrames();
                             continue;  // Loop back for next PCM/FLAC track
                         }
                         // Cross-format (PCM→DSD): can't chain
                         LOG_INFO("[Gapless] Cross-format transition (PCM→DSD), ending chain");
                     }
 
+                    // Park the decoder for the next cold start (skip/seek)
+                    recordDecoderStats(*decoder);
+                    decoderPool.release(decoderFormatCode, config.decoderBackend,
+                                        std::move(decoder));
                     break;  // Exit PCM/FLAC chaining loop
                     }  // end PCM/FLAC chaining loop
+                    closeBoundary();
                     }  // end PCM/FLAC scope
 
                     // Only send STMu (track ended) on natural end, not on forced stop
@@ -1771,6 +2631,7 @@ int main(int argc, char* argv[]) {
                     // new seek stream has ended, causing it to skip to the next track
                     // Also skip STMu if open() failed during gapless (STMn already sent) —
                     // otherwise LMS sees STMn+STMu and skips to the next track prematurely
+                    slimproto->updateBufferState(0, 0, 0, 0);
                     if (audioTestRunning.load(std::memory_order_acquire) && !openFailedInGapless) {
                         slimproto->sendStat(StatEvent::STMu);
                     }
@@ -1797,16 +2658,35 @@ int main(int argc, char* argv[]) {
                 break;
 
             case STRM_PAUSE:
+                // With an interval: sync correction, play that much
+                // silence and carry on (no STMp)
+                if (cmd.getReplayGain() > 0) {
+                    direttaPtr->insertSilenceMs(cmd.getReplayGain());
+                    break;
+                }
                 LOG_INFO("Pause requested");
                 direttaPtr->pausePlayback();
                 slimproto->sendStat(StatEvent::STMp);
                 break;
 
-            case STRM_UNPAUSE:
-                LOG_INFO("Unpause requested");
+            case STRM_UNPAUSE: {
+                // Sync groups: start (or resume) at the given jiffies
+                const uint32_t jiffies = cmd.getReplayGain();
+                LOG_INFO("Unpause requested" << (jiffies ? " (timed)" : ""));
                 direttaPtr->resumePlayback();
+                if (jiffies != 0) {
+                    direttaPtr->startAt(slimproto->jiffiesToTime(jiffies));
+                } else if (direttaPtr->isStartHeld()) {
+                    direttaPtr->startAt(std::chrono::steady_clock::now());
+                }
                 slimproto->sendStat(StatEvent::STMr);
                 break;
+            }
+
+            case STRM_SKIP:
+                // Sync correction: drop that much buffered audio
+                direttaPtr->skipAheadMs(cmd.getReplayGain());
+                break;
 
             case STRM_FLUSH:
                 LOG_INFO("Flush requested");
@@ -1873,6 +2753,18 @@ int main(int argc, char* argv[]) {
     int backoffS = INITIAL_BACKOFF_S;
     int connectionCount = 0;
 
+    // HELO advertises the highest rate the target accepts once an SDK
+    // connection (boot warmup or first track) has probed it. With
+    // --resample, higher rates are converted here instead.
+    uint32_t sinkCapsGen = UINT32_MAX;
+    auto advertiseTarget = [&]() {
+        const uint32_t gen = direttaPtr->getSinkCapabilitiesGeneration();
+        if (gen == sinkCapsGen) return;
+        sinkCapsGen = gen;
+        const auto caps = direttaPtr->getSinkCapabilities();
+        slimproto->setTargetMaxRate(caps.known && !config.resample ? caps.maxPcmRate : 0);
+    };
+
     while (g_running.load(std::memory_order_acquire)) {
         // Wait before reconnection (skip on first attempt)
         if (connectionCount > 0) {
@@ -1882,6 +2774,7 @@ int main(int argc, char* argv[]) {
         }
 
         // Connect to LMS
+        advertiseTarget();
         if (!slimproto->connect(config.lmsServer, config.lmsPort, config)) {
             if (g_running.load(std::memory_order_acquire)) {
                 LOG_WARN("Failed to connect to LMS");
@@ -1916,6 +2809,10 @@ int main(int argc, char* argv[]) {
         while (g_running.load(std::memory_order_acquire) && slimproto->isConnected()) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
 
+            // Target probed, or a codec library failed to load: re-HELO
+            advertiseTarget();
+            slimproto->refreshCapabilities();
+
             // Auto-release Diretta target after idle timeout
             if (idleTimerActive.load(std::memory_order_acquire) &&
                 !direttaReleased.load(std::memory_order_acquire)) {
@@ -1948,6 +2845,8 @@ int main(int argc, char* argv[]) {
     std::cout << "\nShutting down..." << std::endl;
     stopAudioThread();
     g_slimproto = nullptr;
+    g_decoderPool = nullptr;
+    g_memoryBudget = nullptr;
     slimproto->disconnect();
 
     if (diretta->isOpen()) diretta->close();
@@ -0,0 +1,56 @@
+#!/bin/bash
+#
+# run-stall-tests.sh — run tools/stall-client against every fault scenario
+# of tools/stall-server.py.
+#
+# Usage:
+#   tools/run-stall-tests.sh [CLIENT] [CLIENT OPTIONS...]
+#
+# CLIENT defaults to build/stall-client (cmake -DBUILD_TOOLS=ON). Extra
+# options go to the client, e.g. --uring or --spool /dev/shm.
+#
+# Expected: every scenario prints OK. "norange" ends short by design (the
+# server cannot resume), so it only has to stop cleanly: it passes when
+# the client reports FAIL with fewer bytes and returns within the retries.
+#
+
+set -uo pipefail
+
+DIR="$(cd "$(dirname "$0")" && pwd)"
+CLIENT="${1:-build/stall-client}"
+shift || true
+PORT=18081
+FAILED=0
+
+run() {
+    local scenario="$1"; shift
+    python3 "$DIR/stall-server.py" --port "$PORT" "$scenario" > "/tmp/stall-server-$scenario.log" 2>&1 &
+    local server=$!
+    for _ in $(seq 50); do
+        grep -q serving "/tmp/stall-server-$scenario.log" 2>/dev/null && break
+        sleep 0.1
+    done
+    echo "== $scenario"
+    timeout 60 "$CLIENT" --port "$PORT" "$@" | grep -E "^(OK|FAIL)|HTTP\]"
+    local status=${PIPESTATUS[0]}
+    kill "$server" 2>/dev/null
+    wait "$server" 2>/dev/null
+    return "$status"
+}
+
+for scenario in clean drop reset stall trickle chunkdrop; do
+    run "$scenario" "$@" || FAILED=1
+done
+
+# Server without Range support: the stream ends short, but must end
+run norange "$@" && FAILED=1
+
+# strm-q while the reader waits out a stall
+run stall --disconnect-after 700 "$@" || FAILED=1
+
+if [ "$FAILED" -eq 0 ]; then
+    echo "All stall scenarios passed"
+else
+    echo "Some stall scenarios FAILED"
+fi
+exit "$FAILED"
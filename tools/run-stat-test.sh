@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# run-stat-test.sh — play one stream from tools/stall-server.py through
+# tools/stat-client, controlled by tools/slimproto-standin.py, and check
+# the STAT buffer fields the way LMS reads them.
+#
+# Usage:
+#   tools/run-stat-test.sh [CLIENT] [CLIENT OPTIONS...]
+#
+# CLIENT defaults to build/stat-client (cmake -DBUILD_TOOLS=ON). Extra
+# options go to the client, e.g. --spool /dev/shm.
+#
+# Expected: the stand-in prints OK (stream buffer empty from STMd on,
+# output buffer fed until STMu).
+#
+
+set -uo pipefail
+
+DIR="$(cd "$(dirname "$0")" && pwd)"
+CLIENT="${1:-build/stat-client}"
+shift || true
+STREAM_PORT=18081
+SLIM_PORT=13483
+
+# 4 s of 44.1 kHz/16/2
+python3 "$DIR/stall-server.py" --port "$STREAM_PORT" --size 705600 \
+    --payload /tmp/stat-payload.bin clean > /tmp/stat-server.log 2>&1 &
+server=$!
+python3 "$DIR/slimproto-standin.py" --port "$SLIM_PORT" --stream-port "$STREAM_PORT" \
+    > /tmp/stat-standin.log 2>&1 &
+standin=$!
+for _ in $(seq 50); do
+    grep -q serving /tmp/stat-server.log 2>/dev/null &&
+        grep -q listening /tmp/stat-standin.log 2>/dev/null && break
+    sleep 0.1
+done
+
+timeout 60 "$CLIENT" --port "$SLIM_PORT" "$@"
+wait "$standin"
+status=$?
+cat /tmp/stat-standin.log
+kill "$server" 2>/dev/null
+wait "$server" 2>/dev/null
+exit "$status"
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""LMS stand-in that checks the buffer fields of a player's STAT messages.
+
+Accepts one Slimproto player, starts one raw PCM stream from an HTTP
+server (tools/stall-server.py clean), sends strm-t heartbeats and reads
+the STATs back the way LMS does, as squeezelite fills them:
+
+    stream buffer  undecoded input the player holds
+    output buffer  decoded audio not played yet
+
+LMS takes STMd with an empty stream buffer as "the decoder has the whole
+track", and an empty output buffer while playing as an output underrun.
+The run fails if the player reports input after STMd, no input while
+downloading, or an empty output buffer between STMl and the end of the
+track. Used with tools/stat-client (cmake -DBUILD_TOOLS=ON), or with
+tools/run-stat-test.sh.
+
+Usage:
+    tools/slimproto-standin.py [--port 13483] [--stream-port 18081] [--timeout 30]
+"""
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+
+def frame(opcode, payload):
+    return struct.pack('>H', len(payload) + 4) + opcode + payload
+
+
+def strm(command, stream_port=0, request=b'', timestamp=0):
+    # strm: command, autostart '1', format 'p', 16-bit, 44.1 kHz, stereo, LE
+    body = bytearray(24)
+    body[0:7] = bytes([ord(command), ord('1'), ord('p'), ord('1'), ord('3'), ord('2'), ord('1')])
+    body[7] = 1                                    # threshold (KB)
+    body[14:18] = struct.pack('>I', timestamp)     # strm-t: server timestamp
+    body[18:20] = struct.pack('>H', stream_port)
+    body[20:24] = socket.inet_aton('127.0.0.1') if stream_port else bytes(4)
+    return frame(b'strm', bytes(body) + request)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--port', type=int, default=13483)
+    parser.add_argument('--stream-port', type=int, default=18081)
+    parser.add_argument('--timeout', type=float, default=30)
+    args = parser.parse_args()
+
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', args.port))
+    server.listen(1)
+    print('listening on port %d' % args.port, flush=True)
+    conn, _ = server.accept()
+    conn.settimeout(0.25)
+
+    start = time.time()
+    buf = b''
+    sent_strm = False
+    heartbeat = 0
+    next_heartbeat = 0.0
+    errors = []
+    seen = {}
+    input_seen = False
+    playing = False
+    drained_at = None
+
+    def log(text):
+        print('%6.2f %s' % (time.time() - start, text), flush=True)
+
+    while time.time() - start < args.timeout and 'STMu' not in seen:
+        try:
+            data = conn.recv(65536)
+            if not data:
+                break
+            buf += data
+        except socket.timeout:
+            pass
+        if sent_strm and time.time() >= next_heartbeat:
+            next_heartbeat = time.time() + 0.25
+            heartbeat += 1
+            conn.sendall(strm('t', timestamp=heartbeat))
+
+        while len(buf) >= 8:
+            opcode = buf[:4]
+            length = struct.unpack('>I', buf[4:8])[0]
+            if len(buf) < 8 + length:
+                break
+            payload, buf = buf[8:8 + length], buf[8 + length:]
+            if opcode == b'HELO' and not sent_strm:
+                log('HELO, starting the stream')
+                conn.sendall(strm('s', args.stream_port, b'GET /stream HTTP/1.0\r\n\r\n'))
+                sent_strm = True
+                continue
+            if opcode != b'STAT':
+                continue
+
+            event = payload[:4].decode(errors='replace')
+            stream_size, stream_full = struct.unpack('>II', payload[7:15])
+            received = struct.unpack('>Q', payload[15:23])[0]
+            output_size, output_full = struct.unpack('>II', payload[29:37])
+            if event != 'STMt' or stream_full or output_full:
+                log('%s stream %d/%d output %d/%d received %d' % (
+                    event, stream_full, stream_size, output_full, output_size, received))
+            if event != 'STMt':
+                seen.setdefault(event, time.time() - start)
+
+            if stream_full > stream_size or output_full > output_size:
+                errors.append('%s: fullness above size' % event)
+            if stream_full > 0:
+                input_seen = True
+            if event == 'STMl':
+                playing = True
+            if 'STMd' in seen and stream_full > 0:
+                errors.append('%s after STMd: %d bytes of input still reported' % (event, stream_full))
+            if event == 'STMd':
+                log('LMS: decoder has the whole track, next track would be sent now')
+            if playing and event == 'STMt' and output_full == 0 and drained_at is None:
+                drained_at = time.time() - start
+            if event == 'STMu' and drained_at is not None and drained_at < seen['STMu'] - 0.5:
+                errors.append('output buffer empty at %.2f s, %.2f s before STMu' % (
+                    drained_at, seen['STMu']))
+
+    for event in ('STMs', 'STMl', 'STMd', 'STMu'):
+        if event not in seen:
+            errors.append('no %s' % event)
+    if not input_seen:
+        errors.append('stream buffer never reported any input')
+
+    conn.close()
+    if errors:
+        for error in errors:
+            print('FAIL: ' + error)
+        sys.exit(1)
+    print('OK: stream buffer drained by STMd, output buffer fed until STMu')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,102 @@
+/**
+ * @file stall-client.cpp
+ * @brief Reads one stream through HttpStreamClient and checks it byte for byte
+ *
+ * Counterpart of tools/stall-server.py: fetches the payload the way the
+ * audio thread does (readView() with short timeouts, stall recovery on)
+ * and compares it with the payload file the server wrote. With
+ * --disconnect-after <ms>, another thread calls disconnect() mid-stream,
+ * as strm-q does, and the read loop must return promptly.
+ *
+ * Exit status: 0 = payload received intact (or stopped as asked), 1 = not.
+ */
+
+#include "HttpStreamClient.h"
+#include "UringReceiver.h"
+#include "LogLevel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+LogLevel g_logLevel = LogLevel::INFO;
+
+int main(int argc, char* argv[]) {
+    std::string host = "127.0.0.1";
+    uint16_t port = 18081;
+    std::string payloadPath = "/tmp/stall-payload.bin";
+    int disconnectAfterMs = -1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--payload" && i + 1 < argc) {
+            payloadPath = argv[++i];
+        } else if (arg == "--uring") {
+            if (!UringReceiver::enable()) std::fprintf(stderr, "io_uring unavailable\n");
+        } else if (arg == "--spool" && i + 1 < argc) {
+            HttpStreamClient::setSpool(argv[++i], 8 << 20);
+        } else if (arg == "--disconnect-after" && i + 1 < argc) {
+            disconnectAfterMs = std::atoi(argv[++i]);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--port N] [--payload FILE] [--uring] "
+                         "[--spool DIR] [--disconnect-after MS]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::ifstream file(payloadPath, std::ios::binary);
+    const std::vector<uint8_t> expected((std::istreambuf_iterator<char>(file)),
+                                        std::istreambuf_iterator<char>());
+
+    HttpStreamClient::setStallRecovery(1000, 16 * 1024, 3);
+    HttpStreamClient client;
+    const auto start = std::chrono::steady_clock::now();
+    if (!client.connect(host, port, "GET /stream HTTP/1.0\r\nHost: test\r\n\r\n")) {
+        std::printf("FAIL: connect\n");
+        return 1;
+    }
+
+    std::thread stopper;
+    if (disconnectAfterMs >= 0) {
+        stopper = std::thread([&client, disconnectAfterMs] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(disconnectAfterMs));
+            client.disconnect();
+        });
+    }
+
+    std::vector<uint8_t> received;
+    while (client.isConnected()) {
+        const uint8_t* data = nullptr;
+        ssize_t n = client.readView(data, 65536, 2);
+        if (n > 0) received.insert(received.end(), data, data + n);
+        if (n < 0) break;
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    if (stopper.joinable()) stopper.join();
+
+    bool ok;
+    if (disconnectAfterMs >= 0) {
+        // Stopped early: what arrived must still be a prefix of the payload
+        ok = received.size() <= expected.size() &&
+             std::equal(received.begin(), received.end(), expected.begin());
+        ok = ok && ms < disconnectAfterMs + 1000;
+    } else {
+        ok = received == expected;
+    }
+    std::printf("%s: %zu of %zu bytes, %u stalls recovered, %lld ms\n", ok ? "OK" : "FAIL",
+                received.size(), expected.size(), client.getStallsRecovered(),
+                static_cast<long long>(ms));
+    client.disconnect();
+    HttpStreamClient::dumpStats();
+    return ok ? 0 : 1;
+}
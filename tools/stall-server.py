@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""HTTP test server that stalls and drops streams mid-body.
+
+Serves one deterministic payload and honours "Range: bytes=<n>-" with a
+206, like LMS and the streaming CDNs. The first connections of a run
+misbehave part-way through the body according to the scenario; later
+ones (the Range reconnects) send the rest cleanly. Used with
+tools/stall-client (cmake -DBUILD_TOOLS=ON) or tools/run-stall-tests.sh
+to exercise HttpStreamClient's stall recovery.
+
+Scenarios:
+    clean      no fault
+    drop       close the connection after a third of the body
+    reset      same, with a TCP reset (SO_LINGER 0)
+    stall      stop sending for 8 s, then close
+    trickle    send 50 bytes every 100 ms (below --stall-min-rate)
+    norange    drop, and answer the Range reconnect with a 200
+    chunkdrop  drop inside a Transfer-Encoding: chunked body
+
+Usage:
+    tools/stall-server.py [--port 18081] [--size 3000000]
+                          [--payload /tmp/stall-payload.bin] [--bad 2] SCENARIO
+"""
+
+import argparse
+import random
+import re
+import socket
+import struct
+import threading
+import time
+
+
+def chunked(data, size=30000):
+    out = bytearray()
+    for i in range(0, len(data), size):
+        piece = data[i:i + size]
+        out += b'%x\r\n' % len(piece) + piece + b'\r\n'
+    return bytes(out + b'0\r\n\r\n')
+
+
+def serve(conn, index, args, payload):
+    request = conn.recv(4096).decode(errors='replace')
+    match = re.search(r'Range: bytes=(\d+)-', request, re.IGNORECASE)
+    offset = int(match.group(1)) if match else 0
+    print('connection %d: range %d' % (index, offset), flush=True)
+
+    is_chunked = args.scenario == 'chunkdrop'
+    if match and args.scenario != 'norange':
+        body = payload[offset:]
+        head = 'HTTP/1.1 206 Partial Content\r\nContent-Range: bytes %d-%d/%d\r\n' % (
+            offset, len(payload) - 1, len(payload))
+    else:
+        body = payload
+        head = 'HTTP/1.1 200 OK\r\n'
+    if is_chunked:
+        head += 'Accept-Ranges: bytes\r\nTransfer-Encoding: chunked\r\n'
+        body = chunked(body)
+    else:
+        head += 'Content-Length: %d\r\n' % len(body)
+    data = head.encode() + b'\r\n' + body
+
+    faulty = args.scenario != 'clean' and index < args.bad
+    cut = len(data) // 3 + 12345 if faulty else len(data)
+    pos = 0
+    try:
+        while pos < cut:
+            n = min(20000, cut - pos)
+            conn.sendall(data[pos:pos + n])
+            pos += n
+            time.sleep(0.002)
+        if faulty:
+            if args.scenario == 'reset':
+                conn.setsockopt(socket.SOL_SOCKET, socket.SO_LINGER, struct.pack('ii', 1, 0))
+            elif args.scenario == 'stall':
+                time.sleep(8)
+            elif args.scenario == 'trickle':
+                for _ in range(100):
+                    conn.sendall(data[pos:pos + 50])
+                    pos += 50
+                    time.sleep(0.1)
+            conn.close()
+            return
+        conn.sendall(data[pos:])
+        time.sleep(0.3)
+    except OSError:
+        pass
+    conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('scenario', choices=['clean', 'drop', 'reset', 'stall', 'trickle',
+                                             'norange', 'chunkdrop'])
+    parser.add_argument('--port', type=int, default=18081)
+    parser.add_argument('--size', type=int, default=3000000, help='payload bytes')
+    parser.add_argument('--payload', default='/tmp/stall-payload.bin',
+                        help='where the payload is written for the client to compare')
+    parser.add_argument('--bad', type=int, default=2, help='connections that misbehave')
+    args = parser.parse_args()
+
+    payload = random.Random(1).randbytes(args.size)
+    with open(args.payload, 'wb') as f:
+        f.write(payload)
+
+    server = socket.socket()
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(('127.0.0.1', args.port))
+    server.listen(5)
+    print('serving %d bytes on port %d (%s)' % (len(payload), args.port, args.scenario),
+          flush=True)
+    index = 0
+    while True:
+        conn, _ = server.accept()
+        threading.Thread(target=serve, args=(conn, index, args, payload), daemon=True).start()
+        index += 1
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,148 @@
+/**
+ * @file stat-client.cpp
+ * @brief Player side of tools/slimproto-standin.py: plays one stream and reports buffers
+ *
+ * Connects to the stand-in with SlimprotoClient, fetches the stream it
+ * starts through HttpStreamClient and "decodes" it at four times real
+ * time into a 2 s output buffer that plays out at 44.1 kHz/16/2. Buffer
+ * fullness goes into every STAT the way the audio thread fills it:
+ * stream buffer = HttpStreamClient::getInputBacklog(), output buffer =
+ * decoded audio not played yet, refreshed every 100 ms and just before
+ * STMd. The stand-in decides whether LMS would read them right.
+ *
+ * Raw PCM needs no decoder, so this tool's Decoder::available() only
+ * advertises 'p' (the real one lives in Decoder.cpp with all the codecs).
+ */
+
+#include "SlimprotoClient.h"
+#include "HttpStreamClient.h"
+#include "Decoder.h"
+#include "LogLevel.h"
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+LogLevel g_logLevel = LogLevel::WARN;
+
+bool Decoder::available(char formatCode, const std::string& /*backend*/) {
+    return formatCode == 'p';
+}
+
+namespace {
+
+constexpr uint64_t BYTES_PER_SECOND = 44100 * 2 * 2;
+constexpr uint64_t DECODE_PER_TICK = BYTES_PER_SECOND * 4 / 100;   // 10 ms ticks
+constexpr uint64_t PLAY_PER_TICK = BYTES_PER_SECOND / 100;
+constexpr uint64_t OUTPUT_CAPACITY = BYTES_PER_SECOND * 2;
+constexpr uint64_t START_THRESHOLD = BYTES_PER_SECOND / 2;
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    uint16_t port = 13483;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::atoi(argv[++i]));
+        } else if (arg == "--spool" && i + 1 < argc) {
+            HttpStreamClient::setSpool(argv[++i], 8 << 20);
+        } else {
+            std::fprintf(stderr, "Usage: %s [--port N] [--spool DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    Config config;
+    config.playerName = "stat-client";
+    SlimprotoClient slimproto;
+    HttpStreamClient http;
+    std::atomic<bool> started{false};
+
+    slimproto.onStream([&](const StrmCommand& cmd, const std::string& request) {
+        if (cmd.command != 's') return;
+        in_addr addr{};
+        addr.s_addr = cmd.serverIp;
+        if (!http.connect(cmd.serverIp ? inet_ntoa(addr) : slimproto.getServerIp(),
+                          cmd.getServerPort(), request)) {
+            slimproto.sendStat(StatEvent::STMn);
+            return;
+        }
+        slimproto.sendStat(StatEvent::STMc);
+        started.store(true, std::memory_order_release);
+    });
+    if (!slimproto.connect("127.0.0.1", port, config)) {
+        std::printf("FAIL: cannot connect to the stand-in\n");
+        return 1;
+    }
+    std::thread control([&slimproto] { slimproto.run(); });
+
+    uint64_t output = 0;
+    uint64_t received = 0;
+    bool inputDone = false;
+    bool playing = false;
+    int ticks = 0;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+    auto report = [&]() {
+        size_t inputSize = 0;
+        const uint64_t input = http.getInputBacklog(inputSize);
+        slimproto.updateBufferState(static_cast<uint32_t>(inputSize),
+                                    static_cast<uint32_t>(input),
+                                    static_cast<uint32_t>(OUTPUT_CAPACITY),
+                                    static_cast<uint32_t>(output));
+    };
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (!started.load(std::memory_order_acquire)) continue;
+
+        // Decode: take input while the output buffer has room
+        uint64_t want = std::min(DECODE_PER_TICK, OUTPUT_CAPACITY - output);
+        while (!inputDone && want > 0) {
+            const uint8_t* data = nullptr;
+            ssize_t n = http.readView(data, want, 0);
+            if (n > 0) {
+                output += static_cast<uint64_t>(n);
+                received += static_cast<uint64_t>(n);
+                want -= static_cast<uint64_t>(n);
+                slimproto.updateStreamBytes(received);
+            } else if (n < 0 || !http.isConnected()) {
+                inputDone = true;
+                report();
+                slimproto.sendStat(StatEvent::STMd);
+            } else {
+                break;
+            }
+        }
+
+        // Play out once past the start threshold
+        if (!playing && (output >= START_THRESHOLD || inputDone)) {
+            playing = true;
+            slimproto.sendStat(StatEvent::STMl);
+            slimproto.sendStat(StatEvent::STMs);
+        }
+        if (playing) output -= std::min(output, PLAY_PER_TICK);
+
+        if (++ticks % 10 == 0) report();
+        if (inputDone && output == 0) {
+            report();
+            slimproto.sendStat(StatEvent::STMu);
+            break;
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    http.disconnect();
+    slimproto.stop();
+    control.join();
+    std::printf("%s: %llu bytes played\n", inputDone ? "Done" : "Timed out",
+                static_cast<unsigned long long>(received));
+    return inputDone ? 0 : 1;
+}
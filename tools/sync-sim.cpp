@@ -0,0 +1,184 @@
+/**
+ * @file sync-sim.cpp
+ * @brief Simulated synced player: checks DriftCorrector against a drifting target
+ *
+ * Plays an album-like stream (tracks of non-zero audio separated by
+ * digital silence) into a simulated Diretta target whose clock runs
+ * --ppm fast or slow against the host, the way the DirettaSync worker
+ * does: one DriftCorrector::fill() per target buffer. It tracks how far
+ * the stream position is from where the host clock says it should be
+ * (what LMS judges a sync group by) with and without correction, and
+ * checks that correction only lengthened or shortened silence: the
+ * output with zero frames removed must equal the input with zero frames
+ * removed.
+ *
+ * Correction waits for silence, so the offset can build up over one track
+ * (ppm x track length), plus what the ppm measurement error adds over the
+ * whole run. Exit status: 0 = the corrected offset stayed within that (or
+ * --max-offset) and the audio is bit-identical, 1 = not.
+ */
+
+#include "DriftCorrector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    double ppm = 80.0;           // Target clock against the host
+    double ppmError = 0.5;       // Measurement error of the ppm fed to the corrector
+    double minutes = 60.0;       // Simulated playback time
+    double trackSeconds = 240.0; // Audio between silences
+    double gapMs = 1000.0;       // Digital silence between tracks
+    double maxOffsetMs = 0.0;    // 0 = one track's drift + the error over the run
+    unsigned rate = 44100;
+    unsigned channels = 2;
+    unsigned bytesPerSample = 4;
+    unsigned bufferFrames = 441;  // Frames per target buffer
+};
+
+// Deterministic stream: frame i of a track is non-zero, gaps are zero
+class Source {
+public:
+    Source(const Options& o)
+        : m_frameBytes(o.channels * o.bytesPerSample),
+          m_trackFrames(static_cast<uint64_t>(o.trackSeconds * o.rate)),
+          m_gapFrames(static_cast<uint64_t>(o.gapMs * o.rate / 1000)) {}
+
+    // pop() for DriftCorrector: the next bytes of the stream
+    void pop(uint8_t* dest, size_t bytes) {
+        for (size_t i = 0; i < bytes / m_frameBytes; i++) {
+            writeFrame(dest + i * m_frameBytes, m_pos++);
+        }
+    }
+
+    uint64_t position() const { return m_pos; }
+    size_t frameBytes() const { return m_frameBytes; }
+
+    void writeFrame(uint8_t* dest, uint64_t frame) const {
+        const uint64_t period = m_trackFrames + m_gapFrames;
+        if (frame % period >= m_trackFrames) {
+            std::memset(dest, 0, m_frameBytes);
+            return;
+        }
+        // Non-zero in every byte, distinct per frame
+        uint64_t v = frame * 0x9E3779B97F4A7C15ULL + 1;
+        for (size_t i = 0; i < m_frameBytes; i++) {
+            v ^= v >> 29;
+            v *= 0xBF58476D1CE4E5B9ULL;
+            dest[i] = static_cast<uint8_t>(v | 1);
+        }
+    }
+
+private:
+    size_t m_frameBytes;
+    uint64_t m_trackFrames;
+    uint64_t m_gapFrames;
+    uint64_t m_pos = 0;
+};
+
+struct Result {
+    double finalOffsetMs = 0;
+    double maxOffsetMs = 0;
+    uint64_t inserted = 0;
+    uint64_t dropped = 0;
+    bool identical = true;
+};
+
+Result run(const Options& o, bool correct) {
+    Source source(o);
+    const size_t fb = source.frameBytes();
+    DriftCorrector drift;
+    drift.reset(fb);
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> error(-o.ppmError, o.ppmError);
+    const double measured = o.ppm + error(rng);
+
+    // Reference copy of the stream, to compare non-silent frames in order
+    Source reference(o);
+    std::vector<uint8_t> buffer(o.bufferFrames * fb);
+    std::vector<uint8_t> expected(fb);
+    uint64_t referenceFrame = 0;
+
+    Result r;
+    const uint64_t buffers = static_cast<uint64_t>(
+        o.minutes * 60 * o.rate / o.bufferFrames);
+    const double framesPerHostSecond = o.rate * (1.0 + o.ppm * 1e-6);
+    for (uint64_t b = 1; b <= buffers; b++) {
+        if (correct) {
+            drift.advance(o.bufferFrames, measured);
+            drift.fill(buffer.data(), buffer.size(), buffer.size() * 2,
+                       [&source](uint8_t* p, size_t n) { source.pop(p, n); });
+        } else {
+            source.pop(buffer.data(), buffer.size());
+        }
+
+        for (size_t f = 0; f < o.bufferFrames && r.identical; f++) {
+            const uint8_t* frame = buffer.data() + f * fb;
+            if (std::all_of(frame, frame + fb, [](uint8_t x) { return x == 0; })) continue;
+            do {
+                reference.writeFrame(expected.data(), referenceFrame++);
+            } while (std::all_of(expected.begin(), expected.end(), [](uint8_t x) { return x == 0; }));
+            r.identical = std::memcmp(frame, expected.data(), fb) == 0;
+        }
+
+        // Host time when this buffer has played; where the stream should be
+        const double hostSeconds = static_cast<double>(b * o.bufferFrames) / framesPerHostSecond;
+        const double offsetMs = (static_cast<double>(source.position()) / o.rate - hostSeconds) * 1000;
+        r.finalOffsetMs = offsetMs;
+        r.maxOffsetMs = std::max(r.maxOffsetMs, std::fabs(offsetMs));
+    }
+    r.inserted = drift.inserted();
+    r.dropped = drift.dropped();
+    return r;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    Options o;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() { return i + 1 < argc ? std::atof(argv[++i]) : 0.0; };
+        if (arg == "--ppm") o.ppm = value();
+        else if (arg == "--ppm-error") o.ppmError = value();
+        else if (arg == "--minutes") o.minutes = value();
+        else if (arg == "--track-seconds") o.trackSeconds = value();
+        else if (arg == "--gap-ms") o.gapMs = value();
+        else if (arg == "--max-offset") o.maxOffsetMs = value();
+        else if (arg == "--rate") o.rate = static_cast<unsigned>(value());
+        else {
+            std::fprintf(stderr, "Usage: %s [--ppm N] [--ppm-error N] [--minutes N] "
+                         "[--track-seconds N] [--gap-ms N] [--max-offset MS] [--rate HZ]\n",
+                         argv[0]);
+            return 1;
+        }
+    }
+
+    if (o.maxOffsetMs <= 0) {
+        o.maxOffsetMs = (std::fabs(o.ppm) * o.trackSeconds + o.ppmError * o.minutes * 60) * 1e-3 +
+                        1000.0 * o.bufferFrames / o.rate;
+    }
+    const Result plain = run(o, false);
+    const Result corrected = run(o, true);
+    const bool ok = corrected.identical && corrected.maxOffsetMs <= o.maxOffsetMs;
+
+    std::printf("Target %+.1f ppm (measured within %.1f), %.0f min, %.0f s tracks, %.0f ms gaps\n",
+                o.ppm, o.ppmError, o.minutes, o.trackSeconds, o.gapMs);
+    std::printf("  uncorrected: %+.2f ms off the host clock at the end\n", plain.finalOffsetMs);
+    std::printf("  corrected:   %+.2f ms at the end, %.2f ms at most; "
+                "%llu frames inserted, %llu dropped\n",
+                corrected.finalOffsetMs, corrected.maxOffsetMs,
+                static_cast<unsigned long long>(corrected.inserted),
+                static_cast<unsigned long long>(corrected.dropped));
+    std::printf("%s: offset limit %.2f ms, audio %s\n", ok ? "OK" : "FAIL", o.maxOffsetMs,
+                corrected.identical ? "bit-identical outside silence" : "ALTERED");
+    return ok ? 0 : 1;
+}